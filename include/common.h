@@ -448,6 +448,10 @@ zbx_graph_yaxis_types_t;
 /* Zabbix Agent non-critical error (agents older than 2.0) */
 #define ZBX_ERROR		"ZBX_ERROR"
 
+/* passive check connection opening request asking agent to keep the connection open for the   */
+/* following requests, agent supporting it replies with the same data, others reject it as key */
+#define ZBX_PERSISTENT		"ZBX_PERSISTENT"
+
 /* media types */
 typedef enum
 {
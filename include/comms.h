@@ -136,17 +136,49 @@ void	zbx_tcp_close(zbx_socket_t *s);
 int	get_address_family(const char *addr, int *family, char *error, int max_error_len);
 #endif
 
-int	zbx_tcp_listen(zbx_socket_t *s, const char *listen_ip, unsigned short listen_port);
+#define ZBX_TCP_LISTEN_REUSEPORT	0x01
+
+#define zbx_tcp_listen(s, listen_ip, listen_port)	zbx_tcp_listen_ext(s, listen_ip, listen_port, 0)
+
+int	zbx_tcp_listen_ext(zbx_socket_t *s, const char *listen_ip, unsigned short listen_port, int flags);
 
 int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept);
+int	zbx_tcp_accept_tls(zbx_socket_t *s, unsigned int tls_accept);
 void	zbx_tcp_unaccept(zbx_socket_t *s);
 
+void	zbx_socket_timeout_set(zbx_socket_t *s, int timeout);
+void	zbx_socket_timeout_cleanup(zbx_socket_t *s);
+
+#ifndef _WINDOWS
+int	zbx_socket_set_nonblocking(ZBX_SOCKET s);
+int	zbx_socket_set_blocking(ZBX_SOCKET s);
+int	zbx_tcp_accept_nonblocking(const zbx_socket_t *s, int index, zbx_socket_t *conn, short *events);
+#endif
+
 #define ZBX_TCP_READ_UNTIL_CLOSE 0x01
 
 #define	zbx_tcp_recv(s)			SUCCEED_OR_FAIL(zbx_tcp_recv_ext(s, 0))
 #define	zbx_tcp_recv_to(s, timeout)	SUCCEED_OR_FAIL(zbx_tcp_recv_ext(s, timeout))
 #define	zbx_tcp_recv_raw(s)		SUCCEED_OR_FAIL(zbx_tcp_recv_raw_ext(s, 0))
 
+/* state of partially received message, allows to resume receiving on nonblocking sockets */
+typedef struct
+{
+	size_t				buf_dyn_bytes;
+	size_t				buf_stat_bytes;
+	size_t				offset;
+	zbx_uint32_t			expected_len;
+	zbx_uint32_t			reserved;
+	unsigned char			expect;
+	int				protocol_version;
+	char				*chunk;
+	struct zbx_uncompress_stream	*stream;
+}
+zbx_tcp_recv_context_t;
+
+void		zbx_tcp_recv_context_init(zbx_socket_t *s, zbx_tcp_recv_context_t *context);
+ssize_t		zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, short *events);
+void		zbx_tcp_recv_context_clear(zbx_tcp_recv_context_t *context);
 ssize_t		zbx_tcp_recv_ext(zbx_socket_t *s, int timeout);
 ssize_t		zbx_tcp_recv_raw_ext(zbx_socket_t *s, int timeout);
 const char	*zbx_tcp_recv_line(zbx_socket_t *s);
@@ -65,6 +65,8 @@ extern int	CONFIG_UNAVAILABLE_DELAY;
 extern int	CONFIG_UNREACHABLE_PERIOD;
 extern int	CONFIG_UNREACHABLE_DELAY;
 extern int	CONFIG_HISTSYNCER_FORKS;
+extern int	CONFIG_TRENDS_UPSERT;
+extern int	CONFIG_TRENDS_FLUSH_SPREAD;
 extern int	CONFIG_PROXYCONFIG_FREQUENCY;
 extern int	CONFIG_PROXYDATA_FREQUENCY;
 
@@ -203,6 +205,16 @@ typedef struct
 }
 DC_ITEM;
 
+/* runtime state of active agent item, changing without configuration sync */
+typedef struct
+{
+	zbx_uint64_t	lastlogsize;
+	int		mtime;
+	int		lastclock;
+	unsigned char	state;
+}
+zbx_active_item_state_t;
+
 typedef struct
 {
 	zbx_uint64_t	functionid;
@@ -242,6 +254,10 @@ typedef struct _DC_TRIGGER
 	char			*expression;
 	char			*recovery_expression;
 
+	/* compiled expressions, NULL if expression must be evaluated in textual form */
+	unsigned char		*expression_program;
+	unsigned char		*recovery_expression_program;
+
 	char			*error;
 	char			*new_error;
 	char			*correlation_tag;
@@ -585,6 +601,17 @@ typedef struct
 }
 zbx_config_cache_info_t;
 
+/* the configuration cache read lock wait time histogram */
+#define ZBX_DC_LOCK_WAIT_BUCKETS	7
+
+typedef struct
+{
+	zbx_uint64_t	buckets[ZBX_DC_LOCK_WAIT_BUCKETS];	/* number of waits falling into each bucket */
+	zbx_uint64_t	count;					/* total number of read locks */
+	double		sum;					/* total wait time in seconds */
+}
+zbx_dc_lock_stats_t;
+
 typedef struct
 {
 	zbx_uint64_t	history_counter;	/* the total number of processed values */
@@ -666,6 +693,7 @@ int	DCconfig_get_hostid_by_name(const char *host, zbx_uint64_t *hostid);
 void	DCconfig_get_hosts_by_itemids(DC_HOST *hosts, const zbx_uint64_t *itemids, int *errcodes, size_t num);
 void	DCconfig_get_items_by_keys(DC_ITEM *items, zbx_host_key_t *keys, int *errcodes, size_t num);
 void	DCconfig_get_items_by_itemids(DC_ITEM *items, const zbx_uint64_t *itemids, int *errcodes, size_t num);
+void	DCconfig_get_active_items_state(const zbx_uint64_t *itemids, zbx_active_item_state_t *states, size_t num);
 void	DCconfig_get_preprocessable_items(zbx_hashset_t *items, int *timestamp);
 void	DCconfig_get_functions_by_functionids(DC_FUNCTION *functions,
 		zbx_uint64_t *functionids, int *errcodes, size_t num);
@@ -723,8 +751,10 @@ int	DCget_host_inventory_value_by_hostid(zbx_uint64_t hostid, char **replace_to,
 #define ZBX_CONFSTATS_BUFFER_PUSED	4
 #define ZBX_CONFSTATS_BUFFER_PFREE	5
 void	*DCconfig_get_stats(int request);
+void	DCconfig_get_rdlock_stats(zbx_dc_lock_stats_t *stats, const double **bounds);
 
 int	DCconfig_get_last_sync_time(void);
+zbx_uint64_t	DCconfig_get_revision(void);
 void	DCconfig_wait_sync(void);
 int	DCconfig_get_proxypoller_hosts(DC_PROXY *proxies, int max_hosts);
 int	DCconfig_get_proxypoller_nextcheck(void);
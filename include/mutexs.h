@@ -44,6 +44,7 @@ typedef enum
 	ZBX_MUTEX_SQLITE3,
 	ZBX_MUTEX_PROCSTAT,
 	ZBX_MUTEX_PROXY_HISTORY,
+	ZBX_MUTEX_CONFIG_STATS,
 	ZBX_MUTEX_COUNT
 }
 zbx_mutex_name_t;
@@ -357,6 +357,24 @@ int	evaluate(double *value, const char *expression, char *error, size_t max_erro
 int	evaluate_unknown(const char *expression, double *value, char *error, size_t max_error_len);
 double	evaluate_string_to_double(const char *in);
 
+/* compiled expressions */
+
+typedef struct
+{
+	char	*str;		/* string value or NULL for numeric values             */
+	double	value;		/* numeric value, ZBX_UNKNOWN for Unknown values       */
+	int	unknown_idx;	/* index of message about the origin of Unknown value */
+}
+zbx_expression_operand_t;
+
+unsigned char	*zbx_expression_compile(const char *expression);
+zbx_uint32_t	zbx_expression_program_size(const unsigned char *program);
+int	zbx_expression_program_functionids(const unsigned char *program, const zbx_uint64_t **functionids);
+int	zbx_expression_operand_parse(zbx_expression_operand_t *operand, const char *value);
+void	zbx_expression_operand_clear(zbx_expression_operand_t *operand);
+int	zbx_expression_execute(double *value, const unsigned char *program, const zbx_expression_operand_t **operands,
+		const char *expression, char *error, size_t max_error_len, zbx_vector_ptr_t *unknown_msgs);
+
 /* forecasting */
 
 #define ZBX_MATH_ERROR	-1.0
@@ -26,6 +26,7 @@
 #define ZBX_PROTO_TAG_REGEXP			"regexp"
 #define ZBX_PROTO_TAG_DELAY			"delay"
 #define ZBX_PROTO_TAG_REFRESH_UNSUPPORTED	"refresh_unsupported"
+#define ZBX_PROTO_TAG_CONFIG_REVISION		"config_revision"
 #define ZBX_PROTO_TAG_DRULE			"drule"
 #define ZBX_PROTO_TAG_DCHECK			"dcheck"
 #define ZBX_PROTO_TAG_HOST			"host"
@@ -29,6 +29,10 @@ import (
 
 const notsupported = "ZBX_NOTSUPPORTED"
 
+// persistent is the connection opening request asking to keep the connection open for the following
+// requests, it is confirmed by replying with the same data
+const persistent = "ZBX_PERSISTENT"
+
 type passiveCheck struct {
 	conn      *passiveConnection
 	scheduler scheduler.Scheduler
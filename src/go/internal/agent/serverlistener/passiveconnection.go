@@ -28,13 +28,17 @@ import (
 
 type passiveConnection struct {
 	conn *zbxcomms.Connection
+	// persistent connection is kept open after response for the following requests
+	persistent bool
 }
 
 func (pc *passiveConnection) Write(data []byte) (n int, err error) {
 	if err = pc.conn.Write(data, time.Second*time.Duration(agent.Options.Timeout)); err != nil {
 		n = len(data)
 	}
-	pc.conn.Close()
+	if !pc.persistent {
+		pc.conn.Close()
+	}
 	return
 }
 
@@ -57,12 +57,45 @@ func (sl *ServerListener) processConnection(conn *zbxcomms.Connection) (err erro
 
 	log.Debugf("received passive check request: '%s' from '%s'", string(data), conn.RemoteIP())
 
+	if string(data) == persistent {
+		go sl.processPersistentConnection(conn)
+		return nil
+	}
+
 	response := passiveCheck{conn: &passiveConnection{conn: conn}, scheduler: sl.scheduler}
 	go response.handleCheck(data)
 
 	return nil
 }
 
+// processPersistentConnection performs passive checks one by one over the connection opened with
+// persistent connection request until server closes it or no request arrives within timeout
+func (sl *ServerListener) processPersistentConnection(conn *zbxcomms.Connection) {
+	defer conn.Close()
+
+	timeout := time.Second * time.Duration(sl.options.Timeout)
+	if err := conn.Write([]byte(persistent), timeout); err != nil {
+		log.Debugf("could not send response to server '%s': %s", conn.RemoteIP(), err.Error())
+		return
+	}
+
+	response := passiveCheck{conn: &passiveConnection{conn: conn, persistent: true}, scheduler: sl.scheduler}
+	for {
+		data, err := conn.Read(timeout)
+		if err != nil {
+			log.Debugf("cannot read passive check request from '%s': %s", conn.RemoteIP(), err.Error())
+			return
+		}
+		if len(data) == 0 {
+			// connection closed by server
+			return
+		}
+
+		log.Debugf("received passive check request: '%s' from '%s'", string(data), conn.RemoteIP())
+		response.handleCheck(data)
+	}
+}
+
 func (sl *ServerListener) run() {
 	defer log.PanicHook()
 	log.Debugf("[%d] starting listener for '%s:%d'", sl.listenerID, sl.bindIP, sl.options.ListenPort)
@@ -952,6 +952,58 @@ static zbx_variant_t	evaluate_term1(int *unknown_idx)
 	return res;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: evaluate_unknown_to_error                                        *
+ *                                                                            *
+ * Purpose: map Unknown expression result to error                            *
+ *                                                                            *
+ * Parameters: value         - [OUT] set to ZBX_INFINITY                      *
+ *             unknown_idx   - [IN] index of message about the origin of      *
+ *                                  Unknown value in 'unknown_msgs' vector    *
+ *             expression    - [IN] the expression, used for logging          *
+ *             error         - [OUT] error message buffer                     *
+ *             max_error_len - [IN] error buffer size                         *
+ *             unknown_msgs  - [IN] messages about origins of Unknown values  *
+ *                                                                            *
+ * Comments: callers currently do not operate with ZBX_UNKNOWN                *
+ *                                                                            *
+ ******************************************************************************/
+static void	evaluate_unknown_to_error(double *value, int unknown_idx, const char *expression, char *error,
+		size_t max_error_len, zbx_vector_ptr_t *unknown_msgs)
+{
+	if (NULL != unknown_msgs)
+	{
+		if (0 > unknown_idx)
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			zabbix_log(LOG_LEVEL_WARNING, "%s() internal error: " ZBX_UNKNOWN_STR " index:%d"
+					" expression:'%s'", __func__, unknown_idx, expression);
+			zbx_snprintf(error, max_error_len, "Internal error: " ZBX_UNKNOWN_STR " index %d."
+					" Please report this to Zabbix developers.", unknown_idx);
+		}
+		else if (unknown_msgs->values_num > unknown_idx)
+		{
+			zbx_snprintf(error, max_error_len, "Cannot evaluate expression: \"%s\".",
+					(char *)(unknown_msgs->values[unknown_idx]));
+		}
+		else
+		{
+			zbx_snprintf(error, max_error_len, "Cannot evaluate expression: unsupported "
+					ZBX_UNKNOWN_STR "%d value.", unknown_idx);
+		}
+	}
+	else
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		/* do not leave garbage in error buffer, write something helpful */
+		zbx_snprintf(error, max_error_len, "%s(): internal error: no message for unknown result",
+				__func__);
+	}
+
+	*value = ZBX_INFINITY;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: evaluate an expression like "(26.416>10) or (0=1)"                *
@@ -997,39 +1049,7 @@ int	evaluate(double *value, const char *expression, char *error, size_t max_erro
 	}
 
 	if (ZBX_UNKNOWN == *value)
-	{
-		/* Map Unknown result to error. Callers currently do not operate with ZBX_UNKNOWN. */
-		if (NULL != unknown_msgs)
-		{
-			if (0 > unknown_idx)
-			{
-				THIS_SHOULD_NEVER_HAPPEN;
-				zabbix_log(LOG_LEVEL_WARNING, "%s() internal error: " ZBX_UNKNOWN_STR " index:%d"
-						" expression:'%s'", __func__, unknown_idx, expression);
-				zbx_snprintf(error, max_error_len, "Internal error: " ZBX_UNKNOWN_STR " index %d."
-						" Please report this to Zabbix developers.", unknown_idx);
-			}
-			else if (unknown_msgs->values_num > unknown_idx)
-			{
-				zbx_snprintf(error, max_error_len, "Cannot evaluate expression: \"%s\".",
-						(char *)(unknown_msgs->values[unknown_idx]));
-			}
-			else
-			{
-				zbx_snprintf(error, max_error_len, "Cannot evaluate expression: unsupported "
-						ZBX_UNKNOWN_STR "%d value.", unknown_idx);
-			}
-		}
-		else
-		{
-			THIS_SHOULD_NEVER_HAPPEN;
-			/* do not leave garbage in error buffer, write something helpful */
-			zbx_snprintf(error, max_error_len, "%s(): internal error: no message for unknown result",
-					__func__);
-		}
-
-		*value = ZBX_INFINITY;
-	}
+		evaluate_unknown_to_error(value, unknown_idx, expression, error, max_error_len, unknown_msgs);
 
 	if (ZBX_INFINITY == *value)
 	{
@@ -1128,3 +1148,1020 @@ double	evaluate_string_to_double(const char *in)
 
 	return result_double_value;
 }
+
+/******************************************************************************
+ *                                                                            *
+ *                       Compiled expression programs                         *
+ *                  ---------------------------------------                   *
+ *                                                                            *
+ * Trigger expressions can be compiled into a compact postfix program which   *
+ * is executed by a stack machine without building any strings. Function      *
+ * references like {12345} are compiled into slots, their values are passed   *
+ * to the executor as already parsed operands. The {TRIGGER.VALUE} macro is   *
+ * compiled into a slot with functionid 0.                                    *
+ *                                                                            *
+ * The compiler mirrors the evaluate_termX() parser and the executor mirrors  *
+ * its semantics, including error messages and Unknown value handling.        *
+ * Expressions whose result could depend on the textual form of substituted   *
+ * values are not compiled, they must be evaluated with evaluate().           *
+ *                                                                            *
+ * Program layout:                                                            *
+ *   zbx_expression_header_t - program header                                 *
+ *   zbx_uint64_t[]          - functionids of slots (slots_num)               *
+ *   unsigned char[]         - code                                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#define ZBX_EXPRESSION_OP_NUMBER	1	/* push double constant, followed by the value      */
+#define ZBX_EXPRESSION_OP_STRING	2	/* push string constant, followed by the string     */
+#define ZBX_EXPRESSION_OP_SLOT		3	/* push slot value, followed by unsigned short index */
+#define ZBX_EXPRESSION_OP_TODBL		4	/* convert stack top to double                       */
+#define ZBX_EXPRESSION_OP_NEG		5
+#define ZBX_EXPRESSION_OP_NOT		6
+#define ZBX_EXPRESSION_OP_MUL		7
+#define ZBX_EXPRESSION_OP_DIV		8
+#define ZBX_EXPRESSION_OP_ADD		9
+#define ZBX_EXPRESSION_OP_SUB		10
+#define ZBX_EXPRESSION_OP_LT		11
+#define ZBX_EXPRESSION_OP_LE		12
+#define ZBX_EXPRESSION_OP_GE		13
+#define ZBX_EXPRESSION_OP_GT		14
+#define ZBX_EXPRESSION_OP_EQ		15
+#define ZBX_EXPRESSION_OP_NE		16
+#define ZBX_EXPRESSION_OP_AND		17
+#define ZBX_EXPRESSION_OP_OR		18
+
+#define ZBX_EXPRESSION_TRIGGER_VALUE	"{TRIGGER.VALUE}"
+
+/* executor stack size, programs requiring deeper stack allocate it dynamically */
+#define ZBX_EXPRESSION_STACK_SIZE	32
+
+typedef struct
+{
+	zbx_uint32_t	size;		/* total program size in bytes     */
+	unsigned short	slots_num;	/* number of slots                 */
+	unsigned short	stack_depth;	/* maximum stack depth of the code */
+}
+zbx_expression_header_t;
+
+/* executor stack value, strings are borrowed from the program or operands */
+typedef struct
+{
+	const char	*str;
+	double		value;
+	int		unknown_idx;
+}
+zbx_expression_value_t;
+
+static unsigned char		*code;		/* code being compiled          */
+static size_t			code_alloc;
+static size_t			code_offset;
+static int			depth;		/* current stack depth          */
+static int			max_depth;	/* maximum stack depth          */
+static zbx_vector_uint64_t	*slots;		/* functionids of compiled slots */
+
+static void	compile_emit(const void *data, size_t size)
+{
+	if (code_offset + size > code_alloc)
+	{
+		while (code_offset + size > code_alloc)
+			code_alloc *= 2;
+
+		code = (unsigned char *)zbx_realloc(code, code_alloc);
+	}
+
+	memcpy(code + code_offset, data, size);
+	code_offset += size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: emit operator code and track the stack depth                      *
+ *                                                                            *
+ * Parameters: op    - [IN] the operator                                      *
+ *             stack - [IN] the number of values pushed (positive) or popped  *
+ *                          (negative) by the operator                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	compile_emit_op(unsigned char op, int stack)
+{
+	compile_emit(&op, 1);
+
+	if (max_depth < (depth += stack))
+		max_depth = depth;
+}
+
+static int	compile_term1(void);
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile a quoted string, see evaluate_string()                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_string(void)
+{
+	const char	*start;
+
+	for (start = ptr; '"' != *ptr; ptr++)
+	{
+		if ('\\' == *ptr)
+		{
+			ptr++;
+
+			if ('\\' != *ptr && '\"' != *ptr)
+				return FAIL;
+		}
+
+		/* function references and macros inside strings are substituted by the textual evaluation */
+		if ('\0' == *ptr || '{' == *ptr)
+			return FAIL;
+	}
+
+	compile_emit_op(ZBX_EXPRESSION_OP_STRING, 1);
+
+	for (; start != ptr; start++)
+	{
+		switch (*start)
+		{
+			case '\\':
+				start++;
+				break;
+			case '\r':
+				continue;
+		}
+
+		compile_emit(start, 1);
+	}
+
+	compile_emit("", 1);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile function reference {functionid} or {TRIGGER.VALUE} macro  *
+ *          into a slot                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_slot(void)
+{
+	const char	*end;
+	zbx_uint64_t	functionid;
+	unsigned short	index;
+	int		i;
+
+	if (NULL == (end = strchr(ptr, '}')))
+		return FAIL;
+
+	if (0 == strncmp(ptr, ZBX_EXPRESSION_TRIGGER_VALUE, ZBX_CONST_STRLEN(ZBX_EXPRESSION_TRIGGER_VALUE)))
+		functionid = 0;
+	else if (SUCCEED != is_uint64_n(ptr + 1, end - ptr - 1, &functionid) || 0 == functionid)
+		return FAIL;
+
+	/* Numeric values are substituted as is while other values are enclosed in parentheses, */
+	/* which adds a nesting level. Do not compile references where the substituted value    */
+	/* would be parsed differently depending on its form.                                    */
+	if (FAIL == is_number_delimiter(end[1]) || 31 < level)
+		return FAIL;
+
+	for (i = 0; i < slots->values_num; i++)
+	{
+		if (slots->values[i] == functionid)
+			break;
+	}
+
+	if (i == slots->values_num)
+	{
+		if (USHRT_MAX < i)
+			return FAIL;
+
+		zbx_vector_uint64_append(slots, functionid);
+	}
+
+	index = (unsigned short)i;
+	compile_emit_op(ZBX_EXPRESSION_OP_SLOT, 1);
+	compile_emit(&index, sizeof(index));
+	ptr = end + 1;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile a suffixed number, a string, a function reference or a    *
+ *          parenthesized expression, see evaluate_term9()                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term9(void)
+{
+	while (' ' == *ptr || '\r' == *ptr || '\n' == *ptr || '\t' == *ptr)
+		ptr++;
+
+	if ('(' == *ptr)
+	{
+		ptr++;
+
+		if (SUCCEED != compile_term1() || ')' != *ptr)
+			return FAIL;
+
+		ptr++;
+	}
+	else if ('"' == *ptr)
+	{
+		ptr++;
+
+		if (SUCCEED != compile_string())
+			return FAIL;
+
+		ptr++;
+
+		if (FAIL == is_operator_delimiter(*ptr) && FAIL == is_number_delimiter(*ptr))
+			return FAIL;
+	}
+	else if ('{' == *ptr)
+	{
+		if (SUCCEED != compile_slot())
+			return FAIL;
+	}
+	else
+	{
+		double	value;
+		int	len;
+
+		if (0 == strncmp(ZBX_UNKNOWN_STR, ptr, ZBX_UNKNOWN_STR_LEN))
+			return FAIL;
+
+		if (SUCCEED != zbx_suffixed_number_parse(ptr, &len) || SUCCEED != is_number_delimiter(ptr[len]))
+			return FAIL;
+
+		if (ZBX_INFINITY == (value = atof(ptr) * suffix2factor(ptr[len - 1])))
+			return FAIL;
+
+		compile_emit_op(ZBX_EXPRESSION_OP_NUMBER, 1);
+		compile_emit(&value, sizeof(value));
+		ptr += len;
+	}
+
+	while (' ' == *ptr || '\r' == *ptr || '\n' == *ptr || '\t' == *ptr)
+		ptr++;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "-" (unary), see evaluate_term8()                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term8(void)
+{
+	while (' ' == *ptr || '\r' == *ptr || '\n' == *ptr || '\t' == *ptr)
+		ptr++;
+
+	if ('-' != *ptr)
+		return compile_term9();
+
+	ptr++;
+
+	if (SUCCEED != compile_term9())
+		return FAIL;
+
+	compile_emit_op(ZBX_EXPRESSION_OP_NEG, 0);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "not", see evaluate_term7()                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term7(void)
+{
+	while (' ' == *ptr || '\r' == *ptr || '\n' == *ptr || '\t' == *ptr)
+		ptr++;
+
+	if ('n' != ptr[0] || 'o' != ptr[1] || 't' != ptr[2] || SUCCEED != is_operator_delimiter(ptr[3]))
+		return compile_term8();
+
+	ptr += 3;
+
+	if (SUCCEED != compile_term8())
+		return FAIL;
+
+	compile_emit_op(ZBX_EXPRESSION_OP_NOT, 0);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "*" and "/", see evaluate_term6()                         *
+ *                                                                            *
+ * Comments: The left operand is converted to double before the right one is  *
+ *           evaluated, so that errors are reported in the same order as by   *
+ *           evaluate(). The same applies to other binary operators except    *
+ *           "=" and "<>", which compare strings too.                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term6(void)
+{
+	unsigned char	op;
+
+	if (SUCCEED != compile_term7())
+		return FAIL;
+
+	while ('*' == *ptr || '/' == *ptr)
+	{
+		op = ('*' == *ptr++ ? ZBX_EXPRESSION_OP_MUL : ZBX_EXPRESSION_OP_DIV);
+		compile_emit_op(ZBX_EXPRESSION_OP_TODBL, 0);
+
+		if (SUCCEED != compile_term7())
+			return FAIL;
+
+		compile_emit_op(op, -1);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "+" and "-", see evaluate_term5()                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term5(void)
+{
+	unsigned char	op;
+
+	if (SUCCEED != compile_term6())
+		return FAIL;
+
+	while ('+' == *ptr || '-' == *ptr)
+	{
+		op = ('+' == *ptr++ ? ZBX_EXPRESSION_OP_ADD : ZBX_EXPRESSION_OP_SUB);
+		compile_emit_op(ZBX_EXPRESSION_OP_TODBL, 0);
+
+		if (SUCCEED != compile_term6())
+			return FAIL;
+
+		compile_emit_op(op, -1);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "<", "<=", ">=", ">", see evaluate_term4()                *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term4(void)
+{
+	unsigned char	op;
+
+	if (SUCCEED != compile_term5())
+		return FAIL;
+
+	while (1)
+	{
+		if ('<' == ptr[0] && '=' == ptr[1])
+		{
+			op = ZBX_EXPRESSION_OP_LE;
+			ptr += 2;
+		}
+		else if ('>' == ptr[0] && '=' == ptr[1])
+		{
+			op = ZBX_EXPRESSION_OP_GE;
+			ptr += 2;
+		}
+		else if ('<' == ptr[0] && '>' != ptr[1])
+		{
+			op = ZBX_EXPRESSION_OP_LT;
+			ptr++;
+		}
+		else if ('>' == ptr[0])
+		{
+			op = ZBX_EXPRESSION_OP_GT;
+			ptr++;
+		}
+		else
+			break;
+
+		compile_emit_op(ZBX_EXPRESSION_OP_TODBL, 0);
+
+		if (SUCCEED != compile_term5())
+			return FAIL;
+
+		compile_emit_op(op, -1);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "=" and "<>", see evaluate_term3()                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term3(void)
+{
+	unsigned char	op;
+
+	if (SUCCEED != compile_term4())
+		return FAIL;
+
+	while (1)
+	{
+		if ('=' == *ptr)
+		{
+			op = ZBX_EXPRESSION_OP_EQ;
+			ptr++;
+		}
+		else if ('<' == ptr[0] && '>' == ptr[1])
+		{
+			op = ZBX_EXPRESSION_OP_NE;
+			ptr += 2;
+		}
+		else
+			break;
+
+		if (SUCCEED != compile_term4())
+			return FAIL;
+
+		compile_emit_op(op, -1);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "and", see evaluate_term2()                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term2(void)
+{
+	if (SUCCEED != compile_term3())
+		return FAIL;
+
+	while ('a' == ptr[0] && 'n' == ptr[1] && 'd' == ptr[2] && SUCCEED == is_operator_delimiter(ptr[3]))
+	{
+		ptr += 3;
+		compile_emit_op(ZBX_EXPRESSION_OP_TODBL, 0);
+
+		if (SUCCEED != compile_term3())
+			return FAIL;
+
+		compile_emit_op(ZBX_EXPRESSION_OP_AND, -1);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "or", see evaluate_term1()                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term1(void)
+{
+	if (32 < ++level || SUCCEED != compile_term2())
+		return FAIL;
+
+	while ('o' == ptr[0] && 'r' == ptr[1] && SUCCEED == is_operator_delimiter(ptr[2]))
+	{
+		ptr += 2;
+		compile_emit_op(ZBX_EXPRESSION_OP_TODBL, 0);
+
+		if (SUCCEED != compile_term2())
+			return FAIL;
+
+		compile_emit_op(ZBX_EXPRESSION_OP_OR, -1);
+	}
+
+	level--;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_expression_compile                                           *
+ *                                                                            *
+ * Purpose: compile trigger expression into a program                         *
+ *                                                                            *
+ * Parameters: expression - [IN] the expression with function references,     *
+ *                               for example "{15}>10 or {123}=1"             *
+ *                                                                            *
+ * Return value: The compiled program allocated with zbx_malloc() or NULL if  *
+ *               the expression cannot be compiled. In the latter case the    *
+ *               expression must be evaluated with evaluate() after function  *
+ *               results are substituted.                                     *
+ *                                                                            *
+ ******************************************************************************/
+unsigned char	*zbx_expression_compile(const char *expression)
+{
+	zbx_vector_uint64_t	functionids;
+	zbx_expression_header_t	header;
+	unsigned char		*program = NULL;
+	size_t			slots_size;
+
+	zbx_vector_uint64_create(&functionids);
+
+	ptr = expression;
+	level = 0;
+	depth = 0;
+	max_depth = 0;
+	slots = &functionids;
+	code_alloc = 64;
+	code_offset = 0;
+	code = (unsigned char *)zbx_malloc(NULL, code_alloc);
+
+	if (SUCCEED != compile_term1() || '\0' != *ptr || USHRT_MAX < max_depth)
+		goto out;
+
+	slots_size = sizeof(zbx_uint64_t) * functionids.values_num;
+
+	header.size = (zbx_uint32_t)(sizeof(header) + slots_size + code_offset);
+	header.slots_num = (unsigned short)functionids.values_num;
+	header.stack_depth = (unsigned short)max_depth;
+
+	program = (unsigned char *)zbx_malloc(NULL, header.size);
+	memcpy(program, &header, sizeof(header));
+
+	if (0 != slots_size)
+		memcpy(program + sizeof(header), functionids.values, slots_size);
+
+	memcpy(program + sizeof(header) + slots_size, code, code_offset);
+out:
+	zbx_free(code);
+	zbx_vector_uint64_destroy(&functionids);
+
+	return program;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_expression_program_size                                      *
+ *                                                                            *
+ * Purpose: get size of compiled program in bytes                             *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_expression_program_size(const unsigned char *program)
+{
+	return ((const zbx_expression_header_t *)program)->size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_expression_program_functionids                               *
+ *                                                                            *
+ * Purpose: get functionids of compiled program slots                         *
+ *                                                                            *
+ * Parameters: program     - [IN] the compiled program                        *
+ *             functionids - [OUT] functionids of slots in the order they     *
+ *                                 must be passed to zbx_expression_execute() *
+ *                                 where 0 stands for {TRIGGER.VALUE} macro   *
+ *                                                                            *
+ * Return value: the number of slots                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_expression_program_functionids(const unsigned char *program, const zbx_uint64_t **functionids)
+{
+	*functionids = (const zbx_uint64_t *)(program + sizeof(zbx_expression_header_t));
+
+	return ((const zbx_expression_header_t *)program)->slots_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_expression_operand_parse                                     *
+ *                                                                            *
+ * Purpose: parse function result into program operand                        *
+ *                                                                            *
+ * Parameters: operand - [OUT] the operand                                    *
+ *             value   - [IN] the function result, a suffixed number, a       *
+ *                            quoted string or ZBX_UNKNOWN<N> token           *
+ *                                                                            *
+ * Return value: SUCCEED - the value was parsed                               *
+ *               FAIL    - the value cannot be used as program operand, the   *
+ *                         expression must be evaluated with evaluate()       *
+ *                                                                            *
+ * Comments: Results are parsed the same way as they would be parsed after    *
+ *           substitution into expression, see                                *
+ *           substitute_expression_functions_results().                       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_expression_operand_parse(zbx_expression_operand_t *operand, const char *value)
+{
+	const char	*p;
+	char		*dst;
+	int		len;
+
+	operand->str = NULL;
+	operand->unknown_idx = -1;
+
+	if (SUCCEED == is_double_suffix(value, ZBX_FLAG_DOUBLE_SUFFIX) && '-' != *value)
+	{
+		if (SUCCEED != zbx_suffixed_number_parse(value, &len) || '\0' != value[len])
+			return FAIL;
+
+		operand->value = atof(value) * suffix2factor(value[len - 1]);
+
+		return ZBX_INFINITY == operand->value ? FAIL : SUCCEED;
+	}
+
+	if ('-' == *value)
+	{
+		if (SUCCEED != zbx_suffixed_number_parse(value + 1, &len) || '\0' != value[len + 1])
+			return FAIL;
+
+		if (ZBX_INFINITY == (operand->value = atof(value + 1) * suffix2factor(value[len])))
+			return FAIL;
+
+		operand->value = -operand->value;
+
+		return SUCCEED;
+	}
+
+	if (0 == strncmp(value, ZBX_UNKNOWN_STR, ZBX_UNKNOWN_STR_LEN))
+	{
+		for (p = value + ZBX_UNKNOWN_STR_LEN; 0 != isdigit((unsigned char)*p); p++)
+			;
+
+		if (p == value + ZBX_UNKNOWN_STR_LEN || '\0' != *p)
+			return FAIL;
+
+		operand->value = ZBX_UNKNOWN;
+		operand->unknown_idx = atoi(value + ZBX_UNKNOWN_STR_LEN);
+
+		return SUCCEED;
+	}
+
+	if ('"' != *value)
+		return FAIL;
+
+	for (p = value + 1; '"' != *p; p++)
+	{
+		if ('\\' == *p && '\\' != *(++p) && '"' != *p)
+			return FAIL;
+
+		if ('\0' == *p)
+			return FAIL;
+	}
+
+	if ('\0' != p[1])
+		return FAIL;
+
+	operand->str = dst = (char *)zbx_malloc(NULL, p - value);
+	operand->value = 0;
+
+	for (p = value + 1; '"' != *p; p++)
+	{
+		switch (*p)
+		{
+			case '\\':
+				p++;
+				break;
+			case '\r':
+				continue;
+		}
+
+		*dst++ = *p;
+	}
+
+	*dst = '\0';
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_expression_operand_clear                                     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_expression_operand_clear(zbx_expression_operand_t *operand)
+{
+	zbx_free(operand->str);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: convert executor stack value to double, see                       *
+ *          variant_convert_to_double()                                       *
+ *                                                                            *
+ * Return value: SUCCEED - the value is a number or Unknown                   *
+ *               FAIL    - the value cannot be converted                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	expression_value_to_double(zbx_expression_value_t *value)
+{
+	if (NULL != value->str)
+	{
+		if (ZBX_INFINITY == (value->value = evaluate_string_to_double(value->str)))
+		{
+			zbx_snprintf(buffer, max_buffer_len, "Cannot evaluate expression:"
+					" value \"%s\" is not a numeric operand.", value->str);
+		}
+
+		value->str = NULL;
+	}
+
+	return ZBX_INFINITY == value->value ? FAIL : SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compare operands for "=" operator, see evaluate_term3()           *
+ *                                                                            *
+ ******************************************************************************/
+static double	expression_values_equal(const zbx_expression_value_t *left, const zbx_expression_value_t *right)
+{
+	double	left_dbl, right_dbl;
+
+	left_dbl = (NULL == left->str ? left->value : evaluate_string_to_double(left->str));
+	right_dbl = (NULL == right->str ? right->value : evaluate_string_to_double(right->str));
+
+	if (ZBX_INFINITY != left_dbl && ZBX_INFINITY != right_dbl)
+		return SUCCEED == zbx_double_compare(left_dbl, right_dbl) ? 1 : 0;
+
+	if (NULL == left->str || NULL == right->str)
+		return 0;
+
+	return 0 == strcmp(left->str, right->str);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute binary operator                                           *
+ *                                                                            *
+ * Parameters: op    - [IN] the operator                                      *
+ *             left  - [IN/OUT] the left operand and the result               *
+ *             right - [IN] the right operand                                 *
+ *                                                                            *
+ * Return value: SUCCEED - the operator was executed                          *
+ *               FAIL    - evaluation error, the error message is written to  *
+ *                         the error buffer                                   *
+ *                                                                            *
+ * Comments: Operands of all operators except "=" and "<>" are converted to   *
+ *           double, the left operand is converted by the preceding           *
+ *           ZBX_EXPRESSION_OP_TODBL instruction.                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	expression_execute_binary(unsigned char op, zbx_expression_value_t *left,
+		zbx_expression_value_t *right)
+{
+	if (ZBX_EXPRESSION_OP_EQ == op || ZBX_EXPRESSION_OP_NE == op)
+	{
+		if (NULL == left->str && ZBX_UNKNOWN == left->value)
+			return SUCCEED;
+
+		if (NULL == right->str && ZBX_UNKNOWN == right->value)
+		{
+			*left = *right;
+			return SUCCEED;
+		}
+
+		left->value = expression_values_equal(left, right);
+		left->str = NULL;
+
+		if (ZBX_EXPRESSION_OP_NE == op)
+			left->value = (SUCCEED == zbx_double_compare(left->value, 0.0) ? 1.0 : 0.0);
+
+		return SUCCEED;
+	}
+
+	if (SUCCEED != expression_value_to_double(right))
+		return FAIL;
+
+	switch (op)
+	{
+		case ZBX_EXPRESSION_OP_AND:
+			if (ZBX_UNKNOWN == left->value)
+			{
+				if (ZBX_UNKNOWN == right->value)				/* Unknown and Unknown */
+					*left = *right;
+				else if (SUCCEED == zbx_double_compare(right->value, 0.0))	/* Unknown and 0 */
+					left->value = 0.0;
+			}
+			else if (ZBX_UNKNOWN == right->value)
+			{
+				if (SUCCEED == zbx_double_compare(left->value, 0.0))		/* 0 and Unknown */
+					left->value = 0.0;
+				else							/* 1 and Unknown */
+					*left = *right;
+			}
+			else
+			{
+				left->value = (SUCCEED != zbx_double_compare(left->value, 0.0) &&
+						SUCCEED != zbx_double_compare(right->value, 0.0));
+			}
+			return SUCCEED;
+		case ZBX_EXPRESSION_OP_OR:
+			if (ZBX_UNKNOWN == left->value)
+			{
+				if (ZBX_UNKNOWN == right->value)				/* Unknown or Unknown */
+					*left = *right;
+				else if (SUCCEED != zbx_double_compare(right->value, 0.0))	/* Unknown or 1 */
+					left->value = 1;
+			}
+			else if (ZBX_UNKNOWN == right->value)
+			{
+				if (SUCCEED != zbx_double_compare(left->value, 0.0))		/* 1 or Unknown */
+					left->value = 1;
+				else							/* 0 or Unknown */
+					*left = *right;
+			}
+			else
+			{
+				left->value = (SUCCEED != zbx_double_compare(left->value, 0.0) ||
+						SUCCEED != zbx_double_compare(right->value, 0.0));
+			}
+			return SUCCEED;
+	}
+
+	/* catch division by 0 even if 1st operand is Unknown */
+	if (ZBX_EXPRESSION_OP_DIV == op && ZBX_UNKNOWN != right->value &&
+			SUCCEED == zbx_double_compare(right->value, 0.0))
+	{
+		zbx_strlcpy(buffer, "Cannot evaluate expression: division by zero.", max_buffer_len);
+		return FAIL;
+	}
+
+	if (ZBX_UNKNOWN == right->value)		/* (anything) op Unknown */
+	{
+		*left = *right;
+		return SUCCEED;
+	}
+
+	if (ZBX_UNKNOWN == left->value)			/* Unknown op known */
+		return SUCCEED;
+
+	switch (op)
+	{
+		case ZBX_EXPRESSION_OP_MUL:
+			left->value *= right->value;
+			break;
+		case ZBX_EXPRESSION_OP_DIV:
+			left->value /= right->value;
+			break;
+		case ZBX_EXPRESSION_OP_ADD:
+			left->value += right->value;
+			break;
+		case ZBX_EXPRESSION_OP_SUB:
+			left->value -= right->value;
+			break;
+		case ZBX_EXPRESSION_OP_LT:
+			left->value = (left->value < right->value - ZBX_DOUBLE_EPSILON);
+			break;
+		case ZBX_EXPRESSION_OP_LE:
+			left->value = (left->value <= right->value + ZBX_DOUBLE_EPSILON);
+			break;
+		case ZBX_EXPRESSION_OP_GE:
+			left->value = (left->value >= right->value - ZBX_DOUBLE_EPSILON);
+			break;
+		case ZBX_EXPRESSION_OP_GT:
+			left->value = (left->value > right->value + ZBX_DOUBLE_EPSILON);
+			break;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			zbx_strlcpy(buffer, "Cannot evaluate expression: unsupported operator.", max_buffer_len);
+			return FAIL;
+	}
+
+	return ZBX_INFINITY == left->value ? FAIL : SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_expression_execute                                           *
+ *                                                                            *
+ * Purpose: execute compiled expression program                               *
+ *                                                                            *
+ * Parameters: value         - [OUT] the expression evaluation result         *
+ *             program       - [IN] the compiled program                      *
+ *             operands      - [IN] slot values in the order returned by      *
+ *                                  zbx_expression_program_functionids()      *
+ *             expression    - [IN] the source expression, used for logging   *
+ *             error         - [OUT] error message buffer                     *
+ *             max_error_len - [IN] error buffer size                         *
+ *             unknown_msgs  - [IN] messages about origins of Unknown values  *
+ *                                                                            *
+ * Return value: SUCCEED - the expression was evaluated successfully          *
+ *               FAIL    - otherwise, the error is written to error buffer    *
+ *                                                                            *
+ * Comments: the result is the same as of evaluate() for the expression with  *
+ *           substituted function results                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_expression_execute(double *value, const unsigned char *program, const zbx_expression_operand_t **operands,
+		const char *expression, char *error, size_t max_error_len, zbx_vector_ptr_t *unknown_msgs)
+{
+	zbx_expression_header_t		header;
+	zbx_expression_value_t		stack_local[ZBX_EXPRESSION_STACK_SIZE], *stack, *top;
+	const zbx_expression_operand_t	*operand;
+	const unsigned char		*pc, *end;
+	unsigned short			index;
+	int				ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() expression:'%s'", __func__, expression);
+
+	memcpy(&header, program, sizeof(header));
+
+	if (ZBX_EXPRESSION_STACK_SIZE >= header.stack_depth)
+		stack = stack_local;
+	else
+		stack = (zbx_expression_value_t *)zbx_malloc(NULL, sizeof(zbx_expression_value_t) * header.stack_depth);
+
+	buffer = error;
+	max_buffer_len = max_error_len;
+	*error = '\0';
+
+	top = stack;
+	pc = program + sizeof(header) + sizeof(zbx_uint64_t) * header.slots_num;
+	end = program + header.size;
+
+	while (pc < end)
+	{
+		unsigned char	op = *pc++;
+
+		switch (op)
+		{
+			case ZBX_EXPRESSION_OP_NUMBER:
+				memcpy(&top->value, pc, sizeof(double));
+				pc += sizeof(double);
+				top->str = NULL;
+				top->unknown_idx = -1;
+				top++;
+				break;
+			case ZBX_EXPRESSION_OP_STRING:
+				top->str = (const char *)pc;
+				pc += strlen(top->str) + 1;
+				top->value = 0;
+				top->unknown_idx = -1;
+				top++;
+				break;
+			case ZBX_EXPRESSION_OP_SLOT:
+				memcpy(&index, pc, sizeof(index));
+				pc += sizeof(index);
+				operand = operands[index];
+				top->str = operand->str;
+				top->value = operand->value;
+				top->unknown_idx = operand->unknown_idx;
+				top++;
+				break;
+			case ZBX_EXPRESSION_OP_TODBL:
+				if (SUCCEED != expression_value_to_double(top - 1))
+					goto out;
+				break;
+			case ZBX_EXPRESSION_OP_NEG:
+				if (SUCCEED != expression_value_to_double(top - 1))
+					goto out;
+
+				if (ZBX_UNKNOWN != top[-1].value)
+					top[-1].value = -top[-1].value;
+				break;
+			case ZBX_EXPRESSION_OP_NOT:
+				if (SUCCEED != expression_value_to_double(top - 1))
+					goto out;
+
+				if (ZBX_UNKNOWN != top[-1].value)
+					top[-1].value = (SUCCEED == zbx_double_compare(top[-1].value, 0.0) ? 1.0 : 0.0);
+				break;
+			default:
+				top--;
+
+				if (SUCCEED != expression_execute_binary(op, top - 1, top))
+					goto out;
+		}
+	}
+
+	if (NULL != stack->str && '\0' == *stack->str)
+	{
+		zbx_strlcpy(buffer, "Cannot evaluate expression: unexpected end of expression.", max_buffer_len);
+		goto out;
+	}
+
+	if (SUCCEED != expression_value_to_double(stack))
+		goto out;
+
+	*value = stack->value;
+
+	if (ZBX_UNKNOWN == *value)
+		evaluate_unknown_to_error(value, stack->unknown_idx, expression, error, max_error_len, unknown_msgs);
+
+	if (ZBX_INFINITY != *value)
+		ret = SUCCEED;
+out:
+	if (stack != stack_local)
+		zbx_free(stack);
+
+	if (SUCCEED == ret)
+		zabbix_log(LOG_LEVEL_DEBUG, "End of %s() value:" ZBX_FS_DBL, __func__, *value);
+	else
+		zabbix_log(LOG_LEVEL_DEBUG, "End of %s() error:'%s'", __func__, error);
+
+	return ret;
+}
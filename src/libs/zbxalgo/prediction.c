@@ -28,6 +28,12 @@
 
 #define ZBX_IS_NAN(x)	((x) != (x))
 
+/* the maximal number of fit coefficients (polynomial of the 6th degree) */
+#define ZBX_MAX_COEFFICIENTS	7
+
+/* the number of independent partial sums used when summing data points */
+#define ZBX_SUM_LANES		4
+
 #define ZBX_VALID_MATRIX(m)		(0 < (m)->rows && 0 < (m)->columns && NULL != (m)->elements)
 #define ZBX_MATRIX_EL(m, row, col)	((m)->elements[(row) * (m)->columns + (col)])
 #define ZBX_MATRIX_ROW(m, row)		((m)->elements + (row) * (m)->columns)
@@ -102,26 +108,6 @@ static int	zbx_identity_matrix(zbx_matrix_t *m, int n)
 	return SUCCEED;
 }
 
-static int	zbx_transpose_matrix(zbx_matrix_t *m, zbx_matrix_t *r)
-{
-	int	i, j;
-
-	if (!ZBX_VALID_MATRIX(m))
-		goto error;
-
-	if (SUCCEED != zbx_matrix_alloc(r, m->columns, m->rows))
-		return FAIL;
-
-	for (i = 0; i < r->rows; i++)
-		for (j = 0; j < r->columns; j++)
-			ZBX_MATRIX_EL(r, i, j) = ZBX_MATRIX_EL(m, j, i);
-
-	return SUCCEED;
-error:
-	THIS_SHOULD_NEVER_HAPPEN;
-	return FAIL;
-}
-
 static void	zbx_matrix_swap_rows(zbx_matrix_t *m, int r1, int r2)
 {
 	double	tmp;
@@ -298,122 +284,104 @@ error:
 	return FAIL;
 }
 
-static int	zbx_least_squares(zbx_matrix_t *independent, zbx_matrix_t *dependent, zbx_matrix_t *coefficients)
-{
-	/*                         |<----------to_be_inverted---------->|                                          */
-	/* coefficients = inverse( transpose( independent ) * independent ) * transpose( independent ) * dependent */
-	/*                |<------------------left_part------------------>|   |<-----------right_part----------->| */
-	/*           we change order of matrix multiplication to reduce operation count and memory usage           */
-	zbx_matrix_t	*independent_transposed = NULL, *to_be_inverted = NULL, *left_part = NULL, *right_part = NULL;
-	int		res;
-
-	zbx_matrix_struct_alloc(&independent_transposed);
-	zbx_matrix_struct_alloc(&to_be_inverted);
-	zbx_matrix_struct_alloc(&left_part);
-	zbx_matrix_struct_alloc(&right_part);
-
-	if (SUCCEED != (res = zbx_transpose_matrix(independent, independent_transposed)))
-		goto out;
-
-	if (SUCCEED != (res = zbx_matrix_mult(independent_transposed, independent, to_be_inverted)))
-		goto out;
-
-	if (SUCCEED != (res = zbx_inverse_matrix(to_be_inverted, left_part)))
-		goto out;
-
-	if (SUCCEED != (res = zbx_matrix_mult(independent_transposed, dependent, right_part)))
-		goto out;
-
-	if (SUCCEED != (res = zbx_matrix_mult(left_part, right_part, coefficients)))
-		goto out;
-
-out:
-	zbx_matrix_free(independent_transposed);
-	zbx_matrix_free(to_be_inverted);
-	zbx_matrix_free(left_part);
-	zbx_matrix_free(right_part);
-	return res;
-}
-
-static int	zbx_fill_dependent(double *x, int n, zbx_fit_t fit, zbx_matrix_t *m)
+static int	zbx_fill_normal_equations(double *t, double *x, int n, zbx_fit_t fit, int k, zbx_matrix_t *left,
+		zbx_matrix_t *right)
 {
-	int	i;
-
-	if (FIT_LINEAR == fit || FIT_POLYNOMIAL == fit || FIT_LOGARITHMIC == fit)
+	/* Normal equations of least squares fit are built directly from power sums of independent variable:  */
+	/* left[i][j] = sum(u^(i+j)), right[i] = sum(u^i * y), where u and y are independent and dependent    */
+	/* variables after fit specific transformation. The sums are accumulated in ZBX_SUM_LANES independent */
+	/* lanes with fixed trip count inner loops, which allows the compiler to vectorize them.              */
+	double	powers[2 * ZBX_MAX_COEFFICIENTS - 1][ZBX_SUM_LANES], products[ZBX_MAX_COEFFICIENTS][ZBX_SUM_LANES];
+	double	u[ZBX_SUM_LANES], y[ZBX_SUM_LANES], pw[ZBX_SUM_LANES], sum;
+	int	i, j, l, p, coefficients;
+
+	if (FIT_POLYNOMIAL == fit)
 	{
-		if (SUCCEED != zbx_matrix_alloc(m, n, 1))
-			return FAIL;
+		if (k > n - 1)
+			k = n - 1;
 
-		for (i = 0; i < n; i++)
-			ZBX_MATRIX_EL(m, i, 0) = x[i];
+		coefficients = k + 1;
 	}
-	else if (FIT_EXPONENTIAL == fit || FIT_POWER == fit)
+	else
+		coefficients = 2;
+
+	if (SUCCEED != zbx_matrix_alloc(left, coefficients, coefficients) ||
+			SUCCEED != zbx_matrix_alloc(right, coefficients, 1))
 	{
-		if (SUCCEED != zbx_matrix_alloc(m, n, 1))
-			return FAIL;
+		return FAIL;
+	}
 
-		for (i = 0; i < n; i++)
+	memset(powers, 0, sizeof(powers));
+	memset(products, 0, sizeof(products));
+
+	for (i = 0; i < n; i += ZBX_SUM_LANES)
+	{
+		for (l = 0; l < ZBX_SUM_LANES; l++)
 		{
-			if (0.0 >= x[i])
+			/* pad the last incomplete block with zero weight points */
+			if (i + l >= n)
 			{
-				zabbix_log(LOG_LEVEL_DEBUG, "data contains negative or zero values");
-				return FAIL;
+				u[l] = 0.0;
+				y[l] = 0.0;
+				pw[l] = 0.0;
+				continue;
 			}
 
-			ZBX_MATRIX_EL(m, i, 0) = log(x[i]);
-		}
-	}
+			if (FIT_EXPONENTIAL == fit || FIT_POWER == fit)
+			{
+				if (0.0 >= x[i + l])
+				{
+					zabbix_log(LOG_LEVEL_DEBUG, "data contains negative or zero values");
+					return FAIL;
+				}
 
-	return SUCCEED;
-}
+				y[l] = log(x[i + l]);
+			}
+			else
+				y[l] = x[i + l];
 
-static int	zbx_fill_independent(double *t, int n, zbx_fit_t fit, int k, zbx_matrix_t *m)
-{
-	double	element;
-	int	i, j;
+			if (FIT_LOGARITHMIC == fit || FIT_POWER == fit)
+				u[l] = log(t[i + l]);
+			else
+				u[l] = t[i + l];
 
-	if (FIT_LINEAR == fit || FIT_EXPONENTIAL == fit)
-	{
-		if (SUCCEED != zbx_matrix_alloc(m, n, 2))
-			return FAIL;
+			pw[l] = 1.0;
+		}
 
-		for (i = 0; i < n; i++)
+		for (p = 0; p < coefficients; p++)
 		{
-			ZBX_MATRIX_EL(m, i, 0) = 1.0;
-			ZBX_MATRIX_EL(m, i, 1) = t[i];
+			for (l = 0; l < ZBX_SUM_LANES; l++)
+			{
+				powers[p][l] += pw[l];
+				products[p][l] += pw[l] * y[l];
+				pw[l] *= u[l];
+			}
 		}
-	}
-	else if (FIT_LOGARITHMIC == fit || FIT_POWER == fit)
-	{
-		if (SUCCEED != zbx_matrix_alloc(m, n, 2))
-			return FAIL;
 
-		for (i = 0; i < n; i++)
+		for (; p < 2 * coefficients - 1; p++)
 		{
-			ZBX_MATRIX_EL(m, i, 0) = 1.0;
-			ZBX_MATRIX_EL(m, i, 1) = log(t[i]);
+			for (l = 0; l < ZBX_SUM_LANES; l++)
+			{
+				powers[p][l] += pw[l];
+				pw[l] *= u[l];
+			}
 		}
 	}
-	else if (FIT_POLYNOMIAL == fit)
-	{
-		if (k > n - 1)
-			k = n - 1;
-
-		if (SUCCEED != zbx_matrix_alloc(m, n, k+1))
-			return FAIL;
 
-		for (i = 0; i < n; i++)
+	for (i = 0; i < coefficients; i++)
+	{
+		for (j = 0; j < coefficients; j++)
 		{
-			element = 1.0;
-
-			for (j = 0; j < k; j++)
-			{
-				ZBX_MATRIX_EL(m, i, j) = element;
-				element *= t[i];
-			}
+			for (sum = 0.0, l = 0; l < ZBX_SUM_LANES; l++)
+				sum += powers[i + j][l];
 
-			ZBX_MATRIX_EL(m, i, k) = element;
+			ZBX_MATRIX_EL(left, i, j) = sum;
 		}
+
+		for (sum = 0.0, l = 0; l < ZBX_SUM_LANES; l++)
+			sum += products[i][l];
+
+		ZBX_MATRIX_EL(right, i, 0) = sum;
 	}
 
 	return SUCCEED;
@@ -421,24 +389,28 @@ static int	zbx_fill_independent(double *t, int n, zbx_fit_t fit, int k, zbx_matr
 
 static int	zbx_regression(double *t, double *x, int n, zbx_fit_t fit, int k, zbx_matrix_t *coefficients)
 {
-	zbx_matrix_t	*independent = NULL, *dependent = NULL;
+	/* coefficients = inverse( transpose( independent ) * independent ) * transpose( independent ) * dependent */
+	/*                         |<--------------left---------------->|   |<-------------right-------------->| */
+	zbx_matrix_t	*left = NULL, *right = NULL, *left_inverted = NULL;
 	int		res;
 
-	zbx_matrix_struct_alloc(&independent);
-	zbx_matrix_struct_alloc(&dependent);
+	zbx_matrix_struct_alloc(&left);
+	zbx_matrix_struct_alloc(&right);
+	zbx_matrix_struct_alloc(&left_inverted);
 
-	if (SUCCEED != (res = zbx_fill_independent(t, n, fit, k, independent)))
+	if (SUCCEED != (res = zbx_fill_normal_equations(t, x, n, fit, k, left, right)))
 		goto out;
 
-	if (SUCCEED != (res = zbx_fill_dependent(x, n, fit, dependent)))
+	if (SUCCEED != (res = zbx_inverse_matrix(left, left_inverted)))
 		goto out;
 
-	if (SUCCEED != (res = zbx_least_squares(independent, dependent, coefficients)))
+	if (SUCCEED != (res = zbx_matrix_mult(left_inverted, right, coefficients)))
 		goto out;
 
 out:
-	zbx_matrix_free(independent);
-	zbx_matrix_free(dependent);
+	zbx_matrix_free(left);
+	zbx_matrix_free(right);
+	zbx_matrix_free(left_inverted);
 	return res;
 }
 
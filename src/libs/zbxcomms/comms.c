@@ -23,6 +23,10 @@
 #include "../zbxcrypto/tls_tcp.h"
 #include "zbxcompress.h"
 
+#ifndef _WINDOWS
+#	include <poll.h>
+#endif
+
 #ifdef _WINDOWS
 #	ifndef _WIN32_WINNT_WIN7
 #		define _WIN32_WINNT_WIN7		0x0601	/* allow compilation on older Windows systems */
@@ -43,6 +47,14 @@
 #	define SOCK_CLOEXEC 0	/* SOCK_CLOEXEC is Linux-specific, available since 2.6.23 */
 #endif
 
+#define ZBX_TCP_EXPECT_HEADER		1
+#define ZBX_TCP_EXPECT_VERSION		2
+#define ZBX_TCP_EXPECT_VERSION_VALIDATE	3
+#define ZBX_TCP_EXPECT_LENGTH		4
+#define ZBX_TCP_EXPECT_SIZE		5
+
+#define ZBX_TCP_RECV_CHUNK_SIZE		(128 * ZBX_KIBIBYTE)
+
 #ifdef HAVE_OPENSSL
 extern ZBX_THREAD_LOCAL char	info_buf[256];
 #endif
@@ -351,7 +363,7 @@ static void	zbx_socket_free(zbx_socket_t *s)
  * Author: Alexander Vladishev                                                *
  *                                                                            *
  ******************************************************************************/
-static void	zbx_socket_timeout_set(zbx_socket_t *s, int timeout)
+void	zbx_socket_timeout_set(zbx_socket_t *s, int timeout)
 {
 	s->timeout = timeout;
 #ifdef _WINDOWS
@@ -384,7 +396,7 @@ static void	zbx_socket_timeout_set(zbx_socket_t *s, int timeout)
  * Author: Alexander Vladishev                                                *
  *                                                                            *
  ******************************************************************************/
-static void	zbx_socket_timeout_cleanup(zbx_socket_t *s)
+void	zbx_socket_timeout_cleanup(zbx_socket_t *s)
 {
 #ifndef _WINDOWS
 	if (0 != s->timeout)
@@ -985,10 +997,18 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_tcp_listen                                                   *
+ * Function: zbx_tcp_listen_ext                                               *
  *                                                                            *
  * Purpose: create socket for listening                                       *
  *                                                                            *
+ * Parameters: s           - [OUT] the listening socket                       *
+ *             listen_ip   - [IN] comma separated list of addresses, optional *
+ *             listen_port - [IN] the port to listen on                       *
+ *             flags       - [IN] ZBX_TCP_LISTEN_REUSEPORT - allow other      *
+ *                                processes to listen on the same address and *
+ *                                port (ignored where SO_REUSEPORT is not     *
+ *                                supported)                                  *
+ *                                                                            *
  * Return value: SUCCEED - success                                            *
  *               FAIL - an error occurred                                     *
  *                                                                            *
@@ -996,7 +1016,7 @@ out:
  *                                                                            *
  ******************************************************************************/
 #ifdef HAVE_IPV6
-int	zbx_tcp_listen(zbx_socket_t *s, const char *listen_ip, unsigned short listen_port)
+int	zbx_tcp_listen_ext(zbx_socket_t *s, const char *listen_ip, unsigned short listen_port, int flags)
 {
 	struct addrinfo	hints, *ai = NULL, *current_ai;
 	char		port[8], *ip, *ips, *delim;
@@ -1116,6 +1136,17 @@ int	zbx_tcp_listen(zbx_socket_t *s, const char *listen_ip, unsigned short listen
 						"SO_REUSEADDR", ip ? ip : "-", port,
 						strerror_from_system(zbx_socket_last_error()));
 			}
+#	ifdef SO_REUSEPORT
+			/* allow several processes to listen on the same address, with kernel */
+			/* distributing incoming connections between their sockets            */
+			if (0 != (flags & ZBX_TCP_LISTEN_REUSEPORT) && ZBX_PROTO_ERROR == setsockopt(
+					s->sockets[s->num_socks], SOL_SOCKET, SO_REUSEPORT, (void *)&on, sizeof(on)))
+			{
+				zbx_set_socket_strerror("setsockopt() with %s for [[%s]:%s] failed: %s",
+						"SO_REUSEPORT", ip ? ip : "-", port,
+						strerror_from_system(zbx_socket_last_error()));
+			}
+#	endif
 #endif
 
 #if defined(IPPROTO_IPV6) && defined(IPV6_V6ONLY)
@@ -1192,7 +1223,7 @@ out:
 	return ret;
 }
 #else
-int	zbx_tcp_listen(zbx_socket_t *s, const char *listen_ip, unsigned short listen_port)
+int	zbx_tcp_listen_ext(zbx_socket_t *s, const char *listen_ip, unsigned short listen_port, int flags)
 {
 	ZBX_SOCKADDR	serv_addr;
 	char		*ip, *ips, *delim;
@@ -1290,6 +1321,16 @@ int	zbx_tcp_listen(zbx_socket_t *s, const char *listen_ip, unsigned short listen
 			zbx_set_socket_strerror("setsockopt() with %s for [[%s]:%hu] failed: %s", "SO_REUSEADDR",
 					ip ? ip : "-", listen_port, strerror_from_system(zbx_socket_last_error()));
 		}
+#	ifdef SO_REUSEPORT
+		/* allow several processes to listen on the same address, with kernel */
+		/* distributing incoming connections between their sockets            */
+		if (0 != (flags & ZBX_TCP_LISTEN_REUSEPORT) && ZBX_PROTO_ERROR == setsockopt(s->sockets[s->num_socks],
+				SOL_SOCKET, SO_REUSEPORT, (void *)&on, sizeof(on)))
+		{
+			zbx_set_socket_strerror("setsockopt() with %s for [[%s]:%hu] failed: %s", "SO_REUSEPORT",
+					ip ? ip : "-", listen_port, strerror_from_system(zbx_socket_last_error()));
+		}
+#	endif
 #endif
 		memset(&serv_addr, 0, sizeof(serv_addr));
 
@@ -1343,6 +1384,86 @@ out:
 }
 #endif	/* HAVE_IPV6 */
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_accept_tls                                               *
+ *                                                                            *
+ * Purpose: detect type of accepted connection and perform TLS handshake if   *
+ *          the connection is encrypted                                       *
+ *                                                                            *
+ * Parameters: s          - [IN/OUT] the accepted connection                  *
+ *             tls_accept - [IN] the allowed connection types                 *
+ *                                                                            *
+ * Return value: SUCCEED - success                                            *
+ *               FAIL - an error occurred, the connection is closed           *
+ *                                                                            *
+ * Comments: The first byte of the connection must be available, nonblocking  *
+ *           sockets are switched to blocking mode for TLS handshake.         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_accept_tls(zbx_socket_t *s, unsigned int tls_accept)
+{
+	ssize_t		res;
+	unsigned char	buf;	/* 1 byte buffer */
+
+	if (ZBX_SOCKET_ERROR == (res = recv(s->socket, &buf, 1, MSG_PEEK)))
+	{
+		zbx_set_socket_strerror("from %s: reading first byte from connection failed: %s", s->peer,
+				strerror_from_system(zbx_socket_last_error()));
+		zbx_tcp_unaccept(s);
+		return FAIL;
+	}
+
+	/* if the 1st byte is 0x16 then assume it's a TLS connection */
+	if (1 == res && '\x16' == buf)
+	{
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+		if (0 != (tls_accept & (ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK)))
+		{
+			char	*error = NULL;
+#ifndef _WINDOWS
+			/* TLS handshake is performed in blocking mode */
+			if (SUCCEED != zbx_socket_set_blocking(s->socket))
+			{
+				zbx_tcp_unaccept(s);
+				return FAIL;
+			}
+#endif
+			if (SUCCEED != zbx_tls_accept(s, tls_accept, &error))
+			{
+				zbx_set_socket_strerror("from %s: %s", s->peer, error);
+				zbx_tcp_unaccept(s);
+				zbx_free(error);
+				return FAIL;
+			}
+		}
+		else
+		{
+			zbx_set_socket_strerror("from %s: TLS connections are not allowed", s->peer);
+			zbx_tcp_unaccept(s);
+			return FAIL;
+		}
+#else
+		zbx_set_socket_strerror("from %s: support for TLS was not compiled in", s->peer);
+		zbx_tcp_unaccept(s);
+		return FAIL;
+#endif
+	}
+	else
+	{
+		if (0 == (tls_accept & ZBX_TCP_SEC_UNENCRYPTED))
+		{
+			zbx_set_socket_strerror("from %s: unencrypted connections are not allowed", s->peer);
+			zbx_tcp_unaccept(s);
+			return FAIL;
+		}
+
+		s->connection_type = ZBX_TCP_SEC_UNENCRYPTED;
+	}
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_tcp_accept                                                   *
@@ -1362,8 +1483,6 @@ int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept)
 	ZBX_SOCKET	accepted_socket;
 	ZBX_SOCKLEN_T	nlen;
 	int		i, n = 0, ret = FAIL;
-	ssize_t		res;
-	unsigned char	buf;	/* 1 byte buffer */
 
 	zbx_tcp_unaccept(s);
 
@@ -1413,60 +1532,123 @@ int	zbx_tcp_accept(zbx_socket_t *s, unsigned int tls_accept)
 
 	zbx_socket_timeout_set(s, CONFIG_TIMEOUT);
 
-	if (ZBX_SOCKET_ERROR == (res = recv(s->socket, &buf, 1, MSG_PEEK)))
+	ret = zbx_tcp_accept_tls(s, tls_accept);
+out:
+	zbx_socket_timeout_cleanup(s);
+
+	return ret;
+}
+
+#ifndef _WINDOWS
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_socket_set_nonblocking                                       *
+ *                                                                            *
+ * Purpose: switch socket to nonblocking mode                                 *
+ *                                                                            *
+ * Return value: SUCCEED - success                                            *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_socket_set_nonblocking(ZBX_SOCKET s)
+{
+	int	flags;
+
+	if (-1 == (flags = fcntl(s, F_GETFL, 0)) || -1 == fcntl(s, F_SETFL, flags | O_NONBLOCK))
 	{
-		zbx_set_socket_strerror("from %s: reading first byte from connection failed: %s", s->peer,
+		zbx_set_socket_strerror("cannot set socket to nonblocking mode: %s",
 				strerror_from_system(zbx_socket_last_error()));
-		zbx_tcp_unaccept(s);
-		goto out;
+		return FAIL;
 	}
 
-	/* if the 1st byte is 0x16 then assume it's a TLS connection */
-	if (1 == res && '\x16' == buf)
-	{
-#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-		if (0 != (tls_accept & (ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK)))
-		{
-			char	*error = NULL;
+	return SUCCEED;
+}
 
-			if (SUCCEED != zbx_tls_accept(s, tls_accept, &error))
-			{
-				zbx_set_socket_strerror("from %s: %s", s->peer, error);
-				zbx_tcp_unaccept(s);
-				zbx_free(error);
-				goto out;
-			}
-		}
-		else
-		{
-			zbx_set_socket_strerror("from %s: TLS connections are not allowed", s->peer);
-			zbx_tcp_unaccept(s);
-			goto out;
-		}
-#else
-		zbx_set_socket_strerror("from %s: support for TLS was not compiled in", s->peer);
-		zbx_tcp_unaccept(s);
-		goto out;
-#endif
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_socket_set_blocking                                          *
+ *                                                                            *
+ * Purpose: switch socket to blocking mode                                    *
+ *                                                                            *
+ * Return value: SUCCEED - success                                            *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_socket_set_blocking(ZBX_SOCKET s)
+{
+	int	flags;
+
+	if (-1 == (flags = fcntl(s, F_GETFL, 0)) || -1 == fcntl(s, F_SETFL, flags & ~O_NONBLOCK))
+	{
+		zbx_set_socket_strerror("cannot set socket to blocking mode: %s",
+				strerror_from_system(zbx_socket_last_error()));
+		return FAIL;
 	}
-	else
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_accept_nonblocking                                       *
+ *                                                                            *
+ * Purpose: accept incoming connection on the specified listening socket      *
+ *          without blocking                                                  *
+ *                                                                            *
+ * Parameters: s      - [IN] the listening socket                             *
+ *             index  - [IN] index of the listening socket descriptor         *
+ *             conn   - [OUT] the accepted nonblocking connection             *
+ *             events - [OUT] set to POLLIN if there are no pending           *
+ *                            connections                                     *
+ *                                                                            *
+ * Return value: SUCCEED - the connection was accepted                        *
+ *               FAIL - an error occurred or there are no pending connections *
+ *                      (in this case events are set)                         *
+ *                                                                            *
+ * Comments: The connection type is not known yet, zbx_tcp_accept_tls() must  *
+ *           be called when the connection becomes readable.                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_accept_nonblocking(const zbx_socket_t *s, int index, zbx_socket_t *conn, short *events)
+{
+	ZBX_SOCKADDR	serv_addr;
+	ZBX_SOCKET	accepted_socket;
+	ZBX_SOCKLEN_T	nlen;
+	int		err;
+
+	*events = 0;
+
+	nlen = sizeof(serv_addr);
+	if (ZBX_SOCKET_ERROR == (accepted_socket = (ZBX_SOCKET)accept(s->sockets[index],
+			(struct sockaddr *)&serv_addr, &nlen)))
 	{
-		if (0 == (tls_accept & ZBX_TCP_SEC_UNENCRYPTED))
+		/* other process may have accepted the connection first */
+		if (EAGAIN == (err = zbx_socket_last_error()) || EWOULDBLOCK == err || EINTR == err ||
+				ECONNABORTED == err)
 		{
-			zbx_set_socket_strerror("from %s: unencrypted connections are not allowed", s->peer);
-			zbx_tcp_unaccept(s);
-			goto out;
+			*events = POLLIN;
 		}
+		else
+			zbx_set_socket_strerror("accept() failed: %s", strerror_from_system(err));
 
-		s->connection_type = ZBX_TCP_SEC_UNENCRYPTED;
+		return FAIL;
 	}
 
-	ret = SUCCEED;
-out:
-	zbx_socket_timeout_cleanup(s);
+	zbx_socket_clean(conn);
+	conn->socket = accepted_socket;
+	conn->socket_orig = ZBX_SOCKET_ERROR;
+	conn->accepted = 1;
+	conn->buffer = conn->buf_stat;
 
-	return ret;
+	if (SUCCEED != zbx_socket_set_nonblocking(accepted_socket) || SUCCEED != zbx_socket_peer_ip_save(conn))
+	{
+		zbx_tcp_unaccept(conn);
+		return FAIL;
+	}
+
+	return SUCCEED;
 }
+#endif
 
 /******************************************************************************
  *                                                                            *
@@ -1654,7 +1836,24 @@ out:
 	return line;
 }
 
-static ssize_t	zbx_tcp_read(zbx_socket_t *s, char *buf, size_t len)
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_read                                                     *
+ *                                                                            *
+ * Purpose: read data from socket                                             *
+ *                                                                            *
+ * Parameters: s      - [IN] the socket                                       *
+ *             buf    - [OUT] the read data                                   *
+ *             len    - [IN] the buffer size                                  *
+ *             events - [OUT] set to POLLIN if nonblocking socket has no data *
+ *                            available, optional                             *
+ *                                                                            *
+ * Return value: number of bytes read - success,                              *
+ *               ZBX_PROTO_ERROR - an error occurred or no data is available  *
+ *                                 on nonblocking socket                      *
+ *                                                                            *
+ ******************************************************************************/
+static ssize_t	zbx_tcp_read(zbx_socket_t *s, char *buf, size_t len, short *events)
 {
 	ssize_t	res;
 	int	err;
@@ -1695,67 +1894,158 @@ static ssize_t	zbx_tcp_read(zbx_socket_t *s, char *buf, size_t len)
 	while (ZBX_PROTO_ERROR == res && ZBX_PROTO_AGAIN == (err = zbx_socket_last_error()));
 
 	if (ZBX_PROTO_ERROR == res)
+	{
+#ifndef _WINDOWS
+		if (NULL != events && (EAGAIN == err || EWOULDBLOCK == err))
+		{
+			*events = POLLIN;
+			return res;
+		}
+#else
+		ZBX_UNUSED(events);
+#endif
 		zbx_set_socket_strerror("ZBX_TCP_READ() failed: %s", strerror_from_system(err));
+	}
 
 	return res;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_tcp_recv_ext                                                 *
- *                                                                            *
- * Purpose: receive data                                                      *
+ * Function: zbx_tcp_recv_context_init                                        *
  *                                                                            *
- * Return value: number of bytes received - success,                          *
- *               FAIL - an error occurred                                     *
+ * Purpose: prepare socket and receive context for a new message              *
  *                                                                            *
- * Author: Eugene Grigorjev                                                   *
+ * Parameters: s       - [IN/OUT] the socket                                  *
+ *             context - [OUT] the receive context                            *
  *                                                                            *
  ******************************************************************************/
-ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout)
+void	zbx_tcp_recv_context_init(zbx_socket_t *s, zbx_tcp_recv_context_t *context)
 {
-#define ZBX_TCP_EXPECT_HEADER		1
-#define ZBX_TCP_EXPECT_VERSION		2
-#define ZBX_TCP_EXPECT_VERSION_VALIDATE	3
-#define ZBX_TCP_EXPECT_LENGTH		4
-#define ZBX_TCP_EXPECT_SIZE		5
-
-	ssize_t		nbytes;
-	size_t		buf_dyn_bytes = 0, buf_stat_bytes = 0, offset = 0;
-	zbx_uint32_t	expected_len = 16 * ZBX_MEBIBYTE, reserved = 0;
-	unsigned char	expect = ZBX_TCP_EXPECT_HEADER;
-	int		protocol_version;
-
-	if (0 != timeout)
-		zbx_socket_timeout_set(s, timeout);
+	context->buf_dyn_bytes = 0;
+	context->buf_stat_bytes = 0;
+	context->offset = 0;
+	context->expected_len = 16 * ZBX_MEBIBYTE;
+	context->reserved = 0;
+	context->expect = ZBX_TCP_EXPECT_HEADER;
+	context->protocol_version = 0;
+	context->chunk = NULL;
+	context->stream = NULL;
 
 	zbx_socket_free(s);
 
 	s->buf_type = ZBX_BUF_TYPE_STAT;
 	s->buffer = s->buf_stat;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_recv_context_clear                                       *
+ *                                                                            *
+ * Purpose: release resources of receive context                              *
+ *                                                                            *
+ * Parameters: context - [IN] the receive context                             *
+ *                                                                            *
+ * Comments: Must be called if receiving is abandoned before the message is   *
+ *           complete, e.g. when nonblocking connection times out.            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_tcp_recv_context_clear(zbx_tcp_recv_context_t *context)
+{
+	if (NULL != context->stream)
+	{
+		zbx_uncompress_stream_free(context->stream);
+		context->stream = NULL;
+	}
+
+	zbx_free(context->chunk);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_recv_context                                             *
+ *                                                                            *
+ * Purpose: receive data, resuming from the state stored in context           *
+ *                                                                            *
+ * Parameters: s       - [IN/OUT] the socket                                  *
+ *             context - [IN/OUT] the receive context                         *
+ *             events  - [OUT] the events to wait for before calling again,   *
+ *                             optional (for nonblocking sockets)             *
+ *                                                                            *
+ * Return value: number of bytes received - success,                          *
+ *               FAIL - an error occurred or more data is expected (in this   *
+ *                      case events are set)                                  *
+ *                                                                            *
+ * Comments: With nonblocking socket the function returns FAIL with events    *
+ *           set to POLLIN when no more data is available yet. The received   *
+ *           data is kept in socket and context, so the function must be      *
+ *           called again when the socket becomes readable.                   *
+ *                                                                            *
+ ******************************************************************************/
+ssize_t	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, short *events)
+{
+	ssize_t	nbytes;
+	size_t	recv_size;
+	char	*recv_buf;
+
+	if (NULL != events)
+		*events = 0;
 
-	while (0 != (nbytes = zbx_tcp_read(s, s->buf_stat + buf_stat_bytes, sizeof(s->buf_stat) - buf_stat_bytes)))
+	for (;;)
 	{
+		if (ZBX_BUF_TYPE_STAT == s->buf_type)
+		{
+			recv_buf = s->buf_stat + context->buf_stat_bytes;
+			recv_size = sizeof(s->buf_stat) - context->buf_stat_bytes;
+		}
+		else if (NULL != context->stream)
+		{
+			recv_buf = context->chunk;
+			recv_size = ZBX_TCP_RECV_CHUNK_SIZE;
+		}
+		else
+		{
+			/* read directly into the message buffer, reserving the terminating zero */
+			/* space to detect messages longer than expected                         */
+			recv_buf = s->buffer + context->buf_dyn_bytes;
+			recv_size = context->expected_len + 1 - context->buf_dyn_bytes;
+		}
+
+		if (0 == (nbytes = zbx_tcp_read(s, recv_buf, recv_size, events)))
+			break;
+
 		if (ZBX_PROTO_ERROR == nbytes)
+		{
+			if (NULL != events && 0 != *events)
+				return FAIL;
+
 			goto out;
+		}
 
 		if (ZBX_BUF_TYPE_STAT == s->buf_type)
-			buf_stat_bytes += nbytes;
+			context->buf_stat_bytes += nbytes;
 		else
 		{
-			if (buf_dyn_bytes + nbytes <= expected_len)
-				memcpy(s->buffer + buf_dyn_bytes, s->buf_stat, nbytes);
-			buf_dyn_bytes += nbytes;
+			if (NULL != context->stream && context->buf_dyn_bytes < context->expected_len &&
+					SUCCEED != zbx_uncompress_stream_append(context->stream, context->chunk,
+					MIN((size_t)nbytes, context->expected_len - context->buf_dyn_bytes)))
+			{
+				zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
+				nbytes = ZBX_PROTO_ERROR;
+				goto out;
+			}
+
+			context->buf_dyn_bytes += nbytes;
 		}
 
-		if (buf_stat_bytes + buf_dyn_bytes >= expected_len)
+		if (context->buf_stat_bytes + context->buf_dyn_bytes >= context->expected_len)
 			break;
 
-		if (ZBX_TCP_EXPECT_HEADER == expect)
+		if (ZBX_TCP_EXPECT_HEADER == context->expect)
 		{
-			if (ZBX_TCP_HEADER_LEN > buf_stat_bytes)
+			if (ZBX_TCP_HEADER_LEN > context->buf_stat_bytes)
 			{
-				if (0 == strncmp(s->buf_stat, ZBX_TCP_HEADER_DATA, buf_stat_bytes))
+				if (0 == strncmp(s->buf_stat, ZBX_TCP_HEADER_DATA, context->buf_stat_bytes))
 					continue;
 
 				break;
@@ -1768,96 +2058,148 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout)
 					break;
 				}
 
-				expect = ZBX_TCP_EXPECT_VERSION;
-				offset += ZBX_TCP_HEADER_LEN;
+				context->expect = ZBX_TCP_EXPECT_VERSION;
+				context->offset += ZBX_TCP_HEADER_LEN;
 			}
 		}
 
-		if (ZBX_TCP_EXPECT_VERSION == expect)
+		if (ZBX_TCP_EXPECT_VERSION == context->expect)
 		{
-			if (offset + 1 > buf_stat_bytes)
+			if (context->offset + 1 > context->buf_stat_bytes)
 				continue;
 
-			expect = ZBX_TCP_EXPECT_VERSION_VALIDATE;
-			protocol_version = s->buf_stat[ZBX_TCP_HEADER_LEN];
+			context->expect = ZBX_TCP_EXPECT_VERSION_VALIDATE;
+			context->protocol_version = s->buf_stat[ZBX_TCP_HEADER_LEN];
 
-			if (0 == (protocol_version & ZBX_TCP_PROTOCOL) ||
-					protocol_version > (ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS))
+			if (0 == (context->protocol_version & ZBX_TCP_PROTOCOL) ||
+					context->protocol_version > (ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS))
 			{
 				/* invalid protocol version, abort receiving */
 				break;
 			}
-			s->protocol = protocol_version;
-			expect = ZBX_TCP_EXPECT_LENGTH;
-			offset++;
+			s->protocol = context->protocol_version;
+			context->expect = ZBX_TCP_EXPECT_LENGTH;
+			context->offset++;
 		}
 
-		if (ZBX_TCP_EXPECT_LENGTH == expect)
+		if (ZBX_TCP_EXPECT_LENGTH == context->expect)
 		{
-			if (offset + 2 * sizeof(zbx_uint32_t) > buf_stat_bytes)
+			if (context->offset + 2 * sizeof(zbx_uint32_t) > context->buf_stat_bytes)
 				continue;
 
-			memcpy(&expected_len, s->buf_stat + offset, sizeof(zbx_uint32_t));
-			offset += sizeof(zbx_uint32_t);
-			expected_len = zbx_letoh_uint32(expected_len);
+			memcpy(&context->expected_len, s->buf_stat + context->offset, sizeof(zbx_uint32_t));
+			context->offset += sizeof(zbx_uint32_t);
+			context->expected_len = zbx_letoh_uint32(context->expected_len);
 
-			memcpy(&reserved, s->buf_stat + offset, sizeof(zbx_uint32_t));
-			offset += sizeof(zbx_uint32_t);
-			reserved = zbx_letoh_uint32(reserved);
+			memcpy(&context->reserved, s->buf_stat + context->offset, sizeof(zbx_uint32_t));
+			context->offset += sizeof(zbx_uint32_t);
+			context->reserved = zbx_letoh_uint32(context->reserved);
 
-			if (ZBX_MAX_RECV_DATA_SIZE < expected_len)
+			if (ZBX_MAX_RECV_DATA_SIZE < context->expected_len)
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "Message size " ZBX_FS_UI64 " from %s exceeds the "
 						"maximum size " ZBX_FS_UI64 " bytes. Message ignored.",
-						(zbx_uint64_t)expected_len, s->peer,
+						(zbx_uint64_t)context->expected_len, s->peer,
 						(zbx_uint64_t)ZBX_MAX_RECV_DATA_SIZE);
 				nbytes = ZBX_PROTO_ERROR;
 				goto out;
 			}
 
 			/* compressed protocol stores uncompressed packet size in the reserved data */
-			if (0 != (protocol_version & ZBX_TCP_COMPRESS) && ZBX_MAX_RECV_DATA_SIZE < reserved)
+			if (0 != (context->protocol_version & ZBX_TCP_COMPRESS) &&
+					ZBX_MAX_RECV_DATA_SIZE < context->reserved)
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "Uncompressed message size " ZBX_FS_UI64
 						" from %s exceeds the maximum size " ZBX_FS_UI64
-						" bytes. Message ignored.", (zbx_uint64_t)reserved, s->peer,
+						" bytes. Message ignored.", (zbx_uint64_t)context->reserved, s->peer,
 						(zbx_uint64_t)ZBX_MAX_RECV_DATA_SIZE);
 				nbytes = ZBX_PROTO_ERROR;
 				goto out;
 			}
 
-			if (sizeof(s->buf_stat) > expected_len)
+			if (sizeof(s->buf_stat) > context->expected_len)
+			{
+				context->buf_stat_bytes -= context->offset;
+				memmove(s->buf_stat, s->buf_stat + context->offset, context->buf_stat_bytes);
+			}
+			else if (0 != (context->protocol_version & ZBX_TCP_COMPRESS))
 			{
-				buf_stat_bytes -= offset;
-				memmove(s->buf_stat, s->buf_stat + offset, buf_stat_bytes);
+				/* uncompress large messages while receiving, without keeping compressed data */
+				s->buf_type = ZBX_BUF_TYPE_DYN;
+				s->buffer = (char *)zbx_malloc(NULL, context->reserved + 1);
+
+				if (SUCCEED != zbx_uncompress_stream_init(&context->stream, s->buffer, context->reserved))
+				{
+					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+
+				context->chunk = (char *)zbx_malloc(NULL, ZBX_TCP_RECV_CHUNK_SIZE);
+				context->buf_dyn_bytes = context->buf_stat_bytes - context->offset;
+				context->buf_stat_bytes = 0;
+
+				if (SUCCEED != zbx_uncompress_stream_append(context->stream, s->buf_stat + context->offset,
+						context->buf_dyn_bytes))
+				{
+					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
 			}
 			else
 			{
 				s->buf_type = ZBX_BUF_TYPE_DYN;
-				s->buffer = (char *)zbx_malloc(NULL, expected_len + 1);
-				buf_dyn_bytes = buf_stat_bytes - offset;
-				buf_stat_bytes = 0;
-				memcpy(s->buffer, s->buf_stat + offset, buf_dyn_bytes);
+				s->buffer = (char *)zbx_malloc(NULL, context->expected_len + 1);
+				context->buf_dyn_bytes = context->buf_stat_bytes - context->offset;
+				context->buf_stat_bytes = 0;
+				memcpy(s->buffer, s->buf_stat + context->offset, context->buf_dyn_bytes);
 			}
 
-			expect = ZBX_TCP_EXPECT_SIZE;
+			context->expect = ZBX_TCP_EXPECT_SIZE;
 
-			if (buf_stat_bytes + buf_dyn_bytes >= expected_len)
+			if (context->buf_stat_bytes + context->buf_dyn_bytes >= context->expected_len)
 				break;
 		}
 	}
 
-	if (ZBX_TCP_EXPECT_SIZE == expect)
+	if (ZBX_TCP_EXPECT_SIZE == context->expect)
 	{
-		if (buf_stat_bytes + buf_dyn_bytes == expected_len)
+		size_t	received = context->buf_stat_bytes + context->buf_dyn_bytes;
+
+		if (received == context->expected_len)
 		{
-			if (0 != (protocol_version & ZBX_TCP_COMPRESS))
+			if (NULL != context->stream)
+			{
+				size_t	out_size;
+
+				if (FAIL == zbx_uncompress_stream_finish(context->stream, &out_size))
+				{
+					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+
+				if (out_size != context->reserved)
+				{
+					zbx_set_socket_strerror("size of uncompressed data is less than expected");
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+
+				s->read_bytes = context->reserved;
+
+				zabbix_log(LOG_LEVEL_TRACE, "%s(): received " ZBX_FS_SIZE_T " bytes with"
+						" compression ratio %.1f", __func__, (zbx_fs_size_t)received,
+						(double)context->reserved / received);
+			}
+			else if (0 != (context->protocol_version & ZBX_TCP_COMPRESS))
 			{
 				char	*out;
-				size_t	out_size = reserved;
+				size_t	out_size = context->reserved;
 
-				out = (char *)zbx_malloc(NULL, reserved + 1);
-				if (FAIL == zbx_uncompress(s->buffer, buf_stat_bytes + buf_dyn_bytes, out, &out_size))
+				out = (char *)zbx_malloc(NULL, context->reserved + 1);
+				if (FAIL == zbx_uncompress(s->buffer, received, out, &out_size))
 				{
 					zbx_free(out);
 					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
@@ -1865,7 +2207,7 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout)
 					goto out;
 				}
 
-				if (out_size != reserved)
+				if (out_size != context->reserved)
 				{
 					zbx_free(out);
 					zbx_set_socket_strerror("size of uncompressed data is less than expected");
@@ -1878,52 +2220,51 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout)
 
 				s->buf_type = ZBX_BUF_TYPE_DYN;
 				s->buffer = out;
-				s->read_bytes = reserved;
+				s->read_bytes = context->reserved;
 
 				zabbix_log(LOG_LEVEL_TRACE, "%s(): received " ZBX_FS_SIZE_T " bytes with"
-						" compression ratio %.1f", __func__,
-						(zbx_fs_size_t)(buf_stat_bytes + buf_dyn_bytes),
-						(double)reserved / (buf_stat_bytes + buf_dyn_bytes));
+						" compression ratio %.1f", __func__, (zbx_fs_size_t)received,
+						(double)context->reserved / received);
 			}
 			else
-				s->read_bytes = buf_stat_bytes + buf_dyn_bytes;
+				s->read_bytes = received;
 
 			s->buffer[s->read_bytes] = '\0';
 		}
 		else
 		{
-			if (buf_stat_bytes + buf_dyn_bytes < expected_len)
+			if (received < context->expected_len)
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "Message from %s is shorter than expected " ZBX_FS_UI64
-						" bytes. Message ignored.", s->peer, (zbx_uint64_t)expected_len);
+						" bytes. Message ignored.", s->peer, (zbx_uint64_t)context->expected_len);
 			}
 			else
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "Message from %s is longer than expected " ZBX_FS_UI64
-						" bytes. Message ignored.", s->peer, (zbx_uint64_t)expected_len);
+						" bytes. Message ignored.", s->peer, (zbx_uint64_t)context->expected_len);
 			}
 
 			nbytes = ZBX_PROTO_ERROR;
 		}
 	}
-	else if (ZBX_TCP_EXPECT_LENGTH == expect)
+	else if (ZBX_TCP_EXPECT_LENGTH == context->expect)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is missing data length. Message ignored.", s->peer);
 		nbytes = ZBX_PROTO_ERROR;
 	}
-	else if (ZBX_TCP_EXPECT_VERSION == expect)
+	else if (ZBX_TCP_EXPECT_VERSION == context->expect)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is missing protocol version. Message ignored.",
 				s->peer);
 		nbytes = ZBX_PROTO_ERROR;
 	}
-	else if (ZBX_TCP_EXPECT_VERSION_VALIDATE == expect)
+	else if (ZBX_TCP_EXPECT_VERSION_VALIDATE == context->expect)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is using unsupported protocol version \"%d\"."
-				" Message ignored.", s->peer, protocol_version);
+				" Message ignored.", s->peer, context->protocol_version);
 		nbytes = ZBX_PROTO_ERROR;
 	}
-	else if (0 != buf_stat_bytes)
+	else if (0 != context->buf_stat_bytes)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is missing header. Message ignored.", s->peer);
 		nbytes = ZBX_PROTO_ERROR;
@@ -1934,14 +2275,38 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout)
 		s->buffer[s->read_bytes] = '\0';
 	}
 out:
+	zbx_tcp_recv_context_clear(context);
+
+	return (ZBX_PROTO_ERROR == nbytes ? FAIL : (ssize_t)(s->read_bytes + context->offset));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_recv_ext                                                 *
+ *                                                                            *
+ * Purpose: receive data                                                      *
+ *                                                                            *
+ * Return value: number of bytes received - success,                          *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ * Author: Eugene Grigorjev                                                   *
+ *                                                                            *
+ ******************************************************************************/
+ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout)
+{
+	zbx_tcp_recv_context_t	context;
+	ssize_t			nbytes;
+
 	if (0 != timeout)
-		zbx_socket_timeout_cleanup(s);
+		zbx_socket_timeout_set(s, timeout);
+
+	zbx_tcp_recv_context_init(s, &context);
+	nbytes = zbx_tcp_recv_context(s, &context, NULL);
 
-	return (ZBX_PROTO_ERROR == nbytes ? FAIL : (ssize_t)(s->read_bytes + offset));
+	if (0 != timeout)
+		zbx_socket_timeout_cleanup(s);
 
-#undef ZBX_TCP_EXPECT_HEADER
-#undef ZBX_TCP_EXPECT_LENGTH
-#undef ZBX_TCP_EXPECT_SIZE
+	return nbytes;
 }
 
 /******************************************************************************
@@ -1968,7 +2333,8 @@ ssize_t	zbx_tcp_recv_raw_ext(zbx_socket_t *s, int timeout)
 	s->buf_type = ZBX_BUF_TYPE_STAT;
 	s->buffer = s->buf_stat;
 
-	while (0 != (nbytes = zbx_tcp_read(s, s->buf_stat + buf_stat_bytes, sizeof(s->buf_stat) - buf_stat_bytes)))
+	while (0 != (nbytes = zbx_tcp_read(s, s->buf_stat + buf_stat_bytes, sizeof(s->buf_stat) - buf_stat_bytes,
+			NULL)))
 	{
 		if (ZBX_PROTO_ERROR == nbytes)
 			goto out;
@@ -126,6 +126,119 @@ int	zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
 	return SUCCEED;
 }
 
+struct zbx_uncompress_stream
+{
+	z_stream	zs;
+	int		status;
+};
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_uncompress_stream_init                                       *
+ *                                                                            *
+ * Purpose: start uncompressing data arriving in parts                        *
+ *                                                                            *
+ * Parameters: stream   - [OUT] the uncompression stream                      *
+ *             out      - [IN] the buffer for uncompressed data               *
+ *             size_out - [IN] the buffer size                                *
+ *                                                                            *
+ * Return value: SUCCEED - the stream was initialized successfully            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: In the case of success the stream must be freed by the caller.   *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_uncompress_stream_init(zbx_uncompress_stream_t **stream, char *out, size_t size_out)
+{
+	zbx_uncompress_stream_t	*st;
+
+	st = (zbx_uncompress_stream_t *)zbx_malloc(NULL, sizeof(zbx_uncompress_stream_t));
+	memset(&st->zs, 0, sizeof(st->zs));
+	st->zs.next_out = (Bytef *)out;
+	st->zs.avail_out = size_out;
+
+	if (Z_OK != (zbx_zlib_errno = inflateInit(&st->zs)))
+	{
+		zbx_free(st);
+		return FAIL;
+	}
+
+	st->status = Z_OK;
+	*stream = st;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_uncompress_stream_append                                     *
+ *                                                                            *
+ * Purpose: uncompress next part of data                                      *
+ *                                                                            *
+ * Parameters: stream  - [IN] the uncompression stream                        *
+ *             in      - [IN] the data to uncompress                          *
+ *             size_in - [IN] the input data size                             *
+ *                                                                            *
+ * Return value: SUCCEED - the data was uncompressed successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_uncompress_stream_append(zbx_uncompress_stream_t *stream, const char *in, size_t size_in)
+{
+	stream->zs.next_in = (Bytef *)in;
+	stream->zs.avail_in = size_in;
+
+	while (0 != stream->zs.avail_in)
+	{
+		/* data after the end of compressed stream */
+		if (Z_STREAM_END == stream->status)
+		{
+			zbx_zlib_errno = Z_DATA_ERROR;
+			return FAIL;
+		}
+
+		if (Z_OK != (stream->status = inflate(&stream->zs, Z_NO_FLUSH)) && Z_STREAM_END != stream->status)
+		{
+			zbx_zlib_errno = stream->status;
+			return FAIL;
+		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_uncompress_stream_finish                                     *
+ *                                                                            *
+ * Purpose: check that all data was uncompressed                              *
+ *                                                                            *
+ * Parameters: stream   - [IN] the uncompression stream                       *
+ *             size_out - [OUT] the uncompressed data size                    *
+ *                                                                            *
+ * Return value: SUCCEED - the compressed data was complete                   *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_uncompress_stream_finish(zbx_uncompress_stream_t *stream, size_t *size_out)
+{
+	if (Z_STREAM_END != stream->status)
+	{
+		zbx_zlib_errno = Z_DATA_ERROR;
+		return FAIL;
+	}
+
+	*size_out = stream->zs.total_out;
+
+	return SUCCEED;
+}
+
+void	zbx_uncompress_stream_free(zbx_uncompress_stream_t *stream)
+{
+	inflateEnd(&stream->zs);
+	zbx_free(stream);
+}
+
 #else
 
 int zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out)
@@ -151,4 +264,32 @@ const char	*zbx_compress_strerror(void)
 	return "";
 }
 
+int	zbx_uncompress_stream_init(zbx_uncompress_stream_t **stream, char *out, size_t size_out)
+{
+	ZBX_UNUSED(stream);
+	ZBX_UNUSED(out);
+	ZBX_UNUSED(size_out);
+	return FAIL;
+}
+
+int	zbx_uncompress_stream_append(zbx_uncompress_stream_t *stream, const char *in, size_t size_in)
+{
+	ZBX_UNUSED(stream);
+	ZBX_UNUSED(in);
+	ZBX_UNUSED(size_in);
+	return FAIL;
+}
+
+int	zbx_uncompress_stream_finish(zbx_uncompress_stream_t *stream, size_t *size_out)
+{
+	ZBX_UNUSED(stream);
+	ZBX_UNUSED(size_out);
+	return FAIL;
+}
+
+void	zbx_uncompress_stream_free(zbx_uncompress_stream_t *stream)
+{
+	ZBX_UNUSED(stream);
+}
+
 #endif
@@ -71,6 +71,9 @@ extern int		CONFIG_DOUBLE_PRECISION;
 #define ZBX_HC_SYNC_MAX		1000
 #define ZBX_HC_TIMER_MAX	(ZBX_HC_SYNC_MAX / 2)
 
+/* the minimum number of items in one synchronization batch when queued items are shared between syncers */
+#define ZBX_HC_SYNC_MIN		100
+
 /* the minimum processed item percentage of item candidates to continue synchronizing */
 #define ZBX_HC_SYNC_MIN_PCNT	10
 
@@ -100,6 +103,7 @@ static ZBX_DC_IDS	*ids = NULL;
 typedef struct
 {
 	zbx_hashset_t		trends;
+	zbx_hashset_t		trends_pending;	/* trends of the previous hour waiting to be flushed */
 	ZBX_DC_STATS		stats;
 
 	zbx_hashset_t		history_items;
@@ -108,8 +112,10 @@ typedef struct
 	int			history_num;
 	int			trends_num;
 	int			trends_last_cleanup_hour;
+	int			trends_pending_flush;
 	int			history_num_total;
 	int			history_progress_ts;
+	int			history_syncers_busy;	/* the number of syncers processing popped items */
 }
 ZBX_DC_CACHE;
 
@@ -746,6 +752,234 @@ static void	DBflush_trends(ZBX_DC_TREND *trends, int *trends_num, zbx_vector_uin
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_trends_upsert_supported                                       *
+ *                                                                            *
+ * Purpose: check if trends can be flushed with insert or update statements   *
+ *                                                                            *
+ * Return value: SUCCEED - upsert is enabled and supported by the database    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_trends_upsert_supported(void)
+{
+	if (0 == CONFIG_TRENDS_UPSERT)
+		return FAIL;
+#if defined(HAVE_POSTGRESQL)
+	/* insert ... on conflict is available starting with PostgreSQL 9.5 */
+	if (90500 > zbx_dbms_get_version())
+	{
+		static int	warning_logged = 0;
+
+		if (0 == warning_logged)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "\"TrendUpsert\" configuration parameter is ignored:"
+					" PostgreSQL 9.5 or newer is required");
+			warning_logged = 1;
+		}
+
+		return FAIL;
+	}
+#endif
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_trends_upsert_execute                                         *
+ *                                                                            *
+ * Purpose: finish multi-row trend insert statement with the clause merging   *
+ *          the inserted values with the existing trend and execute it        *
+ *                                                                            *
+ * Parameters: table_name - [IN] the trends table name                        *
+ *             value_type - [IN] the trends value type                        *
+ *             sql_offset - [IN/OUT] the sql buffer offset                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_trends_upsert_execute(const char *table_name, unsigned char value_type, size_t *sql_offset)
+{
+#if defined(HAVE_POSTGRESQL)
+	zbx_snprintf_alloc(&sql, &sql_alloc, sql_offset,
+			" on conflict (itemid,clock) do update set"
+			" num=%s.num+excluded.num,"
+			"value_min=least(%s.value_min,excluded.value_min),",
+			table_name, table_name);
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+	{
+		zbx_snprintf_alloc(&sql, &sql_alloc, sql_offset,
+				"value_avg=(%s.value_avg*%s.num+excluded.value_avg*excluded.num)/"
+				"(%s.num+excluded.num),",
+				table_name, table_name, table_name);
+	}
+	else
+	{
+		zbx_snprintf_alloc(&sql, &sql_alloc, sql_offset,
+				"value_avg=div(%s.value_avg*%s.num+excluded.value_avg*excluded.num,"
+				"%s.num+excluded.num),",
+				table_name, table_name, table_name);
+	}
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, sql_offset,
+			"value_max=greatest(%s.value_max,excluded.value_max)", table_name);
+#else
+	/* assignments are evaluated left to right, value_avg must be updated before num */
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+	{
+		zbx_strcpy_alloc(&sql, &sql_alloc, sql_offset,
+				" on duplicate key update"
+				" value_avg=(value_avg*num+values(value_avg)*values(num))/(num+values(num)),");
+	}
+	else
+	{
+		/* cast to decimal to avoid bigint unsigned overflow in the weighted sum */
+		zbx_strcpy_alloc(&sql, &sql_alloc, sql_offset,
+				" on duplicate key update"
+				" value_avg=(cast(value_avg as decimal(20,0))*num+"
+				"cast(values(value_avg) as decimal(20,0))*values(num)) div (num+values(num)),");
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, sql_offset,
+			"num=num+values(num),"
+			"value_min=least(value_min,values(value_min)),"
+			"value_max=greatest(value_max,values(value_max))");
+#endif
+	DBexecute("%s", sql);
+	*sql_offset = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DBupsert_trends                                                  *
+ *                                                                            *
+ * Purpose: flush trends to the database with multi-row insert statements     *
+ *          merging values with the existing trends on the database side      *
+ *                                                                            *
+ * Parameters: trends     - [IN/OUT] the trends to flush                      *
+ *             trends_num - [IN/OUT] the number of trends                     *
+ *                                                                            *
+ * Comments: Only the trends of the same hour and value type as the first     *
+ *           trend are flushed, the rest are left in the array. An item trend *
+ *           can be present more than once if the item received values out of *
+ *           order, such duplicates are left for the next call because one    *
+ *           statement cannot update the same row twice.                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	DBupsert_trends(ZBX_DC_TREND *trends, int *trends_num)
+{
+	int		i, num, clock, rows_num = 0;
+	unsigned char	value_type;
+	const char	*table_name;
+	size_t		sql_offset = 0;
+	zbx_hashset_t	itemids;
+	ZBX_DC_TREND	*trend;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() trends_num:%d", __func__, *trends_num);
+
+	clock = trends[0].clock;
+	value_type = trends[0].value_type;
+
+	switch (value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			table_name = "trends";
+			break;
+		case ITEM_VALUE_TYPE_UINT64:
+			table_name = "trends_uint";
+			break;
+		default:
+			assert(0);
+	}
+
+	zbx_hashset_create(&itemids, (size_t)MIN(ZBX_HC_SYNC_MAX, *trends_num), ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (i = 0; i < *trends_num; i++)
+	{
+		trend = &trends[i];
+
+		if (clock != trend->clock || value_type != trend->value_type)
+			continue;
+
+		if (NULL != zbx_hashset_search(&itemids, &trend->itemid))
+			continue;
+
+		zbx_hashset_insert(&itemids, &trend->itemid, sizeof(trend->itemid));
+
+		if (0 == sql_offset)
+		{
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+					"insert into %s (itemid,clock,num,value_min,value_avg,value_max) values ",
+					table_name);
+		}
+		else
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+
+		if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		{
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+					"(" ZBX_FS_UI64 ",%d,%d," ZBX_FS_DBL64_SQL "," ZBX_FS_DBL64_SQL ","
+					ZBX_FS_DBL64_SQL ")",
+					trend->itemid, trend->clock, trend->num, trend->value_min.dbl,
+					trend->value_avg.dbl, trend->value_max.dbl);
+		}
+		else
+		{
+			zbx_uint128_t	avg;
+
+			/* calculate the trend average value */
+			udiv128_64(&avg, &trend->value_avg.ui64, trend->num);
+
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+					"(" ZBX_FS_UI64 ",%d,%d," ZBX_FS_UI64 "," ZBX_FS_UI64 "," ZBX_FS_UI64 ")",
+					trend->itemid, trend->clock, trend->num, trend->value_min.ui64, avg.lo,
+					trend->value_max.ui64);
+		}
+
+		trend->itemid = 0;
+		rows_num++;
+
+		if (ZBX_MAX_SQL_SIZE < sql_offset)
+			dc_trends_upsert_execute(table_name, value_type, &sql_offset);
+	}
+
+	if (0 != sql_offset)
+		dc_trends_upsert_execute(table_name, value_type, &sql_offset);
+
+	zbx_hashset_destroy(&itemids);
+
+	/* clean trends */
+	for (i = 0, num = 0; i < *trends_num; i++)
+	{
+		if (0 == trends[i].itemid)
+			continue;
+
+		memcpy(&trends[num++], &trends[i], sizeof(ZBX_DC_TREND));
+	}
+	*trends_num = num;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() rows:%d", __func__, rows_num);
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_trend_reset                                                   *
+ *                                                                            *
+ * Purpose: clear trend values after they have been moved for flushing        *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_trend_reset(ZBX_DC_TREND *trend)
+{
+	trend->clock = 0;
+	trend->num = 0;
+	memset(&trend->value_min, 0, sizeof(history_value_t));
+	memset(&trend->value_avg, 0, sizeof(value_avg_t));
+	memset(&trend->value_max, 0, sizeof(history_value_t));
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: DCflush_trend                                                    *
@@ -766,11 +1000,90 @@ static void	DCflush_trend(ZBX_DC_TREND *trend, ZBX_DC_TREND **trends, int *trend
 	memcpy(&(*trends)[*trends_num], trend, sizeof(ZBX_DC_TREND));
 	(*trends_num)++;
 
-	trend->clock = 0;
-	trend->num = 0;
-	memset(&trend->value_min, 0, sizeof(history_value_t));
-	memset(&trend->value_avg, 0, sizeof(value_avg_t));
-	memset(&trend->value_max, 0, sizeof(history_value_t));
+	dc_trend_reset(trend);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCdefer_trend                                                    *
+ *                                                                            *
+ * Purpose: move trend of the previous hour to the pending trends, they are   *
+ *          flushed gradually by DCflush_pending_trends()                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	DCdefer_trend(ZBX_DC_TREND *trend, ZBX_DC_TREND **trends, int *trends_alloc, int *trends_num)
+{
+	ZBX_DC_TREND	*pending;
+
+	if (NULL != (pending = (ZBX_DC_TREND *)zbx_hashset_search(&cache->trends_pending, &trend->itemid)))
+	{
+		/* only one trend per item can be pending, flush the older one right away */
+		DCflush_trend(pending, trends, trends_alloc, trends_num);
+		memcpy(pending, trend, sizeof(ZBX_DC_TREND));
+	}
+	else
+		zbx_hashset_insert(&cache->trends_pending, trend, sizeof(ZBX_DC_TREND));
+
+	dc_trend_reset(trend);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCflush_pending_trends                                           *
+ *                                                                            *
+ * Purpose: move part of pending trends to the array of trends for flushing   *
+ *          to DB                                                             *
+ *                                                                            *
+ * Parameters: now             - [IN] the current time                        *
+ *             compression_age - [IN] history compression age                 *
+ *             trends          - [OUT] list of trends to flush into database  *
+ *             trends_alloc    - [IN/OUT] allocated size of trends list       *
+ *             trends_num      - [IN/OUT] number of trends                    *
+ *                                                                            *
+ * Comments: Pending trends are flushed at the rate that empties them by      *
+ *           TrendFlushSpread seconds after the beginning of the hour, so the *
+ *           trends of all items are not written at once when hour changes.   *
+ *                                                                            *
+ ******************************************************************************/
+static void	DCflush_pending_trends(int now, int compression_age, ZBX_DC_TREND **trends, int *trends_alloc,
+		int *trends_num)
+{
+	zbx_hashset_iter_t	iter;
+	ZBX_DC_TREND		*trend;
+	int			deadline, num;
+
+	if (0 == cache->trends_pending.num_data)
+	{
+		cache->trends_pending_flush = now;
+		return;
+	}
+
+	deadline = now - now % SEC_PER_HOUR + CONFIG_TRENDS_FLUSH_SPREAD;
+
+	if (now >= deadline)
+	{
+		num = cache->trends_pending.num_data;
+	}
+	else
+	{
+		num = (int)((zbx_uint64_t)cache->trends_pending.num_data * (now - cache->trends_pending_flush) /
+				(deadline - cache->trends_pending_flush));
+	}
+
+	if (0 == num)
+		return;
+
+	zbx_hashset_iter_reset(&cache->trends_pending, &iter);
+
+	while (0 < num-- && NULL != (trend = (ZBX_DC_TREND *)zbx_hashset_iter_next(&iter)))
+	{
+		if (0 == compression_age || trend->clock >= compression_age)
+			DCflush_trend(trend, trends, trends_alloc, trends_num);
+
+		zbx_hashset_iter_remove(&iter);
+	}
+
+	cache->trends_pending_flush = now;
 }
 
 /******************************************************************************
@@ -794,7 +1107,13 @@ static void	DCadd_trend(const ZBX_DC_HISTORY *history, ZBX_DC_TREND **trends, in
 	if (trend->num > 0 && (trend->clock != hour || trend->value_type != history->value_type) &&
 			SUCCEED == zbx_history_requires_trends(trend->value_type))
 	{
-		DCflush_trend(trend, trends, trends_alloc, trends_num);
+		if (0 != CONFIG_TRENDS_FLUSH_SPREAD && trend->clock < hour &&
+				trend->value_type == history->value_type)
+		{
+			DCdefer_trend(trend, trends, trends_alloc, trends_num);
+		}
+		else
+			DCflush_trend(trend, trends, trends_alloc, trends_num);
 	}
 
 	trend->value_type = history->value_type;
@@ -861,6 +1180,9 @@ static void	DCmass_update_trends(const ZBX_DC_HISTORY *history, int history_num,
 		DCadd_trend(h, trends, &trends_alloc, trends_num);
 	}
 
+	if (0 != CONFIG_TRENDS_FLUSH_SPREAD)
+		DCflush_pending_trends(ts.sec, compression_age, trends, &trends_alloc, trends_num);
+
 	if (cache->trends_last_cleanup_hour < hour && ZBX_TRENDS_CLEANUP_TIME < seconds)
 	{
 		zbx_hashset_iter_t	iter;
@@ -905,7 +1227,7 @@ static void	DCmass_update_trends(const ZBX_DC_HISTORY *history, int history_num,
  *                                                                            *
  * Parameters: trends      - [IN] trends from cache to be added to database   *
  *             trends_num  - [IN] number of trends to add to database         *
- *             trends_diff - [OUT] disable_from updates                       *
+ *             trends_diff - [OUT] disable_from updates (optional)            *
  *                                                                            *
  ******************************************************************************/
 static void	DBmass_update_trends(const ZBX_DC_TREND *trends, int trends_num,
@@ -918,6 +1240,16 @@ static void	DBmass_update_trends(const ZBX_DC_TREND *trends, int trends_num,
 		trends_tmp = (ZBX_DC_TREND *)zbx_malloc(NULL, trends_num * sizeof(ZBX_DC_TREND));
 		memcpy(trends_tmp, trends, trends_num * sizeof(ZBX_DC_TREND));
 
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+		if (SUCCEED == dc_trends_upsert_supported())
+		{
+			while (0 < trends_num)
+				DBupsert_trends(trends_tmp, &trends_num);
+
+			zbx_free(trends_tmp);
+			return;
+		}
+#endif
 		while (0 < trends_num)
 			DBflush_trends(trends_tmp, &trends_num, trends_diff);
 
@@ -1494,6 +1826,16 @@ static void	DCsync_trends(void)
 			DCflush_trend(trend, &trends, &trends_alloc, &trends_num);
 	}
 
+	zbx_hashset_iter_reset(&cache->trends_pending, &iter);
+
+	while (NULL != (trend = (ZBX_DC_TREND *)zbx_hashset_iter_next(&iter)))
+	{
+		if (trend->clock >= compression_age)
+			DCflush_trend(trend, &trends, &trends_alloc, &trends_num);
+
+		zbx_hashset_iter_remove(&iter);
+	}
+
 	UNLOCK_TRENDS;
 
 	if (SUCCEED == zbx_is_export_enabled() && 0 != trends_num)
@@ -1501,8 +1843,7 @@ static void	DCsync_trends(void)
 
 	DBbegin();
 
-	while (trends_num > 0)
-		DBflush_trends(trends, &trends_num, NULL);
+	DBmass_update_trends(trends, trends_num, NULL);
 
 	DBcommit();
 
@@ -4063,13 +4404,29 @@ static void	hc_copy_history_data(ZBX_DC_HISTORY *history, zbx_uint64_t itemid, z
  * Comments: The history_items must be returned back to history cache with    *
  *           hc_push_items() function after they have been processed.         *
  *                                                                            *
+ *           Queued items are shared between the syncers which are not busy,  *
+ *           so that a large burst of values (for example, proxy upload) is   *
+ *           processed by several syncers in parallel instead of being taken  *
+ *           by one syncer in a single batch.                                 *
+ *                                                                            *
  ******************************************************************************/
 static void	hc_pop_items(zbx_vector_ptr_t *history_items)
 {
 	zbx_binary_heap_elem_t	*elem;
 	zbx_hc_item_t		*item;
+	int			syncers_free, items_max;
+
+	if (1 > (syncers_free = CONFIG_HISTSYNCER_FORKS - cache->history_syncers_busy))
+		syncers_free = 1;
+
+	items_max = (hc_queue_get_size() + syncers_free - 1) / syncers_free;
 
-	while (ZBX_HC_SYNC_MAX > history_items->values_num && FAIL == zbx_binary_heap_empty(&cache->history_queue))
+	if (ZBX_HC_SYNC_MIN > items_max)
+		items_max = ZBX_HC_SYNC_MIN;
+	else if (ZBX_HC_SYNC_MAX < items_max)
+		items_max = ZBX_HC_SYNC_MAX;
+
+	while (items_max > history_items->values_num && FAIL == zbx_binary_heap_empty(&cache->history_queue))
 	{
 		elem = zbx_binary_heap_find_min(&cache->history_queue);
 		item = (zbx_hc_item_t *)elem->data;
@@ -4077,6 +4434,9 @@ static void	hc_pop_items(zbx_vector_ptr_t *history_items)
 
 		zbx_binary_heap_remove_min(&cache->history_queue);
 	}
+
+	if (0 != history_items->values_num)
+		cache->history_syncers_busy++;
 }
 
 /******************************************************************************
@@ -4127,6 +4487,9 @@ void	hc_push_items(zbx_vector_ptr_t *history_items)
 	zbx_hc_item_t	*item;
 	zbx_hc_data_t	*data_free;
 
+	if (0 != history_items->values_num)
+		cache->history_syncers_busy--;
+
 	for (i = 0; i < history_items->values_num; i++)
 	{
 		item = (zbx_hc_item_t *)history_items->values[i];
@@ -4217,6 +4580,7 @@ static int	init_trend_cache(char **error)
 
 	cache->trends_num = 0;
 	cache->trends_last_cleanup_hour = 0;
+	cache->trends_pending_flush = 0;
 
 #define INIT_HASHSET_SIZE	100	/* Should be calculated dynamically based on trends size? */
 					/* Still does not make sense to have it more than initial */
@@ -4226,6 +4590,10 @@ static int	init_trend_cache(char **error)
 			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
 			__trend_mem_malloc_func, __trend_mem_realloc_func, __trend_mem_free_func);
 
+	zbx_hashset_create_ext(&cache->trends_pending, INIT_HASHSET_SIZE,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+			__trend_mem_malloc_func, __trend_mem_realloc_func, __trend_mem_free_func);
+
 #undef INIT_HASHSET_SIZE
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -4287,6 +4655,7 @@ int	init_database_cache(char **error)
 
 	cache->history_num_total = 0;
 	cache->history_progress_ts = 0;
+	cache->history_syncers_busy = 0;
 
 	if (NULL == sql)
 		sql = (char *)zbx_malloc(sql, sql_alloc);
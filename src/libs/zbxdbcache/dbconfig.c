@@ -44,6 +44,9 @@ int	sync_in_progress = 0;
 #define START_SYNC	WRLOCK_CACHE; sync_in_progress = 1
 #define FINISH_SYNC	sync_in_progress = 0; UNLOCK_CACHE
 
+/* interval between flushing read lock wait statistics into shared memory, seconds */
+#define ZBX_DC_LOCK_STATS_FLUSH_PERIOD	1
+
 #define ZBX_LOC_NOWHERE	0
 #define ZBX_LOC_QUEUE	1
 #define ZBX_LOC_POLLER	2
@@ -88,8 +91,16 @@ typedef int (*zbx_value_validator_func_t)(const char *macro, const char *value,
 
 ZBX_DC_CONFIG	*config = NULL;
 zbx_rwlock_t	config_lock = ZBX_RWLOCK_NULL;
+static zbx_mutex_t	config_stats_lock = ZBX_MUTEX_NULL;
 static zbx_mem_info_t	*config_mem;
 
+/* read lock wait time histogram bucket upper bounds in seconds, the last bucket is unbounded */
+static const double	rdlock_wait_bounds[ZBX_DC_LOCK_WAIT_BUCKETS - 1] = {0.00001, 0.0001, 0.001, 0.01, 0.1, 1};
+
+/* read lock wait statistics collected by the current process since the last flush */
+static zbx_dc_lock_stats_t	rdlock_stats_local;
+static double			rdlock_stats_flush_time;
+
 extern unsigned char	program_type;
 extern int		CONFIG_TIMER_FORKS;
 
@@ -100,6 +111,66 @@ static void	dc_maintenance_precache_nested_groups(void);
 /* by default the macro environment is non-secure and all secret macros are masked with ****** */
 static unsigned char	macro_env = ZBX_MACRO_ENV_NONSECURE;
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_rdlock_stats_flush                                            *
+ *                                                                            *
+ * Purpose: adds read lock wait statistics collected by the current process   *
+ *          to the configuration cache statistics                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_rdlock_stats_flush(void)
+{
+	int	i;
+
+	zbx_mutex_lock(config_stats_lock);
+
+	for (i = 0; i < ZBX_DC_LOCK_WAIT_BUCKETS; i++)
+		config->rdlock_stats.buckets[i] += rdlock_stats_local.buckets[i];
+
+	config->rdlock_stats.count += rdlock_stats_local.count;
+	config->rdlock_stats.sum += rdlock_stats_local.sum;
+
+	zbx_mutex_unlock(config_stats_lock);
+
+	memset(&rdlock_stats_local, 0, sizeof(rdlock_stats_local));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_rdlock_cache                                                  *
+ *                                                                            *
+ * Purpose: acquires configuration cache read lock and records the time spent *
+ *          waiting for it                                                    *
+ *                                                                            *
+ * Comments: The statistics are accumulated locally and flushed to shared     *
+ *           memory once per ZBX_DC_LOCK_STATS_FLUSH_PERIOD to avoid extra    *
+ *           locking on every cache access.                                   *
+ *                                                                            *
+ ******************************************************************************/
+void	dc_rdlock_cache(void)
+{
+	double	time_start, time_wait;
+	int	i;
+
+	time_start = zbx_time();
+	zbx_rwlock_rdlock(config_lock);
+	time_wait = zbx_time() - time_start;
+
+	for (i = 0; i < ZBX_DC_LOCK_WAIT_BUCKETS - 1 && time_wait > rdlock_wait_bounds[i]; i++)
+		;
+
+	rdlock_stats_local.buckets[i]++;
+	rdlock_stats_local.count++;
+	rdlock_stats_local.sum += time_wait;
+
+	if (ZBX_DC_LOCK_STATS_FLUSH_PERIOD <= time_start - rdlock_stats_flush_time)
+	{
+		dc_rdlock_stats_flush();
+		rdlock_stats_flush_time = time_start;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_strdup                                                        *
@@ -3343,6 +3414,48 @@ static void	DCsync_prototype_items(zbx_dbsync_t *sync)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_expression_compile                                            *
+ *                                                                            *
+ * Purpose: compile trigger expression into configuration cache               *
+ *                                                                            *
+ * Return value: the compiled program in shared memory or NULL if the         *
+ *               expression cannot be compiled                                *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	*dc_expression_compile(const char *expression)
+{
+	unsigned char	*program, *dst;
+	zbx_uint32_t	size;
+
+	if (NULL == (program = zbx_expression_compile(expression)))
+		return NULL;
+
+	size = zbx_expression_program_size(program);
+	dst = (unsigned char *)__config_mem_malloc_func(NULL, size);
+	memcpy(dst, program, size);
+	zbx_free(program);
+
+	return dst;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_trigger_free_programs                                         *
+ *                                                                            *
+ * Purpose: free compiled trigger expressions                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_trigger_free_programs(ZBX_DC_TRIGGER *trigger)
+{
+	if (NULL != trigger->expression_program)
+		__config_mem_free_func(trigger->expression_program);
+
+	if (NULL != trigger->recovery_expression_program)
+		__config_mem_free_func(trigger->recovery_expression_program);
+}
+
 static void	DCsync_triggers(zbx_dbsync_t *sync)
 {
 	char		**row;
@@ -3351,8 +3464,9 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 
 	ZBX_DC_TRIGGER	*trigger;
 
-	int		found, ret;
+	int		found, ret, expression_changed, recovery_changed;
 	zbx_uint64_t	triggerid;
+	unsigned char	recovery_mode;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -3369,16 +3483,21 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 		/* store new information in trigger structure */
 
 		DCstrpool_replace(found, &trigger->description, row[1]);
-		DCstrpool_replace(found, &trigger->expression, row[2]);
-		DCstrpool_replace(found, &trigger->recovery_expression, row[11]);
+		expression_changed = DCstrpool_replace(found, &trigger->expression, row[2]);
+		recovery_changed = DCstrpool_replace(found, &trigger->recovery_expression, row[11]);
 		DCstrpool_replace(found, &trigger->correlation_tag, row[13]);
 		DCstrpool_replace(found, &trigger->opdata, row[14]);
 		ZBX_STR2UCHAR(trigger->priority, row[4]);
 		ZBX_STR2UCHAR(trigger->type, row[5]);
 		ZBX_STR2UCHAR(trigger->status, row[9]);
-		ZBX_STR2UCHAR(trigger->recovery_mode, row[10]);
+		ZBX_STR2UCHAR(recovery_mode, row[10]);
 		ZBX_STR2UCHAR(trigger->correlation_mode, row[12]);
 
+		if (0 != found && recovery_mode != trigger->recovery_mode)
+			recovery_changed = SUCCEED;
+
+		trigger->recovery_mode = recovery_mode;
+
 		if (0 == found)
 		{
 			DCstrpool_replace(found, &trigger->error, row[3]);
@@ -3390,6 +3509,29 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 			zbx_vector_ptr_create_ext(&trigger->tags, __config_mem_malloc_func, __config_mem_realloc_func,
 					__config_mem_free_func);
 			trigger->topoindex = 1;
+			trigger->expression_program = NULL;
+			trigger->recovery_expression_program = NULL;
+		}
+
+		/* expressions are compiled once here instead of being parsed on every recalculation, */
+		/* trigger value, state and error updates keep the compiled programs                  */
+		if (SUCCEED == expression_changed)
+		{
+			if (NULL != trigger->expression_program)
+				__config_mem_free_func(trigger->expression_program);
+
+			trigger->expression_program = dc_expression_compile(trigger->expression);
+		}
+
+		if (SUCCEED == recovery_changed)
+		{
+			if (NULL != trigger->recovery_expression_program)
+				__config_mem_free_func(trigger->recovery_expression_program);
+
+			if (TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION == trigger->recovery_mode)
+				trigger->recovery_expression_program = dc_expression_compile(trigger->recovery_expression);
+			else
+				trigger->recovery_expression_program = NULL;
 		}
 	}
 
@@ -3439,6 +3581,7 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 			zbx_strpool_release(trigger->correlation_tag);
 			zbx_strpool_release(trigger->opdata);
 
+			dc_trigger_free_programs(trigger);
 			zbx_vector_ptr_destroy(&trigger->tags);
 
 			zbx_hashset_remove_direct(&config->triggers, trigger);
@@ -5064,6 +5207,28 @@ static void	dc_hostgroups_update_cache(void)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_log_load_stats                                                *
+ *                                                                            *
+ * Purpose: logs initial configuration cache load statistics of a table group *
+ *                                                                            *
+ * Parameters: name     - [IN] the table group name                           *
+ *             sql_sec  - [IN] the time spent executing database queries      *
+ *             sync_sec - [IN] the time spent fetching rows and applying them *
+ *                             to configuration cache                         *
+ *             rows     - [IN] the number of loaded rows                      *
+ *             total    - [IN/OUT] the total load time                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_log_load_stats(const char *name, double sql_sec, double sync_sec, zbx_uint64_t rows, double *total)
+{
+	zabbix_log(LOG_LEVEL_INFORMATION, "configuration cache load: %-18s " ZBX_FS_UI64 " rows, sql:" ZBX_FS_DBL
+			" sync:" ZBX_FS_DBL " sec", name, rows, sql_sec, sync_sec);
+
+	*total += sql_sec + sync_sec;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: DCsync_configuration                                             *
@@ -5381,16 +5546,11 @@ void	DCsync_configuration(unsigned char mode)
 		goto out;
 	corr_operation_sec = zbx_time() - sec;
 
-	START_SYNC;
-
-	sec = zbx_time();
-	DCsync_triggers(&triggers_sync);
-	tsec2 = zbx_time() - sec;
-
-	sec = zbx_time();
-	DCsync_trigdeps(&tdep_sync);
-	dsec2 = zbx_time() - sec;
+	/* Apply independent changes in separate write lock slices to let readers interleave. Lock must not be      */
+	/* released while a table is partially applied or before trigger links are updated, so every slice must */
+	/* leave cache in consistent state.                                                                     */
 
+	START_SYNC;
 	sec = zbx_time();
 	DCsync_expressions(&expr_sync);
 	expr_sec2 = zbx_time() - sec;
@@ -5406,12 +5566,9 @@ void	DCsync_configuration(unsigned char mode)
 	sec = zbx_time();
 	DCsync_action_conditions(&action_condition_sync);
 	action_condition_sec2 = zbx_time() - sec;
+	FINISH_SYNC;
 
-	sec = zbx_time();
-	/* relies on triggers, must be after DCsync_triggers() */
-	DCsync_trigger_tags(&trigger_tag_sync);
-	trigger_tag_sec2 = zbx_time() - sec;
-
+	START_SYNC;
 	sec = zbx_time();
 	DCsync_correlations(&correlation_sync);
 	correlation_sec2 = zbx_time() - sec;
@@ -5425,6 +5582,22 @@ void	DCsync_configuration(unsigned char mode)
 	/* relies on correlation rules, must be after DCsync_correlations() */
 	DCsync_corr_operations(&corr_operation_sync);
 	corr_operation_sec2 = zbx_time() - sec;
+	FINISH_SYNC;
+
+	START_SYNC;
+
+	sec = zbx_time();
+	DCsync_triggers(&triggers_sync);
+	tsec2 = zbx_time() - sec;
+
+	sec = zbx_time();
+	DCsync_trigdeps(&tdep_sync);
+	dsec2 = zbx_time() - sec;
+
+	sec = zbx_time();
+	/* relies on triggers, must be after DCsync_triggers() */
+	DCsync_trigger_tags(&trigger_tag_sync);
+	trigger_tag_sec2 = zbx_time() - sec;
 
 	sec = zbx_time();
 
@@ -5705,6 +5878,44 @@ void	DCsync_configuration(unsigned char mode)
 
 		zbx_mem_dump_stats(LOG_LEVEL_DEBUG, config_mem);
 	}
+
+	if (ZBX_DBSYNC_INIT == mode)
+	{
+		total = 0;
+
+		dc_log_load_stats("config", csec + autoreg_csec, csec2 + autoreg_csec2, config_sync.add_num +
+				autoreg_config_sync.add_num, &total);
+		dc_log_load_stats("templates", htsec, htsec2, htmpl_sync.add_num, &total);
+		dc_log_load_stats("global macros", gmsec, gmsec2, gmacro_sync.add_num, &total);
+		dc_log_load_stats("host macros", hmsec, hmsec2, hmacro_sync.add_num, &total);
+		dc_log_load_stats("host tags", host_tag_sec, host_tag_sec2, host_tag_sync.add_num, &total);
+		dc_log_load_stats("hosts", hsec, hsec2, hosts_sync.add_num, &total);
+		dc_log_load_stats("host inventory", hisec, hisec2, hi_sync.add_num, &total);
+		dc_log_load_stats("host groups", hgroups_sec, hgroups_sec2, hgroups_sync.add_num +
+				hgroup_host_sync.add_num, &total);
+		dc_log_load_stats("maintenances", maintenance_sec, maintenance_sec2, maintenance_sync.add_num +
+				maintenance_tag_sync.add_num + maintenance_period_sync.add_num +
+				maintenance_group_sync.add_num + maintenance_host_sync.add_num, &total);
+		dc_log_load_stats("interfaces", ifsec, ifsec2, if_sync.add_num, &total);
+		dc_log_load_stats("items", isec, isec2, items_sync.add_num + template_items_sync.add_num +
+				prototype_items_sync.add_num, &total);
+		dc_log_load_stats("item preprocessing", itempp_sec, itempp_sec2, itempp_sync.add_num, &total);
+		dc_log_load_stats("functions", fsec, fsec2, func_sync.add_num, &total);
+		dc_log_load_stats("triggers", tsec, tsec2, triggers_sync.add_num, &total);
+		dc_log_load_stats("trigger deps", dsec, dsec2, tdep_sync.add_num, &total);
+		dc_log_load_stats("trigger tags", trigger_tag_sec, trigger_tag_sec2, trigger_tag_sync.add_num, &total);
+		dc_log_load_stats("expressions", expr_sec, expr_sec2, expr_sync.add_num, &total);
+		dc_log_load_stats("actions", action_sec + action_op_sec + action_condition_sec, action_sec2 +
+				action_op_sec2 + action_condition_sec2, action_sync.add_num + action_op_sync.add_num +
+				action_condition_sync.add_num, &total);
+		dc_log_load_stats("correlations", correlation_sec + corr_condition_sec + corr_operation_sec,
+				correlation_sec2 + corr_condition_sec2 + corr_operation_sec2, correlation_sync.add_num +
+				corr_condition_sync.add_num + corr_operation_sync.add_num, &total);
+
+		zabbix_log(LOG_LEVEL_INFORMATION, "configuration cache loaded in " ZBX_FS_DBL " sec (reindex "
+				ZBX_FS_DBL " sec), %d hosts, %d items, %d triggers", total + update_sec, update_sec,
+				config->hosts.num_data, config->items.num_data, config->triggers.num_data);
+	}
 out:
 	if (0 == sync_in_progress)
 	{
@@ -5716,6 +5927,17 @@ out:
 	config->status->last_update = 0;
 	config->sync_ts = time(NULL);
 
+	if (0 != hosts_sync.add_num + hosts_sync.update_num + hosts_sync.remove_num +
+			htmpl_sync.add_num + htmpl_sync.update_num + htmpl_sync.remove_num +
+			gmacro_sync.add_num + gmacro_sync.update_num + gmacro_sync.remove_num +
+			hmacro_sync.add_num + hmacro_sync.update_num + hmacro_sync.remove_num +
+			if_sync.add_num + if_sync.update_num + if_sync.remove_num +
+			items_sync.add_num + items_sync.update_num + items_sync.remove_num +
+			expr_sync.add_num + expr_sync.update_num + expr_sync.remove_num)
+	{
+		config->revision++;
+	}
+
 	FINISH_SYNC;
 
 	zbx_dbsync_clear(&config_sync);
@@ -6080,6 +6302,9 @@ int	init_configuration_cache(char **error)
 	if (SUCCEED != (ret = zbx_rwlock_create(&config_lock, ZBX_RWLOCK_CONFIG, error)))
 		goto out;
 
+	if (SUCCEED != (ret = zbx_mutex_create(&config_stats_lock, ZBX_MUTEX_CONFIG_STATS, error)))
+		goto out;
+
 	if (SUCCEED != (ret = zbx_mem_create(&config_mem, CONFIG_CONF_CACHE_SIZE, "configuration cache",
 			"CacheSize", 0, error)))
 	{
@@ -6216,9 +6441,12 @@ int	init_configuration_cache(char **error)
 	config->status = (ZBX_DC_STATUS *)__config_mem_malloc_func(NULL, sizeof(ZBX_DC_STATUS));
 	config->status->last_update = 0;
 
+	memset(&config->rdlock_stats, 0, sizeof(config->rdlock_stats));
+
 	config->availability_diff_ts = 0;
 	config->sync_ts = 0;
 	config->item_sync_ts = 0;
+	config->revision = 0;
 
 	config->internal_actions = 0;
 
@@ -6273,6 +6501,7 @@ void	free_configuration_cache(void)
 	UNLOCK_CACHE;
 
 	zbx_rwlock_destroy(&config_lock);
+	zbx_mutex_destroy(&config_stats_lock);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -6987,6 +7216,28 @@ static void	DCget_function(DC_FUNCTION *dst_function, const ZBX_DC_FUNCTION *src
 	memcpy(dst_function->parameter, src_function->parameter, sz_parameter);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_expression_program_dup                                        *
+ *                                                                            *
+ * Purpose: copy compiled expression from configuration cache                 *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	*dc_expression_program_dup(const unsigned char *program)
+{
+	unsigned char	*dst;
+	zbx_uint32_t	size;
+
+	if (NULL == program)
+		return NULL;
+
+	size = zbx_expression_program_size(program);
+	dst = (unsigned char *)zbx_malloc(NULL, size);
+	memcpy(dst, program, size);
+
+	return dst;
+}
+
 static void	DCget_trigger(DC_TRIGGER *dst_trigger, const ZBX_DC_TRIGGER *src_trigger)
 {
 	int	i;
@@ -7018,6 +7269,9 @@ static void	DCget_trigger(DC_TRIGGER *dst_trigger, const ZBX_DC_TRIGGER *src_tri
 
 	dst_trigger->expression = zbx_strdup(NULL, src_trigger->expression);
 	dst_trigger->recovery_expression = zbx_strdup(NULL, src_trigger->recovery_expression);
+	dst_trigger->expression_program = dc_expression_program_dup(src_trigger->expression_program);
+	dst_trigger->recovery_expression_program = dc_expression_program_dup(
+			src_trigger->recovery_expression_program);
 
 	zbx_vector_ptr_create(&dst_trigger->tags);
 
@@ -7061,6 +7315,8 @@ static void	DCclean_trigger(DC_TRIGGER *trigger)
 	zbx_free(trigger->recovery_expression_orig);
 	zbx_free(trigger->expression);
 	zbx_free(trigger->recovery_expression);
+	zbx_free(trigger->expression_program);
+	zbx_free(trigger->recovery_expression_program);
 	zbx_free(trigger->description);
 	zbx_free(trigger->correlation_tag);
 	zbx_free(trigger->opdata);
@@ -7167,6 +7423,44 @@ void	DCconfig_get_items_by_itemids(DC_ITEM *items, const zbx_uint64_t *itemids,
 	UNLOCK_CACHE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_get_active_items_state                                  *
+ *                                                                            *
+ * Purpose: get runtime state of the specified active agent items             *
+ *                                                                            *
+ * Parameters: itemids - [IN] the item identifiers                            *
+ *             states  - [OUT] the item states                                *
+ *             num     - [IN] the number of items                             *
+ *                                                                            *
+ * Comments: Zeroed state is returned for items missing in configuration      *
+ *           cache.                                                           *
+ *                                                                            *
+ ******************************************************************************/
+void	DCconfig_get_active_items_state(const zbx_uint64_t *itemids, zbx_active_item_state_t *states, size_t num)
+{
+	size_t			i;
+	const ZBX_DC_ITEM	*dc_item;
+
+	RDLOCK_CACHE;
+
+	for (i = 0; i < num; i++)
+	{
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])))
+		{
+			memset(&states[i], 0, sizeof(zbx_active_item_state_t));
+			continue;
+		}
+
+		states[i].lastlogsize = dc_item->lastlogsize;
+		states[i].mtime = dc_item->mtime;
+		states[i].lastclock = dc_item->lastclock;
+		states[i].state = dc_item->state;
+	}
+
+	UNLOCK_CACHE;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_preproc_item_init                                             *
@@ -8103,6 +8397,75 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
 	DCupdate_item_queue(dc_item, old_poller_type, old_nextcheck);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_snmp_item_async                                               *
+ *                                                                            *
+ * Purpose: check if SNMP item can be requested together with items of other  *
+ *          interfaces                                                        *
+ *                                                                            *
+ * Return value: SUCCEED - the item is SNMP item with plain OID               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_snmp_item_async(const ZBX_DC_ITEM *dc_item)
+{
+	const ZBX_DC_SNMPITEM	*snmpitem;
+
+	if (ITEM_TYPE_SNMP != dc_item->type || 0 != (ZBX_FLAG_DISCOVERY_RULE & dc_item->flags))
+		return FAIL;
+
+	if (NULL == (snmpitem = (const ZBX_DC_SNMPITEM *)zbx_hashset_search(&config->snmpitems, &dc_item->itemid)))
+		return FAIL;
+
+	return ZBX_SNMP_OID_TYPE_NORMAL == snmpitem->snmp_oid_type ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_agent_item_async                                              *
+ *                                                                            *
+ * Purpose: check if passive agent item can be checked together with other    *
+ *          items over nonblocking connection                                 *
+ *                                                                            *
+ * Return value: SUCCEED - the item host does not use encryption              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_agent_item_async(const ZBX_DC_ITEM *dc_item)
+{
+	const ZBX_DC_HOST	*dc_host;
+
+	if (NULL == (dc_host = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
+		return FAIL;
+
+	return ZBX_TCP_SEC_UNENCRYPTED == dc_host->tls_connect ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_agent_item_compare                                            *
+ *                                                                            *
+ * Purpose: check if passive agent item can be checked in the same batch as   *
+ *          the previous item                                                 *
+ *                                                                            *
+ * Return value: SUCCEED - both items are of the same interface, checked over *
+ *                         one connection, or both are unencrypted, checked   *
+ *                         concurrently                                       *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_agent_item_compare(const ZBX_DC_ITEM *dc_item_prev, const ZBX_DC_ITEM *dc_item)
+{
+	if (dc_item_prev->interfaceid == dc_item->interfaceid)
+		return SUCCEED;
+
+	if (SUCCEED == dc_agent_item_async(dc_item_prev) && SUCCEED == dc_agent_item_async(dc_item))
+		return SUCCEED;
+
+	return FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: DCconfig_get_poller_items                                        *
@@ -8120,9 +8483,9 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
  *           always return the items they have taken using DCrequeue_items()  *
  *           or DCpoller_requeue_items().                                     *
  *                                                                            *
- *           Currently batch polling is supported only for JMX, SNMP and      *
- *           icmpping* simple checks. In other cases only single item is      *
- *           retrieved.                                                       *
+ *           Currently batch polling is supported only for JMX, SNMP,         *
+ *           Zabbix agent, HTTP agent and icmpping* simple checks. In other   *
+ *           cases only single item is retrieved.                             *
  *                                                                            *
  *           IPMI poller queue are handled by DCconfig_get_ipmi_poller_items()*
  *           function.                                                        *
@@ -8130,7 +8493,7 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
  ******************************************************************************/
 int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 {
-	int			now, num = 0, max_items;
+	int			now, num = 0, max_items, group_num = 0, group_max = 1, snmp_async = 0;
 	zbx_binary_heap_t	*queue;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() poller_type:%d", __func__, (int)poller_type);
@@ -8156,6 +8519,7 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 	while (num < max_items && FAIL == zbx_binary_heap_empty(queue))
 	{
 		int				disable_until;
+		int				new_group = 0;
 		const zbx_binary_heap_elem_t	*min;
 		ZBX_DC_HOST			*dc_host;
 		ZBX_DC_ITEM			*dc_item;
@@ -8172,6 +8536,14 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 			if (ITEM_TYPE_SNMP == dc_item_prev->type)
 			{
 				if (0 != __config_snmp_item_compare(dc_item_prev, dc_item))
+				{
+					/* standard SNMP items of other interfaces are queried concurrently */
+					if (0 == snmp_async || FAIL == dc_snmp_item_async(dc_item))
+						break;
+
+					new_group = 1;
+				}
+				else if (group_num == group_max)
 					break;
 			}
 			else if (ITEM_TYPE_JMX == dc_item_prev->type)
@@ -8179,6 +8551,16 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 				if (0 != __config_java_item_compare(dc_item_prev, dc_item))
 					break;
 			}
+			else if (ITEM_TYPE_ZABBIX == dc_item_prev->type)
+			{
+				if (ITEM_TYPE_ZABBIX != dc_item->type || FAIL == dc_agent_item_compare(dc_item_prev, dc_item))
+					break;
+			}
+			else if (ITEM_TYPE_HTTPAGENT == dc_item_prev->type)
+			{
+				if (ITEM_TYPE_HTTPAGENT != dc_item->type)
+					break;
+			}
 		}
 
 		zbx_binary_heap_remove_min(queue);
@@ -8226,13 +8608,35 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 			}
 		}
 
+		if (0 != new_group)
+		{
+			group_num = 0;
+			group_max = 1;
+		}
+
 		dc_item_prev = dc_item;
 		dc_item->location = ZBX_LOC_POLLER;
 		DCget_host(&items[num].host, dc_host);
 		DCget_item(&items[num], dc_item);
 		num++;
+		group_num++;
 
-		if (1 == num && ZBX_POLLER_TYPE_NORMAL == poller_type && ITEM_TYPE_SNMP == dc_item->type &&
+		/* unencrypted passive agent checks are performed concurrently and checks of the same */
+		/* interface over one connection, see get_values_agent()                             */
+		if (1 == num && ITEM_TYPE_ZABBIX == dc_item->type && (ZBX_POLLER_TYPE_NORMAL == poller_type ||
+				ZBX_POLLER_TYPE_UNREACHABLE == poller_type))
+		{
+			max_items = MAX_POLLER_ITEMS;
+		}
+#ifdef HAVE_LIBCURL
+		/* HTTP agent checks are performed concurrently, see get_values_http() */
+		if (1 == num && ITEM_TYPE_HTTPAGENT == dc_item->type && (ZBX_POLLER_TYPE_NORMAL == poller_type ||
+				ZBX_POLLER_TYPE_UNREACHABLE == poller_type))
+		{
+			max_items = MAX_POLLER_ITEMS;
+		}
+#endif
+		if (1 == group_num && ZBX_POLLER_TYPE_NORMAL == poller_type && ITEM_TYPE_SNMP == dc_item->type &&
 				0 == (ZBX_FLAG_DISCOVERY_RULE & dc_item->flags))
 		{
 			ZBX_DC_SNMPITEM	*snmpitem;
@@ -8242,7 +8646,20 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 			if (ZBX_SNMP_OID_TYPE_NORMAL == snmpitem->snmp_oid_type ||
 					ZBX_SNMP_OID_TYPE_DYNAMIC == snmpitem->snmp_oid_type)
 			{
-				max_items = DCconfig_get_suggested_snmp_vars_nolock(dc_item->interfaceid, NULL);
+				group_max = DCconfig_get_suggested_snmp_vars_nolock(dc_item->interfaceid, NULL);
+			}
+
+			if (1 == num)
+			{
+				/* standard SNMP items are requested from several interfaces at once, */
+				/* see get_values_snmp(), other SNMP items from one interface only    */
+				if (SUCCEED == dc_snmp_item_async(dc_item))
+				{
+					snmp_async = 1;
+					max_items = MAX_POLLER_ITEMS;
+				}
+				else
+					max_items = group_max;
 			}
 		}
 	}
@@ -9341,6 +9758,26 @@ void	*DCconfig_get_stats(int request)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_get_rdlock_stats                                        *
+ *                                                                            *
+ * Purpose: get configuration cache read lock wait time histogram             *
+ *                                                                            *
+ * Parameters: stats  - [OUT] the read lock wait statistics                   *
+ *             bounds - [OUT] the histogram bucket upper bounds in seconds,   *
+ *                            ZBX_DC_LOCK_WAIT_BUCKETS - 1 values             *
+ *                                                                            *
+ ******************************************************************************/
+void	DCconfig_get_rdlock_stats(zbx_dc_lock_stats_t *stats, const double **bounds)
+{
+	zbx_mutex_lock(config_stats_lock);
+	*stats = config->rdlock_stats;
+	zbx_mutex_unlock(config_stats_lock);
+
+	*bounds = rdlock_wait_bounds;
+}
+
 static void	DCget_proxy(DC_PROXY *dst_proxy, const ZBX_DC_PROXY *src_proxy)
 {
 	const ZBX_DC_HOST	*host;
@@ -9418,6 +9855,28 @@ int	DCconfig_get_last_sync_time(void)
 	return config->sync_ts;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_get_revision                                            *
+ *                                                                            *
+ * Purpose: get revision of hosts, interfaces, items, macros and regular      *
+ *          expressions in configuration cache                                *
+ *                                                                            *
+ * Comments: Allows processes to keep data prepared from configuration cache  *
+ *           until configuration sync changes it.                             *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	DCconfig_get_revision(void)
+{
+	zbx_uint64_t	revision;
+
+	RDLOCK_CACHE;
+	revision = config->revision;
+	UNLOCK_CACHE;
+
+	return revision;
+}
+
 void	DCconfig_wait_sync(void)
 {
 	struct timespec	ts = {0, 1e8};
@@ -33,6 +33,8 @@ typedef struct
 	const char		*error;
 	const char		*correlation_tag;
 	const char		*opdata;
+	unsigned char		*expression_program;		/* compiled expressions, see      */
+	unsigned char		*recovery_expression_program;	/* zbx_expression_compile()       */
 	int			lastchange;
 	int			nextcheck;		/* time of next trigger recalculation,    */
 							/* valid for triggers with time functions */
@@ -748,6 +750,9 @@ typedef struct
 	int			sync_ts;
 	int			item_sync_ts;
 
+	/* incremented by configuration syncs changing hosts, interfaces, items, macros or regular expressions */
+	zbx_uint64_t		revision;
+
 	unsigned int		internal_actions;		/* number of enabled internal actions */
 
 	/* maintenance processing management */
@@ -827,6 +832,7 @@ typedef struct
 	ZBX_DC_CONFIG_TABLE	*config;
 	ZBX_DC_STATUS		*status;
 	zbx_hashset_t		strpool;
+	zbx_dc_lock_stats_t	rdlock_stats;		/* read lock wait statistics, protected by config_stats_lock */
 	char			autoreg_psk_identity[HOST_TLS_PSK_IDENTITY_LEN_MAX];	/* autoregistration PSK */
 	char			autoreg_psk[HOST_TLS_PSK_LEN_MAX];
 }
@@ -836,7 +842,9 @@ extern int	sync_in_progress;
 extern ZBX_DC_CONFIG	*config;
 extern zbx_rwlock_t	config_lock;
 
-#define	RDLOCK_CACHE	if (0 == sync_in_progress) zbx_rwlock_rdlock(config_lock)
+void	dc_rdlock_cache(void);
+
+#define	RDLOCK_CACHE	if (0 == sync_in_progress) dc_rdlock_cache()
 #define	WRLOCK_CACHE	if (0 == sync_in_progress) zbx_rwlock_wrlock(config_lock)
 #define	UNLOCK_CACHE	if (0 == sync_in_progress) zbx_rwlock_unlock(config_lock)
 
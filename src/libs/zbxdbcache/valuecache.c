@@ -124,6 +124,67 @@ zbx_vc_chunk_t;
 #define ZBX_VC_MAX_CHUNK_RECORDS	((64 * ZBX_KIBIBYTE - sizeof(zbx_vc_chunk_t)) / \
 		sizeof(zbx_history_record_t) + 1)
 
+/* the window minimum/maximum value candidates, kept in a ring buffer in timestamp order */
+typedef struct
+{
+	zbx_history_record_t	*values;
+	int			values_alloc;
+	int			values_num;
+	int			first;
+}
+zbx_vc_window_queue_t;
+
+/* the sliding window aggregates */
+typedef struct zbx_vc_window
+{
+	/* the next window of the same item */
+	struct zbx_vc_window	*next;
+
+	/* the window length and time shift in seconds, identifying the window */
+	int			seconds;
+	int			time_shift;
+
+	/* the last time when window was requested */
+	int			last_accessed;
+
+	/* the aggregates maintained in window, see ZBX_VC_AGGREGATE_* defines */
+	unsigned char		flags;
+
+	/* 0 - the window must be rebuilt from cached values before it can be used */
+	unsigned char		valid;
+
+	/* the window contains values with timestamps in range (start, end] */
+	zbx_timespec_t		start;
+	zbx_timespec_t		end;
+
+	/* the position of the first (oldest) value in window */
+	zbx_vc_chunk_t		*first_chunk;
+	int			first_index;
+
+	/* the position of the value following the last (newest) value in window */
+	zbx_vc_chunk_t		*next_chunk;
+	int			next_index;
+
+	/* the number of values in window */
+	int			values_num;
+
+	/* the number of values removed from window since the sums were calculated from scratch */
+	int			values_removed;
+
+	zbx_uint64_t		sum_ui64;
+	double			sum_dbl;
+
+	/* the rounding error of sum_dbl, see vch_window_sum_dbl() */
+	double			sum_dbl_err;
+
+	zbx_vc_window_queue_t	min;
+	zbx_vc_window_queue_t	max;
+}
+zbx_vc_window_t;
+
+/* the maximum number of sliding windows tracked per item */
+#define ZBX_VC_ITEM_WINDOWS_MAX		8
+
 /* the item operational state flags */
 #define ZBX_ITEM_STATE_CLEAN_PENDING	1
 #define ZBX_ITEM_STATE_REMOVE_PENDING	2
@@ -186,6 +247,9 @@ typedef struct
 
 	/* the first (oldest) chunk of item history data              */
 	zbx_vc_chunk_t	*tail;
+
+	/* the sliding windows with item history data aggregates      */
+	zbx_vc_window_t	*windows;
 }
 zbx_vc_item_t;
 
@@ -243,6 +307,7 @@ static size_t	vch_item_free_cache(zbx_vc_item_t *item);
 static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk);
 static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num);
 static void	vch_item_clean_cache(zbx_vc_item_t *item);
+static void	vch_item_invalidate_windows(zbx_vc_item_t *item, const zbx_vc_chunk_t *chunk, int first_value);
 
 /******************************************************************************
  *                                                                            *
@@ -1674,6 +1739,8 @@ static void	vch_item_remove_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
 	if (chunk == item->tail)
 		item->tail = chunk->next;
 
+	/* all window positions in chunk are less than its slot count + 1 */
+	vch_item_invalidate_windows(item, chunk, chunk->slots_num + 1);
 	vch_item_free_chunk(item, chunk);
 }
 
@@ -1724,6 +1791,8 @@ static void	vch_item_clean_cache(zbx_vc_item_t *item)
 					vc_item_free_values(item, next->slots, next->first_value, next->first_value);
 					next->first_value++;
 				}
+
+				vch_item_invalidate_windows(item, next, next->first_value);
 			}
 
 			/* set the database cached from timestamp to the last (oldest) removed value timestamp + 1 */
@@ -1775,6 +1844,8 @@ static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
 				chunk->first_value++;
 			}
 
+			vch_item_invalidate_windows(item, chunk, chunk->first_value);
+
 			break;
 		}
 
@@ -1834,6 +1905,9 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 			goto out;
 		}
 
+		/* the value is inserted between cached values, shifting their positions */
+		vch_item_invalidate_windows(item, NULL, 0);
+
 		sindex = item->head->last_value;
 		schunk = item->head;
 
@@ -1934,6 +2008,10 @@ static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_re
 		while (--count >= 0 && values[count].timestamp.sec >= sec)
 			;
 		++count;
+
+		/* windows starting at the first cached value must be extended to the older values */
+		if (0 != count)
+			vch_item_invalidate_windows(item, item->tail, item->tail->first_value + 1);
 	}
 
 	while (0 != count)
@@ -2356,6 +2434,639 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_window_queue_free                                            *
+ *                                                                            *
+ * Purpose: frees resources allocated for window minimum/maximum candidates   *
+ *                                                                            *
+ * Parameters: queue - [IN] the candidate queue                               *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_window_queue_free(zbx_vc_window_queue_t *queue)
+{
+	size_t	freed = 0;
+
+	if (NULL != queue->values)
+	{
+		freed = queue->values_alloc * sizeof(zbx_history_record_t);
+		__vc_mem_free_func(queue->values);
+		queue->values = NULL;
+	}
+
+	queue->values_alloc = 0;
+	queue->values_num = 0;
+	queue->first = 0;
+
+	return freed;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_window_free                                                  *
+ *                                                                            *
+ * Purpose: frees resources allocated for sliding window                      *
+ *                                                                            *
+ * Parameters: window - [IN] the window                                       *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_window_free(zbx_vc_window_t *window)
+{
+	size_t	freed = sizeof(zbx_vc_window_t);
+
+	freed += vch_window_queue_free(&window->min);
+	freed += vch_window_queue_free(&window->max);
+
+	__vc_mem_free_func(window);
+
+	return freed;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_invalidate_windows                                      *
+ *                                                                            *
+ * Purpose: marks item windows referring to removed values for rebuilding     *
+ *                                                                            *
+ * Parameters: item        - [IN] the item                                    *
+ *             chunk       - [IN] the chunk with removed values, NULL if      *
+ *                                cached values were moved and all windows    *
+ *                                must be rebuilt                             *
+ *             first_value - [IN] the window positions in chunk below this    *
+ *                                index refer to removed values               *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_invalidate_windows(zbx_vc_item_t *item, const zbx_vc_chunk_t *chunk, int first_value)
+{
+	zbx_vc_window_t	*window;
+
+	for (window = item->windows; NULL != window; window = window->next)
+	{
+		if (NULL == chunk || (window->first_chunk == chunk && window->first_index < first_value) ||
+				(window->next_chunk == chunk && window->next_index < first_value))
+		{
+			window->valid = 0;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_window_value_compare                                         *
+ *                                                                            *
+ * Purpose: compares two numeric history values                               *
+ *                                                                            *
+ * Parameters: v1         - [IN] the first value                              *
+ *             v2         - [IN] the second value                             *
+ *             value_type - [IN] the value type                               *
+ *                                                                            *
+ * Return value: <0 - the first value is less than the second                 *
+ *                0 - the values are equal                                    *
+ *               >0 - the first value is greater than the second              *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_window_value_compare(const history_value_t *v1, const history_value_t *v2, int value_type)
+{
+	if (ITEM_VALUE_TYPE_UINT64 == value_type)
+	{
+		ZBX_RETURN_IF_NOT_EQUAL(v1->ui64, v2->ui64);
+	}
+	else
+	{
+		ZBX_RETURN_IF_NOT_EQUAL(v1->dbl, v2->dbl);
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_window_queue_push                                            *
+ *                                                                            *
+ * Purpose: adds the newest window value to minimum/maximum candidates        *
+ *                                                                            *
+ * Parameters: item   - [IN] the item                                         *
+ *             queue  - [IN/OUT] the candidate queue                          *
+ *             record - [IN] the value                                        *
+ *             sign   - [IN] 1 - the queue keeps minimum candidates,          *
+ *                          -1 - the queue keeps maximum candidates           *
+ *                                                                            *
+ * Return value: SUCCEED - the value was added                                *
+ *               FAIL    - not enough memory                                  *
+ *                                                                            *
+ * Comments: The candidates older than a value and not better than it cannot  *
+ *           become window extremes while the value stays in window, so they  *
+ *           are dropped. This keeps the candidates ordered by both           *
+ *           timestamps and values with the extreme at the queue front.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_window_queue_push(zbx_vc_item_t *item, zbx_vc_window_queue_t *queue,
+		const zbx_history_record_t *record, int sign)
+{
+	while (0 < queue->values_num)
+	{
+		int	last = (queue->first + queue->values_num - 1) % queue->values_alloc;
+
+		if (0 > sign * vch_window_value_compare(&queue->values[last].value, &record->value, item->value_type))
+			break;
+
+		queue->values_num--;
+	}
+
+	if (queue->values_num == queue->values_alloc)
+	{
+		zbx_history_record_t	*values;
+		int			values_alloc, i;
+
+		values_alloc = (0 == queue->values_alloc ? 16 : queue->values_alloc * 2);
+
+		if (NULL == (values = (zbx_history_record_t *)vc_item_malloc(item,
+				values_alloc * sizeof(zbx_history_record_t))))
+		{
+			return FAIL;
+		}
+
+		for (i = 0; i < queue->values_num; i++)
+			values[i] = queue->values[(queue->first + i) % queue->values_alloc];
+
+		if (NULL != queue->values)
+			__vc_mem_free_func(queue->values);
+
+		queue->values = values;
+		queue->values_alloc = values_alloc;
+		queue->first = 0;
+	}
+
+	queue->values[(queue->first + queue->values_num++) % queue->values_alloc] = *record;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_window_queue_remove                                          *
+ *                                                                            *
+ * Purpose: removes minimum/maximum candidates that left the window           *
+ *                                                                            *
+ * Parameters: queue - [IN/OUT] the candidate queue                           *
+ *             start - [IN] the window start timestamp                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_window_queue_remove(zbx_vc_window_queue_t *queue, const zbx_timespec_t *start)
+{
+	while (0 < queue->values_num && 0 >= zbx_timespec_compare(&queue->values[queue->first].timestamp, start))
+	{
+		queue->first = (queue->first + 1) % queue->values_alloc;
+		queue->values_num--;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_window_get_value                                             *
+ *                                                                            *
+ * Purpose: gets cached value at the specified window position                *
+ *                                                                            *
+ * Parameters: chunk - [IN/OUT] the position chunk                            *
+ *             index - [IN/OUT] the position index                            *
+ *                                                                            *
+ * Return value: the value or NULL if the position is after the last cached   *
+ *               value                                                        *
+ *                                                                            *
+ * Comments: The position past the last chunk value is moved to the first     *
+ *           value of the next chunk. When there is no next chunk it stays    *
+ *           unchanged, so values added to cache later are found there.       *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_history_record_t	*vch_window_get_value(zbx_vc_chunk_t **chunk, int *index)
+{
+	while (*index > (*chunk)->last_value)
+	{
+		if (NULL == (*chunk)->next)
+			return NULL;
+
+		*chunk = (*chunk)->next;
+		*index = (*chunk)->first_value;
+	}
+
+	return &(*chunk)->slots[*index];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_window_sum_dbl                                               *
+ *                                                                            *
+ * Purpose: adds floating point value to window sum                           *
+ *                                                                            *
+ * Parameters: window - [IN/OUT] the window                                   *
+ *             value  - [IN] the value to add, negative to remove value       *
+ *                                                                            *
+ * Comments: The low order bits lost when rounding the sum are accumulated    *
+ *           separately (Neumaier summation). Otherwise a large value leaving *
+ *           the window would leave behind rounding errors of its magnitude   *
+ *           for every value added and removed while it was in the window.    *
+ *           The error is not tracked once the sum has overflowed.            *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_window_sum_dbl(zbx_vc_window_t *window, double value)
+{
+	double	sum;
+
+	sum = window->sum_dbl + value;
+
+	if (ZBX_INFINITY != fabs(sum))
+	{
+		if (fabs(window->sum_dbl) >= fabs(value))
+			window->sum_dbl_err += (window->sum_dbl - sum) + value;
+		else
+			window->sum_dbl_err += (value - sum) + window->sum_dbl;
+	}
+
+	window->sum_dbl = sum;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_window_add_value                                             *
+ *                                                                            *
+ * Purpose: adds value to window sums                                         *
+ *                                                                            *
+ * Parameters: window     - [IN/OUT] the window                               *
+ *             record     - [IN] the value                                    *
+ *             value_type - [IN] the value type                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_window_add_value(zbx_vc_window_t *window, const zbx_history_record_t *record, int value_type)
+{
+	window->values_num++;
+
+	switch (value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			vch_window_sum_dbl(window, record->value.dbl);
+			break;
+		case ITEM_VALUE_TYPE_UINT64:
+			window->sum_ui64 += record->value.ui64;
+			vch_window_sum_dbl(window, (double)record->value.ui64);
+			break;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_window_remove_value                                          *
+ *                                                                            *
+ * Purpose: removes value from window sums                                    *
+ *                                                                            *
+ * Parameters: window     - [IN/OUT] the window                               *
+ *             record     - [IN] the value                                    *
+ *             value_type - [IN] the value type                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_window_remove_value(zbx_vc_window_t *window, const zbx_history_record_t *record, int value_type)
+{
+	if (0 == --window->values_num)
+	{
+		window->sum_ui64 = 0;
+		window->sum_dbl = 0;
+		window->sum_dbl_err = 0;
+		window->values_removed = 0;
+		return;
+	}
+
+	switch (value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			vch_window_sum_dbl(window, -record->value.dbl);
+			break;
+		case ITEM_VALUE_TYPE_UINT64:
+			window->sum_ui64 -= record->value.ui64;
+			vch_window_sum_dbl(window, -(double)record->value.ui64);
+			break;
+	}
+
+	window->values_removed++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_window_calculate_sums                                        *
+ *                                                                            *
+ * Purpose: calculates window sums from scratch                               *
+ *                                                                            *
+ * Parameters: window     - [IN/OUT] the window                               *
+ *             value_type - [IN] the value type                               *
+ *                                                                            *
+ * Comments: The tracked rounding error of floating point sum is not exact    *
+ *           either, so the sums are recalculated after the window contents   *
+ *           have been replaced. This keeps the amortized cost per value      *
+ *           constant. Overflowed sum cannot be restored by removing values   *
+ *           and is recalculated on every window update.                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_window_calculate_sums(zbx_vc_window_t *window, int value_type)
+{
+	zbx_vc_chunk_t	*chunk = window->first_chunk;
+	int		index = window->first_index, values_num = window->values_num;
+
+	window->values_num = 0;
+	window->values_removed = 0;
+	window->sum_ui64 = 0;
+	window->sum_dbl = 0;
+	window->sum_dbl_err = 0;
+
+	while (window->values_num < values_num)
+	{
+		vch_window_add_value(window, vch_window_get_value(&chunk, &index), value_type);
+		index++;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_window_calculate_avg                                         *
+ *                                                                            *
+ * Purpose: calculates average of window values without summing them          *
+ *                                                                            *
+ * Parameters: window - [IN] the window with floating point values            *
+ *                                                                            *
+ * Return value: the average of window values                                 *
+ *                                                                            *
+ * Comments: Used when the window sum overflows while the average does not.   *
+ *                                                                            *
+ ******************************************************************************/
+static double	vch_window_calculate_avg(const zbx_vc_window_t *window)
+{
+	zbx_vc_chunk_t	*chunk = window->first_chunk;
+	int		index = window->first_index, i;
+	double		avg = 0;
+
+	for (i = 0; i < window->values_num; i++, index++)
+		avg += vch_window_get_value(&chunk, &index)->value.dbl / (i + 1) - avg / (i + 1);
+
+	return avg;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_window_reset                                                 *
+ *                                                                            *
+ * Purpose: empties window and positions it at the specified start timestamp  *
+ *                                                                            *
+ * Parameters: item   - [IN] the item, must have cached values                *
+ *             window - [IN/OUT] the window                                   *
+ *             start  - [IN] the window start timestamp                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_window_reset(zbx_vc_item_t *item, zbx_vc_window_t *window, const zbx_timespec_t *start)
+{
+	if (SUCCEED == vch_item_get_last_value(item, start, &window->first_chunk, &window->first_index))
+	{
+		window->first_index++;
+	}
+	else
+	{
+		window->first_chunk = item->tail;
+		window->first_index = item->tail->first_value;
+	}
+
+	window->next_chunk = window->first_chunk;
+	window->next_index = window->first_index;
+
+	window->values_num = 0;
+	window->values_removed = 0;
+	window->sum_ui64 = 0;
+	window->sum_dbl = 0;
+	window->sum_dbl_err = 0;
+
+	window->min.values_num = 0;
+	window->min.first = 0;
+	window->max.values_num = 0;
+	window->max.first = 0;
+
+	window->valid = 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_window_update                                                *
+ *                                                                            *
+ * Purpose: slides window to the specified time period                        *
+ *                                                                            *
+ * Parameters: item   - [IN] the item, must have cached values                *
+ *             window - [IN/OUT] the window                                   *
+ *             start  - [IN] the window start timestamp (exclusive)           *
+ *             end    - [IN] the window end timestamp (inclusive)             *
+ *                                                                            *
+ * Return value: SUCCEED - the window was updated                             *
+ *               FAIL    - not enough memory for minimum/maximum candidates   *
+ *                                                                            *
+ * Comments: Only the values added to and removed from the window since the   *
+ *           last update are processed. When the window moves backwards it is *
+ *           rebuilt from the cached values.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_window_update(zbx_vc_item_t *item, zbx_vc_window_t *window, const zbx_timespec_t *start,
+		const zbx_timespec_t *end)
+{
+	zbx_history_record_t	*record;
+
+	if (0 == window->valid || 0 > zbx_timespec_compare(start, &window->start) ||
+			0 > zbx_timespec_compare(end, &window->end))
+	{
+		vch_window_reset(item, window, start);
+	}
+
+	while (NULL != (record = vch_window_get_value(&window->next_chunk, &window->next_index)) &&
+			0 >= zbx_timespec_compare(&record->timestamp, end))
+	{
+		vch_window_add_value(window, record, item->value_type);
+
+		if (0 != (window->flags & ZBX_VC_AGGREGATE_MIN) &&
+				SUCCEED != vch_window_queue_push(item, &window->min, record, 1))
+		{
+			goto fail;
+		}
+
+		if (0 != (window->flags & ZBX_VC_AGGREGATE_MAX) &&
+				SUCCEED != vch_window_queue_push(item, &window->max, record, -1))
+		{
+			goto fail;
+		}
+
+		window->next_index++;
+	}
+
+	while (0 < window->values_num)
+	{
+		record = vch_window_get_value(&window->first_chunk, &window->first_index);
+
+		if (0 < zbx_timespec_compare(&record->timestamp, start))
+			break;
+
+		vch_window_remove_value(window, record, item->value_type);
+		window->first_index++;
+	}
+
+	vch_window_queue_remove(&window->min, start);
+	vch_window_queue_remove(&window->max, start);
+
+	if (window->values_removed > window->values_num || ZBX_INFINITY == fabs(window->sum_dbl))
+		vch_window_calculate_sums(window, item->value_type);
+
+	window->start = *start;
+	window->end = *end;
+
+	return SUCCEED;
+fail:
+	window->valid = 0;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_window                                              *
+ *                                                                            *
+ * Purpose: finds or creates item sliding window                              *
+ *                                                                            *
+ * Parameters: item       - [IN] the item                                     *
+ *             seconds    - [IN] the window length                            *
+ *             time_shift - [IN] the window time shift                        *
+ *             now        - [IN] the current timestamp                        *
+ *                                                                            *
+ * Return value: the window or NULL if there was not enough memory            *
+ *                                                                            *
+ * Comments: When the item already has the maximum number of windows, the     *
+ *           least recently used window is taken over.                        *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_vc_window_t	*vch_item_get_window(zbx_vc_item_t *item, int seconds, int time_shift, int now)
+{
+	zbx_vc_window_t	*window, *lru = NULL;
+	int		windows_num = 0;
+
+	for (window = item->windows; NULL != window; window = window->next, windows_num++)
+	{
+		if (window->seconds == seconds && window->time_shift == time_shift)
+			goto out;
+
+		if (NULL == lru || window->last_accessed < lru->last_accessed)
+			lru = window;
+	}
+
+	if (ZBX_VC_ITEM_WINDOWS_MAX <= windows_num)
+	{
+		window = lru;
+		window->flags = 0;
+		window->valid = 0;
+	}
+	else
+	{
+		if (NULL == (window = (zbx_vc_window_t *)vc_item_malloc(item, sizeof(zbx_vc_window_t))))
+			return NULL;
+
+		memset(window, 0, sizeof(zbx_vc_window_t));
+		window->next = item->windows;
+		item->windows = window;
+	}
+
+	window->seconds = seconds;
+	window->time_shift = time_shift;
+out:
+	window->last_accessed = now;
+
+	return window;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_aggregate                                           *
+ *                                                                            *
+ * Purpose: calculates aggregates of item values in time period               *
+ *                                                                            *
+ * Parameters: item       - [IN] the item                                     *
+ *             seconds    - [IN] the time period length                       *
+ *             time_shift - [IN] the time shift of period end timestamp       *
+ *             ts         - [IN] the period end timestamp                     *
+ *             flags      - [IN] the requested aggregates                     *
+ *             aggregate  - [OUT] the aggregates                              *
+ *                                                                            *
+ * Return value:  SUCCEED - the aggregates were calculated successfully       *
+ *                FAIL    - failed to cache values or not enough memory for   *
+ *                          sliding window                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_aggregate(zbx_vc_item_t *item, int seconds, int time_shift, const zbx_timespec_t *ts,
+		unsigned char flags, zbx_vc_aggregate_t *aggregate)
+{
+	int		records_read, range_start, now;
+	zbx_timespec_t	start = {ts->sec - seconds, ts->ns};
+	zbx_vc_window_t	*window;
+
+	if (0 > (range_start = ts->sec - seconds))
+		range_start = 0;
+
+	if (FAIL == (records_read = vch_item_cache_values_by_time(item, range_start)))
+		return FAIL;
+
+	now = time(NULL);
+
+	/* update the item range the same way as for value requests, see vch_item_get_values_by_time() */
+	if (0 != item->active_range || ZBX_ITEM_STATUS_CACHED_ALL != item->status)
+		vch_item_update_range(item, seconds + now - ts->sec + 1, now);
+
+	memset(aggregate, 0, sizeof(zbx_vc_aggregate_t));
+
+	if (NULL != item->head)
+	{
+		if (NULL == (window = vch_item_get_window(item, seconds, time_shift, now)))
+			return FAIL;
+
+		/* start tracking the newly requested aggregates */
+		if (flags != (window->flags & flags))
+		{
+			window->flags |= flags;
+			window->valid = 0;
+		}
+
+		if (SUCCEED != vch_window_update(item, window, &start, ts))
+			return FAIL;
+
+		if (0 != (aggregate->values_num = window->values_num))
+		{
+			double	sum_dbl = window->sum_dbl + window->sum_dbl_err;
+
+			if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
+				aggregate->sum.ui64 = window->sum_ui64;
+			else
+				aggregate->sum.dbl = sum_dbl;
+
+			if (ZBX_INFINITY != fabs(sum_dbl))
+				aggregate->avg = sum_dbl / window->values_num;
+			else
+				aggregate->avg = vch_window_calculate_avg(window);
+
+			if (0 != (flags & ZBX_VC_AGGREGATE_MIN))
+				aggregate->min = window->min.values[window->min.first].value;
+
+			if (0 != (flags & ZBX_VC_AGGREGATE_MAX))
+				aggregate->max = window->max.values[window->max.first].value;
+		}
+	}
+
+	if (records_read > aggregate->values_num)
+		records_read = aggregate->values_num;
+
+	vc_update_statistics(item, aggregate->values_num - records_read, records_read);
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: vch_item_free_cache                                              *
@@ -2384,6 +3095,14 @@ static size_t	vch_item_free_cache(zbx_vc_item_t *item)
 	item->head = NULL;
 	item->tail = NULL;
 
+	while (NULL != item->windows)
+	{
+		zbx_vc_window_t	*window = item->windows;
+
+		item->windows = window->next;
+		freed += vch_window_free(window);
+	}
+
 	return freed;
 }
 
@@ -2725,6 +3444,69 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_get_aggregate                                             *
+ *                                                                            *
+ * Purpose: get aggregates of item history data for the specified time period *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             seconds    - [IN] the time period length                       *
+ *             time_shift - [IN] the time shift of period end timestamp,      *
+ *                          identifies the period together with its length    *
+ *             ts         - [IN] the period end timestamp                     *
+ *             flags      - [IN] the requested aggregates, see                *
+ *                          ZBX_VC_AGGREGATE_* defines                        *
+ *             aggregate  - [OUT] the aggregates                              *
+ *                                                                            *
+ * Return value:  SUCCEED - the aggregates were calculated successfully       *
+ *                FAIL    - the aggregates cannot be calculated from cache,   *
+ *                          the values must be requested with                 *
+ *                          zbx_vc_get_values() function                      *
+ *                                                                            *
+ * Comments: The aggregates are maintained in sliding windows updated only    *
+ *           with values entering and leaving the period since the previous   *
+ *           request for the same length and time shift.                      *
+ *           Only items already stored in cache are processed.                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_get_aggregate(zbx_uint64_t itemid, int value_type, int seconds, int time_shift, const zbx_timespec_t *ts,
+		unsigned char flags, zbx_vc_aggregate_t *aggregate)
+{
+	zbx_vc_item_t	*item = NULL;
+	int		ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d seconds:%d time_shift:%d sec:%d"
+			" ns:%d flags:0x%x", __func__, itemid, value_type, seconds, time_shift, ts->sec, ts->ns,
+			(unsigned int)flags);
+
+	vc_try_lock();
+
+	if (ZBX_VC_DISABLED == vc_state)
+		goto out;
+
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+		goto out;
+
+	vc_item_addref(item);
+
+	if (0 != (item->state & ZBX_ITEM_STATE_REMOVE_PENDING) || item->value_type != value_type)
+		goto out;
+
+	ret = vch_item_get_aggregate(item, seconds, time_shift, ts, flags, aggregate);
+out:
+	if (NULL != item)
+		vc_item_release(item);
+
+	vc_try_unlock();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d", __func__, zbx_result_string(ret),
+			SUCCEED == ret ? aggregate->values_num : 0);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_vc_get_statistics                                            *
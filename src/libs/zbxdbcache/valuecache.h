@@ -82,6 +82,25 @@ typedef struct
 }
 zbx_vc_stats_t;
 
+/* the optional value cache aggregates, the value count, sum and average are always calculated */
+#define ZBX_VC_AGGREGATE_MIN	0x01
+#define ZBX_VC_AGGREGATE_MAX	0x02
+
+/* the aggregates of numeric item values in time period */
+typedef struct
+{
+	/* the number of values in period, other aggregates are set only if there are values */
+	int		values_num;
+
+	history_value_t	sum;
+	double		avg;
+
+	/* the minimum and maximum values, set only if requested with ZBX_VC_AGGREGATE_MIN/MAX flags */
+	history_value_t	min;
+	history_value_t	max;
+}
+zbx_vc_aggregate_t;
+
 int	zbx_vc_init(char **error);
 
 void	zbx_vc_destroy(void);
@@ -101,6 +120,9 @@ int	zbx_vc_get_values(zbx_uint64_t itemid, int value_type, zbx_vector_history_re
 
 int	zbx_vc_get_value(zbx_uint64_t itemid, int value_type, const zbx_timespec_t *ts, zbx_history_record_t *value);
 
+int	zbx_vc_get_aggregate(zbx_uint64_t itemid, int value_type, int seconds, int time_shift, const zbx_timespec_t *ts,
+		unsigned char flags, zbx_vc_aggregate_t *aggregate);
+
 int	zbx_vc_add_values(zbx_vector_ptr_t *history);
 
 int	zbx_vc_get_statistics(zbx_vc_stats_t *stats);
@@ -3114,24 +3114,84 @@ static void	log_client_timediff(int level, struct zbx_json_parse *jp, const zbx_
 static int	parse_history_data_row_value(const struct zbx_json_parse *jp_row, zbx_timespec_t *unique_shift,
 		zbx_agent_value_t *av)
 {
-	char	*tmp = NULL;
-	size_t	tmp_alloc = 0;
-	int	ret = FAIL;
+#define ZBX_ROW_TAG_CLOCK		0x01
+#define ZBX_ROW_TAG_NS			0x02
+#define ZBX_ROW_TAG_LASTLOGSIZE		0x04
+#define ZBX_ROW_TAG_MTIME		0x08
+
+	char		*tmp = NULL, name[MAX_STRING_LEN];
+	const char	*p = NULL;
+	size_t		tmp_alloc = 0;
+	int		ret = FAIL, tags = 0, ns_valid = FAIL, mtime = 0;
+	zbx_uint64_t	lastlogsize = 0;
 
 	memset(av, 0, sizeof(zbx_agent_value_t));
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_CLOCK, &tmp, &tmp_alloc, NULL))
+	/* rows can be large (log values), so all tags are decoded in a single pass instead of searching each */
+	while (NULL != (p = zbx_json_pair_next(jp_row, p, name, sizeof(name))))
 	{
-		if (FAIL == is_uint31(tmp, &av->ts.sec))
-			goto out;
+		if (NULL == zbx_json_decodevalue_dyn(p, &tmp, &tmp_alloc, NULL))
+			continue;
 
-		if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_NS, &tmp, &tmp_alloc, NULL))
+		if (0 == strcmp(name, ZBX_PROTO_TAG_CLOCK))
 		{
-			if (FAIL == is_uint_n_range(tmp, tmp_alloc, &av->ts.ns, sizeof(av->ts.ns),
-				0LL, 999999999LL))
-			{
+			if (FAIL == is_uint31(tmp, &av->ts.sec))
+				goto out;
+
+			tags |= ZBX_ROW_TAG_CLOCK;
+		}
+		else if (0 == strcmp(name, ZBX_PROTO_TAG_NS))
+		{
+			ns_valid = is_uint_n_range(tmp, tmp_alloc, &av->ts.ns, sizeof(av->ts.ns), 0LL, 999999999LL);
+			tags |= ZBX_ROW_TAG_NS;
+		}
+		else if (0 == strcmp(name, ZBX_PROTO_TAG_STATE))
+		{
+			av->state = (unsigned char)atoi(tmp);
+		}
+		else if (0 == strcmp(name, ZBX_PROTO_TAG_LASTLOGSIZE))
+		{
+			is_uint64(tmp, &lastlogsize);
+			tags |= ZBX_ROW_TAG_LASTLOGSIZE;
+		}
+		else if (0 == strcmp(name, ZBX_PROTO_TAG_MTIME))
+		{
+			mtime = atoi(tmp);
+			tags |= ZBX_ROW_TAG_MTIME;
+		}
+		else if (0 == strcmp(name, ZBX_PROTO_TAG_VALUE))
+		{
+			av->value = zbx_strdup(av->value, tmp);
+		}
+		else if (0 == strcmp(name, ZBX_PROTO_TAG_LOGTIMESTAMP))
+		{
+			av->timestamp = atoi(tmp);
+		}
+		else if (0 == strcmp(name, ZBX_PROTO_TAG_LOGSOURCE))
+		{
+			av->source = zbx_strdup(av->source, tmp);
+		}
+		else if (0 == strcmp(name, ZBX_PROTO_TAG_LOGSEVERITY))
+		{
+			av->severity = atoi(tmp);
+		}
+		else if (0 == strcmp(name, ZBX_PROTO_TAG_LOGEVENTID))
+		{
+			av->logeventid = atoi(tmp);
+		}
+		else if (0 == strcmp(name, ZBX_PROTO_TAG_ID))
+		{
+			if (SUCCEED != is_uint64(tmp, &av->id))
+				av->id = 0;
+		}
+	}
+
+	if (0 != (tags & ZBX_ROW_TAG_CLOCK))
+	{
+		if (0 != (tags & ZBX_ROW_TAG_NS))
+		{
+			if (FAIL == ns_valid)
 				goto out;
-			}
 		}
 		else
 		{
@@ -3150,50 +3210,33 @@ static int	parse_history_data_row_value(const struct zbx_json_parse *jp_row, zbx
 	else
 		zbx_timespec(&av->ts);
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_STATE, &tmp, &tmp_alloc, NULL))
-		av->state = (unsigned char)atoi(tmp);
-
 	/* Unsupported item meta information must be ignored for backwards compatibility. */
 	/* New agents will not send meta information for items in unsupported state.      */
-	if (ITEM_STATE_NOTSUPPORTED != av->state)
+	if (ITEM_STATE_NOTSUPPORTED != av->state && 0 != (tags & ZBX_ROW_TAG_LASTLOGSIZE))
 	{
-		if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LASTLOGSIZE, &tmp, &tmp_alloc, NULL))
-		{
-			av->meta = 1;	/* contains meta information */
-
-			is_uint64(tmp, &av->lastlogsize);
+		av->meta = 1;	/* contains meta information */
+		av->lastlogsize = lastlogsize;
 
-			if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_MTIME, &tmp, &tmp_alloc, NULL))
-				av->mtime = atoi(tmp);
-		}
+		if (0 != (tags & ZBX_ROW_TAG_MTIME))
+			av->mtime = mtime;
 	}
 
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_VALUE, &tmp, &tmp_alloc, NULL))
-		av->value = zbx_strdup(av->value, tmp);
-
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGTIMESTAMP, &tmp, &tmp_alloc, NULL))
-		av->timestamp = atoi(tmp);
-
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGSOURCE, &tmp, &tmp_alloc, NULL))
-		av->source = zbx_strdup(av->source, tmp);
-
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGSEVERITY, &tmp, &tmp_alloc, NULL))
-		av->severity = atoi(tmp);
-
-	if (SUCCEED == zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_LOGEVENTID, &tmp, &tmp_alloc, NULL))
-		av->logeventid = atoi(tmp);
-
-	if (SUCCEED != zbx_json_value_by_name_dyn(jp_row, ZBX_PROTO_TAG_ID, &tmp, &tmp_alloc, NULL) ||
-			SUCCEED != is_uint64(tmp, &av->id))
+	ret = SUCCEED;
+out:
+	if (SUCCEED != ret)
 	{
-		av->id = 0;
+		zbx_free(av->value);
+		zbx_free(av->source);
 	}
 
 	zbx_free(tmp);
 
-	ret = SUCCEED;
-out:
 	return ret;
+
+#undef ZBX_ROW_TAG_CLOCK
+#undef ZBX_ROW_TAG_NS
+#undef ZBX_ROW_TAG_LASTLOGSIZE
+#undef ZBX_ROW_TAG_MTIME
 }
 
 /******************************************************************************
@@ -22,6 +22,7 @@
 #include "comms.h"
 #include "zbxexec.h"
 #include "log.h"
+#include "icmpsock.h"
 
 extern char	*CONFIG_SOURCE_IP;
 extern char	*CONFIG_FPING_LOCATION;
@@ -549,7 +550,9 @@ out:
  *                                                                            *
  * Author: Alexei Vladishev                                                   *
  *                                                                            *
- * Comments: use external binary 'fping' to avoid superuser privileges        *
+ * Comments: ICMP sockets are used when the process is permitted to open      *
+ *           them, otherwise external binary 'fping' is executed to avoid     *
+ *           superuser privileges                                             *
  *                                                                            *
  ******************************************************************************/
 int	do_ping(ZBX_FPING_HOST *hosts, int hosts_count, int count, int interval, int size, int timeout, char *error,
@@ -559,7 +562,10 @@ int	do_ping(ZBX_FPING_HOST *hosts, int hosts_count, int count, int interval, int
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() hosts_count:%d", __func__, hosts_count);
 
-	if (NOTSUPPORTED == (res = process_ping(hosts, hosts_count, count, interval, size, timeout, error, max_error_len)))
+	if (FAIL == (res = icmp_ping(hosts, hosts_count, count, interval, size, timeout, error, max_error_len)))
+		res = process_ping(hosts, hosts_count, count, interval, size, timeout, error, max_error_len);
+
+	if (NOTSUPPORTED == res)
 		zabbix_log(LOG_LEVEL_ERR, "%s", error);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(res));
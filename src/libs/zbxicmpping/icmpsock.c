@@ -0,0 +1,604 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "log.h"
+#include "zbxicmpping.h"
+#include "icmpsock.h"
+
+#include <poll.h>
+
+extern char	*CONFIG_SOURCE_IP;
+
+#define ZBX_ICMP_ECHO_REQUEST		8
+#define ZBX_ICMP_ECHO_REPLY		0
+#define ZBX_ICMPV6_ECHO_REQUEST		128
+#define ZBX_ICMPV6_ECHO_REPLY		129
+
+#define ZBX_ICMP_HEADER_LEN		8
+#define ZBX_ICMP_DATA_MIN		8	/* payload tag and probe index */
+#define ZBX_ICMP_TAG			0x5a425850
+#define ZBX_ICMP_BUFFER_LEN		(65535 + 60)
+#define ZBX_ICMP_RCVBUF			(4 * ZBX_MEBIBYTE)
+#define ZBX_ICMP_SEND_BURST		256
+
+#define ZBX_ICMP_DEFAULT_INTERVAL	1000	/* fping default period between packets to the same host, ms */
+#define ZBX_ICMP_DEFAULT_SIZE		56
+#define ZBX_ICMP_DEFAULT_TIMEOUT	500
+
+#define ZBX_ICMP_SOCKET_UNINITIALIZED	-2
+#define ZBX_ICMP_SOCKET_UNAVAILABLE	-1
+
+typedef struct
+{
+	int		fd;
+	int		family;
+	/* raw IPv4 sockets receive replies with IP header and replies to other processes, */
+	/* datagram sockets receive only own replies and have echo identifier set by kernel */
+	unsigned char	raw;
+}
+zbx_icmp_socket_t;
+
+typedef struct
+{
+	ZBX_FPING_HOST		*host;
+	zbx_icmp_socket_t	*sock;
+	struct sockaddr_storage	addr;
+	socklen_t		addr_len;
+}
+zbx_icmp_target_t;
+
+static zbx_icmp_socket_t	icmp_socket = {ZBX_ICMP_SOCKET_UNINITIALIZED, AF_INET, 0};
+#ifdef HAVE_IPV6
+static zbx_icmp_socket_t	icmp_socket6 = {ZBX_ICMP_SOCKET_UNINITIALIZED, AF_INET6, 0};
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_socket_open                                                 *
+ *                                                                            *
+ * Purpose: open ICMP socket of the specified family                          *
+ *                                                                            *
+ * Parameters: sock - [IN/OUT] the socket, family must be set                 *
+ *                                                                            *
+ * Return value: SUCCEED - the socket is ready for use                        *
+ *               FAIL    - the process is not permitted to open ICMP sockets  *
+ *                         or the socket cannot be bound to SourceIP          *
+ *                                                                            *
+ * Comments: unprivileged datagram ICMP sockets are preferred, raw sockets    *
+ *           are used when the process has the required capability. The       *
+ *           result is remembered, so the socket is opened once per process.  *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_socket_open(zbx_icmp_socket_t *sock)
+{
+	int		protocol, rcvbuf = ZBX_ICMP_RCVBUF;
+	const char	*type = "datagram";
+
+	if (ZBX_ICMP_SOCKET_UNINITIALIZED != sock->fd)
+		return ZBX_ICMP_SOCKET_UNAVAILABLE == sock->fd ? FAIL : SUCCEED;
+
+#ifdef HAVE_IPV6
+	protocol = (AF_INET == sock->family ? IPPROTO_ICMP : IPPROTO_ICMPV6);
+#else
+	protocol = IPPROTO_ICMP;
+#endif
+	if (-1 == (sock->fd = socket(sock->family, SOCK_DGRAM, protocol)))
+	{
+		if (-1 == (sock->fd = socket(sock->family, SOCK_RAW, protocol)))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot open ICMP socket for %s: %s",
+					AF_INET == sock->family ? "IPv4" : "IPv6", zbx_strerror(errno));
+			goto fail;
+		}
+
+		sock->raw = 1;
+		type = "raw";
+	}
+
+	if (NULL != CONFIG_SOURCE_IP)
+	{
+		struct addrinfo	hints, *ai = NULL;
+		int		ret;
+
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = sock->family;
+		hints.ai_flags = AI_NUMERICHOST;
+
+		if (0 != getaddrinfo(CONFIG_SOURCE_IP, NULL, &hints, &ai))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot resolve SourceIP '%s' for ICMP socket", CONFIG_SOURCE_IP);
+			goto fail;
+		}
+
+		ret = bind(sock->fd, ai->ai_addr, ai->ai_addrlen);
+		freeaddrinfo(ai);
+
+		if (0 != ret)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot bind ICMP socket to SourceIP '%s': %s", CONFIG_SOURCE_IP,
+					zbx_strerror(errno));
+			goto fail;
+		}
+	}
+
+	if (-1 == fcntl(sock->fd, F_SETFL, fcntl(sock->fd, F_GETFL) | O_NONBLOCK) ||
+			-1 == fcntl(sock->fd, F_SETFD, FD_CLOEXEC))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot configure ICMP socket: %s", zbx_strerror(errno));
+		goto fail;
+	}
+
+	/* a large batch of hosts answers in bursts, do not let the replies be dropped */
+	if (0 != setsockopt(sock->fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)))
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot set ICMP socket receive buffer: %s", zbx_strerror(errno));
+
+	zabbix_log(LOG_LEVEL_DEBUG, "using %s ICMP socket for %s", type, AF_INET == sock->family ? "IPv4" : "IPv6");
+
+	return SUCCEED;
+fail:
+	if (0 <= sock->fd)
+		close(sock->fd);
+
+	sock->fd = ZBX_ICMP_SOCKET_UNAVAILABLE;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_checksum                                                    *
+ *                                                                            *
+ * Purpose: calculate internet checksum (RFC 1071) of ICMP message            *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned short	icmp_checksum(const unsigned char *data, size_t len)
+{
+	zbx_uint32_t	sum = 0;
+	size_t		i;
+
+	for (i = 0; i + 1 < len; i += 2)
+		sum += (zbx_uint32_t)(data[i] << 8 | data[i + 1]);
+
+	if (i < len)
+		sum += (zbx_uint32_t)(data[i] << 8);
+
+	while (0 != (sum >> 16))
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return (unsigned short)~sum;
+}
+
+static void	icmp_put_uint16(unsigned char *data, unsigned short value)
+{
+	data[0] = (unsigned char)(value >> 8);
+	data[1] = (unsigned char)value;
+}
+
+static void	icmp_put_uint32(unsigned char *data, zbx_uint32_t value)
+{
+	data[0] = (unsigned char)(value >> 24);
+	data[1] = (unsigned char)(value >> 16);
+	data[2] = (unsigned char)(value >> 8);
+	data[3] = (unsigned char)value;
+}
+
+static unsigned short	icmp_get_uint16(const unsigned char *data)
+{
+	return (unsigned short)(data[0] << 8 | data[1]);
+}
+
+static zbx_uint32_t	icmp_get_uint32(const unsigned char *data)
+{
+	return (zbx_uint32_t)data[0] << 24 | (zbx_uint32_t)data[1] << 16 | (zbx_uint32_t)data[2] << 8 | data[3];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_target_resolve                                              *
+ *                                                                            *
+ * Purpose: resolve target host address and select ICMP socket for it         *
+ *                                                                            *
+ * Return value: SUCCEED - the target can be pinged                           *
+ *               FAIL    - the address cannot be resolved, such hosts are     *
+ *                         reported as not reachable (like fping does)        *
+ *               NOTSUPPORTED - there is no ICMP socket for address family    *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_target_resolve(zbx_icmp_target_t *target)
+{
+	struct addrinfo	hints, *ai = NULL;
+	int		ret = SUCCEED;
+
+	memset(&hints, 0, sizeof(hints));
+#ifdef HAVE_IPV6
+	hints.ai_family = PF_UNSPEC;
+
+	/* SourceIP limits pinged hosts to its address family, the same as with fping */
+	if (NULL != CONFIG_SOURCE_IP)
+		hints.ai_family = (SUCCEED == is_ip4(CONFIG_SOURCE_IP) ? AF_INET : AF_INET6);
+#else
+	hints.ai_family = AF_INET;
+#endif
+	hints.ai_socktype = SOCK_DGRAM;
+
+	if (0 != getaddrinfo(target->host->addr, NULL, &hints, &ai))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot resolve ICMP ping target '%s'", target->host->addr);
+		return FAIL;
+	}
+
+	memcpy(&target->addr, ai->ai_addr, ai->ai_addrlen);
+	target->addr_len = ai->ai_addrlen;
+
+#ifdef HAVE_IPV6
+	if (AF_INET6 == ai->ai_family)
+		target->sock = &icmp_socket6;
+	else
+#endif
+		target->sock = &icmp_socket;
+
+	if (SUCCEED != icmp_socket_open(target->sock))
+		ret = NOTSUPPORTED;
+
+	freeaddrinfo(ai);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_addr_equal                                                  *
+ *                                                                            *
+ * Purpose: check if reply came from the target address                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_addr_equal(const struct sockaddr_storage *addr, const zbx_icmp_target_t *target)
+{
+	if (addr->ss_family != target->addr.ss_family)
+		return FAIL;
+
+#ifdef HAVE_IPV6
+	if (AF_INET6 == addr->ss_family)
+	{
+		return 0 == memcmp(&((const struct sockaddr_in6 *)addr)->sin6_addr,
+				&((const struct sockaddr_in6 *)&target->addr)->sin6_addr, sizeof(struct in6_addr)) ?
+				SUCCEED : FAIL;
+	}
+#endif
+	return ((const struct sockaddr_in *)addr)->sin_addr.s_addr ==
+			((const struct sockaddr_in *)&target->addr)->sin_addr.s_addr ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_send_probe                                                  *
+ *                                                                            *
+ * Purpose: send echo request for the specified probe                         *
+ *                                                                            *
+ * Parameters: target - [IN] the target host                                  *
+ *             probe  - [IN] the probe index, encoded in request payload      *
+ *             buf    - [IN/OUT] the request buffer with zeroed payload       *
+ *             len    - [IN] the request length                               *
+ *             id     - [IN] the echo identifier for raw sockets              *
+ *                                                                            *
+ ******************************************************************************/
+static void	icmp_send_probe(const zbx_icmp_target_t *target, int probe, unsigned char *buf, size_t len,
+		unsigned short id)
+{
+	buf[0] = (AF_INET == target->sock->family ? ZBX_ICMP_ECHO_REQUEST : ZBX_ICMPV6_ECHO_REQUEST);
+	buf[1] = 0;
+	icmp_put_uint16(buf + 2, 0);
+	icmp_put_uint16(buf + 4, id);
+	icmp_put_uint16(buf + 6, (unsigned short)probe);
+	icmp_put_uint32(buf + ZBX_ICMP_HEADER_LEN, ZBX_ICMP_TAG);
+	icmp_put_uint32(buf + ZBX_ICMP_HEADER_LEN + 4, (zbx_uint32_t)probe);
+
+	/* ICMPv6 checksum covers pseudo header and is always calculated by kernel */
+	if (AF_INET == target->sock->family)
+		icmp_put_uint16(buf + 2, icmp_checksum(buf, len));
+
+	if (-1 == sendto(target->sock->fd, buf, len, 0, (const struct sockaddr *)&target->addr, target->addr_len))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot send ICMP echo request to '%s': %s", target->host->addr,
+				zbx_strerror(errno));
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_recv_replies                                                *
+ *                                                                            *
+ * Purpose: read all pending echo replies from the socket and account them    *
+ *          to the target hosts                                               *
+ *                                                                            *
+ * Parameters: sock        - [IN] the socket                                  *
+ *             targets     - [IN] the target hosts                            *
+ *             hosts_count - [IN] the number of target hosts                  *
+ *             count       - [IN] the number of probes per host               *
+ *             sent        - [IN] the probe send timestamps                   *
+ *             timeout     - [IN] the reply timeout in seconds                *
+ *             id          - [IN] the echo identifier for raw sockets         *
+ *             buf         - [IN] the receive buffer                          *
+ *                                                                            *
+ * Return value: the number of accepted replies                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_recv_replies(const zbx_icmp_socket_t *sock, zbx_icmp_target_t *targets, int hosts_count,
+		int count, const double *sent, double timeout, unsigned short id, unsigned char *buf)
+{
+	struct sockaddr_storage	from;
+	socklen_t		from_len;
+	ssize_t			n;
+	const unsigned char	*icmp;
+	size_t			len;
+	int			probe, replies = 0;
+	zbx_uint32_t		value;
+	zbx_icmp_target_t	*target;
+	double			now, sec;
+
+	while (1)
+	{
+		from_len = sizeof(from);
+
+		if (-1 == (n = recvfrom(sock->fd, buf, ZBX_ICMP_BUFFER_LEN, 0, (struct sockaddr *)&from, &from_len)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			break;
+		}
+
+		now = zbx_time();
+		icmp = buf;
+		len = (size_t)n;
+
+		/* raw IPv4 socket returns the whole datagram */
+		if (0 != sock->raw && AF_INET == sock->family)
+		{
+			size_t	ip_header_len;
+
+			if (0 == len || len < (ip_header_len = (size_t)(buf[0] & 0x0f) * 4))
+				continue;
+
+			icmp += ip_header_len;
+			len -= ip_header_len;
+		}
+
+		if (ZBX_ICMP_HEADER_LEN + ZBX_ICMP_DATA_MIN > len)
+			continue;
+
+		if (icmp[0] != (AF_INET == sock->family ? ZBX_ICMP_ECHO_REPLY : ZBX_ICMPV6_ECHO_REPLY))
+			continue;
+
+		if (0 != sock->raw && id != icmp_get_uint16(icmp + 4))
+			continue;
+
+		if (ZBX_ICMP_TAG != icmp_get_uint32(icmp + ZBX_ICMP_HEADER_LEN))
+			continue;
+
+		value = icmp_get_uint32(icmp + ZBX_ICMP_HEADER_LEN + 4);
+
+		if (value >= (zbx_uint32_t)(hosts_count * count) || (unsigned short)value != icmp_get_uint16(icmp + 6))
+			continue;
+
+		probe = (int)value;
+		target = &targets[probe % hosts_count];
+
+		/* replies from other addresses (for example, to broadcast pings) are not counted */
+		if (target->sock != sock || SUCCEED != icmp_addr_equal(&from, target))
+			continue;
+
+		/* duplicates and late replies are ignored */
+		if (1 == target->host->status[probe / hosts_count] || 0 > (sec = now - sent[probe]) || sec > timeout)
+			continue;
+
+		target->host->status[probe / hosts_count] = 1;
+
+		if (0 == target->host->rcv || target->host->min > sec)
+			target->host->min = sec;
+		if (0 == target->host->rcv || target->host->max < sec)
+			target->host->max = sec;
+		target->host->sum += sec;
+		target->host->rcv++;
+
+		replies++;
+	}
+
+	return replies;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_ping                                                        *
+ *                                                                            *
+ * Purpose: ping hosts using ICMP sockets opened by the process               *
+ *                                                                            *
+ * Parameters: hosts       - [IN/OUT] the hosts to ping                       *
+ *             hosts_count - [IN] the number of hosts                         *
+ *             count       - [IN] the number of packets sent to each host     *
+ *             interval    - [IN] the interval between packets sent to the    *
+ *                                same host, ms (0 - default)                 *
+ *             size        - [IN] the packet data size (0 - default)          *
+ *             timeout     - [IN] the reply timeout, ms (0 - default)         *
+ *             error       - [OUT] the error message                          *
+ *             max_error_len - [IN] the error buffer size                     *
+ *                                                                            *
+ * Return value: SUCCEED      - hosts were pinged                             *
+ *               NOTSUPPORTED - no host could be pinged                       *
+ *               FAIL         - the process cannot open ICMP sockets for      *
+ *                              the hosts, external fping must be used        *
+ *                                                                            *
+ * Comments: All probes are sent from a single socket per address family and  *
+ *           matched to hosts by the probe index carried in echo payload, so  *
+ *           the number of outstanding probes is limited by the batch only.   *
+ *           Probes of each round are spread over half of the interval to     *
+ *           avoid bursts. Send times are monotonic in probe index order, so  *
+ *           the pending probes form a queue and only its head is tracked.    *
+ *                                                                            *
+ ******************************************************************************/
+int	icmp_ping(ZBX_FPING_HOST *hosts, int hosts_count, int count, int interval, int size, int timeout, char *error,
+		size_t max_error_len)
+{
+	static unsigned char	*recv_buf = NULL;
+
+	zbx_icmp_target_t	*targets;
+	unsigned char		*send_buf;
+	double			*sent, start, now, spread, sec_timeout, due, last_sent = 0;
+	int			i, ret = FAIL, probe = 0, probes, expected = 0, replies = 0, fds_num = 0, wait_ms, rc,
+				burst;
+	size_t			send_len;
+	unsigned short		id;
+	struct pollfd		fds[2];
+	zbx_icmp_socket_t	*socks[2];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() hosts_count:%d count:%d interval:%d size:%d timeout:%d", __func__,
+			hosts_count, count, interval, size, timeout);
+
+	if (0 == interval)
+		interval = ZBX_ICMP_DEFAULT_INTERVAL;
+
+	if (0 == size)
+		size = ZBX_ICMP_DEFAULT_SIZE;
+
+	if (0 == timeout)
+		timeout = ZBX_ICMP_DEFAULT_TIMEOUT;
+
+	targets = (zbx_icmp_target_t *)zbx_malloc(NULL, sizeof(zbx_icmp_target_t) * (size_t)hosts_count);
+
+	for (i = 0; i < hosts_count; i++)
+	{
+		targets[i].host = &hosts[i];
+
+		if (FAIL == (rc = icmp_target_resolve(&targets[i])))
+		{
+			targets[i].sock = NULL;
+			continue;
+		}
+
+		if (NOTSUPPORTED == rc)
+			goto out;
+	}
+
+	ret = NOTSUPPORTED;
+
+	if (NULL == recv_buf)
+		recv_buf = (unsigned char *)zbx_malloc(NULL, ZBX_ICMP_BUFFER_LEN);
+
+	send_len = ZBX_ICMP_HEADER_LEN + (size_t)MAX(size, ZBX_ICMP_DATA_MIN);
+	send_buf = (unsigned char *)zbx_calloc(NULL, 1, send_len);
+	probes = hosts_count * count;
+	sent = (double *)zbx_malloc(NULL, sizeof(double) * (size_t)probes);
+	id = (unsigned short)getpid();
+	sec_timeout = (double)timeout / 1000;
+	spread = (double)interval / 2000 / hosts_count;
+
+	for (i = 0; i < hosts_count; i++)
+	{
+		hosts[i].status = (char *)zbx_calloc(NULL, 1, (size_t)count);
+
+		if (NULL == targets[i].sock)
+			continue;
+
+		hosts[i].cnt = count;
+		expected += count;
+		ret = SUCCEED;
+	}
+
+	if (0 <= icmp_socket.fd)
+		socks[fds_num++] = &icmp_socket;
+#ifdef HAVE_IPV6
+	if (0 <= icmp_socket6.fd)
+		socks[fds_num++] = &icmp_socket6;
+#endif
+	for (i = 0; i < fds_num; i++)
+	{
+		fds[i].fd = socks[i]->fd;
+		fds[i].events = POLLIN;
+
+		/* discard late replies to the previous batch, no probe matches them */
+		icmp_recv_replies(socks[i], targets, 0, 0, NULL, 0, id, recv_buf);
+	}
+
+	start = zbx_time();
+
+	while (replies < expected)
+	{
+		now = zbx_time();
+
+		/* limit bursts to read the replies before they overflow socket receive buffer */
+		for (burst = 0; probe < probes && ZBX_ICMP_SEND_BURST > burst; probe++)
+		{
+			due = start + (double)(probe / hosts_count) * interval / 1000 + (probe % hosts_count) * spread;
+
+			if (due > now)
+				break;
+
+			if (NULL == targets[probe % hosts_count].sock)
+				continue;
+
+			icmp_send_probe(&targets[probe % hosts_count], probe, send_buf, send_len, id);
+			sent[probe] = last_sent = zbx_time();
+			burst++;
+		}
+
+		if (probe < probes)
+			due = start + (double)(probe / hosts_count) * interval / 1000 + (probe % hosts_count) * spread;
+		else if ((due = last_sent + sec_timeout) <= now)
+			break;
+
+		if (0 > (wait_ms = (int)((due - now) * 1000) + 1))
+			wait_ms = 0;
+
+		if (0 >= (rc = poll(fds, (nfds_t)fds_num, wait_ms)))
+		{
+			if (-1 == rc && EINTR != errno)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "cannot wait for ICMP replies: %s", zbx_strerror(errno));
+				break;
+			}
+
+			continue;
+		}
+
+		for (i = 0; i < fds_num; i++)
+		{
+			if (0 == (fds[i].revents & POLLIN))
+				continue;
+
+			replies += icmp_recv_replies(socks[i], targets, hosts_count, count, sent, sec_timeout, id,
+					recv_buf);
+		}
+	}
+
+	for (i = 0; i < hosts_count; i++)
+		zbx_free(hosts[i].status);
+
+	zbx_free(sent);
+	zbx_free(send_buf);
+
+	if (NOTSUPPORTED == ret)
+		zbx_strlcpy(error, "cannot resolve any of the hosts", max_error_len);
+out:
+	zbx_free(targets);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s replies:%d", __func__, zbx_result_string(ret), replies);
+
+	return ret;
+}
@@ -577,13 +577,14 @@ static int	evaluate_COUNT(char **value, DC_ITEM *item, const char *parameters, c
 		char **error)
 {
 	int				arg1, op = OP_UNKNOWN, numeric_search, nparams, count = 0, i, ret = FAIL;
-	int				seconds = 0, nvalues = 0;
+	int				seconds = 0, nvalues = 0, time_shift = 0, count_all;
 	char				*arg2 = NULL, *arg2_2 = NULL, *arg3 = NULL, buf[ZBX_MAX_UINT64_LEN];
 	double				arg2_dbl;
 	zbx_uint64_t			arg2_ui64, arg2_2_ui64;
 	zbx_value_type_t		arg1_type;
 	zbx_vector_ptr_t		regexps;
 	zbx_vector_history_record_t	values;
+	zbx_vc_aggregate_t		aggregate;
 	zbx_timespec_t			ts_end = *ts;
 	size_t				value_alloc = 0, value_offset = 0;
 
@@ -621,7 +622,6 @@ static int	evaluate_COUNT(char **value, DC_ITEM *item, const char *parameters, c
 
 	if (4 <= nparams)
 	{
-		int			time_shift = 0;
 		zbx_value_type_t	time_shift_type = ZBX_VALUE_SECONDS;
 
 		if (SUCCEED != get_function_parameter_int(item->host.hostid, parameters, 4, ZBX_PARAM_OPTIONAL,
@@ -771,15 +771,21 @@ static int	evaluate_COUNT(char **value, DC_ITEM *item, const char *parameters, c
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	/* skip counting values one by one if both pattern and operator are empty or "" is searched in text values */
+	count_all = !((NULL != arg2 && '\0' != *arg2) || (NULL != arg3 && '\0' != *arg3 &&
+			OP_LIKE != op && OP_REGEXP != op && OP_IREGEXP != op));
+
+	if (0 != count_all && 0 != seconds && SUCCEED == zbx_vc_get_aggregate(item->itemid, item->value_type,
+			seconds, time_shift, &ts_end, 0, &aggregate))
+	{
+		count = aggregate.values_num;
+	}
+	else if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
-
-	/* skip counting values one by one if both pattern and operator are empty or "" is searched in text values */
-	if ((NULL != arg2 && '\0' != *arg2) || (NULL != arg3 && '\0' != *arg3 &&
-			OP_LIKE != op && OP_REGEXP != op && OP_IREGEXP != op))
+	else if (0 == count_all)
 	{
 		switch (item->value_type)
 		{
@@ -881,9 +887,10 @@ out:
  ******************************************************************************/
 static int	evaluate_SUM(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, i, ret = FAIL, seconds = 0, nvalues = 0;
+	int				nparams, arg1, i, ret = FAIL, seconds = 0, nvalues = 0, time_shift = 0;
 	zbx_value_type_t		arg1_type;
 	zbx_vector_history_record_t	values;
+	zbx_vc_aggregate_t		aggregate;
 	history_value_t			result;
 	zbx_timespec_t			ts_end = *ts;
 
@@ -912,7 +919,6 @@ static int	evaluate_SUM(char **value, DC_ITEM *item, const char *parameters, con
 
 	if (2 == nparams)
 	{
-		int			time_shift = 0;
 		zbx_value_type_t	time_shift_type = ZBX_VALUE_SECONDS;
 
 		if (SUCCEED != get_function_parameter_int(item->host.hostid, parameters, 2, ZBX_PARAM_OPTIONAL,
@@ -938,25 +944,33 @@ static int	evaluate_SUM(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (0 != seconds && SUCCEED == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, time_shift,
+			&ts_end, 0, &aggregate))
 	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto out;
-	}
-
-	if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-	{
-		result.dbl = 0;
-
-		for (i = 0; i < values.values_num; i++)
-			result.dbl += values.values[i].value.dbl;
+		result = aggregate.sum;
 	}
 	else
 	{
-		result.ui64 = 0;
+		if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+		{
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto out;
+		}
+
+		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
+		{
+			result.dbl = 0;
+
+			for (i = 0; i < values.values_num; i++)
+				result.dbl += values.values[i].value.dbl;
+		}
+		else
+		{
+			result.ui64 = 0;
 
-		for (i = 0; i < values.values_num; i++)
-			result.ui64 += values.values[i].value.ui64;
+			for (i = 0; i < values.values_num; i++)
+				result.ui64 += values.values[i].value.ui64;
+		}
 	}
 
 	*value = zbx_history_value2str_dyn(&result, item->value_type);
@@ -984,9 +998,12 @@ out:
  ******************************************************************************/
 static int	evaluate_AVG(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, ret = FAIL, i, seconds = 0, nvalues = 0;
+	int				nparams, arg1, ret = FAIL, i, seconds = 0, nvalues = 0, time_shift = 0,
+					values_num;
+	double				avg = 0;
 	zbx_value_type_t		arg1_type;
 	zbx_vector_history_record_t	values;
+	zbx_vc_aggregate_t		aggregate;
 	zbx_timespec_t			ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -1014,7 +1031,6 @@ static int	evaluate_AVG(char **value, DC_ITEM *item, const char *parameters, con
 
 	if (2 == nparams)
 	{
-		int			time_shift = 0;
 		zbx_value_type_t	time_shift_type = ZBX_VALUE_SECONDS;
 
 		if (SUCCEED != get_function_parameter_int(item->host.hostid, parameters, 2, ZBX_PARAM_OPTIONAL,
@@ -1040,29 +1056,41 @@ static int	evaluate_AVG(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (0 != seconds && SUCCEED == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, time_shift,
+			&ts_end, 0, &aggregate))
 	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto out;
+		values_num = aggregate.values_num;
+		avg = aggregate.avg;
 	}
-
-	if (0 < values.values_num)
+	else
 	{
-		double	avg = 0;
-		size_t	value_alloc = 0, value_offset = 0;
-
-		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
+		if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 		{
-			for (i = 0; i < values.values_num; i++)
-				avg += values.values[i].value.dbl / (i + 1) - avg / (i + 1);
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto out;
 		}
-		else
+
+		if (0 < (values_num = values.values_num))
 		{
-			for (i = 0; i < values.values_num; i++)
-				avg += values.values[i].value.ui64;
+			if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
+			{
+				for (i = 0; i < values.values_num; i++)
+					avg += values.values[i].value.dbl / (i + 1) - avg / (i + 1);
+			}
+			else
+			{
+				for (i = 0; i < values.values_num; i++)
+					avg += values.values[i].value.ui64;
 
-			avg = avg / values.values_num;
+				avg = avg / values.values_num;
+			}
 		}
+	}
+
+	if (0 < values_num)
+	{
+		size_t	value_alloc = 0, value_offset = 0;
+
 		zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_DBL64, avg);
 
 		ret = SUCCEED;
@@ -1194,9 +1222,12 @@ out:
  ******************************************************************************/
 static int	evaluate_MIN(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, i, ret = FAIL, seconds = 0, nvalues = 0;
+	int				nparams, arg1, i, ret = FAIL, seconds = 0, nvalues = 0, time_shift = 0,
+					values_num;
 	zbx_value_type_t		arg1_type;
 	zbx_vector_history_record_t	values;
+	zbx_vc_aggregate_t		aggregate;
+	history_value_t			*result = NULL;
 	zbx_timespec_t			ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -1224,7 +1255,6 @@ static int	evaluate_MIN(char **value, DC_ITEM *item, const char *parameters, con
 
 	if (2 == nparams)
 	{
-		int			time_shift = 0;
 		zbx_value_type_t	time_shift_type = ZBX_VALUE_SECONDS;
 
 		if (SUCCEED != get_function_parameter_int(item->host.hostid, parameters, 2, ZBX_PARAM_OPTIONAL,
@@ -1250,34 +1280,48 @@ static int	evaluate_MIN(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (0 != seconds && SUCCEED == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, time_shift,
+			&ts_end, ZBX_VC_AGGREGATE_MIN, &aggregate))
 	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto out;
+		values_num = aggregate.values_num;
+		result = &aggregate.min;
 	}
-
-	if (0 < values.values_num)
+	else
 	{
-		int	index = 0;
+		if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+		{
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto out;
+		}
 
-		if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
+		if (0 < (values_num = values.values_num))
 		{
-			for (i = 1; i < values.values_num; i++)
+			int	index = 0;
+
+			if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
 			{
-				if (values.values[i].value.ui64 < values.values[index].value.ui64)
-					index = i;
+				for (i = 1; i < values.values_num; i++)
+				{
+					if (values.values[i].value.ui64 < values.values[index].value.ui64)
+						index = i;
+				}
 			}
-		}
-		else
-		{
-			for (i = 1; i < values.values_num; i++)
+			else
 			{
-				if (values.values[i].value.dbl < values.values[index].value.dbl)
-					index = i;
+				for (i = 1; i < values.values_num; i++)
+				{
+					if (values.values[i].value.dbl < values.values[index].value.dbl)
+						index = i;
+				}
 			}
+
+			result = &values.values[index].value;
 		}
+	}
 
-		*value = zbx_history_value2str_dyn(&values.values[index].value, item->value_type);
+	if (0 < values_num)
+	{
+		*value = zbx_history_value2str_dyn(result, item->value_type);
 		ret = SUCCEED;
 	}
 	else
@@ -1308,9 +1352,12 @@ out:
  ******************************************************************************/
 static int	evaluate_MAX(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, ret = FAIL, i, seconds = 0, nvalues = 0;
+	int				nparams, arg1, ret = FAIL, i, seconds = 0, nvalues = 0, time_shift = 0,
+					values_num;
 	zbx_value_type_t		arg1_type;
 	zbx_vector_history_record_t	values;
+	zbx_vc_aggregate_t		aggregate;
+	history_value_t			*result = NULL;
 	zbx_timespec_t			ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -1338,7 +1385,6 @@ static int	evaluate_MAX(char **value, DC_ITEM *item, const char *parameters, con
 
 	if (2 == nparams)
 	{
-		int			time_shift = 0;
 		zbx_value_type_t	time_shift_type = ZBX_VALUE_SECONDS;
 
 		if (SUCCEED != get_function_parameter_int(item->host.hostid, parameters, 2, ZBX_PARAM_OPTIONAL,
@@ -1364,34 +1410,48 @@ static int	evaluate_MAX(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (0 != seconds && SUCCEED == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, time_shift,
+			&ts_end, ZBX_VC_AGGREGATE_MAX, &aggregate))
 	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto out;
+		values_num = aggregate.values_num;
+		result = &aggregate.max;
 	}
-
-	if (0 < values.values_num)
+	else
 	{
-		int	index = 0;
+		if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+		{
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto out;
+		}
 
-		if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
+		if (0 < (values_num = values.values_num))
 		{
-			for (i = 1; i < values.values_num; i++)
+			int	index = 0;
+
+			if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
 			{
-				if (values.values[i].value.ui64 > values.values[index].value.ui64)
-					index = i;
+				for (i = 1; i < values.values_num; i++)
+				{
+					if (values.values[i].value.ui64 > values.values[index].value.ui64)
+						index = i;
+				}
 			}
-		}
-		else
-		{
-			for (i = 1; i < values.values_num; i++)
+			else
 			{
-				if (values.values[i].value.dbl > values.values[index].value.dbl)
-					index = i;
+				for (i = 1; i < values.values_num; i++)
+				{
+					if (values.values[i].value.dbl > values.values[index].value.dbl)
+						index = i;
+				}
 			}
+
+			result = &values.values[index].value;
 		}
+	}
 
-		*value = zbx_history_value2str_dyn(&values.values[index].value, item->value_type);
+	if (0 < values_num)
+	{
+		*value = zbx_history_value2str_dyn(result, item->value_type);
 
 		ret = SUCCEED;
 	}
@@ -1422,6 +1482,81 @@ static int	__history_record_uint64_compare(const zbx_history_record_t *d1, const
 	return 0;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: history_record_select                                            *
+ *                                                                            *
+ * Purpose: moves the n-th smallest value to its sorted position              *
+ *                                                                            *
+ * Parameters: values     - [IN/OUT] the values                               *
+ *             values_num - [IN] the number of values                         *
+ *             n          - [IN] the index of value to select                 *
+ *             compare    - [IN] the value comparison function                *
+ *                                                                            *
+ * Comments: Values before the n-th position are less or equal and values     *
+ *           after it greater or equal to the selected value. Quickselect     *
+ *           with median of three pivot is used, which is linear on average   *
+ *           instead of sorting all values.                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	history_record_select(zbx_history_record_t *values, int values_num, int n, zbx_compare_func_t compare)
+{
+	int			left = 0, right = values_num - 1, i, j, middle;
+	zbx_history_record_t	pivot, tmp;
+
+	while (left < right)
+	{
+		middle = left + (right - left) / 2;
+
+		/* order the first, middle and last values to use the median as pivot */
+		if (0 < compare(&values[left], &values[middle]))
+		{
+			tmp = values[left];
+			values[left] = values[middle];
+			values[middle] = tmp;
+		}
+
+		if (0 < compare(&values[middle], &values[right]))
+		{
+			tmp = values[middle];
+			values[middle] = values[right];
+			values[right] = tmp;
+
+			if (0 < compare(&values[left], &values[middle]))
+			{
+				tmp = values[left];
+				values[left] = values[middle];
+				values[middle] = tmp;
+			}
+		}
+
+		pivot = values[middle];
+
+		for (i = left, j = right; i <= j;)
+		{
+			while (0 > compare(&values[i], &pivot))
+				i++;
+
+			while (0 < compare(&values[j], &pivot))
+				j--;
+
+			if (i <= j)
+			{
+				tmp = values[i];
+				values[i++] = values[j];
+				values[j--] = tmp;
+			}
+		}
+
+		if (n <= j)
+			right = j;
+		else if (n >= i)
+			left = i;
+		else
+			break;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: evaluate_PERCENTILE                                              *
@@ -1507,16 +1642,22 @@ static int	evaluate_PERCENTILE(char **value, DC_ITEM *item, const char *paramete
 	{
 		int	index;
 
-		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-			zbx_vector_history_record_sort(&values, (zbx_compare_func_t)__history_record_float_compare);
-		else
-			zbx_vector_history_record_sort(&values, (zbx_compare_func_t)__history_record_uint64_compare);
-
 		if (0 == percentage)
 			index = 1;
 		else
 			index = (int)ceil(values.values_num * (percentage / 100));
 
+		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
+		{
+			history_record_select(values.values, values.values_num, index - 1,
+					(zbx_compare_func_t)__history_record_float_compare);
+		}
+		else
+		{
+			history_record_select(values.values, values.values_num, index - 1,
+					(zbx_compare_func_t)__history_record_uint64_compare);
+		}
+
 		*value = zbx_history_value2str_dyn(&values.values[index - 1].value, item->value_type);
 
 		ret = SUCCEED;
@@ -4696,6 +4696,47 @@ static int	extract_expression_functionids(zbx_vector_uint64_t *functionids, cons
 	return (NULL == bl ? SUCCEED : FAIL);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: extract_program_functionids                                      *
+ *                                                                            *
+ * Purpose: get functionids used by compiled expression                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	extract_program_functionids(zbx_vector_uint64_t *functionids, const unsigned char *program)
+{
+	const zbx_uint64_t	*ids;
+	int			i, ids_num;
+
+	ids_num = zbx_expression_program_functionids(program, &ids);
+
+	for (i = 0; i < ids_num; i++)
+	{
+		/* functionid 0 stands for {TRIGGER.VALUE} macro */
+		if (0 != ids[i])
+			zbx_vector_uint64_append(functionids, ids[i]);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trigger_is_compiled                                              *
+ *                                                                            *
+ * Purpose: check if trigger expressions can be evaluated by executing their  *
+ *          compiled programs                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	trigger_is_compiled(const DC_TRIGGER *tr)
+{
+	if (NULL == tr->expression_program)
+		return FAIL;
+
+	if (TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION == tr->recovery_mode && NULL == tr->recovery_expression_program)
+		return FAIL;
+
+	return SUCCEED;
+}
+
 static void	zbx_extract_functionids(zbx_vector_uint64_t *functionids, zbx_vector_ptr_t *triggers)
 {
 	DC_TRIGGER	*tr;
@@ -4712,6 +4753,16 @@ static void	zbx_extract_functionids(zbx_vector_uint64_t *functionids, zbx_vector
 		if (NULL != tr->new_error)
 			continue;
 
+		if (SUCCEED == trigger_is_compiled(tr))
+		{
+			extract_program_functionids(functionids, tr->expression_program);
+
+			if (TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION == tr->recovery_mode)
+				extract_program_functionids(functionids, tr->recovery_expression_program);
+
+			continue;
+		}
+
 		values_num_save = functionids->values_num;
 
 		if (SUCCEED != extract_expression_functionids(functionids, tr->expression))
@@ -4778,6 +4829,35 @@ static int	expand_trigger_macros(DB_EVENT *event, DC_TRIGGER *trigger, char *err
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: trigger_expand_macros                                            *
+ *                                                                            *
+ * Purpose: expand macros in trigger expressions before their evaluation in   *
+ *          textual form                                                      *
+ *                                                                            *
+ * Return value: SUCCEED - the macros were expanded                           *
+ *               FAIL    - otherwise, trigger error is set                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	trigger_expand_macros(DC_TRIGGER *tr)
+{
+	DB_EVENT	event;
+	char		err[MAX_STRING_LEN];
+
+	event.object = EVENT_OBJECT_TRIGGER;
+	event.value = tr->value;
+
+	if (SUCCEED != expand_trigger_macros(&event, tr, err, sizeof(err)))
+	{
+		tr->new_error = zbx_dsprintf(tr->new_error, "Cannot evaluate expression: %s", err);
+		tr->new_value = TRIGGER_VALUE_UNKNOWN;
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_link_triggers_with_functions                                 *
@@ -4815,11 +4895,21 @@ static void	zbx_link_triggers_with_functions(zbx_vector_ptr_t *triggers_func_pos
 		if (NULL != tr->new_error)
 			continue;
 
-		ev.value = tr->value;
+		if (SUCCEED == trigger_is_compiled(tr))
+		{
+			extract_program_functionids(&funcids, tr->expression_program);
+		}
+		else
+		{
+			ev.value = tr->value;
+
+			expand_trigger_macros(&ev, tr, NULL, 0);
 
-		expand_trigger_macros(&ev, tr, NULL, 0);
+			if (SUCCEED != extract_expression_functionids(&funcids, tr->expression))
+				zbx_vector_uint64_clear(&funcids);
+		}
 
-		if (SUCCEED == extract_expression_functionids(&funcids, tr->expression))
+		if (0 != funcids.values_num)
 		{
 			tr_func_pos = (zbx_trigger_func_position_t *)zbx_malloc(NULL, sizeof(zbx_trigger_func_position_t));
 			tr_func_pos->trigger = tr;
@@ -4909,14 +4999,21 @@ typedef struct
 	zbx_uint64_t	itemid;
 	char		*function;
 	char		*parameter;
+	char		*parameter_key;	/* canonical parameter form, see func_get_parameter_key() */
 	zbx_timespec_t	timespec;
 
 	/* output data */
-	char		*value;
-	char		*error;
+	char				*value;
+	char				*error;
+	zbx_expression_operand_t	operand;	/* value parsed for compiled expressions */
+	unsigned char			operand_status;	/* see ZBX_FUNC_OPERAND_* defines        */
 }
 zbx_func_t;
 
+#define ZBX_FUNC_OPERAND_UNPARSED	0
+#define ZBX_FUNC_OPERAND_PARSED		1
+#define ZBX_FUNC_OPERAND_INVALID	2
+
 typedef struct
 {
 	zbx_uint64_t	functionid;
@@ -4931,7 +5028,7 @@ static zbx_hash_t	func_hash_func(const void *data)
 
 	hash = ZBX_DEFAULT_UINT64_HASH_FUNC(&func->itemid);
 	hash = ZBX_DEFAULT_STRING_HASH_ALGO(func->function, strlen(func->function), hash);
-	hash = ZBX_DEFAULT_STRING_HASH_ALGO(func->parameter, strlen(func->parameter), hash);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(func->parameter_key, strlen(func->parameter_key), hash);
 	hash = ZBX_DEFAULT_HASH_ALGO(&func->timespec.sec, sizeof(func->timespec.sec), hash);
 	hash = ZBX_DEFAULT_HASH_ALGO(&func->timespec.ns, sizeof(func->timespec.ns), hash);
 
@@ -4949,7 +5046,7 @@ static int	func_compare_func(const void *d1, const void *d2)
 	if (0 != (ret = strcmp(func1->function, func2->function)))
 		return ret;
 
-	if (0 != (ret = strcmp(func1->parameter, func2->parameter)))
+	if (0 != (ret = strcmp(func1->parameter_key, func2->parameter_key)))
 		return ret;
 
 	ZBX_RETURN_IF_NOT_EQUAL(func1->timespec.sec, func2->timespec.sec);
@@ -4964,8 +5061,67 @@ static void	func_clean(void *ptr)
 
 	zbx_free(func->function);
 	zbx_free(func->parameter);
+	zbx_free(func->parameter_key);
 	zbx_free(func->value);
 	zbx_free(func->error);
+
+	if (ZBX_FUNC_OPERAND_PARSED == func->operand_status)
+		zbx_expression_operand_clear(&func->operand);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: func_get_parameter_key                                           *
+ *                                                                            *
+ * Purpose: get canonical form of function parameters                         *
+ *                                                                            *
+ * Parameters: function  - [IN] the function name                             *
+ *             parameter - [IN] the function parameters                       *
+ *                                                                            *
+ * Return value: The canonical parameters. This value must be freed by the    *
+ *               caller.                                                      *
+ *                                                                            *
+ * Comments: Parameters are compared by their unquoted values as they are     *
+ *           seen by the function evaluation, so that differently quoted or   *
+ *           spaced parameters of the same function are evaluated only once.  *
+ *           The evaluation period of time based functions is converted to    *
+ *           seconds, making for example avg(5m) and avg(300) equal.          *
+ *                                                                            *
+ ******************************************************************************/
+static char	*func_get_parameter_key(const char *function, const char *parameter)
+{
+	const char	*ptr;
+	char		*key = NULL, *value;
+	size_t		key_alloc = 0, key_offset = 0, params_len, param_pos, param_len, sep_pos;
+	int		idx = 0, quoted, seconds;
+
+	zbx_snprintf_alloc(&key, &key_alloc, &key_offset, "%d", num_param(parameter));
+
+	params_len = strlen(parameter) + 1;
+
+	for (ptr = parameter; ptr < parameter + params_len; ptr += sep_pos + 1)
+	{
+		zbx_function_param_parse(ptr, &param_pos, &param_len, &sep_pos);
+		value = zbx_function_param_unquote_dyn(ptr + param_pos, param_len, &quoted);
+
+		if (1 == ++idx && (0 == strcmp(function, "avg") || 0 == strcmp(function, "count") ||
+				0 == strcmp(function, "delta") || 0 == strcmp(function, "max") ||
+				0 == strcmp(function, "min") || 0 == strcmp(function, "nodata") ||
+				0 == strcmp(function, "sum")) &&
+				SUCCEED == is_time_suffix(value, &seconds, ZBX_LENGTH_UNLIMITED))
+		{
+			zbx_snprintf_alloc(&key, &key_alloc, &key_offset, ",%d", seconds);
+		}
+		else
+		{
+			/* prefix values with their length to keep the key unambiguous */
+			zbx_snprintf_alloc(&key, &key_alloc, &key_offset, ",%d:%s", (int)strlen(value), value);
+		}
+
+		zbx_free(value);
+	}
+
+	return key;
 }
 
 /******************************************************************************
@@ -4995,6 +5151,7 @@ static void	zbx_populate_function_items(const zbx_vector_uint64_t *functionids,
 
 	func_local.value = NULL;
 	func_local.error = NULL;
+	func_local.operand_status = ZBX_FUNC_OPERAND_UNPARSED;
 
 	functions = (DC_FUNCTION *)zbx_malloc(functions, sizeof(DC_FUNCTION) * functionids->values_num);
 	errcodes = (int *)zbx_malloc(errcodes, sizeof(int) * functionids->values_num);
@@ -5022,6 +5179,7 @@ static void	zbx_populate_function_items(const zbx_vector_uint64_t *functionids,
 
 		func_local.function = functions[i].function;
 		func_local.parameter = functions[i].parameter;
+		func_local.parameter_key = func_get_parameter_key(func_local.function, func_local.parameter);
 
 		if (NULL == (func = (zbx_func_t *)zbx_hashset_search(funcs, &func_local)))
 		{
@@ -5029,6 +5187,8 @@ static void	zbx_populate_function_items(const zbx_vector_uint64_t *functionids,
 			func->function = zbx_strdup(NULL, func_local.function);
 			func->parameter = zbx_strdup(NULL, func_local.parameter);
 		}
+		else
+			zbx_free(func_local.parameter_key);
 
 		ifunc_local.functionid = functions[i].functionid;
 		ifunc_local.func = func;
@@ -5040,7 +5200,8 @@ static void	zbx_populate_function_items(const zbx_vector_uint64_t *functionids,
 	zbx_free(errcodes);
 	zbx_free(functions);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() ifuncs_num:%d", __func__, ifuncs->num_data);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() ifuncs_num:%d funcs_num:%d", __func__, ifuncs->num_data,
+			funcs->num_data);
 }
 
 static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *unknown_msgs)
@@ -5232,6 +5393,77 @@ static int	substitute_expression_functions_results(zbx_hashset_t *ifuncs, char *
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: prepare_program_operands                                         *
+ *                                                                            *
+ * Purpose: check results of functions used by compiled expression and parse  *
+ *          them into program operands                                        *
+ *                                                                            *
+ * Parameters: ifuncs  - [IN] function index by functionid                    *
+ *             program - [IN] the compiled expression                         *
+ *             invalid - [OUT] set to 1 if some result cannot be used as      *
+ *                             program operand                                *
+ *             error   - [OUT] the error message                              *
+ *                                                                            *
+ * Return value: SUCCEED - function results were checked                      *
+ *               FAIL    - function evaluation has failed                     *
+ *                                                                            *
+ * Comments: errors are the same as reported by                               *
+ *           substitute_expression_functions_results()                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	prepare_program_operands(zbx_hashset_t *ifuncs, const unsigned char *program, int *invalid,
+		char **error)
+{
+	const zbx_uint64_t	*functionids;
+	int			i, functionids_num;
+	zbx_func_t		*func;
+	zbx_ifunc_t		*ifunc;
+
+	functionids_num = zbx_expression_program_functionids(program, &functionids);
+
+	for (i = 0; i < functionids_num; i++)
+	{
+		if (0 == functionids[i])
+			continue;
+
+		if (NULL == (ifunc = (zbx_ifunc_t *)zbx_hashset_search(ifuncs, &functionids[i])))
+		{
+			*error = zbx_dsprintf(*error, "Cannot obtain function"
+					" and item for functionid: " ZBX_FS_UI64, functionids[i]);
+			return FAIL;
+		}
+
+		func = ifunc->func;
+
+		if (NULL != func->error)
+		{
+			*error = zbx_strdup(*error, func->error);
+			return FAIL;
+		}
+
+		if (NULL == func->value)
+		{
+			*error = zbx_strdup(*error, "Unexpected error while processing a trigger expression");
+			return FAIL;
+		}
+
+		if (ZBX_FUNC_OPERAND_UNPARSED == func->operand_status)
+		{
+			if (SUCCEED == zbx_expression_operand_parse(&func->operand, func->value))
+				func->operand_status = ZBX_FUNC_OPERAND_PARSED;
+			else
+				func->operand_status = ZBX_FUNC_OPERAND_INVALID;
+		}
+
+		if (ZBX_FUNC_OPERAND_INVALID == func->operand_status)
+			*invalid = 1;
+	}
+
+	return SUCCEED;
+}
+
 static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_ptr_t *triggers)
 {
 	DC_TRIGGER	*tr;
@@ -5251,6 +5483,32 @@ static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_p
 		if (NULL != tr->new_error)
 			continue;
 
+		if (SUCCEED == trigger_is_compiled(tr))
+		{
+			int	invalid = 0;
+
+			if (SUCCEED != prepare_program_operands(ifuncs, tr->expression_program, &invalid,
+					&tr->new_error) ||
+					(TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION == tr->recovery_mode &&
+					SUCCEED != prepare_program_operands(ifuncs, tr->recovery_expression_program,
+					&invalid, &tr->new_error)))
+			{
+				tr->new_value = TRIGGER_VALUE_UNKNOWN;
+				continue;
+			}
+
+			if (0 == invalid)
+				continue;
+
+			/* function results which are not plain numbers, quoted strings or Unknown */
+			/* tokens are substituted into expressions and parsed as part of them     */
+			zbx_free(tr->expression_program);
+			zbx_free(tr->recovery_expression_program);
+
+			if (SUCCEED != trigger_expand_macros(tr))
+				continue;
+		}
+
 		if( SUCCEED != substitute_expression_functions_results(ifuncs, tr->expression, &out, &out_alloc,
 				&tr->new_error))
 		{
@@ -5289,8 +5547,10 @@ static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_p
  *                                                                            *
  * Purpose: substitute expression functions with their values                 *
  *                                                                            *
- * Parameters: triggers - [IN] vector of DC_TRIGGER pointers, sorted by      *
+ * Parameters: triggers - [IN] vector of DC_TRIGGER pointers, sorted by       *
  *                             triggerids                                     *
+ *             funcs    - [OUT] evaluated functions                           *
+ *             ifuncs   - [OUT] function index by functionid                  *
  *             unknown_msgs - vector for storing messages for NOTSUPPORTED    *
  *                            items and failed functions                      *
  *                                                                            *
@@ -5298,11 +5558,14 @@ static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_p
  *                                                                            *
  * Comments: example: "({15}>10) or ({123}=1)" => "(26.416>10) or (0=1)"      *
  *                                                                            *
+ *           Results of functions used by compiled expressions are not        *
+ *           substituted but kept in funcs as program operands.               *
+ *                                                                            *
  ******************************************************************************/
-static void	substitute_functions(zbx_vector_ptr_t *triggers, zbx_vector_ptr_t *unknown_msgs)
+static void	substitute_functions(zbx_vector_ptr_t *triggers, zbx_hashset_t *funcs, zbx_hashset_t *ifuncs,
+		zbx_vector_ptr_t *unknown_msgs)
 {
 	zbx_vector_uint64_t	functionids;
-	zbx_hashset_t		ifuncs, funcs;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -5312,28 +5575,86 @@ static void	substitute_functions(zbx_vector_ptr_t *triggers, zbx_vector_ptr_t *u
 	if (0 == functionids.values_num)
 		goto empty;
 
-	zbx_hashset_create(&ifuncs, triggers->values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-
-	zbx_hashset_create_ext(&funcs, triggers->values_num, func_hash_func, func_compare_func, func_clean,
-				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
-
-	zbx_populate_function_items(&functionids, &funcs, &ifuncs, triggers);
+	zbx_populate_function_items(&functionids, funcs, ifuncs, triggers);
 
-	if (0 != ifuncs.num_data)
+	if (0 != ifuncs->num_data)
 	{
-		zbx_evaluate_item_functions(&funcs, unknown_msgs);
-		zbx_substitute_functions_results(&ifuncs, triggers);
+		zbx_evaluate_item_functions(funcs, unknown_msgs);
+		zbx_substitute_functions_results(ifuncs, triggers);
 	}
-
-	zbx_hashset_destroy(&ifuncs);
-	zbx_hashset_destroy(&funcs);
 empty:
 	zbx_vector_uint64_destroy(&functionids);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: evaluate_trigger_expression                                      *
+ *                                                                            *
+ * Purpose: evaluate trigger problem or recovery expression                   *
+ *                                                                            *
+ * Parameters: tr            - [IN] the trigger                               *
+ *             expression    - [IN] the expression with substituted function  *
+ *                                  results                                   *
+ *             program       - [IN] the compiled expression or NULL if the    *
+ *                                  expression must be evaluated in textual   *
+ *                                  form                                      *
+ *             ifuncs        - [IN] function index by functionid              *
+ *             operands      - [IN/OUT] program operand buffer                *
+ *             result        - [OUT] the expression evaluation result         *
+ *             error         - [OUT] error message buffer                     *
+ *             max_error_len - [IN] error buffer size                         *
+ *             unknown_msgs  - [IN] messages for NOTSUPPORTED items and       *
+ *                                  failed functions                          *
+ *                                                                            *
+ * Return value: SUCCEED - the expression was evaluated successfully          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	evaluate_trigger_expression(const DC_TRIGGER *tr, const char *expression, const unsigned char *program,
+		zbx_hashset_t *ifuncs, zbx_vector_ptr_t *operands, double *result, char *error, size_t max_error_len,
+		zbx_vector_ptr_t *unknown_msgs)
+{
+	const zbx_uint64_t		*functionids;
+	int				i, functionids_num;
+	zbx_expression_operand_t	value;
+	zbx_ifunc_t			*ifunc;
+
+	if (NULL == program)
+		return evaluate(result, expression, error, max_error_len, unknown_msgs);
+
+	value.str = NULL;
+	value.value = tr->value;
+	value.unknown_idx = -1;
+
+	zbx_vector_ptr_clear(operands);
+	functionids_num = zbx_expression_program_functionids(program, &functionids);
+
+	for (i = 0; i < functionids_num; i++)
+	{
+		if (0 == functionids[i])
+		{
+			zbx_vector_ptr_append(operands, &value);
+			continue;
+		}
+
+		/* function results are not evaluated if none of the functions are found in configuration cache */
+		if (NULL == (ifunc = (zbx_ifunc_t *)zbx_hashset_search(ifuncs, &functionids[i])) ||
+				ZBX_FUNC_OPERAND_PARSED != ifunc->func->operand_status)
+		{
+			zbx_snprintf(error, max_error_len, "Cannot obtain function and item for functionid: "
+					ZBX_FS_UI64, functionids[i]);
+			return FAIL;
+		}
+
+		zbx_vector_ptr_append(operands, &ifunc->func->operand);
+	}
+
+	return zbx_expression_execute(result, program, (const zbx_expression_operand_t **)operands->values,
+			expression, error, max_error_len, unknown_msgs);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: evaluate_expressions                                             *
@@ -5345,38 +5666,45 @@ empty:
  *                                                                            *
  * Author: Alexei Vladishev                                                   *
  *                                                                            *
+ * Comments: Expressions compiled in configuration cache are evaluated by     *
+ *           executing their programs with function results as operands.      *
+ *           Other expressions are evaluated in textual form after macro      *
+ *           expansion and function result substitution.                      *
+ *                                                                            *
  ******************************************************************************/
 void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 {
-	DB_EVENT		event;
 	DC_TRIGGER		*tr;
 	int			i;
 	double			expr_result;
 	zbx_vector_ptr_t	unknown_msgs;	    /* pointers to messages about origins of 'unknown' values */
+	zbx_vector_ptr_t	operands;
+	zbx_hashset_t		ifuncs, funcs;
 	char			err[MAX_STRING_LEN];
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() tr_num:%d", __func__, triggers->values_num);
 
-	event.object = EVENT_OBJECT_TRIGGER;
-
 	for (i = 0; i < triggers->values_num; i++)
 	{
 		tr = (DC_TRIGGER *)triggers->values[i];
 
-		event.value = tr->value;
-
-		if (SUCCEED != expand_trigger_macros(&event, tr, err, sizeof(err)))
-		{
-			tr->new_error = zbx_dsprintf(tr->new_error, "Cannot evaluate expression: %s", err);
-			tr->new_value = TRIGGER_VALUE_UNKNOWN;
-		}
+		/* {TRIGGER.VALUE} macro is resolved by compiled expressions */
+		if (SUCCEED != trigger_is_compiled(tr))
+			trigger_expand_macros(tr);
 	}
 
 	/* Assumption: most often there will be no NOTSUPPORTED items and function errors. */
 	/* Therefore initialize error messages vector but do not reserve any space. */
 	zbx_vector_ptr_create(&unknown_msgs);
+	zbx_vector_ptr_create(&operands);
+
+	zbx_hashset_create(&ifuncs, triggers->values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-	substitute_functions(triggers, &unknown_msgs);
+	zbx_hashset_create_ext(&funcs, triggers->values_num, func_hash_func, func_compare_func, func_clean,
+				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	substitute_functions(triggers, &funcs, &ifuncs, &unknown_msgs);
 
 	/* calculate new trigger values based on their recovery modes and expression evaluations */
 	for (i = 0; i < triggers->values_num; i++)
@@ -5386,7 +5714,8 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 		if (NULL != tr->new_error)
 			continue;
 
-		if (SUCCEED != evaluate(&expr_result, tr->expression, err, sizeof(err), &unknown_msgs))
+		if (SUCCEED != evaluate_trigger_expression(tr, tr->expression, tr->expression_program, &ifuncs,
+				&operands, &expr_result, err, sizeof(err), &unknown_msgs))
 		{
 			tr->new_error = zbx_strdup(tr->new_error, err);
 			tr->new_value = TRIGGER_VALUE_UNKNOWN;
@@ -5419,7 +5748,9 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 			}
 
 			/* processing recovery expression mode */
-			if (SUCCEED != evaluate(&expr_result, tr->recovery_expression, err, sizeof(err), &unknown_msgs))
+			if (SUCCEED != evaluate_trigger_expression(tr, tr->recovery_expression,
+					tr->recovery_expression_program, &ifuncs, &operands, &expr_result, err,
+					sizeof(err), &unknown_msgs))
 			{
 				tr->new_error = zbx_strdup(tr->new_error, err);
 				tr->new_value = TRIGGER_VALUE_UNKNOWN;
@@ -5437,6 +5768,10 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 		tr->new_value = TRIGGER_VALUE_NONE;
 	}
 
+	zbx_hashset_destroy(&ifuncs);
+	zbx_hashset_destroy(&funcs);
+	zbx_vector_ptr_destroy(&operands);
+
 	zbx_vector_ptr_clear_ext(&unknown_msgs, zbx_ptr_free);
 	zbx_vector_ptr_destroy(&unknown_msgs);
 
@@ -44,7 +44,9 @@ void	zbx_get_zabbix_stats(struct zbx_json *json)
 	zbx_vmware_stats_t	vmware_stats;
 	zbx_wcache_info_t	wcache_info;
 	zbx_process_info_t	process_stats[ZBX_PROCESS_TYPE_COUNT];
-	int			proc_type;
+	zbx_dc_lock_stats_t	rdlock_stats;
+	const double		*rdlock_bounds;
+	int			proc_type, i;
 
 	DCget_count_stats_all(&count_stats);
 
@@ -78,6 +80,27 @@ void	zbx_get_zabbix_stats(struct zbx_json *json)
 	zbx_json_addfloat(json, "pfree", *(double *)DCconfig_get_stats(ZBX_CONFSTATS_BUFFER_PFREE));
 	zbx_json_adduint64(json, "used", *(zbx_uint64_t *)DCconfig_get_stats(ZBX_CONFSTATS_BUFFER_USED));
 	zbx_json_addfloat(json, "pused", *(double *)DCconfig_get_stats(ZBX_CONFSTATS_BUFFER_PUSED));
+
+	/* configuration cache read lock wait time histogram */
+	DCconfig_get_rdlock_stats(&rdlock_stats, &rdlock_bounds);
+	zbx_json_addobject(json, "rdlock_wait");
+
+	for (i = 0; i < ZBX_DC_LOCK_WAIT_BUCKETS; i++)
+	{
+		char	bound[ZBX_MAX_DOUBLE_LEN + 1];
+
+		if (ZBX_DC_LOCK_WAIT_BUCKETS - 1 > i)
+			zbx_snprintf(bound, sizeof(bound), "%g", rdlock_bounds[i]);
+		else
+			zbx_strlcpy(bound, "+Inf", sizeof(bound));
+
+		zbx_json_adduint64(json, bound, rdlock_stats.buckets[i]);
+	}
+
+	zbx_json_adduint64(json, "count", rdlock_stats.count);
+	zbx_json_addfloat(json, "sum", rdlock_stats.sum);
+	zbx_json_close(json);
+
 	zbx_json_close(json);
 
 	/* zabbix[version] */
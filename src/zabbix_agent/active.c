@@ -48,6 +48,7 @@ static ZBX_THREAD_LOCAL zbx_vector_ptr_t	active_metrics;
 static ZBX_THREAD_LOCAL zbx_vector_ptr_t	regexps;
 static ZBX_THREAD_LOCAL char			*session_token;
 static ZBX_THREAD_LOCAL zbx_uint64_t		last_valueid = 0;
+static ZBX_THREAD_LOCAL zbx_uint64_t		config_revision = 0;
 
 static void	init_active_metrics(void)
 {
@@ -296,7 +297,7 @@ static int	parse_list_of_checks(char *str, const char *host, unsigned short port
 	size_t			name_alloc = 0, key_orig_alloc = 0;
 	char			*name = NULL, *key_orig = NULL, expression[MAX_STRING_LEN],
 				tmp[MAX_STRING_LEN], exp_delimiter;
-	zbx_uint64_t		lastlogsize;
+	zbx_uint64_t		lastlogsize, revision;
 	struct zbx_json_parse	jp;
 	struct zbx_json_parse	jp_data, jp_row;
 	ZBX_ACTIVE_METRIC	*metric;
@@ -329,12 +330,29 @@ static int	parse_list_of_checks(char *str, const char *host, unsigned short port
 		goto out;
 	}
 
+	if (SUCCEED != zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_CONFIG_REVISION, tmp, sizeof(tmp), NULL) ||
+			SUCCEED != is_uint64(tmp, &revision))
+	{
+		revision = 0;
+	}
+
 	if (SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_DATA, &jp_data))
 	{
+		/* server omits the list if it has not changed since the revision sent in request */
+		if (0 != revision && revision == config_revision)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "list of active checks has not changed");
+			ret = SUCCEED;
+			goto out;
+		}
+
 		zabbix_log(LOG_LEVEL_ERR, "cannot parse list of active checks: %s", zbx_json_strerror());
 		goto out;
 	}
 
+	/* force full list on the next request if parsing fails */
+	config_revision = 0;
+
  	p = NULL;
 	while (NULL != (p = zbx_json_next(&jp_data, p)))
 	{
@@ -484,6 +502,7 @@ static int	parse_list_of_checks(char *str, const char *host, unsigned short port
 		}
 	}
 
+	config_revision = revision;
 	ret = SUCCEED;
 out:
 	zbx_vector_str_clear_ext(&received_metrics, zbx_str_free);
@@ -626,6 +645,9 @@ static int	refresh_active_checks(const char *host, unsigned short port)
 	if (ZBX_DEFAULT_AGENT_PORT != CONFIG_LISTEN_PORT)
 		zbx_json_adduint64(&json, ZBX_PROTO_TAG_PORT, CONFIG_LISTEN_PORT);
 
+	if (0 != config_revision)
+		zbx_json_adduint64(&json, ZBX_PROTO_TAG_CONFIG_REVISION, config_revision);
+
 	switch (configured_tls_connect_mode)
 	{
 		case ZBX_TCP_SEC_UNENCRYPTED:
@@ -40,18 +40,42 @@ extern ZBX_THREAD_LOCAL int		server_num, process_num;
 #include "zbxcrypto.h"
 #include "../libs/zbxcrypto/tls_tcp_active.h"
 
+/******************************************************************************
+ *                                                                            *
+ * Function: process_listener                                                 *
+ *                                                                            *
+ * Purpose: process passive check requests of accepted connection             *
+ *                                                                            *
+ * Comments: Connection opened with ZBX_PERSISTENT request is kept open for   *
+ *           the following requests until server closes it or no request      *
+ *           arrives within Timeout.                                          *
+ *                                                                            *
+ ******************************************************************************/
 static void	process_listener(zbx_socket_t *s)
 {
 	AGENT_RESULT	result;
 	char		**value = NULL;
-	int		ret;
+	int		ret, persistent = 0;
 
-	if (SUCCEED == (ret = zbx_tcp_recv_to(s, CONFIG_TIMEOUT)))
+	while (SUCCEED == (ret = zbx_tcp_recv_to(s, CONFIG_TIMEOUT)))
 	{
+		if (0 != persistent && 0 == s->read_bytes)
+			break;	/* connection closed by server */
+
 		zbx_rtrim(s->buffer, "\r\n");
 
 		zabbix_log(LOG_LEVEL_DEBUG, "Requested [%s]", s->buffer);
 
+		if (0 == persistent && 0 == strcmp(s->buffer, ZBX_PERSISTENT))
+		{
+			persistent = 1;
+
+			if (SUCCEED != (ret = zbx_tcp_send_to(s, ZBX_PERSISTENT, CONFIG_TIMEOUT)))
+				break;
+
+			continue;
+		}
+
 		init_result(&result);
 
 		if (SUCCEED == process(s->buffer, PROCESS_WITH_ALIAS, &result))
@@ -93,6 +117,9 @@ static void	process_listener(zbx_socket_t *s)
 		}
 
 		free_result(&result);
+
+		if (SUCCEED != ret || 0 == persistent)
+			break;
 	}
 
 	if (FAIL == ret)
@@ -2967,6 +2967,222 @@ clean:
 	return ret;
 }
 
+/* result of a deferred condition before it is checked */
+#define ZBX_CONDITION_UNKNOWN	1
+
+/* result of action condition check with unknown deferred conditions */
+typedef enum
+{
+	ZBX_ACTION_MATCH = 0,
+	ZBX_ACTION_NO_MATCH,
+	ZBX_ACTION_MAY_MATCH
+}
+zbx_action_match_result_t;
+
+/* events that must be checked against a deferred condition */
+typedef struct
+{
+	zbx_condition_t		*condition;
+	zbx_vector_ptr_t	events;
+}
+zbx_condition_events_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: is_deferred_condition                                            *
+ *                                                                            *
+ * Purpose: checks if condition requires database queries and should be       *
+ *          checked only for events that might match actions after checking   *
+ *          the other conditions                                              *
+ *                                                                            *
+ * Parameters: source        - [IN] the event source                          *
+ *             conditiontype - [IN] the condition type                        *
+ *                                                                            *
+ * Return value: SUCCEED - the condition check is deferred                    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	is_deferred_condition(unsigned char source, unsigned char conditiontype)
+{
+	switch (source)
+	{
+		case EVENT_SOURCE_TRIGGERS:
+			switch (conditiontype)
+			{
+				case CONDITION_TYPE_HOST_GROUP:
+				case CONDITION_TYPE_HOST_TEMPLATE:
+				case CONDITION_TYPE_HOST:
+				case CONDITION_TYPE_TRIGGER:
+				case CONDITION_TYPE_EVENT_ACKNOWLEDGED:
+				case CONDITION_TYPE_APPLICATION:
+					return SUCCEED;
+			}
+			break;
+		case EVENT_SOURCE_INTERNAL:
+			switch (conditiontype)
+			{
+				case CONDITION_TYPE_HOST_GROUP:
+				case CONDITION_TYPE_HOST_TEMPLATE:
+				case CONDITION_TYPE_HOST:
+				case CONDITION_TYPE_APPLICATION:
+					return SUCCEED;
+			}
+			break;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: prefilter_action_conditions                                      *
+ *                                                                            *
+ * Purpose: checks if action might match the event before deferred conditions *
+ *          are checked                                                       *
+ *                                                                            *
+ * Parameters: eventid  - [IN] the id of event that will be checked           *
+ *             action   - [IN] action for matching                            *
+ *             deferred - [IN] the deferred conditions                        *
+ *                                                                            *
+ * Return value: ZBX_ACTION_MATCH     - action matches regardless of deferred *
+ *                                      conditions                            *
+ *               ZBX_ACTION_NO_MATCH  - action doesn't match regardless of    *
+ *                                      deferred conditions                   *
+ *               ZBX_ACTION_MAY_MATCH - action match depends on deferred      *
+ *                                      conditions                            *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_action_match_result_t	prefilter_action_conditions(zbx_uint64_t eventid,
+		const zbx_action_eval_t *action, zbx_hashset_t *deferred)
+{
+	zbx_condition_t			*condition;
+	int				i, condition_result, unknown = 0, group_result = SUCCEED;
+	unsigned char			old_type = 0xff;
+	char				*expression = NULL, *tmp, search[ZBX_MAX_UINT64_LEN + 2], error[256];
+	const char			*value;
+	double				eval_result;
+	zbx_action_match_result_t	ret;
+
+	if (CONDITION_EVAL_TYPE_EXPRESSION == action->evaltype)
+		expression = zbx_strdup(expression, action->formula);
+
+	for (i = 0; i < action->conditions.values_num; i++)
+	{
+		condition = (zbx_condition_t *)action->conditions.values[i];
+
+		if (NULL != zbx_hashset_search(deferred, &condition))
+			condition_result = ZBX_CONDITION_UNKNOWN;
+		else if (FAIL != zbx_vector_uint64_bsearch(&condition->eventids, eventid, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			condition_result = SUCCEED;
+		else
+			condition_result = FAIL;
+
+		switch (action->evaltype)
+		{
+			case CONDITION_EVAL_TYPE_AND_OR:
+				if (old_type == condition->conditiontype)	/* assume conditions are sorted by type */
+				{
+					if (SUCCEED == condition_result || (FAIL == group_result &&
+							ZBX_CONDITION_UNKNOWN == condition_result))
+					{
+						group_result = condition_result;
+					}
+				}
+				else
+				{
+					if (FAIL == group_result)
+					{
+						ret = ZBX_ACTION_NO_MATCH;
+						goto out;
+					}
+
+					if (ZBX_CONDITION_UNKNOWN == group_result)
+						unknown = 1;
+
+					group_result = condition_result;
+					old_type = condition->conditiontype;
+				}
+
+				break;
+			case CONDITION_EVAL_TYPE_AND:
+				if (FAIL == condition_result)
+				{
+					ret = ZBX_ACTION_NO_MATCH;
+					goto out;
+				}
+
+				if (ZBX_CONDITION_UNKNOWN == condition_result)
+					unknown = 1;
+
+				break;
+			case CONDITION_EVAL_TYPE_OR:
+				if (SUCCEED == condition_result)
+				{
+					ret = ZBX_ACTION_MATCH;
+					goto out;
+				}
+
+				if (ZBX_CONDITION_UNKNOWN == condition_result)
+					unknown = 1;
+
+				break;
+			case CONDITION_EVAL_TYPE_EXPRESSION:
+				if (SUCCEED == condition_result)
+					value = "1";
+				else if (FAIL == condition_result)
+					value = "0";
+				else
+					value = ZBX_UNKNOWN_STR "0";
+
+				zbx_snprintf(search, sizeof(search), "{" ZBX_FS_UI64 "}", condition->conditionid);
+				tmp = string_replace(expression, search, value);
+				zbx_free(expression);
+				expression = tmp;
+
+				break;
+			default:
+				ret = ZBX_ACTION_NO_MATCH;
+				goto out;
+		}
+	}
+
+	switch (action->evaltype)
+	{
+		case CONDITION_EVAL_TYPE_AND_OR:
+			if (FAIL == group_result)
+				ret = ZBX_ACTION_NO_MATCH;
+			else if (0 != unknown || ZBX_CONDITION_UNKNOWN == group_result)
+				ret = ZBX_ACTION_MAY_MATCH;
+			else
+				ret = ZBX_ACTION_MATCH;
+			break;
+		case CONDITION_EVAL_TYPE_AND:
+			ret = (0 != unknown ? ZBX_ACTION_MAY_MATCH : ZBX_ACTION_MATCH);
+			break;
+		case CONDITION_EVAL_TYPE_OR:
+			if (0 == action->conditions.values_num)
+				ret = ZBX_ACTION_MATCH;
+			else
+				ret = (0 != unknown ? ZBX_ACTION_MAY_MATCH : ZBX_ACTION_NO_MATCH);
+			break;
+		default:
+			/* leave evaluation errors to be handled by check_action_conditions() */
+			if (SUCCEED != evaluate_unknown(expression, &eval_result, error, sizeof(error)) ||
+					ZBX_UNKNOWN == eval_result)
+			{
+				ret = ZBX_ACTION_MAY_MATCH;
+			}
+			else if (SUCCEED != zbx_double_compare(eval_result, 0))
+				ret = ZBX_ACTION_MATCH;
+			else
+				ret = ZBX_ACTION_NO_MATCH;
+	}
+out:
+	zbx_free(expression);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: execute_operations                                               *
@@ -3389,6 +3605,115 @@ static void	prepare_actions_conditions_eval(zbx_vector_ptr_t *actions, zbx_hashs
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: check_events_conditions                                          *
+ *                                                                            *
+ * Purpose: checks action conditions for events of the same source            *
+ *                                                                            *
+ * Parameters: esc_events      - [IN] events to check, sorted by object       *
+ *             source          - [IN] the event source                        *
+ *             uniq_conditions - [IN/OUT] unique conditions of the actions,   *
+ *                                        outputs event ids that match        *
+ *                                        conditions                          *
+ *             actions         - [IN] the actions                             *
+ *                                                                            *
+ * Comments: Conditions requiring database queries are checked only for       *
+ *           events that might match the actions using them after the other   *
+ *           conditions are checked. Events that cannot match such action     *
+ *           fail it regardless of the deferred condition results, so         *
+ *           check_action_conditions() gives the same results.                *
+ *                                                                            *
+ ******************************************************************************/
+static void	check_events_conditions(const zbx_vector_ptr_t *esc_events, unsigned char source,
+		zbx_hashset_t *uniq_conditions, const zbx_vector_ptr_t *actions)
+{
+	int			i, j, k, checked_num = 0, pairs_num = 0, candidates_num = 0;
+	zbx_hashset_t		deferred;
+	zbx_hashset_iter_t	iter;
+	zbx_condition_t		*condition;
+	zbx_condition_events_t	*condition_events, condition_events_local;
+
+	zbx_hashset_create(&deferred, 0, ZBX_DEFAULT_PTR_HASH_FUNC, ZBX_DEFAULT_PTR_COMPARE_FUNC);
+
+	zbx_hashset_iter_reset(uniq_conditions, &iter);
+
+	while (NULL != (condition = (zbx_condition_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (SUCCEED != is_deferred_condition(source, condition->conditiontype))
+		{
+			check_events_condition(esc_events, source, condition);
+			continue;
+		}
+
+		condition_events_local.condition = condition;
+		condition_events = (zbx_condition_events_t *)zbx_hashset_insert(&deferred, &condition_events_local,
+				sizeof(condition_events_local));
+		zbx_vector_ptr_create(&condition_events->events);
+	}
+
+	if (0 == deferred.num_data)
+		goto out;
+
+	/* events are processed in order, so the events collected for conditions stay sorted and unique */
+	for (i = 0; i < esc_events->values_num; i++)
+	{
+		const DB_EVENT	*event = (const DB_EVENT *)esc_events->values[i];
+
+		for (j = 0; j < actions->values_num; j++)
+		{
+			const zbx_action_eval_t	*action = (const zbx_action_eval_t *)actions->values[j];
+
+			if (action->eventsource != source)
+				continue;
+
+			pairs_num++;
+
+			if (ZBX_ACTION_MAY_MATCH != prefilter_action_conditions(event->eventid, action, &deferred))
+				continue;
+
+			candidates_num++;
+
+			for (k = 0; k < action->conditions.values_num; k++)
+			{
+				zbx_vector_ptr_t	*events;
+
+				condition = (zbx_condition_t *)action->conditions.values[k];
+
+				if (NULL == (condition_events = (zbx_condition_events_t *)zbx_hashset_search(&deferred,
+						&condition)))
+				{
+					continue;
+				}
+
+				events = &condition_events->events;
+
+				if (0 == events->values_num || event != events->values[events->values_num - 1])
+					zbx_vector_ptr_append(events, (void *)event);
+			}
+		}
+	}
+
+	zbx_hashset_iter_reset(&deferred, &iter);
+
+	while (NULL != (condition_events = (zbx_condition_events_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (0 != condition_events->events.values_num)
+		{
+			check_events_condition(&condition_events->events, source, condition_events->condition);
+			checked_num++;
+		}
+
+		zbx_vector_ptr_destroy(&condition_events->events);
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() source:%d events:%d conditions:%d deferred:%d deferred checked:%d"
+			" action candidates:%d/%d", __func__, (int)source, esc_events->values_num,
+			uniq_conditions->num_data, deferred.num_data, checked_num, candidates_num, pairs_num);
+
+	zbx_hashset_destroy(&deferred);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: process_actions                                                  *
@@ -3408,8 +3733,6 @@ void	process_actions(const zbx_vector_ptr_t *events, const zbx_vector_uint64_pai
 	zbx_vector_uint64_pair_t	rec_escalations;
 	zbx_hashset_t			uniq_conditions[EVENT_SOURCE_COUNT];
 	zbx_vector_ptr_t		esc_events[EVENT_SOURCE_COUNT];
-	zbx_hashset_iter_t		iter;
-	zbx_condition_t			*condition;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() events_num:" ZBX_FS_SIZE_T, __func__, (zbx_fs_size_t)events->values_num);
 
@@ -3433,11 +3756,7 @@ void	process_actions(const zbx_vector_ptr_t *events, const zbx_vector_uint64_pai
 			continue;
 
 		zbx_vector_ptr_sort(&esc_events[i], compare_events);
-
-		zbx_hashset_iter_reset(&uniq_conditions[i], &iter);
-
-		while (NULL != (condition = (zbx_condition_t *)zbx_hashset_iter_next(&iter)))
-			check_events_condition(&esc_events[i], i, condition);
+		check_events_conditions(&esc_events[i], i, &uniq_conditions[i], &actions);
 	}
 
 	/* 1. All event sources: match PROBLEM events to action conditions, add them to 'new_escalations' list.      */
@@ -3633,8 +3952,6 @@ int	process_actions_by_acknowledgements(const zbx_vector_ptr_t *ack_tasks)
 	zbx_vector_ptr_t	ack_escalations, events;
 	zbx_ack_escalation_t	*ack_escalation;
 	zbx_vector_ptr_t	esc_events[EVENT_SOURCE_COUNT];
-	zbx_hashset_iter_t	iter;
-	zbx_condition_t		*condition;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -3681,11 +3998,7 @@ int	process_actions_by_acknowledgements(const zbx_vector_ptr_t *ack_tasks)
 			continue;
 
 		zbx_vector_ptr_sort(&esc_events[i], compare_events);
-
-		zbx_hashset_iter_reset(&uniq_conditions[i], &iter);
-
-		while (NULL != (condition = (zbx_condition_t *)zbx_hashset_iter_next(&iter)))
-			check_events_condition(&esc_events[i], i, condition);
+		check_events_conditions(&esc_events[i], i, &uniq_conditions[i], &actions);
 	}
 
 	for (i = 0; i < eventids.values_num; i++)
@@ -84,6 +84,10 @@ extern char	*CONFIG_ALERT_SCRIPTS_PATH;
  *    3) take the next alert from alert pool alerts queue
  *    4) if media type maxsessions limit has not reached, put the media type object back in queue
  *
+ * A media type already having alerts being processed is set aside until the next queue check
+ * if the remaining free alerters are needed for other queued media types with no alerts being
+ * processed, so that media types with slow endpoints cannot take all alerters.
+ *
  * When processing alert response the following actions are done:
  *    1) find alerts media type and alert pool objects
  *    2) cache alert status update to be flushed into database later
@@ -1629,30 +1633,23 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Function: am_check_queue                                                   *
+ * Function: am_check_mediatype_queue                                         *
  *                                                                            *
- * Purpose: checks alert queue if there is an alert that should be sent now   *
+ * Purpose: checks if media type has an alert that should be sent now         *
  *                                                                            *
- * Parameters: manager - [IN] the alert manager                               *
- *             now     - [IN] the current timestamp                           *
+ * Parameters: mediatype - [IN] the media type                                *
+ *             now       - [IN] the current timestamp                         *
  *                                                                            *
  * Return value: SUCCEED - an alert can be sent                               *
  *               FAIL - there are no alerts to be sent at this time           *
  *                                                                            *
  ******************************************************************************/
-static int	am_check_queue(zbx_am_t *manager, int now)
+static int	am_check_mediatype_queue(zbx_am_mediatype_t *mediatype, int now)
 {
 	zbx_binary_heap_elem_t	*elem;
-	zbx_am_mediatype_t	*mediatype;
 	zbx_am_alertpool_t	*alertpool;
 	zbx_am_alert_t		*alert;
 
-	if (SUCCEED == zbx_binary_heap_empty(&manager->queue))
-		return FAIL;
-
-	elem = zbx_binary_heap_find_min(&manager->queue);
-	mediatype = (zbx_am_mediatype_t *)elem->data;
-
 	if (SUCCEED == zbx_binary_heap_empty(&mediatype->queue))
 		return FAIL;
 
@@ -1671,6 +1668,81 @@ static int	am_check_queue(zbx_am_t *manager, int now)
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: am_check_queue                                                   *
+ *                                                                            *
+ * Purpose: checks alert queue if there is an alert that should be sent now   *
+ *                                                                            *
+ * Parameters: manager - [IN] the alert manager                               *
+ *             now     - [IN] the current timestamp                           *
+ *                                                                            *
+ * Return value: SUCCEED - an alert can be sent                               *
+ *               FAIL - there are no alerts to be sent at this time           *
+ *                                                                            *
+ ******************************************************************************/
+static int	am_check_queue(zbx_am_t *manager, int now)
+{
+	zbx_binary_heap_elem_t	*elem;
+
+	if (SUCCEED == zbx_binary_heap_empty(&manager->queue))
+		return FAIL;
+
+	elem = zbx_binary_heap_find_min(&manager->queue);
+
+	return am_check_mediatype_queue((zbx_am_mediatype_t *)elem->data, now);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: am_check_mediatype_share                                         *
+ *                                                                            *
+ * Purpose: checks if the next queued media type may take a free alerter      *
+ *          without starving other media types                                *
+ *                                                                            *
+ * Parameters: manager - [IN] the alert manager                               *
+ *             now     - [IN] the current timestamp                           *
+ *                                                                            *
+ * Return value: SUCCEED - the media type may take a free alerter             *
+ *               FAIL - the remaining free alerters must be left for media    *
+ *                      types having alerts to send and none being processed  *
+ *                                                                            *
+ * Comments: Media types with slow endpoints (for example webhooks during     *
+ *           problem storms) could otherwise occupy all alerters up to their  *
+ *           maxsessions limit, blocking alerts of other media types.         *
+ *                                                                            *
+ ******************************************************************************/
+static int	am_check_mediatype_share(zbx_am_t *manager, int now)
+{
+	zbx_am_mediatype_t	*mediatype, *other;
+	int			i, free_num, waiting_num = 0;
+
+	mediatype = (zbx_am_mediatype_t *)zbx_binary_heap_find_min(&manager->queue)->data;
+
+	/* media type without alerts being processed always gets its first alerter */
+	if (0 == mediatype->alerts_num)
+		return SUCCEED;
+
+	free_num = zbx_queue_ptr_values_num(&manager->free_alerters);
+
+	/* there are enough free alerters for all other queued media types */
+	if (free_num >= manager->queue.elems_num)
+		return SUCCEED;
+
+	for (i = 0; i < manager->queue.elems_num; i++)
+	{
+		other = (zbx_am_mediatype_t *)manager->queue.elems[i].data;
+
+		if (other == mediatype || 0 != other->alerts_num)
+			continue;
+
+		if (SUCCEED == am_check_mediatype_queue(other, now) && ++waiting_num >= free_num)
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: am_update_mediatypes                                             *
@@ -1962,8 +2034,9 @@ ZBX_THREAD_ENTRY(alert_manager_thread, args)
 	zbx_ipc_message_t	*message;
 	zbx_am_alerter_t	*alerter;
 	int			ret, sent_num = 0, failed_num = 0, now, time_watchdog = 0, time_ping = 0,
-				time_mediatype = 0;
+				time_mediatype = 0, i;
 	double			time_stat, time_idle = 0, time_now, sec;
+	zbx_vector_ptr_t	deferred_mediatypes;
 
 	process_type = ((zbx_thread_args_t *)args)->process_type;
 	server_num = ((zbx_thread_args_t *)args)->server_num;
@@ -1985,6 +2058,8 @@ ZBX_THREAD_ENTRY(alert_manager_thread, args)
 
 	manager.dbstatus = ZBX_DB_OK;
 
+	zbx_vector_ptr_create(&deferred_mediatypes);
+
 	/* initialize statistics */
 	time_stat = zbx_time();
 
@@ -2034,13 +2109,27 @@ ZBX_THREAD_ENTRY(alert_manager_thread, args)
 
 		while (SUCCEED == am_check_queue(&manager, now))
 		{
-			if (NULL == (alerter = (zbx_am_alerter_t *)zbx_queue_ptr_pop(&manager.free_alerters)))
+			if (0 == zbx_queue_ptr_values_num(&manager.free_alerters))
 				break;
 
+			/* set media type aside until the next check, leaving free alerters to other media types */
+			if (FAIL == am_check_mediatype_share(&manager, now))
+			{
+				zbx_vector_ptr_append(&deferred_mediatypes, am_pop_mediatype(&manager));
+				continue;
+			}
+
+			alerter = (zbx_am_alerter_t *)zbx_queue_ptr_pop(&manager.free_alerters);
+
 			if (FAIL == am_process_alert(&manager, alerter, am_pop_alert(&manager)))
 				zbx_queue_ptr_push(&manager.free_alerters, alerter);
 		}
 
+		for (i = 0; i < deferred_mediatypes.values_num; i++)
+			am_push_mediatype(&manager, (zbx_am_mediatype_t *)deferred_mediatypes.values[i]);
+
+		zbx_vector_ptr_clear(&deferred_mediatypes);
+
 		if (time_mediatype + ZBX_AM_MEDIATYPE_CLEANUP_FREQUENCY < now)
 		{
 			am_remove_unused_mediatypes(&manager);
@@ -2105,4 +2194,5 @@ ZBX_THREAD_ENTRY(alert_manager_thread, args)
 
 	zbx_ipc_service_close(&manager.ipc);
 	am_destroy(&manager);
+	zbx_vector_ptr_destroy(&deferred_mediatypes);
 }
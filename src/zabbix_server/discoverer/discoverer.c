@@ -34,7 +34,11 @@
 #include "zbxcrypto.h"
 #include "../events.h"
 
+#include <poll.h>
+
 extern int		CONFIG_DISCOVERER_FORKS;
+extern int		CONFIG_DISCOVERER_CONCURRENCY;
+extern int		CONFIG_DISCOVERER_RATE_LIMIT;
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 
@@ -43,6 +47,33 @@ static volatile sig_atomic_t	snmp_cache_reload_requested;
 #endif
 
 #define ZBX_DISCOVERER_IPRANGE_LIMIT	(1 << 16)
+#define ZBX_DISCOVERER_BATCH_PROBES_MAX	(1 << 16)
+
+typedef struct
+{
+	char	ip[INTERFACE_IP_LEN_MAX];
+	char	dns[INTERFACE_DNS_LEN_MAX];
+	int	now;
+}
+zbx_discovery_address_t;
+
+typedef struct
+{
+	const DB_DCHECK	*dcheck;
+	char		*value;
+	int		address;	/* index of the probed address in the batch */
+	int		port;
+	int		status;
+}
+zbx_discovery_probe_t;
+
+/* the probes started by a discovery rule, for DiscovererRateLimit */
+typedef struct
+{
+	double	start;
+	int	probes;
+}
+zbx_discovery_rate_t;
 
 /******************************************************************************
  *                                                                            *
@@ -95,29 +126,107 @@ static void	proxy_update_host(zbx_uint64_t druleid, const char *ip, const char *
 	zbx_free(ip_esc);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: discovery_rate_limit                                             *
+ *                                                                            *
+ * Purpose: wait until the specified number of probes can be started without  *
+ *          exceeding DiscovererRateLimit                                     *
+ *                                                                            *
+ * Parameters: rate   - [IN/OUT] the probes started by the rule               *
+ *             probes - [IN] the number of probes to start                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	discovery_rate_limit(zbx_discovery_rate_t *rate, int probes)
+{
+	double	delay;
+
+	if (0 == CONFIG_DISCOVERER_RATE_LIMIT)
+		return;
+
+	if (0 < (delay = (double)rate->probes / CONFIG_DISCOVERER_RATE_LIMIT - (zbx_time() - rate->start)))
+	{
+		struct timespec	ts;
+
+		ts.tv_sec = (time_t)delay;
+		ts.tv_nsec = (long)((delay - (double)ts.tv_sec) * 1e9);
+		nanosleep(&ts, NULL);
+	}
+
+	rate->probes += probes;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: discovery_chunk_size                                             *
+ *                                                                            *
+ * Purpose: get the maximum number of probes performed at once                *
+ *                                                                            *
+ ******************************************************************************/
+static int	discovery_chunk_size(void)
+{
+	if (0 != CONFIG_DISCOVERER_RATE_LIMIT && CONFIG_DISCOVERER_RATE_LIMIT < CONFIG_DISCOVERER_CONCURRENCY)
+		return CONFIG_DISCOVERER_RATE_LIMIT;
+
+	return CONFIG_DISCOVERER_CONCURRENCY;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: discovery_probe_set_value                                        *
+ *                                                                            *
+ * Purpose: store discovered value of the service, truncated to the size of   *
+ *          dservices.value field                                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	discovery_probe_set_value(zbx_discovery_probe_t *probe, const char *value)
+{
+	char	buf[MAX_DISCOVERED_VALUE_SIZE];
+
+	zbx_strlcpy_utf8(buf, value, sizeof(buf));
+	probe->value = zbx_strdup(probe->value, buf);
+}
+
+static void	discovery_probe_free(zbx_discovery_probe_t *probe)
+{
+	zbx_free(probe->value);
+	zbx_free(probe);
+}
+
+static void	discovery_check_free(DB_DCHECK *dcheck)
+{
+	zbx_free(dcheck->ports);
+	zbx_free(dcheck->key_);
+	zbx_free(dcheck->snmp_community);
+	zbx_free(dcheck->snmpv3_securityname);
+	zbx_free(dcheck->snmpv3_authpassphrase);
+	zbx_free(dcheck->snmpv3_privpassphrase);
+	zbx_free(dcheck->snmpv3_contextname);
+	zbx_free(dcheck);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: discover_service                                                 *
  *                                                                            *
- * Purpose: check if service is available                                     *
+ * Purpose: check if simple TCP service is available                          *
  *                                                                            *
  * Parameters: service type, ip address, port number                          *
  *                                                                            *
  * Return value: SUCCEED - service is UP, FAIL - service not discovered       *
  *                                                                            *
  ******************************************************************************/
-static int	discover_service(const DB_DCHECK *dcheck, char *ip, int port, char **value, size_t *value_alloc)
+static int	discover_service(const DB_DCHECK *dcheck, char *ip, int port)
 {
 	int		ret = SUCCEED;
 	const char	*service = NULL;
 	AGENT_RESULT 	result;
+	char		key[MAX_STRING_LEN];
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	init_result(&result);
 
-	**value = '\0';
-
 	switch (dcheck->type)
 	{
 		case SVC_SSH:
@@ -153,30 +262,464 @@ static int	discover_service(const DB_DCHECK *dcheck, char *ip, int port, char **
 		case SVC_TELNET:
 			service = "telnet";
 			break;
-		case SVC_AGENT:
+		default:
+			ret = FAIL;
+			break;
+	}
+
+	if (SUCCEED == ret)
+	{
+		zbx_alarm_on(CONFIG_TIMEOUT);
+
+		zbx_snprintf(key, sizeof(key), "net.tcp.service[%s,%s,%d]", service, ip, port);
+
+		if (SUCCEED != process(key, 0, &result) || NULL == GET_UI64_RESULT(&result) || 0 == result.ui64)
+			ret = FAIL;
+
+		zbx_alarm_off();
+	}
+	free_result(&result);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: discovery_tcp_connect                                            *
+ *                                                                            *
+ * Purpose: start nonblocking TCP connection to the service                   *
+ *                                                                            *
+ * Parameters: ip   - [IN] the service address                                *
+ *             port - [IN] the service port                                   *
+ *             fd   - [OUT] the socket                                        *
+ *                                                                            *
+ * Return value: SUCCEED - the connection is in progress or established       *
+ *               FAIL    - the connection cannot be started                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	discovery_tcp_connect(const char *ip, int port, int *fd)
+{
+	struct addrinfo	hints, *ai = NULL, *ai_bind = NULL;
+	char		service[MAX_ID_LEN + 1];
+	int		ret = FAIL;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = PF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+
+	zbx_snprintf(service, sizeof(service), "%d", port);
+
+	if (0 != getaddrinfo(ip, service, &hints, &ai))
+		goto out;
+
+	if (-1 == (*fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)))
+		goto out;
+
+	if (-1 == fcntl(*fd, F_SETFL, fcntl(*fd, F_GETFL) | O_NONBLOCK))
+		goto fail;
+
+	if (NULL != CONFIG_SOURCE_IP)
+	{
+		hints.ai_family = ai->ai_family;
+		hints.ai_flags = AI_NUMERICHOST;
+
+		if (0 != getaddrinfo(CONFIG_SOURCE_IP, NULL, &hints, &ai_bind) ||
+				0 != bind(*fd, ai_bind->ai_addr, ai_bind->ai_addrlen))
+		{
+			goto fail;
+		}
+	}
+
+	if (0 != connect(*fd, ai->ai_addr, ai->ai_addrlen) && EINPROGRESS != errno)
+		goto fail;
+
+	ret = SUCCEED;
+fail:
+	if (SUCCEED != ret)
+		close(*fd);
+out:
+	if (NULL != ai)
+		freeaddrinfo(ai);
+
+	if (NULL != ai_bind)
+		freeaddrinfo(ai_bind);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: discovery_check_tcp                                              *
+ *                                                                            *
+ * Purpose: check simple TCP services                                         *
+ *                                                                            *
+ * Parameters: addresses - [IN] the probed addresses                          *
+ *             probes    - [IN/OUT] the probes of simple TCP services         *
+ *             rate      - [IN/OUT] the probes started by the rule            *
+ *                                                                            *
+ * Comments: Connections to all services are started concurrently, limited    *
+ *           by DiscovererConcurrency. Services that do not accept the        *
+ *           connection are down. Services checked by connection only (tcp,   *
+ *           http) are up if connection succeeds, the rest of services are    *
+ *           checked with net.tcp.service after connecting.                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	discovery_check_tcp(zbx_discovery_address_t *addresses, zbx_vector_ptr_t *probes,
+		zbx_discovery_rate_t *rate)
+{
+	struct pollfd		*fds;
+	zbx_discovery_probe_t	**active, *probe;
+	double			*deadlines, now, deadline;
+	int			i, max, next = 0, active_num = 0, fd, err, rc;
+	socklen_t		err_len;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() probes:%d", __func__, probes->values_num);
+
+	max = MIN(discovery_chunk_size(), probes->values_num);
+	fds = (struct pollfd *)zbx_malloc(NULL, sizeof(struct pollfd) * (size_t)max);
+	active = (zbx_discovery_probe_t **)zbx_malloc(NULL, sizeof(zbx_discovery_probe_t *) * (size_t)max);
+	deadlines = (double *)zbx_malloc(NULL, sizeof(double) * (size_t)max);
+
+	while (next < probes->values_num || 0 < active_num)
+	{
+		while (active_num < max && next < probes->values_num)
+		{
+			probe = (zbx_discovery_probe_t *)probes->values[next++];
+
+			discovery_rate_limit(rate, 1);
+
+			if (SUCCEED != discovery_tcp_connect(addresses[probe->address].ip, probe->port, &fd))
+				continue;
+
+			fds[active_num].fd = fd;
+			fds[active_num].events = POLLOUT;
+			active[active_num] = probe;
+			deadlines[active_num++] = zbx_time() + CONFIG_TIMEOUT;
+		}
+
+		if (0 >= active_num)
+			continue;
+
+		for (i = 0, deadline = deadlines[0]; i < active_num; i++)
+		{
+			if (deadline > deadlines[i])
+				deadline = deadlines[i];
+		}
+
+		if (0 > (rc = (int)((deadline - zbx_time()) * 1000) + 1))
+			rc = 0;
+
+		if (-1 == (rc = poll(fds, (nfds_t)active_num, rc)) && EINTR != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot wait for connections: %s", zbx_strerror(errno));
+			break;
+		}
+
+		now = zbx_time();
+
+		for (i = 0; i < active_num;)
+		{
+			if (0 < rc && 0 != fds[i].revents)
+			{
+				err_len = sizeof(err);
+
+				if (0 == getsockopt(fds[i].fd, SOL_SOCKET, SO_ERROR, &err, &err_len) && 0 == err)
+					active[i]->status = DOBJECT_STATUS_UP;
+			}
+			else if (now < deadlines[i])
+			{
+				i++;
+				continue;
+			}
+
+			close(fds[i].fd);
+
+			if (i != --active_num)
+			{
+				fds[i] = fds[active_num];
+				active[i] = active[active_num];
+				deadlines[i] = deadlines[active_num];
+			}
+		}
+	}
+
+	for (i = 0; i < active_num; i++)
+		close(fds[i].fd);
+
+	zbx_free(deadlines);
+	zbx_free(active);
+	zbx_free(fds);
+
+	/* services accepting the connection must respond according to their protocol */
+	for (i = 0; i < probes->values_num; i++)
+	{
+		probe = (zbx_discovery_probe_t *)probes->values[i];
+
+		if (DOBJECT_STATUS_UP != probe->status || SVC_TCP == probe->dcheck->type ||
+				SVC_HTTP == probe->dcheck->type)
+		{
+			continue;
+		}
+
+		discovery_rate_limit(rate, 1);
+
+		if (SUCCEED != discover_service(probe->dcheck, addresses[probe->address].ip, probe->port))
+			probe->status = DOBJECT_STATUS_DOWN;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: discovery_prepare_item                                           *
+ *                                                                            *
+ * Purpose: prepare item for Zabbix agent or SNMP check                       *
+ *                                                                            *
+ * Parameters: dcheck      - [IN] the discovery check                         *
+ *             ip          - [IN] the address                                 *
+ *             port        - [IN] the port                                    *
+ *             interfaceid - [IN] the unique interface identifier, the checks *
+ *                                of different interfaces are concurrent      *
+ *             item        - [OUT] the item                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	discovery_prepare_item(const DB_DCHECK *dcheck, char *ip, int port, zbx_uint64_t interfaceid,
+		DC_ITEM *item)
+{
+	memset(item, 0, sizeof(DC_ITEM));
+
+	strscpy(item->key_orig, dcheck->key_);
+	item->key = item->key_orig;
+
+	item->interface.interfaceid = interfaceid;
+	item->interface.useip = 1;
+	item->interface.addr = ip;
+	item->interface.port = port;
+
+	item->value_type = ITEM_VALUE_TYPE_STR;
+
+	switch (dcheck->type)
+	{
 		case SVC_SNMPv1:
+			item->snmp_version = ZBX_IF_SNMP_VERSION_1;
+			item->type = ITEM_TYPE_SNMP;
+			break;
 		case SVC_SNMPv2c:
+			item->snmp_version = ZBX_IF_SNMP_VERSION_2;
+			item->type = ITEM_TYPE_SNMP;
+			break;
 		case SVC_SNMPv3:
-		case SVC_ICMPPING:
+			item->snmp_version = ZBX_IF_SNMP_VERSION_3;
+			item->type = ITEM_TYPE_SNMP;
 			break;
 		default:
-			ret = FAIL;
-			break;
+			item->type = ITEM_TYPE_ZABBIX;
+			item->host.tls_connect = ZBX_TCP_SEC_UNENCRYPTED;
+			return;
 	}
 
-	if (SUCCEED == ret)
+	item->snmp_community = zbx_strdup(NULL, dcheck->snmp_community);
+	item->snmp_oid = zbx_strdup(NULL, dcheck->key_);
+
+	substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+			&item->snmp_community, MACRO_TYPE_COMMON, NULL, 0);
+	substitute_key_macros(&item->snmp_oid, NULL, NULL, NULL, NULL, MACRO_TYPE_SNMP_OID, NULL, 0);
+
+	if (ZBX_IF_SNMP_VERSION_3 == item->snmp_version)
+	{
+		item->snmpv3_securityname = zbx_strdup(NULL, dcheck->snmpv3_securityname);
+		item->snmpv3_securitylevel = dcheck->snmpv3_securitylevel;
+		item->snmpv3_authpassphrase = zbx_strdup(NULL, dcheck->snmpv3_authpassphrase);
+		item->snmpv3_privpassphrase = zbx_strdup(NULL, dcheck->snmpv3_privpassphrase);
+		item->snmpv3_authprotocol = dcheck->snmpv3_authprotocol;
+		item->snmpv3_privprotocol = dcheck->snmpv3_privprotocol;
+		item->snmpv3_contextname = zbx_strdup(NULL, dcheck->snmpv3_contextname);
+
+		substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+				&item->snmpv3_securityname, MACRO_TYPE_COMMON, NULL, 0);
+		substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+				&item->snmpv3_authpassphrase, MACRO_TYPE_COMMON, NULL, 0);
+		substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+				&item->snmpv3_privpassphrase, MACRO_TYPE_COMMON, NULL, 0);
+		substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+				&item->snmpv3_contextname, MACRO_TYPE_COMMON, NULL, 0);
+	}
+}
+
+static void	discovery_clean_item(DC_ITEM *item)
+{
+	zbx_free(item->snmp_community);
+	zbx_free(item->snmp_oid);
+	zbx_free(item->snmpv3_securityname);
+	zbx_free(item->snmpv3_authpassphrase);
+	zbx_free(item->snmpv3_privpassphrase);
+	zbx_free(item->snmpv3_contextname);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: discovery_check_items                                            *
+ *                                                                            *
+ * Purpose: perform Zabbix agent or SNMP checks                               *
+ *                                                                            *
+ * Parameters: addresses - [IN] the probed addresses                          *
+ *             probes    - [IN/OUT] the probes of the same item type          *
+ *             rate      - [IN/OUT] the probes started by the rule            *
+ *                                                                            *
+ * Comments: The checks are performed in chunks of DiscovererConcurrency      *
+ *           items with the concurrent poller functions.                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	discovery_check_items(zbx_discovery_address_t *addresses, zbx_vector_ptr_t *probes,
+		zbx_discovery_rate_t *rate)
+{
+	DC_ITEM			*items;
+	AGENT_RESULT		*results;
+	int			*errcodes, i, start, num, max;
+	zbx_discovery_probe_t	*probe;
+	char			**pvalue;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() probes:%d", __func__, probes->values_num);
+
+	max = MIN(discovery_chunk_size(), probes->values_num);
+	items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * (size_t)max);
+	results = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT) * (size_t)max);
+	errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)max);
+
+	for (start = 0; start < probes->values_num; start += num)
 	{
-		char		**pvalue;
-		size_t		value_offset = 0;
-		ZBX_FPING_HOST	host;
-		DC_ITEM		item;
-		char		key[MAX_STRING_LEN], error[ITEM_ERROR_LEN_MAX];
+		num = MIN(max, probes->values_num - start);
 
-		zbx_alarm_on(CONFIG_TIMEOUT);
+		discovery_rate_limit(rate, num);
 
-		switch (dcheck->type)
+		for (i = 0; i < num; i++)
+		{
+			probe = (zbx_discovery_probe_t *)probes->values[start + i];
+
+			discovery_prepare_item(probe->dcheck, addresses[probe->address].ip, probe->port,
+					ZBX_MAX_UINT64 - (zbx_uint64_t)i, &items[i]);
+			init_result(&results[i]);
+			errcodes[i] = SUCCEED;
+		}
+
+		if (ITEM_TYPE_ZABBIX == items[0].type)
+			get_values_agent(items, results, errcodes, num);
+#ifdef HAVE_NETSNMP
+		else
+			get_values_snmp(items, results, errcodes, num, ZBX_NO_POLLER);
+#endif
+		for (i = 0; i < num; i++)
+		{
+			probe = (zbx_discovery_probe_t *)probes->values[start + i];
+
+			if (SUCCEED == errcodes[i] && NULL != (pvalue = GET_TEXT_RESULT(&results[i])))
+			{
+				probe->status = DOBJECT_STATUS_UP;
+				discovery_probe_set_value(probe, *pvalue);
+			}
+			else if (ISSET_MSG(&results[i]))
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "discovery: item [%s] error: %s", items[i].key,
+						results[i].msg);
+			}
+
+			free_result(&results[i]);
+			discovery_clean_item(&items[i]);
+		}
+	}
+
+	zbx_free(errcodes);
+	zbx_free(results);
+	zbx_free(items);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: discovery_check_icmp                                             *
+ *                                                                            *
+ * Purpose: ping the addresses, in chunks of DiscovererConcurrency hosts      *
+ *                                                                            *
+ ******************************************************************************/
+static void	discovery_check_icmp(zbx_discovery_address_t *addresses, zbx_vector_ptr_t *probes,
+		zbx_discovery_rate_t *rate)
+{
+	ZBX_FPING_HOST		*hosts;
+	int			i, start, num, max;
+	zbx_discovery_probe_t	*probe;
+	char			error[ITEM_ERROR_LEN_MAX];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() probes:%d", __func__, probes->values_num);
+
+	max = MIN(discovery_chunk_size(), probes->values_num);
+	hosts = (ZBX_FPING_HOST *)zbx_malloc(NULL, sizeof(ZBX_FPING_HOST) * (size_t)max);
+
+	for (start = 0; start < probes->values_num; start += num)
+	{
+		num = MIN(max, probes->values_num - start);
+
+		discovery_rate_limit(rate, num);
+
+		memset(hosts, 0, sizeof(ZBX_FPING_HOST) * (size_t)num);
+
+		for (i = 0; i < num; i++)
+		{
+			probe = (zbx_discovery_probe_t *)probes->values[start + i];
+			hosts[i].addr = addresses[probe->address].ip;
+		}
+
+		if (SUCCEED != do_ping(hosts, num, 3, 0, 0, 0, error, sizeof(error)))
+			continue;
+
+		for (i = 0; i < num; i++)
+		{
+			if (0 != hosts[i].rcv)
+				((zbx_discovery_probe_t *)probes->values[start + i])->status = DOBJECT_STATUS_UP;
+		}
+	}
+
+	zbx_free(hosts);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: discovery_check_probes                                           *
+ *                                                                            *
+ * Purpose: check services of the batch of addresses                          *
+ *                                                                            *
+ * Parameters: addresses - [IN] the probed addresses                          *
+ *             probes    - [IN/OUT] the service probes, all are down          *
+ *                                  initially                                 *
+ *             rate      - [IN/OUT] the probes started by the rule            *
+ *                                                                            *
+ ******************************************************************************/
+static void	discovery_check_probes(zbx_discovery_address_t *addresses, zbx_vector_ptr_t *probes,
+		zbx_discovery_rate_t *rate)
+{
+	zbx_vector_ptr_t	tcp, agent, snmp, icmp;
+	zbx_discovery_probe_t	*probe;
+	int			i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() probes:%d", __func__, probes->values_num);
+
+	zbx_vector_ptr_create(&tcp);
+	zbx_vector_ptr_create(&agent);
+	zbx_vector_ptr_create(&snmp);
+	zbx_vector_ptr_create(&icmp);
+
+	for (i = 0; i < probes->values_num; i++)
+	{
+		probe = (zbx_discovery_probe_t *)probes->values[i];
+
+		switch (probe->dcheck->type)
 		{
-			/* simple checks */
 			case SVC_SSH:
 			case SVC_LDAP:
 			case SVC_SMTP:
@@ -188,231 +731,112 @@ static int	discover_service(const DB_DCHECK *dcheck, char *ip, int port, char **
 			case SVC_TCP:
 			case SVC_HTTPS:
 			case SVC_TELNET:
-				zbx_snprintf(key, sizeof(key), "net.tcp.service[%s,%s,%d]", service, ip, port);
-
-				if (SUCCEED != process(key, 0, &result) || NULL == GET_UI64_RESULT(&result) ||
-						0 == result.ui64)
-				{
-					ret = FAIL;
-				}
+				zbx_vector_ptr_append(&tcp, probe);
 				break;
-			/* agent and SNMP checks */
 			case SVC_AGENT:
+				zbx_vector_ptr_append(&agent, probe);
+				break;
+#ifdef HAVE_NETSNMP
 			case SVC_SNMPv1:
 			case SVC_SNMPv2c:
 			case SVC_SNMPv3:
-				memset(&item, 0, sizeof(DC_ITEM));
-
-				strscpy(item.key_orig, dcheck->key_);
-				item.key = item.key_orig;
-
-				item.interface.useip = 1;
-				item.interface.addr = ip;
-				item.interface.port = port;
-
-				item.value_type	= ITEM_VALUE_TYPE_STR;
-
-				switch (dcheck->type)
-				{
-					case SVC_SNMPv1:
-						item.snmp_version = ZBX_IF_SNMP_VERSION_1;
-						item.type = ITEM_TYPE_SNMP;
-						break;
-					case SVC_SNMPv2c:
-						item.snmp_version = ZBX_IF_SNMP_VERSION_2;
-						item.type = ITEM_TYPE_SNMP;
-						break;
-					case SVC_SNMPv3:
-						item.snmp_version = ZBX_IF_SNMP_VERSION_3;
-						item.type = ITEM_TYPE_SNMP;
-						break;
-					default:
-						item.type = ITEM_TYPE_ZABBIX;
-						break;
-				}
-
-				if (SVC_AGENT == dcheck->type)
-				{
-					item.host.tls_connect = ZBX_TCP_SEC_UNENCRYPTED;
-
-					if (SUCCEED == get_value_agent(&item, &result) &&
-							NULL != (pvalue = GET_TEXT_RESULT(&result)))
-					{
-						zbx_strcpy_alloc(value, value_alloc, &value_offset, *pvalue);
-					}
-					else
-						ret = FAIL;
-				}
-				else
-#ifdef HAVE_NETSNMP
-				{
-					item.snmp_community = strdup(dcheck->snmp_community);
-					item.snmp_oid = strdup(dcheck->key_);
-
-					substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-							NULL, NULL, &item.snmp_community, MACRO_TYPE_COMMON, NULL, 0);
-					substitute_key_macros(&item.snmp_oid, NULL, NULL, NULL, NULL,
-							MACRO_TYPE_SNMP_OID, NULL, 0);
-
-					if (ZBX_IF_SNMP_VERSION_3 == item.snmp_version)
-					{
-						item.snmpv3_securityname =
-								zbx_strdup(NULL, dcheck->snmpv3_securityname);
-						item.snmpv3_securitylevel = dcheck->snmpv3_securitylevel;
-						item.snmpv3_authpassphrase =
-								zbx_strdup(NULL, dcheck->snmpv3_authpassphrase);
-						item.snmpv3_privpassphrase =
-								zbx_strdup(NULL, dcheck->snmpv3_privpassphrase);
-						item.snmpv3_authprotocol = dcheck->snmpv3_authprotocol;
-						item.snmpv3_privprotocol = dcheck->snmpv3_privprotocol;
-						item.snmpv3_contextname = zbx_strdup(NULL, dcheck->snmpv3_contextname);
-
-						substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, NULL,
-								NULL, NULL, NULL, &item.snmpv3_securityname,
-								MACRO_TYPE_COMMON, NULL, 0);
-						substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, NULL,
-								NULL, NULL, NULL, &item.snmpv3_authpassphrase,
-								MACRO_TYPE_COMMON, NULL, 0);
-						substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, NULL,
-								NULL, NULL, NULL, &item.snmpv3_privpassphrase,
-								MACRO_TYPE_COMMON, NULL, 0);
-						substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, NULL,
-								NULL, NULL, NULL, &item.snmpv3_contextname,
-								MACRO_TYPE_COMMON, NULL, 0);
-					}
-
-					if (SUCCEED == get_value_snmp(&item, &result, ZBX_NO_POLLER) &&
-							NULL != (pvalue = GET_TEXT_RESULT(&result)))
-					{
-						zbx_strcpy_alloc(value, value_alloc, &value_offset, *pvalue);
-					}
-					else
-						ret = FAIL;
-
-					zbx_free(item.snmp_community);
-					zbx_free(item.snmp_oid);
-
-					if (ZBX_IF_SNMP_VERSION_3 == item.snmp_version)
-					{
-						zbx_free(item.snmpv3_securityname);
-						zbx_free(item.snmpv3_authpassphrase);
-						zbx_free(item.snmpv3_privpassphrase);
-						zbx_free(item.snmpv3_contextname);
-					}
-				}
-#else
-					ret = FAIL;
-#endif	/* HAVE_NETSNMP */
-
-				if (FAIL == ret && ISSET_MSG(&result))
-				{
-					zabbix_log(LOG_LEVEL_DEBUG, "discovery: item [%s] error: %s",
-							item.key, result.msg);
-				}
+				zbx_vector_ptr_append(&snmp, probe);
 				break;
+#endif
 			case SVC_ICMPPING:
-				memset(&host, 0, sizeof(host));
-				host.addr = strdup(ip);
-
-				if (SUCCEED != do_ping(&host, 1, 3, 0, 0, 0, error, sizeof(error)) || 0 == host.rcv)
-					ret = FAIL;
-
-				zbx_free(host.addr);
-				break;
-			default:
+				zbx_vector_ptr_append(&icmp, probe);
 				break;
 		}
-
-		zbx_alarm_off();
 	}
-	free_result(&result);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+	if (0 != icmp.values_num)
+		discovery_check_icmp(addresses, &icmp, rate);
 
-	return ret;
+	if (0 != agent.values_num)
+		discovery_check_items(addresses, &agent, rate);
+
+	if (0 != snmp.values_num)
+		discovery_check_items(addresses, &snmp, rate);
+
+	if (0 != tcp.values_num)
+		discovery_check_tcp(addresses, &tcp, rate);
+
+	zbx_vector_ptr_destroy(&icmp);
+	zbx_vector_ptr_destroy(&snmp);
+	zbx_vector_ptr_destroy(&agent);
+	zbx_vector_ptr_destroy(&tcp);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: process_check                                                    *
- *                                                                            *
- * Purpose: check if service is available and update database                 *
+ * Function: discovery_add_probes                                             *
  *                                                                            *
- * Parameters: service - service info                                         *
+ * Purpose: add probes of all check ports for the address                     *
  *                                                                            *
  ******************************************************************************/
-static void	process_check(const DB_DCHECK *dcheck, int *host_status, char *ip, int now, zbx_vector_ptr_t *services)
+static void	discovery_add_probes(const zbx_vector_ptr_t *dchecks, int address, zbx_vector_ptr_t *probes)
 {
+	const DB_DCHECK	*dcheck;
 	const char	*start;
-	char		*value = NULL;
-	size_t		value_alloc = 128;
+	int		i;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	value = (char *)zbx_malloc(value, value_alloc);
-
-	for (start = dcheck->ports; '\0' != *start;)
+	for (i = 0; i < dchecks->values_num; i++)
 	{
-		char	*comma, *last_port;
-		int	port, first, last;
-
-		if (NULL != (comma = strchr(start, ',')))
-			*comma = '\0';
+		dcheck = (const DB_DCHECK *)dchecks->values[i];
 
-		if (NULL != (last_port = strchr(start, '-')))
+		for (start = dcheck->ports; '\0' != *start;)
 		{
-			*last_port = '\0';
-			first = atoi(start);
-			last = atoi(last_port + 1);
-			*last_port = '-';
-		}
-		else
-			first = last = atoi(start);
+			const char	*comma, *last_port;
+			int		port, first, last;
 
-		for (port = first; port <= last; port++)
-		{
-			zbx_service_t	*service;
+			comma = strchr(start, ',');
+			first = last = atoi(start);
 
-			zabbix_log(LOG_LEVEL_DEBUG, "%s() port:%d", __func__, port);
+			if (NULL != (last_port = strchr(start, '-')) && (NULL == comma || last_port < comma))
+				last = atoi(last_port + 1);
 
-			service = (zbx_service_t *)zbx_malloc(NULL, sizeof(zbx_service_t));
-			service->status = (SUCCEED == discover_service(dcheck, ip, port, &value, &value_alloc) ?
-					DOBJECT_STATUS_UP : DOBJECT_STATUS_DOWN);
-			service->dcheckid = dcheck->dcheckid;
-			service->itemtime = (time_t)now;
-			service->port = port;
-			zbx_strlcpy_utf8(service->value, value, MAX_DISCOVERED_VALUE_SIZE);
-			zbx_vector_ptr_append(services, service);
+			for (port = first; port <= last; port++)
+			{
+				zbx_discovery_probe_t	*probe;
+
+				probe = (zbx_discovery_probe_t *)zbx_malloc(NULL, sizeof(zbx_discovery_probe_t));
+				probe->dcheck = dcheck;
+				probe->value = NULL;
+				probe->address = address;
+				probe->port = port;
+				probe->status = DOBJECT_STATUS_DOWN;
+				zbx_vector_ptr_append(probes, probe);
+			}
 
-			/* update host status */
-			if (-1 == *host_status || DOBJECT_STATUS_UP == service->status)
-				*host_status = service->status;
-		}
+			if (NULL == comma)
+				break;
 
-		if (NULL != comma)
-		{
-			*comma = ',';
 			start = comma + 1;
 		}
-		else
-			break;
 	}
-	zbx_free(value);
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: process_checks                                                   *
+ * Function: discovery_load_checks                                            *
+ *                                                                            *
+ * Purpose: load checks of the discovery rule                                 *
+ *                                                                            *
+ * Parameters: drule     - [IN] the discovery rule                            *
+ *             unique    - [IN] 1 - load the device uniqueness criteria       *
+ *                                  check, 0 - load the other checks          *
+ *             dchecks   - [OUT] the checks                                   *
+ *             dcheckids - [OUT] the check identifiers                        *
  *                                                                            *
  ******************************************************************************/
-static void	process_checks(const DB_DRULE *drule, int *host_status, char *ip, int unique, int now,
-		zbx_vector_ptr_t *services, zbx_vector_uint64_t *dcheckids)
+static void	discovery_load_checks(const DB_DRULE *drule, int unique, zbx_vector_ptr_t *dchecks,
+		zbx_vector_uint64_t *dcheckids)
 {
 	DB_RESULT	result;
 	DB_ROW		row;
-	DB_DCHECK	dcheck;
+	DB_DCHECK	*dcheck;
 	char		sql[MAX_STRING_LEN];
 	size_t		offset = 0;
 
@@ -436,67 +860,124 @@ static void	process_checks(const DB_DRULE *drule, int *host_status, char *ip, in
 
 	while (NULL != (row = DBfetch(result)))
 	{
-		memset(&dcheck, 0, sizeof(dcheck));
-
-		ZBX_STR2UINT64(dcheck.dcheckid, row[0]);
-		dcheck.type = atoi(row[1]);
-		dcheck.key_ = row[2];
-		dcheck.snmp_community = row[3];
-		dcheck.snmpv3_securityname = row[4];
-		dcheck.snmpv3_securitylevel = (unsigned char)atoi(row[5]);
-		dcheck.snmpv3_authpassphrase = row[6];
-		dcheck.snmpv3_privpassphrase = row[7];
-		dcheck.snmpv3_authprotocol = (unsigned char)atoi(row[8]);
-		dcheck.snmpv3_privprotocol = (unsigned char)atoi(row[9]);
-		dcheck.ports = row[10];
-		dcheck.snmpv3_contextname = row[11];
-
-		zbx_vector_uint64_append(dcheckids, dcheck.dcheckid);
-
-		process_check(&dcheck, host_status, ip, now, services);
+		dcheck = (DB_DCHECK *)zbx_malloc(NULL, sizeof(DB_DCHECK));
+
+		ZBX_STR2UINT64(dcheck->dcheckid, row[0]);
+		dcheck->type = atoi(row[1]);
+		dcheck->key_ = zbx_strdup(NULL, row[2]);
+		dcheck->snmp_community = zbx_strdup(NULL, row[3]);
+		dcheck->snmpv3_securityname = zbx_strdup(NULL, row[4]);
+		dcheck->snmpv3_securitylevel = (unsigned char)atoi(row[5]);
+		dcheck->snmpv3_authpassphrase = zbx_strdup(NULL, row[6]);
+		dcheck->snmpv3_privpassphrase = zbx_strdup(NULL, row[7]);
+		dcheck->snmpv3_authprotocol = (unsigned char)atoi(row[8]);
+		dcheck->snmpv3_privprotocol = (unsigned char)atoi(row[9]);
+		dcheck->ports = zbx_strdup(NULL, row[10]);
+		dcheck->snmpv3_contextname = zbx_strdup(NULL, row[11]);
+
+		zbx_vector_ptr_append(dchecks, dcheck);
+		zbx_vector_uint64_append(dcheckids, dcheck->dcheckid);
 	}
 	DBfree_result(result);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: process_services                                                 *
+ * Function: discovery_update_results                                         *
+ *                                                                            *
+ * Purpose: write discovered services and hosts of the batch of addresses     *
+ *          in a single transaction                                           *
+ *                                                                            *
+ * Parameters: drule         - [IN] the discovery rule                        *
+ *             addresses     - [IN] the probed addresses                      *
+ *             addresses_num - [IN] the number of probed addresses            *
+ *             probes        - [IN] the service probes, ordered by address    *
+ *             dcheckids     - [IN/OUT] the sorted check identifiers, checks  *
+ *                                      deleted during discovery are removed  *
+ *                                                                            *
+ * Return value: SUCCEED - the results were written                           *
+ *               FAIL    - the rule or all its checks were deleted            *
  *                                                                            *
  ******************************************************************************/
-static int	process_services(const DB_DRULE *drule, DB_DHOST *dhost, const char *ip, const char *dns, int now,
-		const zbx_vector_ptr_t *services, zbx_vector_uint64_t *dcheckids)
+static int	discovery_update_results(const DB_DRULE *drule, const zbx_discovery_address_t *addresses,
+		int addresses_num, const zbx_vector_ptr_t *probes, zbx_vector_uint64_t *dcheckids)
 {
-	int	i, ret;
+	DB_DHOST			dhost;
+	const zbx_discovery_probe_t	*probe;
+	int				i, j, host_status;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() addresses:%d", __func__, addresses_num);
 
-	zbx_vector_uint64_sort(dcheckids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	DBbegin();
 
-	if (SUCCEED != (ret = DBlock_ids("dchecks", "dcheckid", dcheckids)))
-		goto fail;
+	if (SUCCEED != DBlock_druleid(drule->druleid))
+	{
+		DBrollback();
 
-	for (i = 0; i < services->values_num; i++)
+		zabbix_log(LOG_LEVEL_DEBUG, "discovery rule '%s' was deleted during processing, stopping", drule->name);
+		return FAIL;
+	}
+
+	if (SUCCEED != DBlock_ids("dchecks", "dcheckid", dcheckids))
 	{
-		zbx_service_t	*service = (zbx_service_t *)services->values[i];
+		DBrollback();
 
-		if (FAIL == zbx_vector_uint64_bsearch(dcheckids, service->dcheckid, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
-			continue;
+		zabbix_log(LOG_LEVEL_DEBUG, "all checks where deleted for discovery rule '%s' during processing,"
+				" stopping", drule->name);
+		return FAIL;
+	}
 
-		if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
+	for (i = 0, j = 0; i < addresses_num; i++)
+	{
+		const zbx_discovery_address_t	*address = &addresses[i];
+
+		memset(&dhost, 0, sizeof(dhost));
+		host_status = -1;
+
+		for (; j < probes->values_num && i == (probe = (const zbx_discovery_probe_t *)probes->values[j])->address;
+				j++)
 		{
-			discovery_update_service(drule, service->dcheckid, dhost, ip, dns, service->port,
-					service->status, service->value, now);
+			/* update host status */
+			if (-1 == host_status || DOBJECT_STATUS_UP == probe->status)
+				host_status = probe->status;
+
+			if (FAIL == zbx_vector_uint64_bsearch(dcheckids, probe->dcheck->dcheckid,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			{
+				continue;
+			}
+
+			if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
+			{
+				discovery_update_service(drule, probe->dcheck->dcheckid, &dhost, address->ip,
+						address->dns, probe->port, probe->status,
+						NULL != probe->value ? probe->value : "", address->now);
+			}
+			else if (0 != (program_type & ZBX_PROGRAM_TYPE_PROXY))
+			{
+				proxy_update_service(drule->druleid, probe->dcheck->dcheckid, address->ip, address->dns,
+						probe->port, probe->status, NULL != probe->value ? probe->value : "",
+						address->now);
+			}
 		}
+
+		if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
+			discovery_update_host(&dhost, host_status, address->now);
 		else if (0 != (program_type & ZBX_PROGRAM_TYPE_PROXY))
-		{
-			proxy_update_service(drule->druleid, service->dcheckid, ip, dns, service->port,
-					service->status, service->value, now);
-		}
+			proxy_update_host(drule->druleid, address->ip, address->dns, host_status, address->now);
 	}
-fail:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
-	return ret;
+	if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
+	{
+		zbx_process_events(NULL, NULL);
+		zbx_clean_events();
+	}
+
+	DBcommit();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return SUCCEED;
 }
 
 /******************************************************************************
@@ -505,22 +986,39 @@ fail:
  *                                                                            *
  * Purpose: process single discovery rule                                     *
  *                                                                            *
+ * Comments: Addresses are probed in batches of DiscovererConcurrency         *
+ *           addresses, the checks of a batch are performed concurrently and  *
+ *           the results are written in a single transaction per batch.       *
+ *                                                                            *
  ******************************************************************************/
 static void	process_rule(DB_DRULE *drule)
 {
-	DB_DHOST		dhost;
-	int			host_status, now;
-	char			ip[INTERFACE_IP_LEN_MAX], *start, *comma, dns[INTERFACE_DNS_LEN_MAX];
-	int			ipaddress[8];
+	char			*start, *comma;
+	int			ipaddress[8], addresses_num = 0;
 	zbx_iprange_t		iprange;
-	zbx_vector_ptr_t	services;
+	zbx_vector_ptr_t	dchecks, probes;
 	zbx_vector_uint64_t	dcheckids;
+	zbx_discovery_address_t	*addresses, *address;
+	zbx_discovery_rate_t	rate;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() rule:'%s' range:'%s'", __func__, drule->name, drule->iprange);
 
-	zbx_vector_ptr_create(&services);
+	zbx_vector_ptr_create(&dchecks);
+	zbx_vector_ptr_create(&probes);
 	zbx_vector_uint64_create(&dcheckids);
 
+	addresses = (zbx_discovery_address_t *)zbx_malloc(NULL,
+			sizeof(zbx_discovery_address_t) * (size_t)CONFIG_DISCOVERER_CONCURRENCY);
+
+	if (0 != drule->unique_dcheckid)
+		discovery_load_checks(drule, 1, &dchecks, &dcheckids);
+	discovery_load_checks(drule, 0, &dchecks, &dcheckids);
+
+	zbx_vector_uint64_sort(&dcheckids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	rate.start = zbx_time();
+	rate.probes = 0;
+
 	for (start = drule->iprange; '\0' != *start;)
 	{
 		if (NULL != (comma = strchr(start, ',')))
@@ -553,74 +1051,48 @@ static void	process_rule(DB_DRULE *drule)
 
 		do
 		{
+			address = &addresses[addresses_num];
 #ifdef HAVE_IPV6
 			if (ZBX_IPRANGE_V6 == iprange.type)
 			{
-				zbx_snprintf(ip, sizeof(ip), "%x:%x:%x:%x:%x:%x:%x:%x", (unsigned int)ipaddress[0],
-						(unsigned int)ipaddress[1], (unsigned int)ipaddress[2],
-						(unsigned int)ipaddress[3], (unsigned int)ipaddress[4],
-						(unsigned int)ipaddress[5], (unsigned int)ipaddress[6],
-						(unsigned int)ipaddress[7]);
+				zbx_snprintf(address->ip, sizeof(address->ip), "%x:%x:%x:%x:%x:%x:%x:%x",
+						(unsigned int)ipaddress[0], (unsigned int)ipaddress[1],
+						(unsigned int)ipaddress[2], (unsigned int)ipaddress[3],
+						(unsigned int)ipaddress[4], (unsigned int)ipaddress[5],
+						(unsigned int)ipaddress[6], (unsigned int)ipaddress[7]);
 			}
 			else
 			{
 #endif
-				zbx_snprintf(ip, sizeof(ip), "%u.%u.%u.%u", (unsigned int)ipaddress[0],
-						(unsigned int)ipaddress[1], (unsigned int)ipaddress[2],
-						(unsigned int)ipaddress[3]);
+				zbx_snprintf(address->ip, sizeof(address->ip), "%u.%u.%u.%u",
+						(unsigned int)ipaddress[0], (unsigned int)ipaddress[1],
+						(unsigned int)ipaddress[2], (unsigned int)ipaddress[3]);
 #ifdef HAVE_IPV6
 			}
 #endif
-			memset(&dhost, 0, sizeof(dhost));
-			host_status = -1;
-
-			now = time(NULL);
+			address->now = time(NULL);
 
-			zabbix_log(LOG_LEVEL_DEBUG, "%s() ip:'%s'", __func__, ip);
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() ip:'%s'", __func__, address->ip);
 
 			zbx_alarm_on(CONFIG_TIMEOUT);
-			zbx_gethost_by_ip(ip, dns, sizeof(dns));
+			zbx_gethost_by_ip(address->ip, address->dns, sizeof(address->dns));
 			zbx_alarm_off();
 
-			if (0 != drule->unique_dcheckid)
-				process_checks(drule, &host_status, ip, 1, now, &services, &dcheckids);
-			process_checks(drule, &host_status, ip, 0, now, &services, &dcheckids);
-
-			DBbegin();
+			discovery_add_probes(&dchecks, addresses_num++, &probes);
 
-			if (SUCCEED != DBlock_druleid(drule->druleid))
+			if (CONFIG_DISCOVERER_CONCURRENCY > addresses_num &&
+					ZBX_DISCOVERER_BATCH_PROBES_MAX > probes.values_num)
 			{
-				DBrollback();
-
-				zabbix_log(LOG_LEVEL_DEBUG, "discovery rule '%s' was deleted during processing,"
-						" stopping", drule->name);
-				zbx_vector_ptr_clear_ext(&services, zbx_ptr_free);
-				goto out;
+				continue;
 			}
 
-			if (SUCCEED != process_services(drule, &dhost, ip, dns, now, &services, &dcheckids))
-			{
-				DBrollback();
+			discovery_check_probes(addresses, &probes, &rate);
 
-				zabbix_log(LOG_LEVEL_DEBUG, "all checks where deleted for discovery rule '%s'"
-						" during processing, stopping", drule->name);
-				zbx_vector_ptr_clear_ext(&services, zbx_ptr_free);
+			if (SUCCEED != discovery_update_results(drule, addresses, addresses_num, &probes, &dcheckids))
 				goto out;
-			}
-
-			zbx_vector_uint64_clear(&dcheckids);
-			zbx_vector_ptr_clear_ext(&services, zbx_ptr_free);
 
-			if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
-			{
-				discovery_update_host(&dhost, host_status, now);
-				zbx_process_events(NULL, NULL);
-				zbx_clean_events();
-			}
-			else if (0 != (program_type & ZBX_PROGRAM_TYPE_PROXY))
-				proxy_update_host(drule->druleid, ip, dns, host_status, now);
-
-			DBcommit();
+			zbx_vector_ptr_clear_ext(&probes, (zbx_clean_func_t)discovery_probe_free);
+			addresses_num = 0;
 		}
 		while (SUCCEED == iprange_next(&iprange, ipaddress));
 next:
@@ -632,9 +1104,19 @@ next:
 		else
 			break;
 	}
+
+	if (0 != addresses_num)
+	{
+		discovery_check_probes(addresses, &probes, &rate);
+		(void)discovery_update_results(drule, addresses, addresses_num, &probes, &dcheckids);
+	}
 out:
-	zbx_vector_ptr_destroy(&services);
+	zbx_vector_ptr_clear_ext(&probes, (zbx_clean_func_t)discovery_probe_free);
+	zbx_vector_ptr_destroy(&probes);
+	zbx_vector_ptr_clear_ext(&dchecks, (zbx_clean_func_t)discovery_check_free);
+	zbx_vector_ptr_destroy(&dchecks);
 	zbx_vector_uint64_destroy(&dcheckids);
+	zbx_free(addresses);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -50,6 +50,9 @@ extern int	CONFIG_ESCALATOR_FORKS;
 
 #define ZBX_ESCALATIONS_PER_STEP	1000
 
+/* period after which escalations postponed due to trigger dependencies are fully checked again */
+#define ZBX_ESCALATION_RECHECK_PERIOD	SEC_PER_MIN
+
 #define ZBX_ALERT_MESSAGE_ERR_NONE	0
 #define ZBX_ALERT_MESSAGE_ERR_USR	1
 #define ZBX_ALERT_MESSAGE_ERR_MSG	2
@@ -73,6 +76,21 @@ typedef struct
 }
 zbx_tag_filter_t;
 
+/* escalation postponed because one of the trigger dependencies is in PROBLEM state */
+typedef struct
+{
+	zbx_uint64_t		escalationid;
+	zbx_uint64_t		r_eventid;
+	int			nextcheck;
+	int			esc_step;
+	zbx_escalation_status_t	status;
+	int			recheck;
+	int			lastcheck;
+}
+zbx_escalation_postponed_t;
+
+static zbx_hashset_t	postponed_escalations;
+
 static void	zbx_tag_filter_free(zbx_tag_filter_t *tag_filter)
 {
 	zbx_free(tag_filter->tag);
@@ -2209,6 +2227,112 @@ static void	add_ack_escalation_r_eventids(zbx_vector_ptr_t *escalations, zbx_vec
 	zbx_vector_uint64_destroy(&r_eventids);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: escalation_postpone                                              *
+ *                                                                            *
+ * Purpose: remembers escalation skipped because of trigger dependencies, so  *
+ *          it is not loaded and checked again while the dependencies are in  *
+ *          PROBLEM state                                                     *
+ *                                                                            *
+ * Parameters: escalation - [IN] the skipped escalation                       *
+ *             now        - [IN] the current time                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_postpone(const DB_ESCALATION *escalation, int now)
+{
+	zbx_escalation_postponed_t	*postponed, postponed_local;
+
+	postponed_local.escalationid = escalation->escalationid;
+
+	if (NULL == (postponed = (zbx_escalation_postponed_t *)zbx_hashset_search(&postponed_escalations,
+			&postponed_local)))
+	{
+		postponed = (zbx_escalation_postponed_t *)zbx_hashset_insert(&postponed_escalations,
+				&postponed_local, sizeof(postponed_local));
+	}
+
+	postponed->r_eventid = escalation->r_eventid;
+	postponed->nextcheck = escalation->nextcheck;
+	postponed->esc_step = escalation->esc_step;
+	postponed->status = escalation->status;
+	postponed->recheck = now + ZBX_ESCALATION_RECHECK_PERIOD;
+	postponed->lastcheck = now;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: escalation_is_postponed                                          *
+ *                                                                            *
+ * Purpose: checks if escalation is still postponed because of trigger        *
+ *          dependencies                                                      *
+ *                                                                            *
+ * Parameters: escalation - [IN] the escalation selected from database        *
+ *             now        - [IN] the current time                             *
+ *                                                                            *
+ * Return value: SUCCEED - the escalation was not changed since it was        *
+ *                         postponed and trigger dependencies are still in    *
+ *                         PROBLEM state                                      *
+ *               FAIL    - the escalation must be processed                   *
+ *                                                                            *
+ * Comments: Trigger dependencies are checked in configuration cache without  *
+ *           loading the escalation events and actions from database. Full    *
+ *           escalation check is done at least once per                       *
+ *           ZBX_ESCALATION_RECHECK_PERIOD to cancel escalations of disabled  *
+ *           or deleted objects.                                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	escalation_is_postponed(const DB_ESCALATION *escalation, int now)
+{
+	zbx_escalation_postponed_t	*postponed;
+
+	if (0 == postponed_escalations.num_data || 0 == escalation->triggerid)
+		return FAIL;
+
+	if (NULL == (postponed = (zbx_escalation_postponed_t *)zbx_hashset_search(&postponed_escalations,
+			&escalation->escalationid)))
+	{
+		return FAIL;
+	}
+
+	postponed->lastcheck = now;
+
+	if (now < postponed->recheck && postponed->r_eventid == escalation->r_eventid &&
+			postponed->nextcheck == escalation->nextcheck && postponed->esc_step == escalation->esc_step &&
+			postponed->status == escalation->status &&
+			FAIL == DCconfig_check_trigger_dependencies(escalation->triggerid))
+	{
+		return SUCCEED;
+	}
+
+	zbx_hashset_remove_direct(&postponed_escalations, postponed);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: escalations_remove_postponed                                     *
+ *                                                                            *
+ * Purpose: removes postponed escalations that were not selected from         *
+ *          database during the last check (deleted escalations)              *
+ *                                                                            *
+ * Parameters: now - [IN] the time of the last check                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalations_remove_postponed(int now)
+{
+	zbx_hashset_iter_t		iter;
+	zbx_escalation_postponed_t	*postponed;
+
+	zbx_hashset_iter_reset(&postponed_escalations, &iter);
+	while (NULL != (postponed = (zbx_escalation_postponed_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (postponed->lastcheck < now)
+			zbx_hashset_iter_remove(&iter);
+	}
+}
+
 static int	process_db_escalations(int now, int *nextcheck, zbx_vector_ptr_t *escalations,
 		zbx_vector_uint64_t *eventids, zbx_vector_uint64_t *actionids)
 {
@@ -2313,6 +2437,7 @@ static int	process_db_escalations(int now, int *nextcheck, zbx_vector_ptr_t *esc
 				zbx_vector_uint64_append(&escalationids, escalation->escalationid);
 				continue;
 			case ZBX_ESCALATION_SKIP:
+				escalation_postpone(escalation, now);
 				continue;
 			case ZBX_ESCALATION_SUPPRESS:
 				diff = escalation_create_diff(escalation);
@@ -2607,6 +2732,12 @@ static int	process_escalations(int now, int *nextcheck, unsigned int escalation_
 		ZBX_DBROW2UINT64(escalation->itemid, row[8]);
 		ZBX_DBROW2UINT64(escalation->acknowledgeid, row[9]);
 
+		if (SUCCEED == escalation_is_postponed(escalation, now))
+		{
+			zbx_free(escalation);
+			continue;
+		}
+
 		zbx_vector_ptr_append(&escalations, escalation);
 		zbx_vector_uint64_append(&actionids, escalation->actionid);
 		zbx_vector_uint64_append(&eventids, escalation->eventid);
@@ -2634,7 +2765,11 @@ static int	process_escalations(int now, int *nextcheck, unsigned int escalation_
 	zbx_vector_uint64_destroy(&actionids);
 	zbx_vector_uint64_destroy(&eventids);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	/* only trigger based escalations can be postponed because of trigger dependencies */
+	if (ZBX_ESCALATION_SOURCE_TRIGGER == escalation_source && 0 != postponed_escalations.num_data)
+		escalations_remove_postponed(now);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() postponed:%d", __func__, postponed_escalations.num_data);
 
 	return ret; /* performance metric */
 }
@@ -2680,6 +2815,8 @@ ZBX_THREAD_ENTRY(escalator_thread, args)
 
 	DBconnect(ZBX_DB_CONNECT_NORMAL);
 
+	zbx_hashset_create(&postponed_escalations, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
 	while (ZBX_IS_RUNNING())
 	{
 		sec = zbx_time();
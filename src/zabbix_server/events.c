@@ -62,6 +62,73 @@ static zbx_hashset_t		event_recovery;
 static zbx_hashset_t		correlation_cache;
 static zbx_correlation_rules_t	correlation_rules;
 
+/* correlation rules that can match only new events having the tag */
+typedef struct
+{
+	const char		*tag;
+	zbx_vector_ptr_t	correlations;
+}
+zbx_correlation_tag_t;
+
+/* new event tag index of correlation rules, rebuilt when correlation rules are updated */
+static zbx_hashset_t		correlation_tags;
+static zbx_vector_ptr_t		correlation_untagged;
+static int			correlation_index_ts;
+
+/* the number of tag identifiers reserved by a process at once */
+#define ZBX_EVENT_TAGIDS_BLOCK	1000
+
+/* range of identifiers reserved by the process */
+typedef struct
+{
+	zbx_uint64_t	nextid;
+	zbx_uint64_t	lastid;
+}
+zbx_event_ids_t;
+
+static zbx_event_ids_t	event_tagids, problem_tagids;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: event_reserve_ids                                                *
+ *                                                                            *
+ * Purpose: gets identifiers from the range reserved by the process           *
+ *                                                                            *
+ * Parameters: ids        - [IN/OUT] the identifier range                     *
+ *             table_name - [IN] the table name                               *
+ *             num        - [IN] the number of identifiers to get             *
+ *                                                                            *
+ * Return value: the first identifier of num sequential identifiers or 0 if   *
+ *               the identifiers could not be reserved                        *
+ *                                                                            *
+ * Comments: The identifiers are reserved in blocks of at least               *
+ *           ZBX_EVENT_TAGIDS_BLOCK identifiers, so the ids cache is locked   *
+ *           once per block instead of once per flushed batch. This is used   *
+ *           only for tag tables - event identifiers must grow together with  *
+ *           event time and cannot be reserved in advance by each process.    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	event_reserve_ids(zbx_event_ids_t *ids, const char *table_name, int num)
+{
+	zbx_uint64_t	id;
+
+	if (0 == ids->nextid || ids->lastid - ids->nextid + 1 < (zbx_uint64_t)num)
+	{
+		int	block_num = MAX(num, ZBX_EVENT_TAGIDS_BLOCK);
+
+		if (0 == (id = DBget_maxid_num(table_name, block_num)))
+			return 0;
+
+		ids->nextid = id;
+		ids->lastid = id + block_num - 1;
+	}
+
+	id = ids->nextid;
+	ids->nextid += num;
+
+	return id;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: validate_event_tag                                               *
@@ -330,22 +397,36 @@ static int	save_events(void)
 {
 	int			i;
 	zbx_db_insert_t		db_insert, db_insert_tags;
-	int			j, num = 0, insert_tags = 0;
-	zbx_uint64_t		eventid;
+	int			j, num = 0, tags_num = 0;
+	zbx_uint64_t		eventid = 0, eventtagid = 0;
 	DB_EVENT		*event;
 
 	for (i = 0; i < events.values_num; i++)
 	{
 		event = (DB_EVENT *)events.values[i];
 
-		if (0 != (event->flags & ZBX_FLAGS_DB_EVENT_CREATE) && 0 == event->eventid)
+		if (0 == (event->flags & ZBX_FLAGS_DB_EVENT_CREATE))
+			continue;
+
+		if (0 == event->eventid)
 			num++;
+
+		if (EVENT_SOURCE_TRIGGERS == event->source)
+			tags_num += event->tags.values_num;
 	}
 
 	zbx_db_insert_prepare(&db_insert, "events", "eventid", "source", "object", "objectid", "clock", "ns", "value",
 			"name", "severity", NULL);
 
-	eventid = DBget_maxid_num("events", num);
+	/* event identifiers are normally assigned by zbx_process_events() already */
+	if (0 != num)
+		eventid = DBget_maxid_num("events", num);
+
+	if (0 != tags_num)
+	{
+		zbx_db_insert_prepare(&db_insert_tags, "event_tag", "eventtagid", "eventid", "tag", "value", NULL);
+		eventtagid = event_reserve_ids(&event_tagids, "event_tag", tags_num);
+	}
 
 	num = 0;
 
@@ -368,30 +449,19 @@ static int	save_events(void)
 		if (EVENT_SOURCE_TRIGGERS != event->source)
 			continue;
 
-		if (0 == event->tags.values_num)
-			continue;
-
-		if (0 == insert_tags)
-		{
-			zbx_db_insert_prepare(&db_insert_tags, "event_tag", "eventtagid", "eventid", "tag", "value",
-					NULL);
-			insert_tags = 1;
-		}
-
 		for (j = 0; j < event->tags.values_num; j++)
 		{
 			zbx_tag_t	*tag = (zbx_tag_t *)event->tags.values[j];
 
-			zbx_db_insert_add_values(&db_insert_tags, __UINT64_C(0), event->eventid, tag->tag, tag->value);
+			zbx_db_insert_add_values(&db_insert_tags, eventtagid++, event->eventid, tag->tag, tag->value);
 		}
 	}
 
 	zbx_db_insert_execute(&db_insert);
 	zbx_db_insert_clean(&db_insert);
 
-	if (0 != insert_tags)
+	if (0 != tags_num)
 	{
-		zbx_db_insert_autoincrement(&db_insert_tags, "eventtagid");
 		zbx_db_insert_execute(&db_insert_tags);
 		zbx_db_insert_clean(&db_insert_tags);
 	}
@@ -476,7 +546,10 @@ static void	save_problems(void)
 
 		if (0 != tags_num)
 		{
-			int	k;
+			int		k;
+			zbx_uint64_t	problemtagid;
+
+			problemtagid = event_reserve_ids(&problem_tagids, "problem_tag", tags_num);
 
 			zbx_db_insert_prepare(&db_insert, "problem_tag", "problemtagid", "eventid", "tag", "value",
 					NULL);
@@ -492,12 +565,11 @@ static void	save_problems(void)
 				{
 					zbx_tag_t	*tag = (zbx_tag_t *)event->tags.values[k];
 
-					zbx_db_insert_add_values(&db_insert, __UINT64_C(0), event->eventid, tag->tag,
+					zbx_db_insert_add_values(&db_insert, problemtagid++, event->eventid, tag->tag,
 							tag->value);
 				}
 			}
 
-			zbx_db_insert_autoincrement(&db_insert, "problemtagid");
 			zbx_db_insert_execute(&db_insert);
 			zbx_db_insert_clean(&db_insert);
 		}
@@ -1109,6 +1181,211 @@ static void	correlation_execute_operations(zbx_correlation_t *correlation, DB_EV
 	}
 }
 
+static zbx_hash_t	correlation_tag_hash_func(const void *data)
+{
+	const zbx_correlation_tag_t	*ctag = (const zbx_correlation_tag_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(ctag->tag);
+}
+
+static int	correlation_tag_compare_func(const void *d1, const void *d2)
+{
+	const zbx_correlation_tag_t	*ctag1 = (const zbx_correlation_tag_t *)d1;
+	const zbx_correlation_tag_t	*ctag2 = (const zbx_correlation_tag_t *)d2;
+
+	return strcmp(ctag1->tag, ctag2->tag);
+}
+
+static void	correlation_tag_clean(zbx_correlation_tag_t *ctag)
+{
+	zbx_vector_ptr_destroy(&ctag->correlations);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: correlation_get_new_event_tags                                   *
+ *                                                                            *
+ * Purpose: gets tags the new event must have for the correlation rule to     *
+ *          match it                                                          *
+ *                                                                            *
+ * Parameters: correlation - [IN] the correlation rule                        *
+ *             tags        - [OUT] the tag names, the new event must have at  *
+ *                                 least one of them                          *
+ *                                                                            *
+ * Return value: SUCCEED - the correlation rule never matches new events      *
+ *                         without any of the returned tags                   *
+ *               FAIL    - the correlation rule might match any new event     *
+ *                                                                            *
+ * Comments: New event tag conditions are replaced with false and the other   *
+ *           conditions with unknown values. If the formula is still false,   *
+ *           the rule cannot match events without the tags used by new event  *
+ *           tag conditions.                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	correlation_get_new_event_tags(const zbx_correlation_t *correlation, zbx_vector_str_t *tags)
+{
+	char			*expression, error[256];
+	const char		*value;
+	zbx_token_t		token;
+	int			pos = 0, ret = FAIL;
+	zbx_uint64_t		conditionid;
+	zbx_strloc_t		*loc;
+	zbx_corr_condition_t	*condition;
+	double			result;
+
+	if ('\0' == *correlation->formula)
+		return FAIL;
+
+	expression = zbx_strdup(NULL, correlation->formula);
+
+	for (; SUCCEED == zbx_token_find(expression, pos, &token, ZBX_TOKEN_SEARCH_BASIC); pos++)
+	{
+		if (ZBX_TOKEN_OBJECTID != token.type)
+			continue;
+
+		loc = &token.data.objectid.name;
+
+		if (SUCCEED != is_uint64_n(expression + loc->l, loc->r - loc->l + 1, &conditionid))
+			continue;
+
+		if (NULL == (condition = (zbx_corr_condition_t *)zbx_hashset_search(&correlation_rules.conditions,
+				&conditionid)))
+		{
+			goto out;
+		}
+
+		value = "0";
+
+		switch (condition->type)
+		{
+			case ZBX_CORR_CONDITION_NEW_EVENT_TAG:
+				zbx_vector_str_append(tags, condition->data.tag.tag);
+				break;
+			case ZBX_CORR_CONDITION_NEW_EVENT_TAG_VALUE:
+				zbx_vector_str_append(tags, condition->data.tag_value.tag);
+				break;
+			case ZBX_CORR_CONDITION_EVENT_TAG_PAIR:
+				zbx_vector_str_append(tags, condition->data.tag_pair.newtag);
+				break;
+			default:
+				value = ZBX_UNKNOWN_STR "0";
+		}
+
+		zbx_replace_string(&expression, token.loc.l, &token.loc.r, value);
+		pos = token.loc.r;
+	}
+
+	if (0 != tags->values_num && SUCCEED == evaluate_unknown(expression, &result, error, sizeof(error)) &&
+			ZBX_UNKNOWN != result && SUCCEED == zbx_double_compare(result, 0))
+	{
+		ret = SUCCEED;
+	}
+out:
+	zbx_free(expression);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: correlation_index_rules                                          *
+ *                                                                            *
+ * Purpose: indexes correlation rules by the tags new events must have to     *
+ *          match them                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	correlation_index_rules(void)
+{
+	int			i, j;
+	zbx_vector_str_t	tags;
+	zbx_correlation_t	*correlation;
+	zbx_correlation_tag_t	*ctag, ctag_local;
+
+	zbx_hashset_clear(&correlation_tags);
+	zbx_vector_ptr_clear(&correlation_untagged);
+
+	zbx_vector_str_create(&tags);
+
+	for (i = 0; i < correlation_rules.correlations.values_num; i++)
+	{
+		correlation = (zbx_correlation_t *)correlation_rules.correlations.values[i];
+
+		zbx_vector_str_clear(&tags);
+
+		if (SUCCEED != correlation_get_new_event_tags(correlation, &tags))
+		{
+			zbx_vector_ptr_append(&correlation_untagged, correlation);
+			continue;
+		}
+
+		for (j = 0; j < tags.values_num; j++)
+		{
+			ctag_local.tag = tags.values[j];
+
+			if (NULL == (ctag = (zbx_correlation_tag_t *)zbx_hashset_search(&correlation_tags, &ctag_local)))
+			{
+				ctag = (zbx_correlation_tag_t *)zbx_hashset_insert(&correlation_tags, &ctag_local,
+						sizeof(ctag_local));
+				zbx_vector_ptr_create(&ctag->correlations);
+			}
+
+			/* the same tag can be used by several conditions of a rule */
+			if (0 == ctag->correlations.values_num ||
+					correlation != ctag->correlations.values[ctag->correlations.values_num - 1])
+			{
+				zbx_vector_ptr_append(&ctag->correlations, correlation);
+			}
+		}
+	}
+
+	zbx_vector_str_destroy(&tags);
+
+	correlation_index_ts = correlation_rules.sync_ts;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() correlations:%d untagged:%d tags:%d", __func__,
+			correlation_rules.correlations.values_num, correlation_untagged.values_num,
+			correlation_tags.num_data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: correlation_get_event_rules                                      *
+ *                                                                            *
+ * Purpose: gets correlation rules that might match the new event             *
+ *                                                                            *
+ * Parameters: event        - [IN] the new event                              *
+ *             correlations - [OUT] the correlation rules sorted by           *
+ *                                  correlationid                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	correlation_get_event_rules(const DB_EVENT *event, zbx_vector_ptr_t *correlations)
+{
+	int			i, tagged = 0;
+	zbx_correlation_tag_t	*ctag, ctag_local;
+
+	zbx_vector_ptr_append_array(correlations, correlation_untagged.values, correlation_untagged.values_num);
+
+	if (0 == correlation_tags.num_data)
+		return;
+
+	for (i = 0; i < event->tags.values_num; i++)
+	{
+		ctag_local.tag = ((zbx_tag_t *)event->tags.values[i])->tag;
+
+		if (NULL == (ctag = (zbx_correlation_tag_t *)zbx_hashset_search(&correlation_tags, &ctag_local)))
+			continue;
+
+		zbx_vector_ptr_append_array(correlations, ctag->correlations.values, ctag->correlations.values_num);
+		tagged = 1;
+	}
+
+	if (0 != tagged)
+	{
+		zbx_vector_ptr_sort(correlations, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
+		zbx_vector_ptr_uniq(correlations, ZBX_DEFAULT_PTR_COMPARE_FUNC);
+	}
+}
+
 /* specifies correlation execution scope */
 typedef enum
 {
@@ -1158,15 +1435,19 @@ static void	correlate_event_by_global_rules(DB_EVENT *event, zbx_problem_state_t
 	const char		*delim = "";
 	size_t			sql_alloc = 0, sql_offset = 0;
 	zbx_uint64_t		eventid, correlationid, objectid;
+	zbx_vector_ptr_t	correlations;
 
 	zbx_vector_ptr_create(&corr_old);
 	zbx_vector_ptr_create(&corr_new);
+	zbx_vector_ptr_create(&correlations);
 
-	for (i = 0; i < correlation_rules.correlations.values_num; i++)
+	correlation_get_event_rules(event, &correlations);
+
+	for (i = 0; i < correlations.values_num; i++)
 	{
 		zbx_correlation_scope_t	scope;
 
-		correlation = (zbx_correlation_t *)correlation_rules.correlations.values[i];
+		correlation = (zbx_correlation_t *)correlations.values[i];
 
 		switch (correlation_match_new_event(correlation, event, SUCCEED))
 		{
@@ -1274,6 +1555,7 @@ static void	correlate_event_by_global_rules(DB_EVENT *event, zbx_problem_state_t
 		zbx_free(sql);
 	}
 
+	zbx_vector_ptr_destroy(&correlations);
 	zbx_vector_ptr_destroy(&corr_new);
 	zbx_vector_ptr_destroy(&corr_old);
 }
@@ -1299,6 +1581,9 @@ static void	correlate_events_by_global_rules(zbx_vector_ptr_t *trigger_events, z
 	if (0 == correlation_rules.correlations.values_num)
 		goto out;
 
+	if (correlation_index_ts != correlation_rules.sync_ts)
+		correlation_index_rules();
+
 	/* process global correlation and queue the events that must be closed */
 	for (i = 0; i < trigger_events->values_num; i++)
 	{
@@ -1647,6 +1932,12 @@ void	zbx_initialize_events(void)
 	zbx_hashset_create(&correlation_cache, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	zbx_dc_correlation_rules_init(&correlation_rules);
+
+	zbx_hashset_create_ext(&correlation_tags, 0, correlation_tag_hash_func, correlation_tag_compare_func,
+			(zbx_clean_func_t)correlation_tag_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+	zbx_vector_ptr_create(&correlation_untagged);
+	correlation_index_ts = 0;
 }
 
 /******************************************************************************
@@ -1662,6 +1953,9 @@ void	zbx_uninitialize_events(void)
 	zbx_hashset_destroy(&event_recovery);
 	zbx_hashset_destroy(&correlation_cache);
 
+	zbx_hashset_destroy(&correlation_tags);
+	zbx_vector_ptr_destroy(&correlation_untagged);
+
 	zbx_dc_correlation_rules_free(&correlation_rules);
 }
 
@@ -54,6 +54,54 @@ zbx_httppage_t;
 
 static zbx_httppage_t	page;
 
+/******************************************************************************
+ *                                                                            *
+ * Function: httptest_get_share                                               *
+ *                                                                            *
+ * Purpose: get cURL share handle used by all scenarios of the process        *
+ *                                                                            *
+ * Return value: the share handle or NULL if it cannot be created             *
+ *                                                                            *
+ * Comments: Resolved host names, TLS sessions and (starting with libcurl     *
+ *           7.57.0) connections are reused between scenarios and their       *
+ *           following runs. Cookies are not shared, each scenario starts     *
+ *           with empty cookie storage.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static CURLSH	*httptest_get_share(void)
+{
+	static CURLSH	*share = NULL;
+	static int	failed = 0;
+
+	if (NULL != share || 0 != failed)
+		return share;
+
+	if (NULL == (share = curl_share_init()))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot initialize cURL share handle");
+		goto fail;
+	}
+
+	if (CURLSHE_OK != curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS) ||
+			CURLSHE_OK != curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot configure cURL share handle");
+		curl_share_cleanup(share);
+		share = NULL;
+		goto fail;
+	}
+#if LIBCURL_VERSION_NUM >= 0x073900
+	/* sharing of connection cache is supported starting with version 7.57.0 (0x073900) */
+	if (CURLSHE_OK != curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT))
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot share connection cache between web scenarios");
+#endif
+	return share;
+fail:
+	failed = 1;
+
+	return NULL;
+}
+
 static size_t	curl_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
 	size_t	r_size = size * nmemb;
@@ -690,7 +738,9 @@ static void	process_httptest(DC_HOST *host, zbx_httptest_t *httptest)
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROXY, httptest->httptest.http_proxy)) ||
 			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_COOKIEFILE, "")) ||
 			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_USERAGENT, httptest->httptest.agent)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_ERRORBUFFER, errbuf)))
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_ERRORBUFFER, errbuf)) ||
+			(NULL != httptest_get_share() &&
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_SHARE, httptest_get_share()))))
 	{
 		err_str = zbx_strdup(err_str, curl_easy_strerror(err));
 		goto clean;
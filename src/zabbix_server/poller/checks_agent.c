@@ -20,43 +20,194 @@
 #include "common.h"
 #include "comms.h"
 #include "log.h"
+#include "zbxcompress.h"
 #include "../../libs/zbxcrypto/tls_tcp_active.h"
 
+#ifdef HAVE_LIBEVENT
+#	include <event.h>
+#endif
+
 #include "checks_agent.h"
 
 #if !(defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL))
 extern unsigned char	program_type;
 #endif
 
+extern int	CONFIG_TIMEOUT;
+extern int	CONFIG_AGENT_PERSISTENT;
+
+#define ZBX_AGENT_PERSISTENT_RECHECK	SEC_PER_HOUR
+
+/* interface of agent that rejected persistent connection */
+typedef struct
+{
+	zbx_uint64_t	interfaceid;
+	time_t		recheck;
+}
+zbx_agent_nonpersistent_t;
+
+static zbx_hashset_t	nonpersistent_interfaces;
+static time_t		nonpersistent_cleanup;
+
 /******************************************************************************
  *                                                                            *
- * Function: get_value_agent                                                  *
+ * Function: agent_persistent_allowed                                         *
  *                                                                            *
- * Purpose: retrieve data from Zabbix agent                                   *
+ * Purpose: check if persistent connection can be requested from the agent    *
+ *          of the interface                                                  *
  *                                                                            *
- * Parameters: item - item we are interested in                               *
+ * Return value: SUCCEED - persistent connections are enabled and the agent   *
+ *                         has not rejected it or it is time to ask again     *
+ *               FAIL    - otherwise                                          *
  *                                                                            *
- * Return value: SUCCEED - data successfully retrieved and stored in result   *
- *                         and result_str (as string)                         *
- *               NETWORK_ERROR - network related error occurred               *
+ ******************************************************************************/
+static int	agent_persistent_allowed(zbx_uint64_t interfaceid)
+{
+	zbx_agent_nonpersistent_t	*interface;
+
+	if (0 == CONFIG_AGENT_PERSISTENT)
+		return FAIL;
+
+	if (NULL == nonpersistent_interfaces.slots)
+		return SUCCEED;
+
+	if (NULL == (interface = (zbx_agent_nonpersistent_t *)zbx_hashset_search(&nonpersistent_interfaces,
+			&interfaceid)))
+	{
+		return SUCCEED;
+	}
+
+	if (interface->recheck > time(NULL))
+		return FAIL;
+
+	zbx_hashset_remove_direct(&nonpersistent_interfaces, interface);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_persistent_reject                                          *
+ *                                                                            *
+ * Purpose: stop requesting persistent connection from the agent of the       *
+ *          interface                                                         *
+ *                                                                            *
+ * Comments: Agents without persistent connection support reply to the        *
+ *           opening request as to an unknown item key and close connection.  *
+ *           The agent is asked again after ZBX_AGENT_PERSISTENT_RECHECK      *
+ *           seconds in case it has been upgraded.                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_persistent_reject(zbx_uint64_t interfaceid)
+{
+	zbx_agent_nonpersistent_t	*interface, interface_local;
+	zbx_hashset_iter_t		iter;
+	time_t				now;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() interfaceid:" ZBX_FS_UI64, __func__, interfaceid);
+
+	now = time(NULL);
+
+	if (NULL == nonpersistent_interfaces.slots)
+	{
+		zbx_hashset_create(&nonpersistent_interfaces, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		nonpersistent_cleanup = now + ZBX_AGENT_PERSISTENT_RECHECK;
+	}
+	else if (nonpersistent_cleanup <= now)
+	{
+		/* forget the interfaces that are not checked anymore */
+		zbx_hashset_iter_reset(&nonpersistent_interfaces, &iter);
+
+		while (NULL != (interface = (zbx_agent_nonpersistent_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (interface->recheck <= now)
+				zbx_hashset_iter_remove(&iter);
+		}
+
+		nonpersistent_cleanup = now + ZBX_AGENT_PERSISTENT_RECHECK;
+	}
+
+	if (NULL == (interface = (zbx_agent_nonpersistent_t *)zbx_hashset_search(&nonpersistent_interfaces,
+			&interfaceid)))
+	{
+		interface_local.interfaceid = interfaceid;
+		interface = (zbx_agent_nonpersistent_t *)zbx_hashset_insert(&nonpersistent_interfaces,
+				&interface_local, sizeof(interface_local));
+	}
+
+	interface->recheck = now + ZBX_AGENT_PERSISTENT_RECHECK;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_parse_response                                             *
+ *                                                                            *
+ * Purpose: convert Zabbix agent response to the item result                  *
+ *                                                                            *
+ * Parameters: item     - [IN] the item                                       *
+ *             buffer   - [IN] the received data                              *
+ *             len      - [IN] the received data length                       *
+ *             received - [IN] the number of bytes received, including header *
+ *             result   - [OUT] the item result                               *
+ *                                                                            *
+ * Return value: SUCCEED - agent returned a value                             *
  *               NOTSUPPORTED - item not supported by the agent               *
  *               AGENT_ERROR - uncritical error on agent side occurred        *
- *               FAIL - otherwise                                             *
+ *               NETWORK_ERROR - agent dropped connection without response    *
  *                                                                            *
- * Author: Alexei Vladishev                                                   *
+ ******************************************************************************/
+static int	agent_parse_response(const DC_ITEM *item, char *buffer, size_t len, size_t received,
+		AGENT_RESULT *result)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", buffer);
+
+	if (0 == strcmp(buffer, ZBX_NOTSUPPORTED))
+	{
+		/* 'ZBX_NOTSUPPORTED\0<error message>' */
+		if (sizeof(ZBX_NOTSUPPORTED) < len)
+			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s", buffer + sizeof(ZBX_NOTSUPPORTED)));
+		else
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+
+		return NOTSUPPORTED;
+	}
+
+	if (0 == strcmp(buffer, ZBX_ERROR))
+	{
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Zabbix Agent non-critical error"));
+		return AGENT_ERROR;
+	}
+
+	if (0 == received)
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
+				" Assuming that agent dropped connection because of access permissions.",
+				item->interface.addr));
+		return NETWORK_ERROR;
+	}
+
+	set_result_type(result, ITEM_VALUE_TYPE_TEXT, buffer);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
  *                                                                            *
- * Comments: error will contain error message                                 *
+ * Function: agent_connect                                                    *
+ *                                                                            *
+ * Purpose: connect to Zabbix agent of the item                               *
+ *                                                                            *
+ * Return value: SUCCEED - connected successfully                             *
+ *               NETWORK_ERROR - cannot connect                               *
+ *               CONFIG_ERROR - invalid encryption configuration              *
  *                                                                            *
  ******************************************************************************/
-int	get_value_agent(const DC_ITEM *item, AGENT_RESULT *result)
+static int	agent_connect(zbx_socket_t *s, const DC_ITEM *item, AGENT_RESULT *result)
 {
-	zbx_socket_t	s;
 	const char	*tls_arg1, *tls_arg2;
-	int		ret = SUCCEED;
-	ssize_t		received_len;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' key:'%s' conn:'%s'", __func__, item->host.host,
-			item->interface.addr, item->key, zbx_tcp_connection_type_name(item->host.tls_connect));
 
 	switch (item->host.tls_connect)
 	{
@@ -79,68 +230,946 @@ int	get_value_agent(const DC_ITEM *item, AGENT_RESULT *result)
 			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "A TLS connection is configured to be used with agent"
 					" but support for TLS was not compiled into %s.",
 					get_program_type_string(program_type)));
-			ret = CONFIG_ERROR;
-			goto out;
+			return CONFIG_ERROR;
 #endif
 		default:
 			THIS_SHOULD_NEVER_HAPPEN;
 			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid TLS connection parameters."));
-			ret = CONFIG_ERROR;
-			goto out;
+			return CONFIG_ERROR;
 	}
 
-	if (SUCCEED == (ret = zbx_tcp_connect(&s, CONFIG_SOURCE_IP, item->interface.addr, item->interface.port, 0,
-			item->host.tls_connect, tls_arg1, tls_arg2)))
+	if (SUCCEED != zbx_tcp_connect(s, CONFIG_SOURCE_IP, item->interface.addr, item->interface.port, 0,
+			item->host.tls_connect, tls_arg1, tls_arg2))
 	{
-		zabbix_log(LOG_LEVEL_DEBUG, "Sending [%s]", item->key);
-
-		if (SUCCEED != zbx_tcp_send(&s, item->key))
-			ret = NETWORK_ERROR;
-		else if (FAIL != (received_len = zbx_tcp_recv_ext(&s, 0)))
-			ret = SUCCEED;
-		else if (SUCCEED == zbx_alarm_timed_out())
-			ret = TIMEOUT_ERROR;
-		else
-			ret = NETWORK_ERROR;
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror()));
+		return NETWORK_ERROR;
 	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_exchange                                                   *
+ *                                                                            *
+ * Purpose: send item key over connected socket and parse the response        *
+ *                                                                            *
+ * Return value: see get_value_agent()                                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_exchange(zbx_socket_t *s, const DC_ITEM *item, AGENT_RESULT *result)
+{
+	ssize_t	received_len;
+	int	ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "Sending [%s]", item->key);
+
+	if (SUCCEED != zbx_tcp_send(s, item->key))
+		ret = NETWORK_ERROR;
+	else if (FAIL != (received_len = zbx_tcp_recv_ext(s, 0)))
+		ret = SUCCEED;
+	else if (SUCCEED == zbx_alarm_timed_out())
+		ret = TIMEOUT_ERROR;
 	else
 		ret = NETWORK_ERROR;
 
-	if (SUCCEED == ret)
+	if (SUCCEED != ret)
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror()));
+		return ret;
+	}
+
+	return agent_parse_response(item, s->buffer, s->read_bytes, (size_t)received_len, result);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_persistent_open                                            *
+ *                                                                            *
+ * Purpose: ask agent to keep the connection open for the following checks    *
+ *                                                                            *
+ * Return value: SUCCEED - agent keeps the connection open until it is closed *
+ *                         or no request arrives within agent Timeout         *
+ *               FAIL    - agent does not support persistent connections or   *
+ *                         the request failed, the connection must be closed  *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_persistent_open(zbx_socket_t *s)
+{
+	if (SUCCEED != zbx_tcp_send(s, ZBX_PERSISTENT) || FAIL == zbx_tcp_recv_ext(s, 0))
+		return FAIL;
+
+	return 0 == strcmp(s->buffer, ZBX_PERSISTENT) ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_value_agent                                                  *
+ *                                                                            *
+ * Purpose: retrieve data from Zabbix agent                                   *
+ *                                                                            *
+ * Parameters: item - item we are interested in                               *
+ *                                                                            *
+ * Return value: SUCCEED - data successfully retrieved and stored in result   *
+ *                         and result_str (as string)                         *
+ *               NETWORK_ERROR - network related error occurred               *
+ *               NOTSUPPORTED - item not supported by the agent               *
+ *               AGENT_ERROR - uncritical error on agent side occurred        *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ * Author: Alexei Vladishev                                                   *
+ *                                                                            *
+ * Comments: error will contain error message                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	get_value_agent(const DC_ITEM *item, AGENT_RESULT *result)
+{
+	zbx_socket_t	s;
+	int		ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' key:'%s' conn:'%s'", __func__, item->host.host,
+			item->interface.addr, item->key, zbx_tcp_connection_type_name(item->host.tls_connect));
+
+	if (SUCCEED == (ret = agent_connect(&s, item, result)))
+	{
+		ret = agent_exchange(&s, item, result);
+		zbx_tcp_close(&s);
+	}
+	else if (NETWORK_ERROR == ret)
+		zbx_tcp_close(&s);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_get_interface_values                                       *
+ *                                                                            *
+ * Purpose: retrieve values of items of the same interface one by one,        *
+ *          reusing the connection if agent supports it                       *
+ *                                                                            *
+ * Parameters: items       - [IN] the items                                   *
+ *             results     - [OUT] the item results                           *
+ *             errcodes    - [OUT] the item result codes                      *
+ *             indexes     - [IN] the indexes of items to check               *
+ *             indexes_num - [IN] the number of items to check                *
+ *                                                                            *
+ * Comments: Failure to open persistent connection does not affect the item   *
+ *           results, the checks are performed over separate connections.     *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_get_interface_values(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes,
+		const int *indexes, int indexes_num)
+{
+	zbx_socket_t	s;
+	int		i, j, k, ret, connected = 0, reused, persistent = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' num:%d", __func__, items[indexes[0]].host.host,
+			items[indexes[0]].interface.addr, indexes_num);
+
+	for (i = 0; i < indexes_num; i++)
+	{
+		k = indexes[i];
+		reused = connected;
+
+		zbx_alarm_on(CONFIG_TIMEOUT);
+
+		if (0 == connected)
+		{
+			if (SUCCEED != (ret = agent_connect(&s, &items[k], &results[k])))
+			{
+				zbx_alarm_off();
+
+				if (NETWORK_ERROR == ret)
+					zbx_tcp_close(&s);
+
+				/* the remaining checks of the interface would fail the same way */
+				for (j = i; j < indexes_num; j++)
+				{
+					if (j != i)
+						SET_MSG_RESULT(&results[indexes[j]], zbx_strdup(NULL, results[k].msg));
+
+					errcodes[indexes[j]] = ret;
+				}
+
+				break;
+			}
+
+			connected = 1;
+
+			if (i + 1 < indexes_num && SUCCEED == agent_persistent_allowed(items[k].interface.interfaceid))
+			{
+				ret = agent_persistent_open(&s);
+				zbx_alarm_off();
+
+				if (SUCCEED != ret)
+				{
+					agent_persistent_reject(items[k].interface.interfaceid);
+					zbx_tcp_close(&s);
+					connected = 0;
+					i--;
+					continue;
+				}
+
+				persistent = 1;
+				zbx_alarm_on(CONFIG_TIMEOUT);
+			}
+		}
+
+		ret = agent_exchange(&s, &items[k], &results[k]);
+		zbx_alarm_off();
+
+		if (0 != reused && NETWORK_ERROR == ret)
+		{
+			/* agent could have closed the connection while it was idle, check over new connection */
+			zbx_tcp_close(&s);
+			connected = 0;
+			persistent = 0;
+			free_result(&results[k]);
+			init_result(&results[k]);
+			i--;
+			continue;
+		}
+
+		errcodes[k] = ret;
+
+		/* the connection can be reused only after a complete response */
+		if (0 == persistent || (SUCCEED != ret && NOTSUPPORTED != ret && AGENT_ERROR != ret))
+		{
+			zbx_tcp_close(&s);
+			connected = 0;
+			persistent = 0;
+		}
+	}
+
+	if (0 != connected)
+		zbx_tcp_close(&s);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+#ifdef HAVE_LIBEVENT
+
+#define ZBX_AGENT_HEADER_DATA	"ZBXD"
+#define ZBX_AGENT_HEADER_LEN	ZBX_CONST_STRLEN(ZBX_AGENT_HEADER_DATA)
+#define ZBX_AGENT_HEADER_SIZE	(ZBX_AGENT_HEADER_LEN + 1 + 2 * sizeof(zbx_uint32_t))
+
+#define ZBX_AGENT_STATE_CONNECT	0
+#define ZBX_AGENT_STATE_SEND	1
+#define ZBX_AGENT_STATE_RECV	2
+
+/* passive agent check performed over nonblocking socket */
+typedef struct zbx_agent_request
+{
+	const DC_ITEM		*item;
+	AGENT_RESULT		*result;
+	int			*errcode;
+	struct event_base	*base;
+	struct event		ev;
+	int			fd;
+	int			state;
+	double			deadline;
+
+	/* the next check of the same interface, performed over the same connection if agent keeps it open */
+	struct zbx_agent_request	*next;
+	unsigned char			probe;		/* persistent connection opening request is in progress */
+	unsigned char			persistent;	/* agent keeps the connection open */
+	unsigned char			reused;
+
+	/* the request data when sending, the response data when receiving */
+	char			*buf;
+	size_t			buf_alloc;
+	size_t			buf_offset;
+	size_t			send_len;
+}
+zbx_agent_request_t;
+
+static void	agent_request_event_cb(int fd, short what, void *arg);
+static int	agent_request_start(zbx_agent_request_t *request);
+static void	agent_request_reuse(zbx_agent_request_t *request, int fd);
+static void	agent_request_prepare(zbx_agent_request_t *request, const char *data);
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_request_finish                                             *
+ *                                                                            *
+ * Purpose: close agent request connection and set the check result code      *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_request_finish(zbx_agent_request_t *request, int errcode)
+{
+	zbx_agent_request_t	*next;
+
+	*request->errcode = errcode;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() host:'%s' key:'%s' result:%s", __func__, request->item->host.host,
+			request->item->key, zbx_result_string(errcode));
+
+	if (NULL != (next = request->next))
+	{
+		request->next = NULL;
+
+		if (-1 != request->fd && 0 != request->persistent)
+		{
+			agent_request_reuse(next, request->fd);
+			request->fd = -1;
+		}
+		else
+		{
+			/* agent does not keep the connection open or the check failed, */
+			/* perform the remaining checks of the interface concurrently   */
+			while (NULL != next)
+			{
+				zbx_agent_request_t	*following = next->next;
+
+				next->next = NULL;
+				(void)agent_request_start(next);
+				next = following;
+			}
+		}
+	}
+
+	if (-1 != request->fd)
+	{
+		close(request->fd);
+		request->fd = -1;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_request_restart                                            *
+ *                                                                            *
+ * Purpose: repeat the check over new connection after the reused connection  *
+ *          was closed by agent or agent rejected persistent connection       *
+ *                                                                            *
+ * Comments: When persistent connection is rejected the interface is marked   *
+ *           so, the check is repeated without asking for it.                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_request_restart(zbx_agent_request_t *request)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() host:'%s' key:'%s'", __func__, request->item->host.host,
+			request->item->key);
+
+	if (0 != request->probe)
+		agent_persistent_reject(request->item->interface.interfaceid);
+
+	close(request->fd);
+	request->fd = -1;
+	request->reused = 0;
+	zbx_free(request->buf);
+
+	(void)agent_request_start(request);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_request_fail                                               *
+ *                                                                            *
+ * Purpose: finish agent request with error                                   *
+ *                                                                            *
+ * Comments: Failed persistent connection opening request is not reported,    *
+ *           the check is repeated over new connection instead.               *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_request_fail(zbx_agent_request_t *request, int errcode, const char *fmt, ...)
+{
+	va_list	args;
+	char	*error;
+
+	if (0 != request->probe && ZBX_AGENT_STATE_CONNECT != request->state)
+	{
+		/* failed persistent connection opening request must not affect the check */
+		agent_request_restart(request);
+		return;
+	}
+
+	request->persistent = 0;
+
+	va_start(args, fmt);
+	error = zbx_dvsprintf(NULL, fmt, args);
+	va_end(args);
+
+	SET_MSG_RESULT(request->result, zbx_dsprintf(NULL, "Get value from agent failed: %s", error));
+	zbx_free(error);
+
+	agent_request_finish(request, errcode);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_request_wait                                               *
+ *                                                                            *
+ * Purpose: wait for agent request socket to become readable or writable      *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_request_wait(zbx_agent_request_t *request, short what)
+{
+	struct timeval	tv;
+	double		left;
+
+	if (0 > (left = request->deadline - zbx_time()))
+		left = 0;
+
+	tv.tv_sec = (time_t)left;
+	tv.tv_usec = (suseconds_t)((left - (double)tv.tv_sec) * 1000000);
+
+	event_set(&request->ev, request->fd, what, agent_request_event_cb, request);
+	event_base_set(request->base, &request->ev);
+	event_add(&request->ev, &tv);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_request_complete                                           *
+ *                                                                            *
+ * Purpose: check if the whole agent response has been received               *
+ *                                                                            *
+ * Return value: SUCCEED - the response is complete                           *
+ *               FAIL    - more data is expected or response is invalid,      *
+ *                         in the latter case the request is finished         *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_request_complete(zbx_agent_request_t *request)
+{
+	zbx_uint32_t	len;
+	unsigned char	flags;
+
+	if (0 != strncmp(request->buf, ZBX_AGENT_HEADER_DATA, MIN(request->buf_offset, ZBX_AGENT_HEADER_LEN)))
+	{
+		agent_request_fail(request, NETWORK_ERROR, "message is missing header");
+		return FAIL;
+	}
+
+	if (ZBX_AGENT_HEADER_SIZE > request->buf_offset)
+		return FAIL;
+
+	flags = (unsigned char)request->buf[ZBX_AGENT_HEADER_LEN];
+
+	if (0 == (flags & ZBX_TCP_PROTOCOL) || (ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS) < flags)
+	{
+		agent_request_fail(request, NETWORK_ERROR, "unsupported protocol version \"%d\"", (int)flags);
+		return FAIL;
+	}
+
+	memcpy(&len, request->buf + ZBX_AGENT_HEADER_LEN + 1, sizeof(len));
+	len = zbx_letoh_uint32(len);
+
+	if (ZBX_MAX_RECV_DATA_SIZE < len)
+	{
+		agent_request_fail(request, NETWORK_ERROR, "message size " ZBX_FS_UI64 " exceeds the maximum size "
+				ZBX_FS_UI64 " bytes", (zbx_uint64_t)len, (zbx_uint64_t)ZBX_MAX_RECV_DATA_SIZE);
+		return FAIL;
+	}
+
+	if (ZBX_AGENT_HEADER_SIZE + len > request->buf_offset)
+		return FAIL;
+
+	if (ZBX_AGENT_HEADER_SIZE + len < request->buf_offset)
+	{
+		agent_request_fail(request, NETWORK_ERROR, "message is longer than expected " ZBX_FS_UI64 " bytes",
+				(zbx_uint64_t)len);
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_request_process_response                                   *
+ *                                                                            *
+ * Purpose: parse the received agent response and finish the request or       *
+ *          send the item key after agent confirmed persistent connection     *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_request_process_response(zbx_agent_request_t *request)
+{
+	char		*data;
+	size_t		data_len;
+	zbx_uint32_t	len, reserved;
+	int		errcode;
+
+	if (0 == request->buf_offset)
 	{
-		zabbix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", s.buffer);
+		if (0 != request->probe)
+		{
+			agent_request_restart(request);
+			return;
+		}
+
+		request->persistent = 0;
+		*request->buf = '\0';
+		agent_request_finish(request, agent_parse_response(request->item, request->buf, 0, 0,
+				request->result));
+		return;
+	}
+
+	memcpy(&len, request->buf + ZBX_AGENT_HEADER_LEN + 1, sizeof(len));
+	len = zbx_letoh_uint32(len);
+	memcpy(&reserved, request->buf + ZBX_AGENT_HEADER_LEN + 1 + sizeof(len), sizeof(reserved));
+	reserved = zbx_letoh_uint32(reserved);
 
-		if (0 == strcmp(s.buffer, ZBX_NOTSUPPORTED))
+	if (0 != (request->buf[ZBX_AGENT_HEADER_LEN] & ZBX_TCP_COMPRESS))
+	{
+		if (ZBX_MAX_RECV_DATA_SIZE < reserved)
 		{
-			/* 'ZBX_NOTSUPPORTED\0<error message>' */
-			if (sizeof(ZBX_NOTSUPPORTED) < s.read_bytes)
-				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s", s.buffer + sizeof(ZBX_NOTSUPPORTED)));
-			else
-				SET_MSG_RESULT(result, zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+			agent_request_fail(request, NETWORK_ERROR, "uncompressed message size " ZBX_FS_UI64
+					" exceeds the maximum size " ZBX_FS_UI64 " bytes", (zbx_uint64_t)reserved,
+					(zbx_uint64_t)ZBX_MAX_RECV_DATA_SIZE);
+			return;
+		}
 
-			ret = NOTSUPPORTED;
+		data_len = reserved;
+		data = (char *)zbx_malloc(NULL, data_len + 1);
+
+		if (FAIL == zbx_uncompress(request->buf + ZBX_AGENT_HEADER_SIZE, len, data, &data_len) ||
+				data_len != reserved)
+		{
+			zbx_free(data);
+			agent_request_fail(request, NETWORK_ERROR, "cannot uncompress data: %s",
+					zbx_compress_strerror());
+			return;
 		}
-		else if (0 == strcmp(s.buffer, ZBX_ERROR))
+	}
+	else
+	{
+		data_len = len;
+		data = (char *)zbx_malloc(NULL, data_len + 1);
+		memcpy(data, request->buf + ZBX_AGENT_HEADER_SIZE, data_len);
+	}
+
+	data[data_len] = '\0';
+
+	if (0 != request->probe)
+	{
+		if (0 != strcmp(data, ZBX_PERSISTENT))
 		{
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Zabbix Agent non-critical error"));
-			ret = AGENT_ERROR;
+			zbx_free(data);
+			agent_request_restart(request);
+			return;
 		}
-		else if (0 == received_len)
+
+		zbx_free(data);
+
+		/* agent keeps the connection open, send the item key */
+		request->probe = 0;
+		request->persistent = 1;
+		request->deadline = zbx_time() + CONFIG_TIMEOUT;
+		agent_request_prepare(request, request->item->key);
+		request->state = ZBX_AGENT_STATE_SEND;
+		agent_request_wait(request, EV_WRITE);
+		return;
+	}
+
+	errcode = agent_parse_response(request->item, data, data_len, request->buf_offset, request->result);
+	zbx_free(data);
+
+	agent_request_finish(request, errcode);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_request_event_cb                                           *
+ *                                                                            *
+ * Purpose: advance agent request when its socket is ready or timed out       *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_request_event_cb(int fd, short what, void *arg)
+{
+	zbx_agent_request_t	*request = (zbx_agent_request_t *)arg;
+	ssize_t			n;
+	int			err;
+	socklen_t		err_len = sizeof(err);
+
+	if (0 != (what & EV_TIMEOUT))
+	{
+		if (ZBX_AGENT_STATE_CONNECT == request->state)
 		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
-					" Assuming that agent dropped connection because of access permissions.",
-					item->interface.addr));
-			ret = NETWORK_ERROR;
+			agent_request_fail(request, NETWORK_ERROR, "cannot connect to [[%s]:%hu]: timed out",
+					request->item->interface.addr, request->item->interface.port);
 		}
 		else
-			set_result_type(result, ITEM_VALUE_TYPE_TEXT, s.buffer);
+			agent_request_fail(request, TIMEOUT_ERROR, "timed out");
+
+		return;
+	}
+
+	switch (request->state)
+	{
+		case ZBX_AGENT_STATE_CONNECT:
+			if (0 != getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &err_len))
+				err = errno;
+
+			if (0 != err)
+			{
+				agent_request_fail(request, NETWORK_ERROR, "cannot connect to [[%s]:%hu]: %s",
+						request->item->interface.addr, request->item->interface.port,
+						zbx_strerror(err));
+				return;
+			}
+
+			request->state = ZBX_AGENT_STATE_SEND;
+			ZBX_FALLTHROUGH;
+		case ZBX_AGENT_STATE_SEND:
+			if (-1 == (n = send(fd, request->buf + request->buf_offset,
+					request->send_len - request->buf_offset, 0)))
+			{
+				if (EAGAIN != errno && EINTR != errno)
+				{
+					if (0 != request->reused)
+					{
+						agent_request_restart(request);
+						return;
+					}
+
+					agent_request_fail(request, NETWORK_ERROR, "cannot send data: %s",
+							zbx_strerror(errno));
+					return;
+				}
+
+				n = 0;
+			}
+
+			if (request->send_len > (request->buf_offset += (size_t)n))
+			{
+				agent_request_wait(request, EV_WRITE);
+				return;
+			}
+
+			request->state = ZBX_AGENT_STATE_RECV;
+			request->buf_offset = 0;
+			agent_request_wait(request, EV_READ);
+			return;
+		case ZBX_AGENT_STATE_RECV:
+			if (request->buf_alloc == request->buf_offset + 1)
+			{
+				request->buf_alloc *= 2;
+				request->buf = (char *)zbx_realloc(request->buf, request->buf_alloc);
+			}
+
+			if (-1 == (n = recv(fd, request->buf + request->buf_offset,
+					request->buf_alloc - request->buf_offset - 1, 0)))
+			{
+				if (EAGAIN != errno && EINTR != errno)
+				{
+					if (0 != request->reused && 0 == request->buf_offset)
+					{
+						agent_request_restart(request);
+						return;
+					}
+
+					agent_request_fail(request, NETWORK_ERROR, "cannot read data: %s",
+							zbx_strerror(errno));
+					return;
+				}
+
+				agent_request_wait(request, EV_READ);
+				return;
+			}
+
+			if (0 == n)
+			{
+				if (0 != request->reused && 0 == request->buf_offset)
+				{
+					/* agent closed idle connection before receiving the request */
+					agent_request_restart(request);
+					return;
+				}
+
+				/* connection closed by agent, the response must be either complete or empty */
+				if (0 == request->buf_offset || SUCCEED == agent_request_complete(request))
+					agent_request_process_response(request);
+				else if (-1 != request->fd)
+					agent_request_fail(request, NETWORK_ERROR, "message is shorter than expected");
+
+				return;
+			}
+
+			request->buf_offset += (size_t)n;
+
+			if (SUCCEED == agent_request_complete(request))
+				agent_request_process_response(request);
+			else if (-1 != request->fd)
+				agent_request_wait(request, EV_READ);
+
+			return;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			agent_request_finish(request, NETWORK_ERROR);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_request_prepare                                            *
+ *                                                                            *
+ * Purpose: prepare the request data to send                                  *
+ *                                                                            *
+ * Parameters: request - [IN/OUT] the agent request                           *
+ *             data    - [IN] the item key or persistent connection opening   *
+ *                            request                                         *
+ *                                                                            *
+ * Comments: The data is sent using Zabbix protocol the same way as           *
+ *           zbx_tcp_send() does.                                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_request_prepare(zbx_agent_request_t *request, const char *data)
+{
+	zbx_uint32_t	len32_le;
+	size_t		data_len;
+
+	data_len = strlen(data);
+
+	request->buf_alloc = MAX(ZBX_STAT_BUF_LEN, ZBX_AGENT_HEADER_SIZE + data_len + 1);
+	request->buf = (char *)zbx_realloc(request->buf, request->buf_alloc);
+
+	memcpy(request->buf, ZBX_AGENT_HEADER_DATA, ZBX_AGENT_HEADER_LEN);
+	request->buf[ZBX_AGENT_HEADER_LEN] = ZBX_TCP_PROTOCOL;
+	len32_le = zbx_htole_uint32((zbx_uint32_t)data_len);
+	memcpy(request->buf + ZBX_AGENT_HEADER_LEN + 1, &len32_le, sizeof(len32_le));
+	len32_le = 0;
+	memcpy(request->buf + ZBX_AGENT_HEADER_LEN + 1 + sizeof(len32_le), &len32_le, sizeof(len32_le));
+	memcpy(request->buf + ZBX_AGENT_HEADER_SIZE, data, data_len);
+
+	request->send_len = ZBX_AGENT_HEADER_SIZE + data_len;
+	request->buf_offset = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_request_reuse                                              *
+ *                                                                            *
+ * Purpose: start the check over connection left open by the previous check   *
+ *          of the same interface                                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_request_reuse(zbx_agent_request_t *request, int fd)
+{
+	request->fd = fd;
+	request->reused = 1;
+	request->persistent = 1;
+	request->deadline = zbx_time() + CONFIG_TIMEOUT;
+
+	agent_request_prepare(request, request->item->key);
+	request->state = ZBX_AGENT_STATE_SEND;
+
+	agent_request_wait(request, EV_WRITE);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_request_start                                              *
+ *                                                                            *
+ * Purpose: start nonblocking connection to the agent                         *
+ *                                                                            *
+ * Return value: SUCCEED - the connection is in progress                      *
+ *               FAIL    - the request has been finished with error           *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_request_start(zbx_agent_request_t *request)
+{
+	struct addrinfo	hints, *ai = NULL, *ai_bind = NULL;
+	char		service[8];
+	int		ret = FAIL, flags;
+
+	request->probe = 0;
+	request->persistent = 0;
+	request->deadline = zbx_time() + CONFIG_TIMEOUT;
+
+	zbx_snprintf(service, sizeof(service), "%hu", request->item->interface.port);
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = PF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	if (0 != getaddrinfo(request->item->interface.addr, service, &hints, &ai))
+	{
+		agent_request_fail(request, NETWORK_ERROR, "cannot resolve [%s]", request->item->interface.addr);
+		goto out;
+	}
+
+	if (-1 == (request->fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)))
+	{
+		agent_request_fail(request, NETWORK_ERROR, "cannot create socket [[%s]:%hu]: %s",
+				request->item->interface.addr, request->item->interface.port, zbx_strerror(errno));
+		goto out;
+	}
+
+	if (-1 == (flags = fcntl(request->fd, F_GETFL, 0)) ||
+			-1 == fcntl(request->fd, F_SETFL, flags | O_NONBLOCK) ||
+			-1 == fcntl(request->fd, F_SETFD, FD_CLOEXEC))
+	{
+		agent_request_fail(request, NETWORK_ERROR, "cannot set socket options: %s", zbx_strerror(errno));
+		goto out;
+	}
+
+	if (NULL != CONFIG_SOURCE_IP)
+	{
+		hints.ai_flags = AI_NUMERICHOST;
+
+		if (0 != getaddrinfo(CONFIG_SOURCE_IP, NULL, &hints, &ai_bind))
+		{
+			agent_request_fail(request, NETWORK_ERROR, "invalid source IP address [%s]",
+					CONFIG_SOURCE_IP);
+			goto out;
+		}
+
+		if (0 != bind(request->fd, ai_bind->ai_addr, ai_bind->ai_addrlen))
+		{
+			agent_request_fail(request, NETWORK_ERROR, "bind() failed: %s", zbx_strerror(errno));
+			goto out;
+		}
+	}
+
+	if (0 != connect(request->fd, ai->ai_addr, ai->ai_addrlen) && EINPROGRESS != errno)
+	{
+		agent_request_fail(request, NETWORK_ERROR, "cannot connect to [[%s]:%hu]: %s",
+				request->item->interface.addr, request->item->interface.port, zbx_strerror(errno));
+		goto out;
+	}
+
+	/* ask agent to keep the connection open if other checks of the interface follow */
+	if (NULL != request->next && SUCCEED == agent_persistent_allowed(request->item->interface.interfaceid))
+	{
+		request->probe = 1;
+		agent_request_prepare(request, ZBX_PERSISTENT);
 	}
 	else
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror()));
+		agent_request_prepare(request, request->item->key);
+
+	request->state = ZBX_AGENT_STATE_CONNECT;
 
-	zbx_tcp_close(&s);
+	agent_request_wait(request, EV_WRITE);
+
+	ret = SUCCEED;
 out:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+	if (NULL != ai)
+		freeaddrinfo(ai);
+
+	if (NULL != ai_bind)
+		freeaddrinfo(ai_bind);
 
 	return ret;
 }
+
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_values_agent                                                 *
+ *                                                                            *
+ * Purpose: retrieve values of multiple items from Zabbix agents              *
+ *                                                                            *
+ * Parameters: items    - [IN] the items to check                             *
+ *             results  - [OUT] the item results                              *
+ *             errcodes - [IN/OUT] the item result codes, only items with     *
+ *                                 SUCCEED code are checked                   *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ * Comments: Unencrypted checks of different interfaces are performed         *
+ *           concurrently over nonblocking sockets, each check is limited by  *
+ *           Timeout configuration parameter. Checks using TLS are performed  *
+ *           one by one. If AgentPersistentConnections is enabled, checks of  *
+ *           the same interface are performed over one connection opened with *
+ *           ZBX_PERSISTENT request. Agent rejecting it is checked over       *
+ *           separate connections, see agent_persistent_reject().             *
+ *                                                                            *
+ ******************************************************************************/
+void	get_values_agent(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+#ifdef HAVE_LIBEVENT
+	static struct event_base	*base = NULL;
+	zbx_agent_request_t		*requests;
+#	define ZBX_AGENT_ITEM_ASYNC(item)	(ZBX_TCP_SEC_UNENCRYPTED == (item)->host.tls_connect)
+#else
+#	define ZBX_AGENT_ITEM_ASYNC(item)	0
+#endif
+	int				i, j, *indexes, indexes_num;
+	unsigned char			*processed;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __func__, num);
+
+	indexes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
+#ifdef HAVE_LIBEVENT
+	if (NULL == base)
+		base = event_base_new();
+
+	requests = (zbx_agent_request_t *)zbx_calloc(NULL, (size_t)num, sizeof(zbx_agent_request_t));
+	indexes_num = 0;
+
+	for (i = 0; i < num; i++)
+	{
+		zbx_agent_request_t	*request = &requests[i];
+
+		request->fd = -1;
+
+		if (SUCCEED != errcodes[i] || !ZBX_AGENT_ITEM_ASYNC(&items[i]))
+			continue;
+
+		request->item = &items[i];
+		request->result = &results[i];
+		request->errcode = &errcodes[i];
+		request->base = base;
+
+		/* chain the check after the previous check of the same interface if the connection can be reused */
+		if (SUCCEED == agent_persistent_allowed(items[i].interface.interfaceid))
+		{
+			for (j = i - 1; 0 <= j; j--)
+			{
+				if (NULL != requests[j].item &&
+						items[j].interface.interfaceid == items[i].interface.interfaceid)
+				{
+					requests[j].next = request;
+					break;
+				}
+			}
+		}
+		else
+			j = -1;
+
+		if (0 > j)
+			indexes[indexes_num++] = i;
+	}
+
+	/* start the first check of each interface, the others are started when it finishes */
+	for (i = 0; i < indexes_num; i++)
+		(void)agent_request_start(&requests[indexes[i]]);
+
+	event_base_dispatch(base);
+#endif
+	processed = (unsigned char *)zbx_calloc(NULL, (size_t)num, sizeof(unsigned char));
+
+	for (i = 0; i < num; i++)
+	{
+		if (0 != processed[i] || SUCCEED != errcodes[i] || ZBX_AGENT_ITEM_ASYNC(&items[i]))
+			continue;
+
+		for (indexes_num = 0, j = i; j < num; j++)
+		{
+			if (0 != processed[j] || SUCCEED != errcodes[j] || ZBX_AGENT_ITEM_ASYNC(&items[j]) ||
+					items[j].interface.interfaceid != items[i].interface.interfaceid)
+			{
+				continue;
+			}
+
+			indexes[indexes_num++] = j;
+			processed[j] = 1;
+		}
+
+		agent_get_interface_values(items, results, errcodes, indexes, indexes_num);
+	}
+
+	zbx_free(processed);
+	zbx_free(indexes);
+#ifdef HAVE_LIBEVENT
+	for (i = 0; i < num; i++)
+		zbx_free(requests[i].buf);
+
+	zbx_free(requests);
+#endif
+#undef ZBX_AGENT_ITEM_ASYNC
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
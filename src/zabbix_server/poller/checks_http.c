@@ -206,28 +206,59 @@ static void	http_output_json(unsigned char retrieve_mode, char **buffer, zbx_htt
 	zbx_json_free(&json);
 }
 
-int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
+typedef struct
 {
 	CURL			*easyhandle;
-	CURLcode		err;
-	char			url[ITEM_URL_LEN_MAX], errbuf[CURL_ERROR_SIZE], *error = NULL, *headers, *line, *buffer;
-	int			ret = NOTSUPPORTED, timeout_seconds, found = FAIL;
-	long			response_code;
-	struct curl_slist	*headers_slist = NULL;
-	struct zbx_json		json;
-	zbx_http_response_t	body = {0}, header = {0};
-	size_t			(*curl_body_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
-	char			application_json[] = {"Content-Type: application/json"};
-	char			application_xml[] = {"Content-Type: application/xml"};
+	struct curl_slist	*headers_slist;
+	zbx_http_response_t	body;
+	zbx_http_response_t	header;
+	char			errbuf[CURL_ERROR_SIZE];
+}
+zbx_http_context_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: http_context_clean                                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	http_context_clean(zbx_http_context_t *context)
+{
+	curl_slist_free_all(context->headers_slist);	/* must be called after curl_easy_perform() */
+	curl_easy_cleanup(context->easyhandle);
+	zbx_free(context->body.data);
+	zbx_free(context->header.data);
+}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() request method '%s' URL '%s%s' headers '%s' message body '%s'",
-			__func__, zbx_request_string(item->request_method), item->url, item->query_fields,
-			item->headers, item->posts);
+/******************************************************************************
+ *                                                                            *
+ * Function: http_request_prepare                                             *
+ *                                                                            *
+ * Purpose: create and configure cURL easy handle for HTTP agent item         *
+ *                                                                            *
+ * Parameters: item    - [IN] the HTTP agent item                             *
+ *             context - [OUT] the request context, must be cleaned with      *
+ *                             http_context_clean() regardless of result      *
+ *             result  - [OUT] the error message on failure                   *
+ *                                                                            *
+ * Return value: SUCCEED - the request is ready to be performed               *
+ *               NOTSUPPORTED - otherwise                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	http_request_prepare(const DC_ITEM *item, zbx_http_context_t *context, AGENT_RESULT *result)
+{
+	CURLcode	err;
+	char		url[ITEM_URL_LEN_MAX], *error = NULL, *headers, *line;
+	int		timeout_seconds, found = FAIL;
+	size_t		(*curl_body_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
+	char		application_json[] = {"Content-Type: application/json"};
+	char		application_xml[] = {"Content-Type: application/xml"};
+
+	memset(context, 0, sizeof(zbx_http_context_t));
 
-	if (NULL == (easyhandle = curl_easy_init()))
+	if (NULL == (context->easyhandle = curl_easy_init()))
 	{
 		SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot initialize cURL library"));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	switch (item->retrieve_mode)
@@ -242,97 +273,97 @@ int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
 		default:
 			THIS_SHOULD_NEVER_HAPPEN;
 			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Invalid retrieve mode"));
-			goto clean;
+			return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HEADERFUNCTION, curl_write_cb)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_HEADERFUNCTION, curl_write_cb)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set header function: %s",
 				curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HEADERDATA, &header)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_HEADERDATA, &context->header)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set header callback: %s",
 				curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_WRITEFUNCTION, curl_body_cb)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_WRITEFUNCTION, curl_body_cb)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set write function: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_WRITEDATA, &body)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_WRITEDATA, &context->body)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set write callback: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_ERRORBUFFER, errbuf)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_ERRORBUFFER, context->errbuf)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set error buffer: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROXY, item->http_proxy)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_PROXY, item->http_proxy)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set proxy: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_FOLLOWLOCATION,
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_FOLLOWLOCATION,
 			0 == item->follow_redirects ? 0L : 1L)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set follow redirects: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	if (0 != item->follow_redirects &&
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_MAXREDIRS, ZBX_CURLOPT_MAXREDIRS)))
+			CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_MAXREDIRS, ZBX_CURLOPT_MAXREDIRS)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set number of redirects allowed: %s",
 				curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	if (FAIL == is_time_suffix(item->timeout, &timeout_seconds, strlen(item->timeout)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Invalid timeout: %s", item->timeout));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_TIMEOUT, (long)timeout_seconds)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_TIMEOUT, (long)timeout_seconds)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot specify timeout: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (SUCCEED != zbx_http_prepare_ssl(easyhandle, item->ssl_cert_file, item->ssl_key_file, item->ssl_key_password,
-			item->verify_peer, item->verify_host, &error))
+	if (SUCCEED != zbx_http_prepare_ssl(context->easyhandle, item->ssl_cert_file, item->ssl_key_file,
+			item->ssl_key_password, item->verify_peer, item->verify_host, &error))
 	{
 		SET_MSG_RESULT(result, error);
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (SUCCEED != zbx_http_prepare_auth(easyhandle, item->authtype, item->username, item->password, &error))
+	if (SUCCEED != zbx_http_prepare_auth(context->easyhandle, item->authtype, item->username, item->password, &error))
 	{
 		SET_MSG_RESULT(result, error);
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (SUCCEED != http_prepare_request(easyhandle, item->posts, item->request_method, &error))
+	if (SUCCEED != http_prepare_request(context->easyhandle, item->posts, item->request_method, &error))
 	{
 		SET_MSG_RESULT(result, error);
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	headers = item->headers;
 	while (NULL != (line = zbx_http_get_header(&headers)))
 	{
-		headers_slist = curl_slist_append(headers_slist, line);
+		context->headers_slist = curl_slist_append(context->headers_slist, line);
 
 		if (FAIL == found && 0 == strncmp(line, "Content-Type:", ZBX_CONST_STRLEN("Content-Type:")))
 			found = SUCCEED;
@@ -343,99 +374,122 @@ int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
 	if (FAIL == found)
 	{
 		if (ZBX_POSTTYPE_JSON == item->post_type)
-			headers_slist = curl_slist_append(headers_slist, application_json);
+			context->headers_slist = curl_slist_append(context->headers_slist, application_json);
 		else if (ZBX_POSTTYPE_XML == item->post_type)
-			headers_slist = curl_slist_append(headers_slist, application_xml);
+			context->headers_slist = curl_slist_append(context->headers_slist, application_xml);
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HTTPHEADER, headers_slist)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_HTTPHEADER, context->headers_slist)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot specify headers: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 #if LIBCURL_VERSION_NUM >= 0x071304
 	/* CURLOPT_PROTOCOLS is supported starting with version 7.19.4 (0x071304) */
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set allowed protocols: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 #endif
 
 	zbx_snprintf(url, sizeof(url),"%s%s", item->url, item->query_fields);
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_URL, url)))
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_URL, url)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot specify URL: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	*errbuf = '\0';
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: http_request_finish                                              *
+ *                                                                            *
+ * Purpose: set HTTP agent item result from the performed request             *
+ *                                                                            *
+ * Parameters: item    - [IN] the HTTP agent item                             *
+ *             context - [IN] the request context                             *
+ *             err     - [IN] the result of performing the request            *
+ *             result  - [OUT] the item value or error message                *
+ *                                                                            *
+ * Return value: SUCCEED - the value was retrieved successfully               *
+ *               NOTSUPPORTED - otherwise                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	http_request_finish(const DC_ITEM *item, zbx_http_context_t *context, CURLcode err,
+		AGENT_RESULT *result)
+{
+	char		*headers, *line, *buffer;
+	long		response_code;
+	struct zbx_json	json;
 
-	if (CURLE_OK != (err = curl_easy_perform(easyhandle)))
+	if (CURLE_OK != err)
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot perform request: %s",
-				'\0' == *errbuf ? curl_easy_strerror(err) : errbuf));
-		goto clean;
+				'\0' == *context->errbuf ? curl_easy_strerror(err) : context->errbuf));
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_RESPONSE_CODE, &response_code)))
+	if (CURLE_OK != (err = curl_easy_getinfo(context->easyhandle, CURLINFO_RESPONSE_CODE, &response_code)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot get the response code: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	if ('\0' != *item->status_codes && FAIL == int_in_list(item->status_codes, response_code))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Response code \"%ld\" did not match any of the"
 				" required status codes \"%s\"", response_code, item->status_codes));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (NULL == header.data)
+	if (NULL == context->header.data)
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned empty header"));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	switch (item->retrieve_mode)
 	{
 		case ZBX_RETRIEVE_MODE_CONTENT:
-			if (NULL == body.data)
+			if (NULL == context->body.data)
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned empty content"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
-			if (FAIL == zbx_is_utf8(body.data))
+			if (FAIL == zbx_is_utf8(context->body.data))
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned invalid UTF-8 sequence"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
 			if (HTTP_STORE_JSON == item->output_format)
 			{
-				http_output_json(item->retrieve_mode, &buffer, &header, &body);
+				http_output_json(item->retrieve_mode, &buffer, &context->header, &context->body);
 				SET_TEXT_RESULT(result, buffer);
 			}
 			else
 			{
-				SET_TEXT_RESULT(result, body.data);
-				body.data = NULL;
+				SET_TEXT_RESULT(result, context->body.data);
+				context->body.data = NULL;
 			}
 			break;
 		case ZBX_RETRIEVE_MODE_HEADERS:
-			if (FAIL == zbx_is_utf8(header.data))
+			if (FAIL == zbx_is_utf8(context->header.data))
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned invalid UTF-8 sequence"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
 			if (HTTP_STORE_JSON == item->output_format)
 			{
 				zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
 				zbx_json_addobject(&json, "header");
-				headers = header.data;
+				headers = context->header.data;
 				while (NULL != (line = zbx_http_get_header(&headers)))
 				{
 					http_add_json_header(&json, line);
@@ -446,40 +500,185 @@ int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
 			}
 			else
 			{
-				SET_TEXT_RESULT(result, header.data);
-				header.data = NULL;
+				SET_TEXT_RESULT(result, context->header.data);
+				context->header.data = NULL;
 			}
 			break;
 		case ZBX_RETRIEVE_MODE_BOTH:
-			if (FAIL == zbx_is_utf8(header.data) || (NULL != body.data && FAIL == zbx_is_utf8(body.data)))
+			if (FAIL == zbx_is_utf8(context->header.data) || (NULL != context->body.data &&
+					FAIL == zbx_is_utf8(context->body.data)))
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned invalid UTF-8 sequence"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
 			if (HTTP_STORE_JSON == item->output_format)
 			{
-				http_output_json(item->retrieve_mode, &buffer, &header, &body);
+				http_output_json(item->retrieve_mode, &buffer, &context->header, &context->body);
 				SET_TEXT_RESULT(result, buffer);
 			}
 			else
 			{
-				zbx_strncpy_alloc(&header.data, &header.allocated, &header.offset,
-						body.data, body.offset);
-				SET_TEXT_RESULT(result, header.data);
-				header.data = NULL;
+				zbx_strncpy_alloc(&context->header.data, &context->header.allocated, &context->header.offset,
+						context->body.data, context->body.offset);
+				SET_TEXT_RESULT(result, context->header.data);
+				context->header.data = NULL;
 			}
 			break;
 	}
 
-	ret = SUCCEED;
-clean:
-	curl_slist_free_all(headers_slist);	/* must be called after curl_easy_perform() */
-	curl_easy_cleanup(easyhandle);
-	zbx_free(body.data);
-	zbx_free(header.data);
+	return SUCCEED;
+}
+
+int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
+{
+	zbx_http_context_t	context;
+	int			ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() request method '%s' URL '%s%s' headers '%s' message body '%s'",
+			__func__, zbx_request_string(item->request_method), item->url, item->query_fields,
+			item->headers, item->posts);
+
+	if (SUCCEED == (ret = http_request_prepare(item, &context, result)))
+		ret = http_request_finish(item, &context, curl_easy_perform(context.easyhandle), result);
+
+	http_context_clean(&context);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_values_http                                                  *
+ *                                                                            *
+ * Purpose: retrieve values of multiple HTTP agent items concurrently         *
+ *                                                                            *
+ * Parameters: items    - [IN] the HTTP agent items                           *
+ *             results  - [OUT] the item values or error messages             *
+ *             errcodes - [IN/OUT] the item error codes, only items with      *
+ *                                 SUCCEED error code are requested           *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ * Comments: The requests are performed by the cURL multi handle that is kept *
+ *           for the lifetime of the process, so connections and resolved     *
+ *           host names are reused by the following requests.                 *
+ *                                                                            *
+ ******************************************************************************/
+void	get_values_http(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+/* curl_multi_wait() is supported starting with version 7.28.0 (0x071c00) */
+#if LIBCURL_VERSION_NUM >= 0x071c00
+	static CURLM		*multihandle = NULL;
+	zbx_http_context_t	*contexts;
+	CURLMcode		code;
+	CURLMsg			*msg;
+	int			i, running, fds, msgnum;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __func__, num);
+
+	if (NULL == multihandle && NULL == (multihandle = curl_multi_init()))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot initialize cURL multi handle, performing requests sequentially");
+		goto sequential;
+	}
+
+	contexts = (zbx_http_context_t *)zbx_malloc(NULL, sizeof(zbx_http_context_t) * (size_t)num);
+
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+		{
+			memset(&contexts[i], 0, sizeof(zbx_http_context_t));
+			continue;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() request method '%s' URL '%s%s' headers '%s' message body '%s'",
+				__func__, zbx_request_string(items[i].request_method), items[i].url,
+				items[i].query_fields, items[i].headers, items[i].posts);
+
+		if (SUCCEED != (errcodes[i] = http_request_prepare(&items[i], &contexts[i], &results[i])))
+		{
+			http_context_clean(&contexts[i]);
+			memset(&contexts[i], 0, sizeof(zbx_http_context_t));
+			continue;
+		}
+
+		if (CURLE_OK != curl_easy_setopt(contexts[i].easyhandle, CURLOPT_PRIVATE, &contexts[i]) ||
+				CURLM_OK != (code = curl_multi_add_handle(multihandle, contexts[i].easyhandle)))
+		{
+			/* perform the request without multi handle */
+			errcodes[i] = http_request_finish(&items[i], &contexts[i],
+					curl_easy_perform(contexts[i].easyhandle), &results[i]);
+			http_context_clean(&contexts[i]);
+			memset(&contexts[i], 0, sizeof(zbx_http_context_t));
+		}
+	}
+
+	while (1)
+	{
+		if (CURLM_OK != (code = curl_multi_perform(multihandle, &running)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot perform on cURL multi handle: %s",
+					curl_multi_strerror(code));
+			break;
+		}
+
+		while (NULL != (msg = curl_multi_info_read(multihandle, &msgnum)))
+		{
+			zbx_http_context_t	*context;
+
+			if (CURLMSG_DONE != msg->msg)
+				continue;
+
+			curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&context);
+			i = (int)(context - contexts);
+
+			errcodes[i] = http_request_finish(&items[i], context, msg->data.result, &results[i]);
+
+			curl_multi_remove_handle(multihandle, msg->easy_handle);
+			http_context_clean(context);
+			memset(context, 0, sizeof(zbx_http_context_t));
+		}
+
+		if (0 == running)
+			break;
+
+		if (CURLM_OK != (code = curl_multi_wait(multihandle, NULL, 0, SEC_PER_MIN * 1000, &fds)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot wait on cURL multi handle: %s",
+					curl_multi_strerror(code));
+			break;
+		}
+	}
+
+	for (i = 0; i < num; i++)	/* requests left unfinished because of multi handle failure */
+	{
+		if (SUCCEED != errcodes[i] || NULL == contexts[i].easyhandle)
+			continue;
+
+		curl_multi_remove_handle(multihandle, contexts[i].easyhandle);
+		SET_MSG_RESULT(&results[i], zbx_strdup(NULL, "Cannot perform request: request was interrupted"));
+		errcodes[i] = NOTSUPPORTED;
+		http_context_clean(&contexts[i]);
+	}
+
+	zbx_free(contexts);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return;
+sequential:
+#endif
+	{
+		int	j;
+
+		for (j = 0; j < num; j++)
+		{
+			if (SUCCEED == errcodes[j])
+				errcodes[j] = get_value_http(&items[j], &results[j]);
+		}
+	}
+}
 #endif
@@ -2045,7 +2045,15 @@ int	get_value_snmp(const DC_ITEM *item, AGENT_RESULT *result, unsigned char poll
 	return errcode;
 }
 
-void	get_values_snmp(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num, unsigned char poller_type)
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_get_interface_values                                    *
+ *                                                                            *
+ * Purpose: retrieve values of SNMP items of the same interface               *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_get_interface_values(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num,
+		unsigned char poller_type)
 {
 	struct snmp_session	*ss;
 	char			error[MAX_STRING_LEN];
@@ -2115,6 +2123,402 @@ out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/* SNMP GET request of standard items of one interface sent without waiting for response */
+typedef struct
+{
+	const DC_ITEM		*items;
+	AGENT_RESULT		*results;
+	int			*errcodes;
+	int			num;
+	struct snmp_session	*ss;
+	struct snmp_pdu		*response;
+	int			status;
+	oid			(*parsed_oids)[MAX_OID_LEN];
+	size_t			*parsed_oid_lens;
+	int			*mapping;
+	int			mapping_num;
+}
+zbx_snmp_async_request_t;
+
+#define ZBX_SNMP_ASYNC_PENDING	-1
+
+/* the limit of sessions opened at once, keeping their descriptors within select() descriptor set */
+#define ZBX_SNMP_ASYNC_MAX_SESSIONS	(FD_SETSIZE / 2)
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_async_response_cb                                       *
+ *                                                                            *
+ * Purpose: Net-SNMP callback storing response of asynchronous request        *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_snmp_async_response_cb(int operation, struct snmp_session *ss, int reqid, struct snmp_pdu *pdu,
+		void *magic)
+{
+	zbx_snmp_async_request_t	*request = (zbx_snmp_async_request_t *)magic;
+
+	ZBX_UNUSED(ss);
+	ZBX_UNUSED(reqid);
+
+	if (NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE != operation)
+		request->status = STAT_TIMEOUT;
+	else if (NULL != (request->response = snmp_clone_pdu(pdu)))
+		request->status = STAT_SUCCESS;
+	else
+		request->status = STAT_ERROR;
+
+	return 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_async_request_free                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_async_request_free(zbx_snmp_async_request_t *request)
+{
+	if (NULL != request->response)
+		snmp_free_pdu(request->response);
+
+	if (NULL != request->ss)
+		zbx_snmp_close_session(request->ss);
+
+	zbx_free(request->parsed_oids);
+	zbx_free(request->parsed_oid_lens);
+	zbx_free(request->mapping);
+	zbx_free(request);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_async_request_send                                      *
+ *                                                                            *
+ * Purpose: send GET request for standard SNMP items of one interface         *
+ *                                                                            *
+ * Return value: the sent request or NULL if there was nothing to send, in    *
+ *               which case the item results are already set                  *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_snmp_async_request_t	*zbx_snmp_async_request_send(const DC_ITEM *items, AGENT_RESULT *results,
+		int *errcodes, int num, unsigned char poller_type)
+{
+	zbx_snmp_async_request_t	*request;
+	struct snmp_pdu			*pdu;
+	char				error[MAX_STRING_LEN], oid_translated[ITEM_SNMP_OID_LEN_MAX];
+	int				i, j, err;
+
+	for (j = 0; j < num; j++)	/* locate first supported item to use as a reference */
+	{
+		if (SUCCEED == errcodes[j])
+			break;
+	}
+
+	if (j == num)
+		return NULL;
+
+	request = (zbx_snmp_async_request_t *)zbx_calloc(NULL, 1, sizeof(zbx_snmp_async_request_t));
+	request->items = items;
+	request->results = results;
+	request->errcodes = errcodes;
+	request->num = num;
+	request->status = ZBX_SNMP_ASYNC_PENDING;
+	request->parsed_oids = (oid (*)[MAX_OID_LEN])zbx_malloc(NULL, sizeof(*request->parsed_oids) * (size_t)num);
+	request->parsed_oid_lens = (size_t *)zbx_malloc(NULL, sizeof(size_t) * (size_t)num);
+	request->mapping = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
+
+	if (NULL == (request->ss = zbx_snmp_open_session(&items[j], error, sizeof(error))))
+	{
+		err = NETWORK_ERROR;
+		goto fail;
+	}
+
+	if (NULL == (pdu = snmp_pdu_create(SNMP_MSG_GET)))
+	{
+		zbx_strlcpy(error, "snmp_pdu_create(): cannot create PDU object.", sizeof(error));
+		err = CONFIG_ERROR;
+		goto fail;
+	}
+
+	for (i = j; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+			continue;
+
+		if (0 != num_key_param(items[i].snmp_oid))
+		{
+			SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL, "OID \"%s\" contains unsupported parameters.",
+					items[i].snmp_oid));
+			errcodes[i] = CONFIG_ERROR;
+			continue;
+		}
+
+		zbx_snmp_translate(oid_translated, items[i].snmp_oid, sizeof(oid_translated));
+		request->parsed_oid_lens[i] = MAX_OID_LEN;
+
+		if (NULL == snmp_parse_oid(oid_translated, request->parsed_oids[i], &request->parsed_oid_lens[i]))
+		{
+			SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL, "snmp_parse_oid(): cannot parse OID \"%s\".",
+					oid_translated));
+			errcodes[i] = CONFIG_ERROR;
+			continue;
+		}
+
+		if (NULL == snmp_add_null_var(pdu, request->parsed_oids[i], request->parsed_oid_lens[i]))
+		{
+			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, "snmp_add_null_var(): cannot add null variable."));
+			errcodes[i] = CONFIG_ERROR;
+			continue;
+		}
+
+		request->mapping[request->mapping_num++] = i;
+	}
+
+	if (0 == request->mapping_num)
+	{
+		snmp_free_pdu(pdu);
+		zbx_snmp_async_request_free(request);
+		return NULL;
+	}
+
+	request->ss->retries = (1 == request->mapping_num && ZBX_POLLER_TYPE_UNREACHABLE != poller_type ? 1 : 0);
+
+	if (0 == snmp_async_send(request->ss, pdu, zbx_snmp_async_response_cb, request))
+	{
+		snmp_free_pdu(pdu);
+		request->status = STAT_ERROR;
+	}
+
+	return request;
+fail:
+	for (i = j; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+			continue;
+
+		SET_MSG_RESULT(&results[i], zbx_strdup(NULL, error));
+		errcodes[i] = err;
+	}
+
+	zbx_snmp_async_request_free(request);
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_async_request_process                                   *
+ *                                                                            *
+ * Purpose: set item results from the response of asynchronous request        *
+ *                                                                            *
+ * Comments: Responses that require retrying with fixed or smaller requests   *
+ *           are processed by requesting the interface items again with the   *
+ *           synchronous zbx_snmp_get_interface_values().                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_async_request_process(zbx_snmp_async_request_t *request, unsigned char poller_type)
+{
+	struct snmp_pdu		*response = request->response;
+	struct variable_list	*var;
+	char			error[MAX_STRING_LEN];
+	int			i, j, err;
+
+	if (STAT_SUCCESS == request->status && SNMP_ERR_NOERROR == response->errstat)
+	{
+		for (i = 0, var = response->variables; i < request->mapping_num && NULL != var;
+				i++, var = var->next_variable)
+		{
+			j = request->mapping[i];
+
+			if (request->parsed_oid_lens[j] != var->name_length || 0 != memcmp(request->parsed_oids[j],
+					var->name, request->parsed_oid_lens[j] * sizeof(oid)))
+			{
+				break;
+			}
+		}
+
+		if (i == request->mapping_num && NULL == var)
+		{
+			for (i = 0, var = response->variables; i < request->mapping_num; i++, var = var->next_variable)
+			{
+				j = request->mapping[i];
+				request->errcodes[j] = zbx_snmp_set_result(var, &request->results[j]);
+			}
+
+			DCconfig_update_interface_snmp_stats(request->items[0].interface.interfaceid,
+					request->mapping_num, MAX_SNMP_ITEMS + 1);
+			return;
+		}
+	}
+	else if (1 == request->mapping_num && (STAT_TIMEOUT == request->status ||
+			(STAT_SUCCESS == request->status && SNMP_ERR_NOSUCHNAME != response->errstat)))
+	{
+		/* the result of single variable request would be the same if it was repeated */
+		err = zbx_get_snmp_response_error(request->ss, &request->items[0].interface, request->status,
+				response, error, sizeof(error));
+
+		j = request->mapping[0];
+		SET_MSG_RESULT(&request->results[j], zbx_strdup(NULL, error));
+		request->errcodes[j] = err;
+		return;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() host:'%s' status:%d, repeating request synchronously", __func__,
+			request->items[0].host.host, request->status);
+
+	snmp_free_pdu(request->response);
+	request->response = NULL;
+	zbx_snmp_close_session(request->ss);
+	request->ss = NULL;
+
+	zbx_snmp_get_interface_values(request->items, request->results, request->errcodes, request->num,
+			poller_type);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_async_wait_responses                                    *
+ *                                                                            *
+ * Purpose: wait until all sent asynchronous requests are answered or timed   *
+ *          out                                                               *
+ *                                                                            *
+ * Parameters: requests - [IN] the sent requests                              *
+ *                                                                            *
+ * Comments: Requests left pending because of failure are marked as failed.   *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_async_wait_responses(zbx_vector_ptr_t *requests)
+{
+	zbx_snmp_async_request_t	*request;
+	int				i, pending;
+
+	while (1)
+	{
+		int		fds = 0, block = 1;
+		fd_set		fdset;
+		struct timeval	timeout;
+
+		for (i = 0, pending = 0; i < requests->values_num; i++)
+		{
+			if (ZBX_SNMP_ASYNC_PENDING == ((zbx_snmp_async_request_t *)requests->values[i])->status)
+				pending++;
+		}
+
+		if (0 == pending)
+			break;
+
+		FD_ZERO(&fdset);
+		snmp_select_info(&fds, &fdset, &timeout, &block);
+
+		if (FD_SETSIZE < fds)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot wait for SNMP responses: descriptor %d exceeds the limit"
+					" of %d", fds - 1, FD_SETSIZE - 1);
+			break;
+		}
+
+		if (0 > (fds = select(fds, &fdset, NULL, NULL, 0 == block ? &timeout : NULL)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			zabbix_log(LOG_LEVEL_WARNING, "cannot wait for SNMP responses: %s", zbx_strerror(errno));
+			break;
+		}
+
+		if (0 < fds)
+			snmp_read(&fdset);
+		else
+			snmp_timeout();
+	}
+
+	for (i = 0; i < requests->values_num; i++)
+	{
+		request = (zbx_snmp_async_request_t *)requests->values[i];
+
+		if (ZBX_SNMP_ASYNC_PENDING == request->status)
+			request->status = STAT_ERROR;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_get_values_async                                        *
+ *                                                                            *
+ * Purpose: retrieve values of standard SNMP items of multiple interfaces     *
+ *          with requests to all interfaces sent at once                      *
+ *                                                                            *
+ * Comments: The items of the same interface must be adjacent.                *
+ *           At most ZBX_SNMP_ASYNC_MAX_SESSIONS interfaces are requested at  *
+ *           once, the rest are requested after the responses are processed   *
+ *           and the sessions are closed.                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_get_values_async(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num,
+		unsigned char poller_type)
+{
+	zbx_vector_ptr_t		requests;
+	zbx_snmp_async_request_t	*request;
+	int				i, start = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __func__, num);
+
+	zbx_vector_ptr_create(&requests);
+
+	while (start < num)
+	{
+		for (; start < num && ZBX_SNMP_ASYNC_MAX_SESSIONS > requests.values_num; start = i)
+		{
+			for (i = start + 1; i < num && items[i].interface.interfaceid ==
+					items[start].interface.interfaceid; i++)
+				;
+
+			if (NULL != (request = zbx_snmp_async_request_send(items + start, results + start,
+					errcodes + start, i - start, poller_type)))
+			{
+				zbx_vector_ptr_append(&requests, request);
+			}
+		}
+
+		zbx_snmp_async_wait_responses(&requests);
+
+		for (i = 0; i < requests.values_num; i++)
+		{
+			request = (zbx_snmp_async_request_t *)requests.values[i];
+
+			zbx_snmp_async_request_process(request, poller_type);
+			zbx_snmp_async_request_free(request);
+		}
+
+		zbx_vector_ptr_clear(&requests);
+	}
+
+	zbx_vector_ptr_destroy(&requests);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+#undef ZBX_SNMP_ASYNC_MAX_SESSIONS
+#undef ZBX_SNMP_ASYNC_PENDING
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_values_snmp                                                  *
+ *                                                                            *
+ * Purpose: retrieve values of SNMP items                                     *
+ *                                                                            *
+ * Comments: Items of several interfaces are passed by pollers only for       *
+ *           standard SNMP items, see DCconfig_get_poller_items(). Such items *
+ *           are requested from all interfaces concurrently.                  *
+ *                                                                            *
+ ******************************************************************************/
+void	get_values_snmp(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num, unsigned char poller_type)
+{
+	if (1 < num && items[0].interface.interfaceid != items[num - 1].interface.interfaceid)
+		zbx_snmp_get_values_async(items, results, errcodes, num, poller_type);
+	else
+		zbx_snmp_get_interface_values(items, results, errcodes, num, poller_type);
+}
+
 void	zbx_init_snmp(void)
 {
 	sigset_t	mask, orig_mask;
@@ -736,6 +736,18 @@ void	zbx_check_items(DC_ITEM *items, int *errcodes, int num, AGENT_RESULT *resul
 		get_values_java(ZBX_JAVA_GATEWAY_REQUEST_JMX, items, results, errcodes, num);
 		zbx_alarm_off();
 	}
+	else if (ITEM_TYPE_ZABBIX == items[0].type && 1 < num)
+	{
+		/* passive agent checks use their own timeouts */
+		get_values_agent(items, results, errcodes, num);
+	}
+#ifdef HAVE_LIBCURL
+	else if (ITEM_TYPE_HTTPAGENT == items[0].type && 1 < num)
+	{
+		/* HTTP agent checks use their own timeouts */
+		get_values_http(items, results, errcodes, num);
+	}
+#endif
 	else if (1 == num)
 	{
 		if (SUCCEED == errcodes[0])
@@ -812,18 +824,22 @@ void	zbx_clean_items(DC_ITEM *items, int num, AGENT_RESULT *results)
  *                                                                            *
  * Author: Alexei Vladishev                                                   *
  *                                                                            *
- * Comments: processes single item at a time except for Java, SNMP items,     *
- *           see DCconfig_get_poller_items()                                  *
+ * Comments: processes single item at a time except for Java, SNMP, HTTP      *
+ *           agent and unencrypted Zabbix agent items, see                    *
+ *           DCconfig_get_poller_items()                                      *
  *                                                                            *
  ******************************************************************************/
 static int	get_values(unsigned char poller_type, int *nextcheck)
 {
-	DC_ITEM			items[MAX_POLLER_ITEMS];
-	AGENT_RESULT		results[MAX_POLLER_ITEMS];
-	int			errcodes[MAX_POLLER_ITEMS];
-	zbx_timespec_t		timespec;
-	int			i, num, last_available = HOST_AVAILABLE_UNKNOWN;
-	zbx_vector_ptr_t	add_results;
+	DC_ITEM				items[MAX_POLLER_ITEMS];
+	AGENT_RESULT			results[MAX_POLLER_ITEMS];
+	int				errcodes[MAX_POLLER_ITEMS];
+	zbx_timespec_t			timespec;
+	int				i, num, index;
+	zbx_uint64_t			*last_available;
+	zbx_uint64_pair_t		pair;
+	zbx_vector_uint64_pair_t	hosts_available;
+	zbx_vector_ptr_t		add_results;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -836,6 +852,7 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 	}
 
 	zbx_vector_ptr_create(&add_results);
+	zbx_vector_uint64_pair_create(&hosts_available);
 
 	zbx_prepare_items(items, errcodes, num, results, MACRO_EXPAND_YES);
 	zbx_check_items(items, errcodes, num, results, &add_results, poller_type);
@@ -845,24 +862,37 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 	/* process item values */
 	for (i = 0; i < num; i++)
 	{
+		/* item batches can contain interleaved items of different hosts */
+		pair.first = items[i].host.hostid;
+
+		if (FAIL == (index = zbx_vector_uint64_pair_search(&hosts_available, pair,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+		{
+			pair.second = HOST_AVAILABLE_UNKNOWN;
+			zbx_vector_uint64_pair_append(&hosts_available, pair);
+			index = hosts_available.values_num - 1;
+		}
+
+		last_available = &hosts_available.values[index].second;
+
 		switch (errcodes[i])
 		{
 			case SUCCEED:
 			case NOTSUPPORTED:
 			case AGENT_ERROR:
-				if (HOST_AVAILABLE_TRUE != last_available)
+				if (HOST_AVAILABLE_TRUE != *last_available)
 				{
 					zbx_activate_item_host(&items[i], &timespec);
-					last_available = HOST_AVAILABLE_TRUE;
+					*last_available = HOST_AVAILABLE_TRUE;
 				}
 				break;
 			case NETWORK_ERROR:
 			case GATEWAY_ERROR:
 			case TIMEOUT_ERROR:
-				if (HOST_AVAILABLE_FALSE != last_available)
+				if (HOST_AVAILABLE_FALSE != *last_available)
 				{
 					zbx_deactivate_item_host(&items[i], &timespec, results[i].msg);
-					last_available = HOST_AVAILABLE_FALSE;
+					*last_available = HOST_AVAILABLE_FALSE;
 				}
 				break;
 			case CONFIG_ERROR:
@@ -932,6 +962,7 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 	DCconfig_clean_items(items, NULL, num);
 	zbx_vector_ptr_clear_ext(&add_results, (zbx_mem_free_func_t)zbx_free_result_ptr);
 	zbx_vector_ptr_destroy(&add_results);
+	zbx_vector_uint64_pair_destroy(&hosts_available);
 exit:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, num);
 
@@ -164,6 +164,8 @@ int		server_num		= 0;
 
 int	CONFIG_ALERTER_FORKS		= 3;
 int	CONFIG_DISCOVERER_FORKS		= 1;
+int	CONFIG_DISCOVERER_CONCURRENCY	= 32;
+int	CONFIG_DISCOVERER_RATE_LIMIT	= 0;
 int	CONFIG_HOUSEKEEPER_FORKS	= 1;
 int	CONFIG_PINGER_FORKS		= 1;
 int	CONFIG_POLLER_FORKS		= 5;
@@ -172,6 +174,7 @@ int	CONFIG_HTTPPOLLER_FORKS		= 1;
 int	CONFIG_IPMIPOLLER_FORKS		= 0;
 int	CONFIG_TIMER_FORKS		= 1;
 int	CONFIG_TRAPPER_FORKS		= 5;
+int	CONFIG_TRAPPER_CONCURRENCY	= 1;
 int	CONFIG_SNMPTRAPPER_FORKS	= 0;
 int	CONFIG_JAVAPOLLER_FORKS		= 0;
 int	CONFIG_ESCALATOR_FORKS		= 1;
@@ -200,6 +203,8 @@ int	CONFIG_HOUSEKEEPING_FREQUENCY	= 1;
 int	CONFIG_MAX_HOUSEKEEPER_DELETE	= 5000;		/* applies for every separate field value */
 int	CONFIG_HISTSYNCER_FORKS		= 4;
 int	CONFIG_HISTSYNCER_FREQUENCY	= 1;
+int	CONFIG_TRENDS_UPSERT		= 0;
+int	CONFIG_TRENDS_FLUSH_SPREAD	= 0;
 int	CONFIG_CONFSYNCER_FORKS		= 1;
 int	CONFIG_CONFSYNCER_FREQUENCY	= 60;
 
@@ -219,6 +224,7 @@ zbx_uint64_t	CONFIG_EXPORT_FILE_SIZE		= ZBX_GIBIBYTE;
 int	CONFIG_UNREACHABLE_PERIOD	= 45;
 int	CONFIG_UNREACHABLE_DELAY	= 15;
 int	CONFIG_UNAVAILABLE_DELAY	= 60;
+int	CONFIG_AGENT_PERSISTENT		= 0;
 int	CONFIG_LOG_LEVEL		= LOG_LEVEL_WARNING;
 char	*CONFIG_ALERT_SCRIPTS_PATH	= NULL;
 char	*CONFIG_EXTERNALSCRIPTS		= NULL;
@@ -244,6 +250,7 @@ int	CONFIG_LOG_REMOTE_COMMANDS	= 0;
 int	CONFIG_UNSAFE_USER_PARAMETERS	= 0;
 
 char	*CONFIG_SNMPTRAP_FILE		= NULL;
+char	*CONFIG_SNMPTRAP_LISTEN		= NULL;
 
 char	*CONFIG_JAVA_GATEWAY		= NULL;
 int	CONFIG_JAVA_GATEWAY_PORT	= ZBX_DEFAULT_GATEWAY_PORT;
@@ -578,6 +585,9 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 #if !defined(HAVE_IPV6)
 	err |= (FAIL == check_cfg_feature_str("Fping6Location", CONFIG_FPING6_LOCATION, "IPv6 support"));
 #endif
+#if !defined(HAVE_NETSNMP)
+	err |= (FAIL == check_cfg_feature_str("SNMPTrapperListen", CONFIG_SNMPTRAP_LISTEN, "SNMP support"));
+#endif
 #if !defined(HAVE_LIBCURL)
 	err |= (FAIL == check_cfg_feature_str("SSLCALocation", CONFIG_SSL_CA_LOCATION, "cURL library"));
 	err |= (FAIL == check_cfg_feature_str("SSLCertLocation", CONFIG_SSL_CERT_LOCATION, "cURL library"));
@@ -588,6 +598,10 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 			"cURL library"));
 #endif
 
+#if !defined(HAVE_POSTGRESQL) && !defined(HAVE_MYSQL)
+	err |= (FAIL == check_cfg_feature_int("TrendUpsert", CONFIG_TRENDS_UPSERT, "PostgreSQL or MySQL support"));
+#endif
+
 #if !defined(HAVE_LIBXML2) || !defined(HAVE_LIBCURL)
 	err |= (FAIL == check_cfg_feature_int("StartVMwareCollectors", CONFIG_VMWARE_FORKS, "VMware support"));
 
@@ -649,6 +663,10 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	1,			100},
 		{"StartDiscoverers",		&CONFIG_DISCOVERER_FORKS,		TYPE_INT,
 			PARM_OPT,	0,			250},
+		{"DiscovererConcurrency",	&CONFIG_DISCOVERER_CONCURRENCY,		TYPE_INT,
+			PARM_OPT,	1,			1000},
+		{"DiscovererRateLimit",		&CONFIG_DISCOVERER_RATE_LIMIT,		TYPE_INT,
+			PARM_OPT,	0,			100000},
 		{"StartHTTPPollers",		&CONFIG_HTTPPOLLER_FORKS,		TYPE_INT,
 			PARM_OPT,	0,			1000},
 		{"StartPingers",		&CONFIG_PINGER_FORKS,			TYPE_INT,
@@ -663,6 +681,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	1,			1000},
 		{"StartTrappers",		&CONFIG_TRAPPER_FORKS,			TYPE_INT,
 			PARM_OPT,	0,			1000},
+		{"TrapperConcurrency",		&CONFIG_TRAPPER_CONCURRENCY,		TYPE_INT,
+			PARM_OPT,	1,			1000},
 		{"StartJavaPollers",		&CONFIG_JAVAPOLLER_FORKS,		TYPE_INT,
 			PARM_OPT,	0,			1000},
 		{"StartEscalators",		&CONFIG_ESCALATOR_FORKS,		TYPE_INT,
@@ -673,6 +693,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	1024,			32767},
 		{"SNMPTrapperFile",		&CONFIG_SNMPTRAP_FILE,			TYPE_STRING,
 			PARM_OPT,	0,			0},
+		{"SNMPTrapperListen",		&CONFIG_SNMPTRAP_LISTEN,		TYPE_STRING,
+			PARM_OPT,	0,			0},
 		{"StartSNMPTrapper",		&CONFIG_SNMPTRAPPER_FORKS,		TYPE_INT,
 			PARM_OPT,	0,			1},
 		{"CacheSize",			&CONFIG_CONF_CACHE_SIZE,		TYPE_UINT64,
@@ -683,6 +705,10 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"TrendCacheSize",		&CONFIG_TRENDS_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"TrendUpsert",			&CONFIG_TRENDS_UPSERT,			TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"TrendFlushSpread",		&CONFIG_TRENDS_FLUSH_SPREAD,		TYPE_INT,
+			PARM_OPT,	0,			3300},
 		{"ValueCacheSize",		&CONFIG_VALUE_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	0,			__UINT64_C(64) * ZBX_GIBIBYTE},
 		{"CacheUpdateFrequency",	&CONFIG_CONFSYNCER_FREQUENCY,		TYPE_INT,
@@ -701,6 +727,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	1,			30},
 		{"TrapperTimeout",		&CONFIG_TRAPPER_TIMEOUT,		TYPE_INT,
 			PARM_OPT,	1,			300},
+		{"AgentPersistentConnections",	&CONFIG_AGENT_PERSISTENT,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"UnreachablePeriod",		&CONFIG_UNREACHABLE_PERIOD,		TYPE_INT,
 			PARM_OPT,	1,			SEC_PER_HOUR},
 		{"UnreachableDelay",		&CONFIG_UNREACHABLE_DELAY,		TYPE_INT,
@@ -1178,7 +1206,9 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 
 	if (0 != CONFIG_TRAPPER_FORKS)
 	{
-		if (FAIL == zbx_tcp_listen(&listen_sock, CONFIG_LISTEN_IP, (unsigned short)CONFIG_LISTEN_PORT))
+		/* with concurrent trappers each trapper listens on its own socket bound to the same port */
+		if (FAIL == zbx_tcp_listen_ext(&listen_sock, CONFIG_LISTEN_IP, (unsigned short)CONFIG_LISTEN_PORT,
+				1 < CONFIG_TRAPPER_CONCURRENCY ? ZBX_TCP_LISTEN_REUSEPORT : 0))
 		{
 			zabbix_log(LOG_LEVEL_CRIT, "listener failed: %s", zbx_socket_strerror());
 			exit(EXIT_FAILURE);
@@ -28,6 +28,30 @@
 #include "zbxregexp.h"
 #include "preproc.h"
 
+#ifdef HAVE_NETSNMP
+#	define SNMP_NO_DEBUGGING		/* disabling debugging messages from Net-SNMP library */
+#	include <net-snmp/net-snmp-config.h>
+#	include <net-snmp/net-snmp-includes.h>
+#	include "../poller/checks_snmp.h"
+#endif
+
+#define ZBX_SNMPTRAP_ITEM_NONE		0
+#define ZBX_SNMPTRAP_ITEM_MATCH		1
+#define ZBX_SNMPTRAP_ITEM_FALLBACK	2
+
+/* maximum number of received traps processed at once */
+#define ZBX_SNMPTRAP_BATCH_MAX		1000
+
+typedef struct
+{
+	char		*addr;
+	char		*trap;
+	zbx_timespec_t	ts;
+	int		index;		/* position in the batch, keeps the order of traps from the same address */
+	unsigned char	matched;
+}
+zbx_snmp_trap_t;
+
 static int	trap_fd = -1;
 static off_t	trap_lastsize;
 static ino_t	trap_ino = 0;
@@ -35,6 +59,12 @@ static char	*buffer = NULL;
 static int	offset = 0;
 static int	force = 0;
 
+static zbx_vector_ptr_t	traps;
+
+#ifdef HAVE_NETSNMP
+static netsnmp_transport	*trap_transport = NULL;
+#endif
+
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 
@@ -69,28 +99,93 @@ static void	DBupdate_lastsize(void)
 
 /******************************************************************************
  *                                                                            *
- * Function: process_trap_for_interface                                       *
+ * Function: snmp_trap_free                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmp_trap_free(zbx_snmp_trap_t *trap)
+{
+	zbx_free(trap->addr);
+	zbx_free(trap->trap);
+	zbx_free(trap);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: snmp_trap_compare                                                *
+ *                                                                            *
+ * Purpose: sort traps by address, keeping the order of traps received from   *
+ *          the same address                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_trap_compare(const void *d1, const void *d2)
+{
+	const zbx_snmp_trap_t	*t1 = *(const zbx_snmp_trap_t * const *)d1;
+	const zbx_snmp_trap_t	*t2 = *(const zbx_snmp_trap_t * const *)d2;
+	int			ret;
+
+	if (0 != (ret = strcmp(t1->addr, t2->addr)))
+		return ret;
+
+	ZBX_RETURN_IF_NOT_EQUAL(t1->index, t2->index);
+
+	return 0;
+}
+
+/******************************************************************************
  *                                                                            *
- * Purpose: add trap to all matching items for the specified interface        *
+ * Function: snmp_trap_add_value                                              *
  *                                                                            *
- * Return value: SUCCEED - a matching item was found                          *
- *               FAIL - no matching item was found (including fallback items) *
+ * Purpose: pass trap to preprocessing as value of the specified item         *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmp_trap_add_value(DC_ITEM *item, zbx_snmp_trap_t *trap)
+{
+	AGENT_RESULT	result;
+	int		value_type;
+
+	init_result(&result);
+
+	value_type = (ITEM_VALUE_TYPE_LOG == item->value_type ? ITEM_VALUE_TYPE_LOG : ITEM_VALUE_TYPE_TEXT);
+	set_result_type(&result, value_type, trap->trap);
+
+	if (ITEM_VALUE_TYPE_LOG == item->value_type)
+		calc_timestamp(result.log->value, &result.log->timestamp, item->logtimefmt);
+
+	item->state = ITEM_STATE_NORMAL;
+	zbx_preprocess_item_value(item->itemid, item->value_type, item->flags, &result, &trap->ts, item->state, NULL);
+
+	free_result(&result);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: process_traps_for_interface                                      *
+ *                                                                            *
+ * Purpose: add traps to all matching items for the specified interface       *
+ *                                                                            *
+ * Parameters: interfaceid - [IN] the interface                               *
+ *             batch       - [IN/OUT] the traps received for the interface    *
+ *                                    address, matched traps are marked       *
+ *             batch_num   - [IN] the number of traps                         *
+ *                                                                            *
+ * Comments: Items of the interface are retrieved and their keys are parsed   *
+ *           once for all traps of the batch.                                 *
  *                                                                            *
  * Author: Rudolfs Kreicbergs                                                 *
  *                                                                            *
  ******************************************************************************/
-static int	process_trap_for_interface(zbx_uint64_t interfaceid, char *trap, zbx_timespec_t *ts)
+static void	process_traps_for_interface(zbx_uint64_t interfaceid, zbx_snmp_trap_t **batch, int batch_num)
 {
 	DC_ITEM			*items = NULL;
 	const char		*regex;
-	char			error[ITEM_ERROR_LEN_MAX];
+	char			error[ITEM_ERROR_LEN_MAX], **regexes = NULL, **errors = NULL;
 	size_t			num, i;
-	int			ret = FAIL, fb = -1, *lastclocks = NULL, *errcodes = NULL, value_type, regexp_ret;
+	int			j, matched, fb = -1, *lastclocks = NULL, *errcodes = NULL, regexp_ret;
 	zbx_uint64_t		*itemids = NULL;
-	unsigned char		*states = NULL;
-	AGENT_RESULT		*results = NULL;
+	unsigned char		*states = NULL, *types = NULL;
 	AGENT_REQUEST		request;
 	zbx_vector_ptr_t	regexps;
+	zbx_snmp_trap_t		*trap;
 
 	zbx_vector_ptr_create(&regexps);
 
@@ -100,18 +195,22 @@ static int	process_trap_for_interface(zbx_uint64_t interfaceid, char *trap, zbx_
 	states = (unsigned char *)zbx_malloc(states, sizeof(unsigned char) * num);
 	lastclocks = (int *)zbx_malloc(lastclocks, sizeof(int) * num);
 	errcodes = (int *)zbx_malloc(errcodes, sizeof(int) * num);
-	results = (AGENT_RESULT *)zbx_malloc(results, sizeof(AGENT_RESULT) * num);
+	types = (unsigned char *)zbx_malloc(types, sizeof(unsigned char) * num);
+	regexes = (char **)zbx_malloc(regexes, sizeof(char *) * num);
+	errors = (char **)zbx_malloc(errors, sizeof(char *) * num);
 
 	for (i = 0; i < num; i++)
 	{
-		init_result(&results[i]);
 		errcodes[i] = FAIL;
+		types[i] = ZBX_SNMPTRAP_ITEM_NONE;
+		regexes[i] = NULL;
+		errors[i] = NULL;
 
 		items[i].key = zbx_strdup(items[i].key, items[i].key_orig);
 		if (SUCCEED != substitute_key_macros(&items[i].key, NULL, &items[i], NULL, NULL,
 				MACRO_TYPE_ITEM_KEY, error, sizeof(error)))
 		{
-			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, error));
+			errors[i] = zbx_strdup(NULL, error);
 			errcodes[i] = NOTSUPPORTED;
 			continue;
 		}
@@ -141,81 +240,96 @@ static int	process_trap_for_interface(zbx_uint64_t interfaceid, char *trap, zbx_
 
 				if (0 == regexps.values_num)
 				{
-					SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL,
-							"Global regular expression \"%s\" does not exist.", regex + 1));
+					errors[i] = zbx_dsprintf(NULL, "Global regular expression \"%s\" does not exist.",
+							regex + 1);
 					errcodes[i] = NOTSUPPORTED;
 					goto next;
 				}
 			}
 
-			if (ZBX_REGEXP_NO_MATCH == (regexp_ret = regexp_match_ex(&regexps, trap, regex,
-					ZBX_CASE_SENSITIVE)))
-			{
-				goto next;
-			}
-			else if (FAIL == regexp_ret)
-			{
-				SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL,
-						"Invalid regular expression \"%s\".", regex));
-				errcodes[i] = NOTSUPPORTED;
-				goto next;
-			}
+			regexes[i] = zbx_strdup(NULL, regex);
 		}
 
-		value_type = (ITEM_VALUE_TYPE_LOG == items[i].value_type ? ITEM_VALUE_TYPE_LOG : ITEM_VALUE_TYPE_TEXT);
-		set_result_type(&results[i], value_type, trap);
-		errcodes[i] = SUCCEED;
-		ret = SUCCEED;
+		types[i] = ZBX_SNMPTRAP_ITEM_MATCH;
 next:
 		free_request(&request);
 	}
 
-	if (FAIL == ret && -1 != fb)
+	for (j = 0; j < batch_num; j++)
 	{
-		value_type = (ITEM_VALUE_TYPE_LOG == items[fb].value_type ? ITEM_VALUE_TYPE_LOG : ITEM_VALUE_TYPE_TEXT);
-		set_result_type(&results[fb], value_type, trap);
-		errcodes[fb] = SUCCEED;
-		ret = SUCCEED;
+		trap = batch[j];
+		matched = FAIL;
+
+		for (i = 0; i < num; i++)
+		{
+			if (ZBX_SNMPTRAP_ITEM_MATCH != types[i])
+				continue;
+
+			if (NULL != regexes[i])
+			{
+				if (ZBX_REGEXP_NO_MATCH == (regexp_ret = regexp_match_ex(&regexps, trap->trap, regexes[i],
+						ZBX_CASE_SENSITIVE)))
+				{
+					continue;
+				}
+				else if (FAIL == regexp_ret)
+				{
+					errors[i] = zbx_dsprintf(NULL, "Invalid regular expression \"%s\".", regexes[i]);
+					errcodes[i] = NOTSUPPORTED;
+					types[i] = ZBX_SNMPTRAP_ITEM_NONE;
+					continue;
+				}
+			}
+
+			snmp_trap_add_value(&items[i], trap);
+			errcodes[i] = SUCCEED;
+			lastclocks[i] = trap->ts.sec;
+			matched = SUCCEED;
+		}
+
+		if (FAIL == matched && -1 != fb)
+		{
+			snmp_trap_add_value(&items[fb], trap);
+			errcodes[fb] = SUCCEED;
+			lastclocks[fb] = trap->ts.sec;
+			matched = SUCCEED;
+		}
+
+		if (SUCCEED == matched)
+			trap->matched = 1;
 	}
 
+	trap = batch[batch_num - 1];
+
 	for (i = 0; i < num; i++)
 	{
 		switch (errcodes[i])
 		{
 			case SUCCEED:
-				if (ITEM_VALUE_TYPE_LOG == items[i].value_type)
-				{
-					calc_timestamp(results[i].log->value, &results[i].log->timestamp,
-							items[i].logtimefmt);
-				}
-
-				items[i].state = ITEM_STATE_NORMAL;
-				zbx_preprocess_item_value(items[i].itemid, items[i].value_type, items[i].flags,
-						&results[i], ts, items[i].state, NULL);
-
 				itemids[i] = items[i].itemid;
 				states[i] = items[i].state;
-				lastclocks[i] = ts->sec;
 				break;
 			case NOTSUPPORTED:
 				items[i].state = ITEM_STATE_NOTSUPPORTED;
 				zbx_preprocess_item_value(items[i].itemid, items[i].value_type, items[i].flags, NULL,
-						ts, items[i].state, results[i].msg);
+						&trap->ts, items[i].state, errors[i]);
 
 				itemids[i] = items[i].itemid;
 				states[i] = items[i].state;
-				lastclocks[i] = ts->sec;
+				lastclocks[i] = trap->ts.sec;
 				break;
 		}
 
 		zbx_free(items[i].key);
-		free_result(&results[i]);
+		zbx_free(regexes[i]);
+		zbx_free(errors[i]);
 	}
 
-	zbx_free(results);
-
 	DCrequeue_items(itemids, states, lastclocks, errcodes, num);
 
+	zbx_free(errors);
+	zbx_free(regexes);
+	zbx_free(types);
 	zbx_free(errcodes);
 	zbx_free(lastclocks);
 	zbx_free(states);
@@ -226,64 +340,106 @@ next:
 
 	zbx_regexp_clean_expressions(&regexps);
 	zbx_vector_ptr_destroy(&regexps);
-
-	zbx_preprocessor_flush();
-
-	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: process_trap                                                     *
+ * Function: process_traps                                                    *
  *                                                                            *
- * Purpose: process a single trap                                             *
+ * Purpose: process the collected traps                                       *
  *                                                                            *
- * Parameters: addr - [IN] address of the target interface(s)                 *
- *             begin - [IN] beginning of the trap message                     *
- *             end - [IN] end of the trap message                             *
- *                                                                            *
- * Author: Rudolfs Kreicbergs                                                 *
+ * Comments: Traps are grouped by address, so that interfaces of an address   *
+ *           are looked up once for all its traps.                            *
  *                                                                            *
  ******************************************************************************/
-static void	process_trap(const char *addr, char *begin, char *end)
+static void	process_traps(void)
 {
-	zbx_timespec_t	ts;
 	zbx_uint64_t	*interfaceids = NULL;
-	int		count, i, ret = FAIL;
-	char		*trap = NULL;
+	int		count, i, j, k;
+	zbx_snmp_trap_t	*trap;
+	zbx_config_t	cfg;
 
-	zbx_timespec(&ts);
-	trap = zbx_dsprintf(trap, "%s%s", begin, end);
+	if (0 == traps.values_num)
+		return;
 
-	count = DCconfig_get_snmp_interfaceids_by_addr(addr, &interfaceids);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() traps:%d", __func__, traps.values_num);
 
-	for (i = 0; i < count; i++)
+	zbx_vector_ptr_sort(&traps, snmp_trap_compare);
+
+	for (i = 0; i < traps.values_num; i = j)
 	{
-		if (SUCCEED == process_trap_for_interface(interfaceids[i], trap, &ts))
-			ret = SUCCEED;
+		trap = (zbx_snmp_trap_t *)traps.values[i];
+
+		for (j = i + 1; j < traps.values_num; j++)
+		{
+			if (0 != strcmp(trap->addr, ((zbx_snmp_trap_t *)traps.values[j])->addr))
+				break;
+		}
+
+		count = DCconfig_get_snmp_interfaceids_by_addr(trap->addr, &interfaceids);
+
+		for (k = 0; k < count; k++)
+			process_traps_for_interface(interfaceids[k], (zbx_snmp_trap_t **)traps.values + i, j - i);
+
+		zbx_free(interfaceids);
 	}
 
-	if (FAIL == ret)
-	{
-		zbx_config_t	cfg;
+	zbx_preprocessor_flush();
 
-		zbx_config_get(&cfg, ZBX_CONFIG_FLAGS_SNMPTRAP_LOGGING);
+	zbx_config_get(&cfg, ZBX_CONFIG_FLAGS_SNMPTRAP_LOGGING);
 
-		if (ZBX_SNMPTRAP_LOGGING_ENABLED == cfg.snmptrap_logging)
-			zabbix_log(LOG_LEVEL_WARNING, "unmatched trap received from \"%s\": %s", addr, trap);
+	if (ZBX_SNMPTRAP_LOGGING_ENABLED == cfg.snmptrap_logging)
+	{
+		for (i = 0; i < traps.values_num; i++)
+		{
+			trap = (zbx_snmp_trap_t *)traps.values[i];
 
-		zbx_config_clean(&cfg);
+			if (0 == trap->matched)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "unmatched trap received from \"%s\": %s", trap->addr,
+						trap->trap);
+			}
+		}
 	}
 
-	zbx_free(interfaceids);
-	zbx_free(trap);
+	zbx_config_clean(&cfg);
+
+	zbx_vector_ptr_clear_ext(&traps, (zbx_clean_func_t)snmp_trap_free);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: queue_trap                                                       *
+ *                                                                            *
+ * Purpose: add a single trap to the traps being processed                    *
+ *                                                                            *
+ * Parameters: addr - [IN] address of the target interface(s)                 *
+ *             text - [IN] the trap message, freed with the trap              *
+ *                                                                            *
+ * Author: Rudolfs Kreicbergs                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	queue_trap(const char *addr, char *text)
+{
+	zbx_snmp_trap_t	*trap;
+
+	trap = (zbx_snmp_trap_t *)zbx_malloc(NULL, sizeof(zbx_snmp_trap_t));
+	zbx_timespec(&trap->ts);
+	trap->addr = zbx_strdup(NULL, addr);
+	trap->trap = text;
+	trap->index = traps.values_num;
+	trap->matched = 0;
+
+	zbx_vector_ptr_append(&traps, trap);
 }
 
 /******************************************************************************
  *                                                                            *
  * Function: parse_traps                                                      *
  *                                                                            *
- * Purpose: split traps and process them with process_trap()                  *
+ * Purpose: split traps and process them with process_traps()                 *
  *                                                                            *
  * Author: Rudolfs Kreicbergs                                                 *
  *                                                                            *
@@ -324,7 +480,7 @@ static void	parse_traps(int flag)
 			*pzdate = '\0';
 			*pzaddr = '\0';
 
-			process_trap(addr, begin, end);
+			queue_trap(addr, zbx_dsprintf(NULL, "%s%s", begin, end));
 			end = NULL;
 		}
 
@@ -376,7 +532,7 @@ static void	parse_traps(int flag)
 			*pzdate = '\0';
 			*pzaddr = '\0';
 
-			process_trap(addr, begin, end);
+			queue_trap(addr, zbx_dsprintf(NULL, "%s%s", begin, end));
 			offset = 0;
 			*buffer = '\0';
 		}
@@ -387,6 +543,8 @@ static void	parse_traps(int flag)
 			*buffer = '\0';
 		}
 	}
+
+	process_traps();
 }
 
 /******************************************************************************
@@ -609,6 +767,305 @@ static int	get_latest_data(void)
 	return SUCCEED;
 }
 
+#ifdef HAVE_NETSNMP
+/******************************************************************************
+ *                                                                            *
+ * Function: snmp_trap_add_octets                                             *
+ *                                                                            *
+ * Purpose: add PDU information field with octet string value, non            *
+ *          printable strings are added in hexadecimal form as                *
+ *          zabbix_trap_receiver.pl does                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmp_trap_add_octets(char **text, size_t *text_alloc, size_t *text_offset, const char *name,
+		const u_char *data, size_t len)
+{
+	size_t	i;
+
+	for (i = 0; i < len; i++)
+	{
+		if (0 == isprint(data[i]))
+			break;
+	}
+
+	zbx_snprintf_alloc(text, text_alloc, text_offset, "  %-30s ", name);
+
+	if (i == len)
+	{
+		zbx_strncpy_alloc(text, text_alloc, text_offset, (const char *)data, len);
+	}
+	else
+	{
+		zbx_strcpy_alloc(text, text_alloc, text_offset, "0x");
+
+		for (i = 0; i < len; i++)
+			zbx_snprintf_alloc(text, text_alloc, text_offset, "%02x", (unsigned int)data[i]);
+	}
+
+	zbx_chrcpy_alloc(text, text_alloc, text_offset, '\n');
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: snmp_trap_format                                                 *
+ *                                                                            *
+ * Purpose: format received trap the same way as zabbix_trap_receiver.pl      *
+ *          writes it to SNMP trapper file, so that snmptrap[] items match    *
+ *          traps regardless of the way they are received                     *
+ *                                                                            *
+ * Parameters: pdu          - [IN] the received PDU                           *
+ *             receivedfrom - [IN] the transport address of the sender        *
+ *                                                                            *
+ * Return value: the trap text                                                *
+ *                                                                            *
+ ******************************************************************************/
+static char	*snmp_trap_format(const netsnmp_pdu *pdu, const char *receivedfrom)
+{
+	char			*text = NULL, buffer[MAX_STRING_LEN], date[32];
+	size_t			text_alloc = 0, text_offset = 0;
+	time_t			now;
+	netsnmp_variable_list	*var;
+
+	now = time(NULL);
+	strftime(date, sizeof(date), "%H:%M:%S %Y/%m/%d", localtime(&now));
+
+	zbx_snprintf_alloc(&text, &text_alloc, &text_offset, "%s PDU INFO:\n", date);
+	zbx_snprintf_alloc(&text, &text_alloc, &text_offset, "  %-30s %s\n", "notificationtype",
+			SNMP_MSG_INFORM == pdu->command ? "INFORM" : "TRAP");
+	zbx_snprintf_alloc(&text, &text_alloc, &text_offset, "  %-30s %ld\n", "version", pdu->version);
+	zbx_snprintf_alloc(&text, &text_alloc, &text_offset, "  %-30s %s\n", "receivedfrom", receivedfrom);
+	zbx_snprintf_alloc(&text, &text_alloc, &text_offset, "  %-30s %ld\n", "requestid", pdu->reqid);
+	zbx_snprintf_alloc(&text, &text_alloc, &text_offset, "  %-30s %ld\n", "messageid", pdu->msgid);
+
+	if (SNMP_VERSION_3 == pdu->version)
+	{
+		snmp_trap_add_octets(&text, &text_alloc, &text_offset, "securityname",
+				(const u_char *)pdu->securityName, pdu->securityNameLen);
+		snmp_trap_add_octets(&text, &text_alloc, &text_offset, "contextname",
+				(const u_char *)pdu->contextName, pdu->contextNameLen);
+		zbx_snprintf_alloc(&text, &text_alloc, &text_offset, "  %-30s %d\n", "securitylevel",
+				pdu->securityLevel);
+	}
+	else
+	{
+		snmp_trap_add_octets(&text, &text_alloc, &text_offset, "community", pdu->community,
+				pdu->community_len);
+	}
+
+	if (SNMP_MSG_TRAP == pdu->command)
+	{
+		snprint_objid(buffer, sizeof(buffer), pdu->enterprise, pdu->enterprise_length);
+		zbx_snprintf_alloc(&text, &text_alloc, &text_offset, "  %-30s %s\n", "enterprise", buffer);
+		zbx_snprintf_alloc(&text, &text_alloc, &text_offset, "  %-30s %u.%u.%u.%u\n", "agentaddress",
+				(unsigned int)pdu->agent_addr[0], (unsigned int)pdu->agent_addr[1],
+				(unsigned int)pdu->agent_addr[2], (unsigned int)pdu->agent_addr[3]);
+		zbx_snprintf_alloc(&text, &text_alloc, &text_offset, "  %-30s %ld\n", "generictrap", pdu->trap_type);
+		zbx_snprintf_alloc(&text, &text_alloc, &text_offset, "  %-30s %ld\n", "specifictrap",
+				pdu->specific_type);
+		zbx_snprintf_alloc(&text, &text_alloc, &text_offset, "  %-30s %lu\n", "uptime",
+				(unsigned long)pdu->time);
+	}
+
+	zbx_strcpy_alloc(&text, &text_alloc, &text_offset, "VARBINDS:");
+
+	for (var = pdu->variables; NULL != var; var = var->next_variable)
+	{
+		char	value[MAX_BUFFER_LEN];
+
+		snprint_objid(buffer, sizeof(buffer), var->name, var->name_length);
+		snprint_value(value, sizeof(value), var->name, var->name_length, var);
+
+		zbx_snprintf_alloc(&text, &text_alloc, &text_offset, "\n  %-30s type=%-2d value=%s", buffer,
+				(int)var->type, value);
+	}
+
+	return text;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: snmp_trap_callback                                               *
+ *                                                                            *
+ * Purpose: Net-SNMP callback for received messages, queues traps and         *
+ *          acknowledges informs                                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_trap_callback(int op, netsnmp_session *session, int reqid, netsnmp_pdu *pdu, void *magic)
+{
+	char	*receivedfrom = NULL, *addr = NULL, *ptr;
+
+	ZBX_UNUSED(reqid);
+	ZBX_UNUSED(magic);
+
+	if (NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE != op)
+		return 1;
+
+	switch (pdu->command)
+	{
+		case SNMP_MSG_TRAP:
+		case SNMP_MSG_TRAP2:
+			break;
+		case SNMP_MSG_INFORM:
+		{
+			netsnmp_pdu	*reply;
+
+			if (NULL != (reply = snmp_clone_pdu(pdu)))
+			{
+				reply->command = SNMP_MSG_RESPONSE;
+				reply->errstat = 0;
+				reply->errindex = 0;
+
+				if (0 == snmp_send(session, reply))
+				{
+					zabbix_log(LOG_LEVEL_DEBUG, "cannot acknowledge SNMP inform: %s",
+							snmp_api_errstring(session->s_snmp_errno));
+					snmp_free_pdu(reply);
+				}
+			}
+			break;
+		}
+		default:
+			return 1;
+	}
+
+	if (NULL != trap_transport->f_fmtaddr)
+	{
+		/* format: "UDP: [127.0.0.1]:41070->[127.0.0.1]:162" */
+		if (NULL != (ptr = trap_transport->f_fmtaddr(trap_transport, pdu->transport_data,
+				pdu->transport_data_length)))
+		{
+			receivedfrom = zbx_strdup(NULL, ptr);
+			free(ptr);
+		}
+	}
+
+	if (NULL != receivedfrom && NULL != (ptr = strchr(receivedfrom, '[')))
+	{
+		addr = zbx_strdup(NULL, ptr + 1);
+
+		if (NULL != (ptr = strchr(addr, ']')))
+			*ptr = '\0';
+	}
+
+	queue_trap(NULL != addr ? addr : "unknown", snmp_trap_format(pdu,
+			NULL != receivedfrom ? receivedfrom : "unknown"));
+
+	zbx_free(addr);
+	zbx_free(receivedfrom);
+
+	return 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: snmp_trap_listen                                                 *
+ *                                                                            *
+ * Purpose: open Net-SNMP session receiving traps on SNMPTrapperListen        *
+ *          address                                                           *
+ *                                                                            *
+ * Return value: SUCCEED - the session was opened                             *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_trap_listen(void)
+{
+	netsnmp_session	session;
+
+	zbx_init_snmp();
+
+	if (NULL == (trap_transport = netsnmp_tdomain_transport(CONFIG_SNMPTRAP_LISTEN, 1, "udp")))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot listen for SNMP traps on \"%s\": %s", CONFIG_SNMPTRAP_LISTEN,
+				zbx_strerror(errno));
+		return FAIL;
+	}
+
+	/* the descriptor must fit in select() descriptor set, see receive_traps() */
+	if (FD_SETSIZE <= trap_transport->sock)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot listen for SNMP traps on \"%s\": descriptor %d exceeds the limit"
+				" of %d", CONFIG_SNMPTRAP_LISTEN, trap_transport->sock, FD_SETSIZE - 1);
+		netsnmp_transport_free(trap_transport);
+		trap_transport = NULL;
+		return FAIL;
+	}
+
+	snmp_sess_init(&session);
+	session.peername = SNMP_DEFAULT_PEERNAME;
+	session.version = SNMP_DEFAULT_VERSION;
+	session.community_len = SNMP_DEFAULT_COMMUNITY_LEN;
+	session.retries = SNMP_DEFAULT_RETRIES;
+	session.timeout = SNMP_DEFAULT_TIMEOUT;
+	session.callback = snmp_trap_callback;
+	session.isAuthoritative = SNMP_SESS_UNKNOWNAUTH;
+
+	if (NULL == snmp_add(&session, trap_transport, NULL, NULL))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot open SNMP trap session on \"%s\": %s", CONFIG_SNMPTRAP_LISTEN,
+				snmp_api_errstring(snmp_errno));
+		trap_transport = NULL;
+		return FAIL;
+	}
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "receiving SNMP traps on \"%s\"", CONFIG_SNMPTRAP_LISTEN);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: receive_traps                                                    *
+ *                                                                            *
+ * Purpose: receive traps until there are no more pending datagrams or the    *
+ *          batch is full                                                     *
+ *                                                                            *
+ * Comments: Waits up to 1 second for the first trap.                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	receive_traps(void)
+{
+	fd_set		fdset;
+	struct timeval	timeout;
+	int		numfds, block, ret;
+
+	do
+	{
+		numfds = 0;
+		block = 0;
+		FD_ZERO(&fdset);
+		timeout.tv_sec = (0 == traps.values_num ? 1 : 0);
+		timeout.tv_usec = 0;
+
+		snmp_select_info(&numfds, &fdset, &timeout, &block);
+
+		if (FD_SETSIZE < numfds)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot wait for SNMP traps: descriptor %d exceeds the limit of %d",
+					numfds - 1, FD_SETSIZE - 1);
+			zbx_sleep_loop(1);
+			break;
+		}
+
+		if (-1 == (ret = select(numfds, &fdset, NULL, NULL, &timeout)))
+		{
+			if (EINTR != errno)
+				zabbix_log(LOG_LEVEL_WARNING, "cannot wait for SNMP traps: %s", zbx_strerror(errno));
+
+			break;
+		}
+
+		if (0 == ret)
+		{
+			snmp_timeout();
+			break;
+		}
+
+		snmp_read(&fdset);
+	}
+	while (ZBX_SNMPTRAP_BATCH_MAX > traps.values_num && ZBX_IS_RUNNING());
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: main_snmptrapper_loop                                            *
@@ -629,10 +1086,41 @@ ZBX_THREAD_ENTRY(snmptrapper_thread, args)
 	zabbix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(program_type),
 			server_num, get_process_type_string(process_type), process_num);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() trapfile:'%s'", __func__, CONFIG_SNMPTRAP_FILE);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() trapfile:'%s' listen:'%s'", __func__, CONFIG_SNMPTRAP_FILE,
+			ZBX_NULL2EMPTY_STR(CONFIG_SNMPTRAP_LISTEN));
 
 	update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
 
+	zbx_vector_ptr_create(&traps);
+
+#ifdef HAVE_NETSNMP
+	if (NULL != CONFIG_SNMPTRAP_LISTEN)
+	{
+		int	traps_num;
+
+		if (SUCCEED != snmp_trap_listen())
+			exit(EXIT_FAILURE);
+
+		while (ZBX_IS_RUNNING())
+		{
+			update_selfmon_counter(ZBX_PROCESS_STATE_IDLE);
+			receive_traps();
+			update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+
+			sec = zbx_time();
+			zbx_update_env(sec);
+
+			traps_num = traps.values_num;
+			process_traps();
+			sec = zbx_time() - sec;
+
+			zbx_setproctitle("%s [processed %d traps in " ZBX_FS_DBL " sec, waiting for traps]",
+					get_process_type_string(process_type), traps_num, sec);
+		}
+
+		goto out;
+	}
+#endif
 	zbx_setproctitle("%s [connecting to the database]", get_process_type_string(process_type));
 
 	DBconnect(ZBX_DB_CONNECT_NORMAL);
@@ -663,6 +1151,11 @@ ZBX_THREAD_ENTRY(snmptrapper_thread, args)
 
 	if (-1 != trap_fd)
 		close(trap_fd);
+#ifdef HAVE_NETSNMP
+out:
+#endif
+	zbx_vector_ptr_clear_ext(&traps, (zbx_clean_func_t)snmp_trap_free);
+	zbx_vector_ptr_destroy(&traps);
 
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
 
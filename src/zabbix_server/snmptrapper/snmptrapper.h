@@ -23,6 +23,7 @@
 #include "threads.h"
 
 extern char		*CONFIG_SNMPTRAP_FILE;
+extern char		*CONFIG_SNMPTRAP_LISTEN;
 extern unsigned char	process_type;
 
 ZBX_THREAD_ENTRY(snmptrapper_thread, args);
@@ -29,6 +29,43 @@
 
 extern unsigned char	program_type;
 
+#define ZBX_ACTIVE_CHECKS_CACHE_TTL	SEC_PER_DAY
+
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	char		*key;
+	char		*key_orig;
+	char		*delay;
+	int		interval;
+}
+zbx_active_check_t;
+
+/* list of active checks prepared for a host at the specified configuration cache revision */
+typedef struct
+{
+	zbx_uint64_t		hostid;
+
+	/* the configuration cache revision the list was prepared at */
+	zbx_uint64_t		config_revision;
+
+	/* the list content hash */
+	zbx_uint64_t		revision;
+
+	/* zbx_active_check_t */
+	zbx_vector_ptr_t	checks;
+
+	/* zbx_expression_t */
+	zbx_vector_ptr_t	regexps;
+
+	int			lastaccess;
+}
+zbx_active_checks_t;
+
+static zbx_hashset_t	active_checks_cache;
+static int		active_checks_cache_init = 0;
+static int		active_checks_cache_purge_ts = 0;
+
 /******************************************************************************
  *                                                                            *
  * Function: db_register_host                                                 *
@@ -525,6 +562,386 @@ out:
 	free_request(&request);
 }
 
+static void	active_check_free(zbx_active_check_t *check)
+{
+	zbx_free(check->key);
+	zbx_free(check->key_orig);
+	zbx_free(check->delay);
+	zbx_free(check);
+}
+
+static void	active_checks_clear(zbx_active_checks_t *active_checks)
+{
+	zbx_vector_ptr_clear_ext(&active_checks->checks, (zbx_clean_func_t)active_check_free);
+	zbx_regexp_clean_expressions(&active_checks->regexps);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: active_checks_calculate_revision                                 *
+ *                                                                            *
+ * Purpose: calculate revision of the host active check list from its content *
+ *                                                                            *
+ * Parameters: active_checks - [IN/OUT] the host active check list            *
+ *                                                                            *
+ * Comments: Configuration sync does not change the revision unless the list  *
+ *           content has changed.                                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	active_checks_calculate_revision(zbx_active_checks_t *active_checks)
+{
+	md5_state_t	state;
+	md5_byte_t	hash[MD5_DIGEST_SIZE];
+	int		i;
+
+	zbx_md5_init(&state);
+
+	for (i = 0; i < active_checks->checks.values_num; i++)
+	{
+		zbx_active_check_t	*check = (zbx_active_check_t *)active_checks->checks.values[i];
+
+		zbx_md5_append(&state, (const md5_byte_t *)&check->itemid, sizeof(check->itemid));
+		zbx_md5_append(&state, (const md5_byte_t *)check->key, strlen(check->key) + 1);
+		zbx_md5_append(&state, (const md5_byte_t *)check->key_orig, strlen(check->key_orig) + 1);
+		zbx_md5_append(&state, (const md5_byte_t *)check->delay, strlen(check->delay) + 1);
+	}
+
+	for (i = 0; i < active_checks->regexps.values_num; i++)
+	{
+		zbx_expression_t	*regexp = (zbx_expression_t *)active_checks->regexps.values[i];
+
+		zbx_md5_append(&state, (const md5_byte_t *)regexp->name, strlen(regexp->name) + 1);
+		zbx_md5_append(&state, (const md5_byte_t *)regexp->expression, strlen(regexp->expression) + 1);
+		zbx_md5_append(&state, (const md5_byte_t *)&regexp->expression_type, sizeof(regexp->expression_type));
+		zbx_md5_append(&state, (const md5_byte_t *)&regexp->exp_delimiter, sizeof(regexp->exp_delimiter));
+		zbx_md5_append(&state, (const md5_byte_t *)&regexp->case_sensitive, sizeof(regexp->case_sensitive));
+	}
+
+	zbx_md5_finish(&state, hash);
+
+	memcpy(&active_checks->revision, hash, sizeof(active_checks->revision));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: active_checks_load                                               *
+ *                                                                            *
+ * Purpose: prepare active check list of the host from configuration cache    *
+ *                                                                            *
+ * Parameters: active_checks - [IN/OUT] the host active check list            *
+ *                                                                            *
+ ******************************************************************************/
+static void	active_checks_load(zbx_active_checks_t *active_checks)
+{
+	zbx_vector_uint64_t	itemids;
+	zbx_vector_str_t	names;
+	int			i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() hostid:" ZBX_FS_UI64, __func__, active_checks->hostid);
+
+	zbx_vector_uint64_create(&itemids);
+	zbx_vector_str_create(&names);
+
+	active_checks_clear(active_checks);
+
+	/* read the revision before the configuration, so changes synced meanwhile force another reload */
+	active_checks->config_revision = DCconfig_get_revision();
+
+	get_list_of_active_checks(active_checks->hostid, &itemids);
+
+	if (0 != itemids.values_num)
+	{
+		DC_ITEM			*dc_items;
+		int			*errcodes, delay;
+		zbx_active_check_t	*check;
+
+		zbx_vector_uint64_sort(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		dc_items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * itemids.values_num);
+		errcodes = (int *)zbx_malloc(NULL, sizeof(int) * itemids.values_num);
+
+		DCconfig_get_items_by_itemids(dc_items, itemids.values, errcodes, itemids.values_num);
+
+		for (i = 0; i < itemids.values_num; i++)
+		{
+			if (SUCCEED != errcodes[i])
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "%s() Item [" ZBX_FS_UI64 "] was not found in the"
+						" server cache. Not sending now.", __func__, itemids.values[i]);
+				continue;
+			}
+
+			if (ITEM_STATUS_ACTIVE != dc_items[i].status)
+				continue;
+
+			if (HOST_STATUS_MONITORED != dc_items[i].host.status)
+				continue;
+
+			if (SUCCEED != zbx_interval_preproc(dc_items[i].delay, &delay, NULL, NULL))
+				continue;
+
+			check = (zbx_active_check_t *)zbx_malloc(NULL, sizeof(zbx_active_check_t));
+			check->itemid = dc_items[i].itemid;
+			check->delay = zbx_strdup(NULL, dc_items[i].delay);
+			check->interval = delay;
+			check->key_orig = zbx_strdup(NULL, dc_items[i].key_orig);
+			check->key = zbx_strdup(NULL, dc_items[i].key_orig);
+			substitute_key_macros_unmasked(&check->key, NULL, &dc_items[i], NULL, NULL, MACRO_TYPE_ITEM_KEY,
+					NULL, 0);
+			zbx_vector_ptr_append(&active_checks->checks, check);
+
+			zbx_itemkey_extract_global_regexps(check->key, &names);
+		}
+
+		DCconfig_clean_items(dc_items, errcodes, itemids.values_num);
+
+		zbx_free(errcodes);
+		zbx_free(dc_items);
+	}
+
+	DCget_expressions_by_names(&active_checks->regexps, (const char * const *)names.values, names.values_num);
+
+	active_checks_calculate_revision(active_checks);
+
+	zbx_vector_str_clear_ext(&names, zbx_str_free);
+	zbx_vector_str_destroy(&names);
+	zbx_vector_uint64_destroy(&itemids);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() checks:%d revision:" ZBX_FS_UI64, __func__,
+			active_checks->checks.values_num, active_checks->revision);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: active_checks_get                                                *
+ *                                                                            *
+ * Purpose: get active check list of the host, preparing it only when         *
+ *          configuration sync has changed hosts, items or macros since the   *
+ *          last request                                                      *
+ *                                                                            *
+ * Parameters: hostid - [IN] the host identifier                              *
+ *                                                                            *
+ * Return value: the host active check list                                   *
+ *                                                                            *
+ * Comments: The lists are cached locally by each trapper process. Lists of   *
+ *           hosts that have not requested active checks for a day are        *
+ *           dropped.                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_active_checks_t	*active_checks_get(zbx_uint64_t hostid)
+{
+	zbx_active_checks_t	*active_checks, active_checks_local;
+	int			now;
+
+	now = time(NULL);
+
+	if (0 == active_checks_cache_init)
+	{
+		zbx_hashset_create(&active_checks_cache, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		active_checks_cache_purge_ts = now;
+		active_checks_cache_init = 1;
+	}
+
+	if (SEC_PER_HOUR <= now - active_checks_cache_purge_ts)
+	{
+		zbx_hashset_iter_t	iter;
+
+		zbx_hashset_iter_reset(&active_checks_cache, &iter);
+
+		while (NULL != (active_checks = (zbx_active_checks_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (ZBX_ACTIVE_CHECKS_CACHE_TTL > now - active_checks->lastaccess)
+				continue;
+
+			active_checks_clear(active_checks);
+			zbx_vector_ptr_destroy(&active_checks->checks);
+			zbx_vector_ptr_destroy(&active_checks->regexps);
+			zbx_hashset_iter_remove(&iter);
+		}
+
+		active_checks_cache_purge_ts = now;
+	}
+
+	if (NULL == (active_checks = (zbx_active_checks_t *)zbx_hashset_search(&active_checks_cache, &hostid)))
+	{
+		active_checks_local.hostid = hostid;
+		active_checks = (zbx_active_checks_t *)zbx_hashset_insert(&active_checks_cache, &active_checks_local,
+				sizeof(active_checks_local));
+
+		zbx_vector_ptr_create(&active_checks->checks);
+		zbx_vector_ptr_create(&active_checks->regexps);
+		active_checks_load(active_checks);
+	}
+	else if (active_checks->config_revision != DCconfig_get_revision())
+		active_checks_load(active_checks);
+
+	active_checks->lastaccess = now;
+
+	return active_checks;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: add_regexps_json                                                 *
+ *                                                                            *
+ * Purpose: add global regular expressions to active check list response      *
+ *                                                                            *
+ * Parameters: json    - [IN/OUT] the response                                *
+ *             regexps - [IN] the global regular expressions                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	add_regexps_json(struct zbx_json *json, const zbx_vector_ptr_t *regexps)
+{
+	char	buffer[32];
+	int	i;
+
+	if (0 == regexps->values_num)
+		return;
+
+	zbx_json_addarray(json, ZBX_PROTO_TAG_REGEXP);
+
+	for (i = 0; i < regexps->values_num; i++)
+	{
+		zbx_expression_t	*regexp = (zbx_expression_t *)regexps->values[i];
+
+		zbx_json_addobject(json, NULL);
+		zbx_json_addstring(json, "name", regexp->name, ZBX_JSON_TYPE_STRING);
+		zbx_json_addstring(json, "expression", regexp->expression, ZBX_JSON_TYPE_STRING);
+
+		zbx_snprintf(buffer, sizeof(buffer), "%d", regexp->expression_type);
+		zbx_json_addstring(json, "expression_type", buffer, ZBX_JSON_TYPE_INT);
+
+		zbx_snprintf(buffer, sizeof(buffer), "%c", regexp->exp_delimiter);
+		zbx_json_addstring(json, "exp_delimiter", buffer, ZBX_JSON_TYPE_STRING);
+
+		zbx_snprintf(buffer, sizeof(buffer), "%d", regexp->case_sensitive);
+		zbx_json_addstring(json, "case_sensitive", buffer, ZBX_JSON_TYPE_INT);
+
+		zbx_json_close(json);
+	}
+
+	zbx_json_close(json);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: active_checks_add_json                                           *
+ *                                                                            *
+ * Purpose: add cached active check list to the response                      *
+ *                                                                            *
+ * Parameters: json                - [IN/OUT] the response                    *
+ *             active_checks       - [IN] the host active check list          *
+ *             version             - [IN] the agent version                   *
+ *             refresh_unsupported - [IN] the not supported item refresh      *
+ *                                        interval                            *
+ *             revision            - [IN] the list revision known by agent    *
+ *                                                                            *
+ * Comments: The list is omitted if agent already has its current revision.   *
+ *           Log file positions and item states are not part of the cached    *
+ *           list and are read from configuration cache for every request.    *
+ *                                                                            *
+ ******************************************************************************/
+static void	active_checks_add_json(struct zbx_json *json, const zbx_active_checks_t *active_checks, int version,
+		int refresh_unsupported, zbx_uint64_t revision)
+{
+	zbx_uint64_t		*itemids, list_revision;
+	zbx_active_item_state_t	*states;
+	unsigned char		*skip;
+	int			i, now;
+	md5_state_t		state;
+	md5_byte_t		hash[MD5_DIGEST_SIZE];
+
+	itemids = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (active_checks->checks.values_num + 1));
+	states = (zbx_active_item_state_t *)zbx_malloc(NULL,
+			sizeof(zbx_active_item_state_t) * (active_checks->checks.values_num + 1));
+	skip = (unsigned char *)zbx_calloc(NULL, active_checks->checks.values_num + 1, sizeof(unsigned char));
+
+	for (i = 0; i < active_checks->checks.values_num; i++)
+		itemids[i] = ((zbx_active_check_t *)active_checks->checks.values[i])->itemid;
+
+	DCconfig_get_active_items_state(itemids, states, active_checks->checks.values_num);
+
+	zbx_md5_init(&state);
+	zbx_md5_append(&state, (const md5_byte_t *)&active_checks->revision, sizeof(active_checks->revision));
+	zbx_md5_append(&state, (const md5_byte_t *)&refresh_unsupported, sizeof(refresh_unsupported));
+	zbx_md5_append(&state, (const md5_byte_t *)&version, sizeof(version));
+
+	/* older agents receive not supported items only when it is time to refresh them, */
+	/* which makes the list revision depend on item states                            */
+	if (ZBX_COMPONENT_VERSION(4,4) > version)
+	{
+		now = time(NULL);
+
+		for (i = 0; i < active_checks->checks.values_num; i++)
+		{
+			if (ITEM_STATE_NOTSUPPORTED != states[i].state)
+				continue;
+
+			if (0 != refresh_unsupported && states[i].lastclock + refresh_unsupported <= now)
+				continue;
+
+			skip[i] = 1;
+			zbx_md5_append(&state, (const md5_byte_t *)&itemids[i], sizeof(itemids[i]));
+		}
+	}
+
+	zbx_md5_finish(&state, hash);
+	memcpy(&list_revision, hash, sizeof(list_revision));
+
+	/* zero revision is reserved for agents without active check list */
+	if (0 == list_revision)
+		list_revision = 1;
+
+	zbx_json_adduint64(json, ZBX_PROTO_TAG_CONFIG_REVISION, list_revision);
+
+	if (revision == list_revision)
+		goto out;
+
+	zbx_json_addarray(json, ZBX_PROTO_TAG_DATA);
+
+	for (i = 0; i < active_checks->checks.values_num; i++)
+	{
+		zbx_active_check_t	*check = (zbx_active_check_t *)active_checks->checks.values[i];
+
+		if (0 != skip[i])
+			continue;
+
+		zbx_json_addobject(json, NULL);
+		zbx_json_addstring(json, ZBX_PROTO_TAG_KEY, check->key, ZBX_JSON_TYPE_STRING);
+
+		if (ZBX_COMPONENT_VERSION(4,4) > version)
+		{
+			if (0 != strcmp(check->key, check->key_orig))
+				zbx_json_addstring(json, ZBX_PROTO_TAG_KEY_ORIG, check->key_orig, ZBX_JSON_TYPE_STRING);
+
+			zbx_json_adduint64(json, ZBX_PROTO_TAG_DELAY, check->interval);
+		}
+		else
+		{
+			zbx_json_adduint64(json, ZBX_PROTO_TAG_ITEMID, check->itemid);
+			zbx_json_addstring(json, ZBX_PROTO_TAG_DELAY, check->delay, ZBX_JSON_TYPE_STRING);
+		}
+
+		/* The agent expects ALWAYS to have lastlogsize and mtime tags. */
+		/* Removing those would cause older agents to fail. */
+		zbx_json_adduint64(json, ZBX_PROTO_TAG_LASTLOGSIZE, states[i].lastlogsize);
+		zbx_json_adduint64(json, ZBX_PROTO_TAG_MTIME, states[i].mtime);
+		zbx_json_close(json);
+	}
+
+	zbx_json_close(json);
+
+	if (ZBX_COMPONENT_VERSION(4,4) <= version)
+		zbx_json_adduint64(json, ZBX_PROTO_TAG_REFRESH_UNSUPPORTED, refresh_unsupported);
+
+	add_regexps_json(json, &active_checks->regexps);
+out:
+	zbx_free(skip);
+	zbx_free(states);
+	zbx_free(itemids);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: send_list_of_active_checks_json                                  *
@@ -539,29 +956,25 @@ out:
  *                                                                            *
  * Author: Alexander Vladishev                                                *
  *                                                                            *
+ * Comments: Agents sending revision of their current active check list       *
+ *           receive only the revision if the list has not changed.           *
+ *                                                                            *
  ******************************************************************************/
 int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *jp)
 {
 	char			host[HOST_HOST_LEN_MAX], tmp[MAX_STRING_LEN], ip[INTERFACE_IP_LEN_MAX],
 				error[MAX_STRING_LEN], *host_metadata = NULL, *interface = NULL;
 	struct zbx_json		json;
-	int			ret = FAIL, i, version;
-	zbx_uint64_t		hostid;
+	int			ret = FAIL, version;
+	zbx_uint64_t		hostid, revision;
 	size_t			host_metadata_alloc = 1;	/* for at least NUL-termination char */
 	size_t			interface_alloc = 1;		/* for at least NUL-termination char */
 	unsigned short		port;
-	zbx_vector_uint64_t	itemids;
 	zbx_conn_flags_t	flag = ZBX_CONN_DEFAULT;
 	zbx_config_t		cfg;
 
-	zbx_vector_ptr_t	regexps;
-	zbx_vector_str_t	names;
-
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_vector_ptr_create(&regexps);
-	zbx_vector_str_create(&names);
-
 	if (FAIL == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_HOST, host, sizeof(host), NULL))
 	{
 		zbx_snprintf(error, MAX_STRING_LEN, "%s", zbx_json_strerror());
@@ -624,133 +1037,18 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, struct zbx_json_parse *j
 		version = ZBX_COMPONENT_VERSION(4, 2);
 	}
 
-	zbx_vector_uint64_create(&itemids);
-	zbx_config_get(&cfg, ZBX_CONFIG_FLAGS_REFRESH_UNSUPPORTED);
-
-	get_list_of_active_checks(hostid, &itemids);
-
-	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
-	zbx_json_addstring(&json, ZBX_PROTO_TAG_RESPONSE, ZBX_PROTO_VALUE_SUCCESS, ZBX_JSON_TYPE_STRING);
-	zbx_json_addarray(&json, ZBX_PROTO_TAG_DATA);
-
-	if (0 != itemids.values_num)
+	if (SUCCEED != zbx_json_value_by_name(jp, ZBX_PROTO_TAG_CONFIG_REVISION, tmp, sizeof(tmp), NULL) ||
+			SUCCEED != is_uint64(tmp, &revision))
 	{
-		DC_ITEM		*dc_items;
-		int		*errcodes, now, delay;
-
-		dc_items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * itemids.values_num);
-		errcodes = (int *)zbx_malloc(NULL, sizeof(int) * itemids.values_num);
-
-		DCconfig_get_items_by_itemids(dc_items, itemids.values, errcodes, itemids.values_num);
-
-		now = time(NULL);
-
-		for (i = 0; i < itemids.values_num; i++)
-		{
-			if (SUCCEED != errcodes[i])
-			{
-				zabbix_log(LOG_LEVEL_DEBUG, "%s() Item [" ZBX_FS_UI64 "] was not found in the"
-						" server cache. Not sending now.", __func__, itemids.values[i]);
-				continue;
-			}
-
-			if (ITEM_STATUS_ACTIVE != dc_items[i].status)
-				continue;
-
-			if (HOST_STATUS_MONITORED != dc_items[i].host.status)
-				continue;
-
-			if (ZBX_COMPONENT_VERSION(4,4) > version && ITEM_STATE_NOTSUPPORTED == dc_items[i].state)
-			{
-				if (0 == cfg.refresh_unsupported)
-					continue;
-
-				if (dc_items[i].lastclock + cfg.refresh_unsupported > now)
-					continue;
-			}
-
-			if (SUCCEED != zbx_interval_preproc(dc_items[i].delay, &delay, NULL, NULL))
-				continue;
-
-
-			dc_items[i].key = zbx_strdup(dc_items[i].key, dc_items[i].key_orig);
-			substitute_key_macros_unmasked(&dc_items[i].key, NULL, &dc_items[i], NULL, NULL,
-					MACRO_TYPE_ITEM_KEY, NULL, 0);
-
-			zbx_json_addobject(&json, NULL);
-			zbx_json_addstring(&json, ZBX_PROTO_TAG_KEY, dc_items[i].key, ZBX_JSON_TYPE_STRING);
-
-			if (ZBX_COMPONENT_VERSION(4,4) > version)
-			{
-				if (0 != strcmp(dc_items[i].key, dc_items[i].key_orig))
-				{
-					zbx_json_addstring(&json, ZBX_PROTO_TAG_KEY_ORIG,
-							dc_items[i].key_orig, ZBX_JSON_TYPE_STRING);
-				}
-
-				zbx_json_adduint64(&json, ZBX_PROTO_TAG_DELAY, delay);
-			}
-			else
-			{
-				zbx_json_adduint64(&json, ZBX_PROTO_TAG_ITEMID, dc_items[i].itemid);
-				zbx_json_addstring(&json, ZBX_PROTO_TAG_DELAY, dc_items[i].delay, ZBX_JSON_TYPE_STRING);
-			}
-
-			/* The agent expects ALWAYS to have lastlogsize and mtime tags. */
-			/* Removing those would cause older agents to fail. */
-			zbx_json_adduint64(&json, ZBX_PROTO_TAG_LASTLOGSIZE, dc_items[i].lastlogsize);
-			zbx_json_adduint64(&json, ZBX_PROTO_TAG_MTIME, dc_items[i].mtime);
-			zbx_json_close(&json);
-
-			zbx_itemkey_extract_global_regexps(dc_items[i].key, &names);
-
-			zbx_free(dc_items[i].key);
-		}
-
-		DCconfig_clean_items(dc_items, errcodes, itemids.values_num);
-
-		zbx_free(errcodes);
-		zbx_free(dc_items);
+		revision = 0;
 	}
 
-	zbx_json_close(&json);
-
-	if (ZBX_COMPONENT_VERSION(4,4) <= version)
-		zbx_json_adduint64(&json, ZBX_PROTO_TAG_REFRESH_UNSUPPORTED, cfg.refresh_unsupported);
+	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addstring(&json, ZBX_PROTO_TAG_RESPONSE, ZBX_PROTO_VALUE_SUCCESS, ZBX_JSON_TYPE_STRING);
 
+	zbx_config_get(&cfg, ZBX_CONFIG_FLAGS_REFRESH_UNSUPPORTED);
+	active_checks_add_json(&json, active_checks_get(hostid), version, cfg.refresh_unsupported, revision);
 	zbx_config_clean(&cfg);
-	zbx_vector_uint64_destroy(&itemids);
-
-	DCget_expressions_by_names(&regexps, (const char * const *)names.values, names.values_num);
-
-	if (0 < regexps.values_num)
-	{
-		char	buffer[32];
-
-		zbx_json_addarray(&json, ZBX_PROTO_TAG_REGEXP);
-
-		for (i = 0; i < regexps.values_num; i++)
-		{
-			zbx_expression_t	*regexp = (zbx_expression_t *)regexps.values[i];
-
-			zbx_json_addobject(&json, NULL);
-			zbx_json_addstring(&json, "name", regexp->name, ZBX_JSON_TYPE_STRING);
-			zbx_json_addstring(&json, "expression", regexp->expression, ZBX_JSON_TYPE_STRING);
-
-			zbx_snprintf(buffer, sizeof(buffer), "%d", regexp->expression_type);
-			zbx_json_addstring(&json, "expression_type", buffer, ZBX_JSON_TYPE_INT);
-
-			zbx_snprintf(buffer, sizeof(buffer), "%c", regexp->exp_delimiter);
-			zbx_json_addstring(&json, "exp_delimiter", buffer, ZBX_JSON_TYPE_STRING);
-
-			zbx_snprintf(buffer, sizeof(buffer), "%d", regexp->case_sensitive);
-			zbx_json_addstring(&json, "case_sensitive", buffer, ZBX_JSON_TYPE_INT);
-
-			zbx_json_close(&json);
-		}
-
-		zbx_json_close(&json);
-	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() sending [%s]", __func__, json.buffer);
 
@@ -775,14 +1073,6 @@ error:
 
 	zbx_json_free(&json);
 out:
-	for (i = 0; i < names.values_num; i++)
-		zbx_free(names.values[i]);
-
-	zbx_vector_str_destroy(&names);
-
-	zbx_regexp_clean_expressions(&regexps);
-	zbx_vector_ptr_destroy(&regexps);
-
 	zbx_free(host_metadata);
 	zbx_free(interface);
 
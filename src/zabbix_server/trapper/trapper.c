@@ -43,14 +43,38 @@
 #include "trapper_item_test.h"
 #include "../poller/checks_snmp.h"
 
+#include <poll.h>
+
 #define ZBX_MAX_SECTION_ENTRIES		4
 #define ZBX_MAX_ENTRY_ATTRIBUTES	3
 
+/* Trapper has to accept all types of connections it can accept with the specified configuration. */
+/* Only after receiving data it is known who has sent them and one can decide to accept or discard */
+/* the data. */
+#define ZBX_TRAPPER_TLS_ACCEPT	(ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK | ZBX_TCP_SEC_UNENCRYPTED)
+
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 extern size_t		(*find_psk_in_cache)(const unsigned char *, unsigned char *, unsigned int *);
 
 extern int	CONFIG_CONFSYNCER_FORKS;
+extern int	CONFIG_TRAPPER_CONCURRENCY;
+extern int	CONFIG_LISTEN_PORT;
+extern char	*CONFIG_LISTEN_IP;
+
+#define ZBX_TRAPPER_CONN_ACCEPTED	0	/* connection type is not known yet */
+#define ZBX_TRAPPER_CONN_RECV		1	/* receiving request without blocking */
+
+/* incoming connection served by concurrent trapper */
+typedef struct
+{
+	zbx_socket_t		s;
+	zbx_tcp_recv_context_t	context;
+	zbx_timespec_t		ts;		/* connection timestamp */
+	time_t			deadline;	/* time by which the request must be received */
+	unsigned char		state;
+}
+zbx_trapper_conn_t;
 
 #ifdef HAVE_NETSNMP
 static volatile sig_atomic_t	snmp_cache_reload_requested;
@@ -1318,6 +1342,251 @@ static void	zbx_trapper_sigusr_handler(int flags)
 #endif
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: trapper_conn_free                                                *
+ *                                                                            *
+ * Purpose: close connection of concurrent trapper                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_conn_free(zbx_trapper_conn_t *conn)
+{
+	if (ZBX_TRAPPER_CONN_RECV == conn->state)
+		zbx_tcp_recv_context_clear(&conn->context);
+
+	zbx_tcp_close(&conn->s);
+	zbx_free(conn);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trapper_conn_read                                                *
+ *                                                                            *
+ * Purpose: read available data from readable connection and process the      *
+ *          request when it is received completely                            *
+ *                                                                            *
+ * Parameters: conn - [IN/OUT] the connection                                 *
+ *                                                                            *
+ * Return value: SUCCEED - more data is expected                              *
+ *               FAIL - the connection is served or failed and must be closed *
+ *                                                                            *
+ * Comments: TLS handshake and encrypted connections are served in blocking   *
+ *           mode as before, the handshake is limited by Timeout like in      *
+ *           zbx_tcp_accept(). Responses are always sent in blocking mode.    *
+ *                                                                            *
+ ******************************************************************************/
+static int	trapper_conn_read(zbx_trapper_conn_t *conn)
+{
+	short	events;
+	int	ret;
+
+	if (ZBX_TRAPPER_CONN_ACCEPTED == conn->state)
+	{
+		zbx_socket_timeout_set(&conn->s, CONFIG_TIMEOUT);
+		ret = zbx_tcp_accept_tls(&conn->s, ZBX_TRAPPER_TLS_ACCEPT);
+		zbx_socket_timeout_cleanup(&conn->s);
+
+		if (SUCCEED != ret)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "failed to accept an incoming connection: %s",
+					zbx_socket_strerror());
+			return FAIL;
+		}
+
+		if (ZBX_TCP_SEC_UNENCRYPTED != conn->s.connection_type)
+		{
+			process_trapper_child(&conn->s, &conn->ts);
+			return FAIL;
+		}
+
+		zbx_tcp_recv_context_init(&conn->s, &conn->context);
+		conn->state = ZBX_TRAPPER_CONN_RECV;
+	}
+
+	if (FAIL == zbx_tcp_recv_context(&conn->s, &conn->context, &events))
+		return 0 != events ? SUCCEED : FAIL;
+
+	if (SUCCEED != zbx_socket_set_blocking(conn->s.socket))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot process request from %s: %s", conn->s.peer,
+				zbx_socket_strerror());
+		return FAIL;
+	}
+
+	process_trap(&conn->s, conn->s.buffer, &conn->ts);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trapper_accept_connections                                       *
+ *                                                                            *
+ * Purpose: accept pending connections on readable listening socket           *
+ *                                                                            *
+ * Parameters: listen_sock - [IN] the listening socket                        *
+ *             index       - [IN] index of the readable socket descriptor     *
+ *             conns       - [IN/OUT] the served connections                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_accept_connections(const zbx_socket_t *listen_sock, int index, zbx_vector_ptr_t *conns)
+{
+	zbx_trapper_conn_t	*conn = NULL;
+	short			events;
+
+	while (conns->values_num < CONFIG_TRAPPER_CONCURRENCY)
+	{
+		if (NULL == conn)
+			conn = (zbx_trapper_conn_t *)zbx_malloc(NULL, sizeof(zbx_trapper_conn_t));
+
+		if (SUCCEED != zbx_tcp_accept_nonblocking(listen_sock, index, &conn->s, &events))
+		{
+			if (0 == events)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "failed to accept an incoming connection: %s",
+						zbx_socket_strerror());
+			}
+
+			break;
+		}
+
+		zbx_timespec(&conn->ts);
+		conn->deadline = conn->ts.sec + CONFIG_TRAPPER_TIMEOUT;
+		conn->state = ZBX_TRAPPER_CONN_ACCEPTED;
+
+		zbx_vector_ptr_append(conns, conn);
+		conn = NULL;
+	}
+
+	zbx_free(conn);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: trapper_serve_concurrently                                       *
+ *                                                                            *
+ * Purpose: serve up to CONFIG_TRAPPER_CONCURRENCY connections at once,       *
+ *          receiving requests without blocking                               *
+ *                                                                            *
+ * Parameters: listen_sock - [IN] the listening socket                        *
+ *                                                                            *
+ * Comments: Slow senders do not block the trapper while their request is     *
+ *           being received, only complete requests are processed.            *
+ *                                                                            *
+ ******************************************************************************/
+static void	trapper_serve_concurrently(zbx_socket_t *listen_sock)
+{
+	struct pollfd		*pfds;
+	zbx_vector_ptr_t	conns;
+	zbx_trapper_conn_t	*conn;
+	double			sec = 0.0;
+	int			i, nfds, listen_num, ret;
+	time_t			now;
+
+	for (i = 0; i < listen_sock->num_socks; i++)
+	{
+		/* several trappers may wait for connections on the same socket */
+		if (SUCCEED != zbx_socket_set_nonblocking(listen_sock->sockets[i]))
+			zabbix_log(LOG_LEVEL_WARNING, "%s", zbx_socket_strerror());
+	}
+
+	pfds = (struct pollfd *)zbx_malloc(NULL, sizeof(struct pollfd) *
+			(listen_sock->num_socks + CONFIG_TRAPPER_CONCURRENCY));
+	zbx_vector_ptr_create(&conns);
+
+	while (ZBX_IS_RUNNING())
+	{
+#ifdef HAVE_NETSNMP
+		if (1 == snmp_cache_reload_requested)
+		{
+			zbx_clear_cache_snmp();
+			snmp_cache_reload_requested = 0;
+		}
+#endif
+		zbx_setproctitle("%s #%d [processed data in " ZBX_FS_DBL " sec, receiving data from %d connections]",
+				get_process_type_string(process_type), process_num, sec, conns.values_num);
+
+		update_selfmon_counter(ZBX_PROCESS_STATE_IDLE);
+
+		nfds = 0;
+
+		/* stop accepting new connections while the limit is reached */
+		if (conns.values_num < CONFIG_TRAPPER_CONCURRENCY)
+		{
+			for (i = 0; i < listen_sock->num_socks; i++)
+			{
+				pfds[nfds].fd = listen_sock->sockets[i];
+				pfds[nfds].events = POLLIN;
+				pfds[nfds++].revents = 0;
+			}
+		}
+
+		listen_num = nfds;
+
+		for (i = 0; i < conns.values_num; i++)
+		{
+			conn = (zbx_trapper_conn_t *)conns.values[i];
+			pfds[nfds].fd = conn->s.socket;
+			pfds[nfds].events = POLLIN;
+			pfds[nfds++].revents = 0;
+		}
+
+		/* wake up every second to check connection timeouts */
+		ret = poll(pfds, nfds, 0 == conns.values_num ? -1 : 1000);
+		zbx_update_env(zbx_time());
+
+		if (-1 == ret)
+		{
+			if (EINTR != errno)
+				zabbix_log(LOG_LEVEL_WARNING, "poll() failed: %s", zbx_strerror(errno));
+
+			continue;
+		}
+
+		update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+
+		sec = zbx_time();
+		now = time(NULL);
+
+		/* iterate backwards, removed connection is replaced by the last one that is already checked */
+		for (i = conns.values_num - 1; 0 <= i; i--)
+		{
+			conn = (zbx_trapper_conn_t *)conns.values[i];
+
+			if (0 == pfds[listen_num + i].revents)
+			{
+				if (now < conn->deadline)
+					continue;
+
+				zabbix_log(LOG_LEVEL_DEBUG, "connection from %s timed out", conn->s.peer);
+			}
+			else
+			{
+				zbx_setproctitle("%s #%d [processing data]", get_process_type_string(process_type),
+						process_num);
+
+				if (SUCCEED == trapper_conn_read(conn))
+					continue;
+			}
+
+			trapper_conn_free(conn);
+			zbx_vector_ptr_remove_noorder(&conns, i);
+		}
+
+		for (i = 0; i < listen_num; i++)
+		{
+			if (0 != (pfds[i].revents & POLLIN))
+				trapper_accept_connections(listen_sock, i, &conns);
+		}
+
+		sec = zbx_time() - sec;
+	}
+
+	zbx_vector_ptr_clear_ext(&conns, (zbx_clean_func_t)trapper_conn_free);
+	zbx_vector_ptr_destroy(&conns);
+	zbx_free(pfds);
+}
+
 ZBX_THREAD_ENTRY(trapper_thread, args)
 {
 	double		sec = 0.0;
@@ -1355,6 +1624,29 @@ ZBX_THREAD_ENTRY(trapper_thread, args)
 
 	zbx_set_sigusr_handler(zbx_trapper_sigusr_handler);
 
+	if (1 < CONFIG_TRAPPER_CONCURRENCY)
+	{
+#ifdef SO_REUSEPORT
+		zbx_socket_t	listen_sock;
+
+		/* the first trapper serves the socket inherited from the main process */
+		if (1 != process_num)
+		{
+			if (SUCCEED == zbx_tcp_listen_ext(&listen_sock, CONFIG_LISTEN_IP,
+					(unsigned short)CONFIG_LISTEN_PORT, ZBX_TCP_LISTEN_REUSEPORT))
+			{
+				memcpy(&s, &listen_sock, sizeof(zbx_socket_t));
+			}
+			else
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "cannot create own listening socket, using the shared one:"
+						" %s", zbx_socket_strerror());
+			}
+		}
+#endif
+		trapper_serve_concurrently(&s);
+	}
+
 	while (ZBX_IS_RUNNING())
 	{
 #ifdef HAVE_NETSNMP
@@ -1369,10 +1661,7 @@ ZBX_THREAD_ENTRY(trapper_thread, args)
 
 		update_selfmon_counter(ZBX_PROCESS_STATE_IDLE);
 
-		/* Trapper has to accept all types of connections it can accept with the specified configuration. */
-		/* Only after receiving data it is known who has sent them and one can decide to accept or discard */
-		/* the data. */
-		ret = zbx_tcp_accept(&s, ZBX_TCP_SEC_TLS_CERT | ZBX_TCP_SEC_TLS_PSK | ZBX_TCP_SEC_UNENCRYPTED);
+		ret = zbx_tcp_accept(&s, ZBX_TRAPPER_TLS_ACCEPT);
 		zbx_update_env(zbx_time());
 
 		if (SUCCEED == ret)
@@ -36,6 +36,7 @@ AC_DEFUN([CONF_TESTS],[
 		tests/libs/zbxserver/Makefile
 		tests/libs/zbxprometheus/Makefile
 		tests/zabbix_server/Makefile
+		tests/zabbix_server/poller/Makefile
 		tests/zabbix_server/preprocessor/Makefile
 		tests/libs/zbxcomms/Makefile
 		tests/zabbix_server/trapper/Makefile
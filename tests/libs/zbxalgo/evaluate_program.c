@@ -0,0 +1,135 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockutil.h"
+#include "zbxmockassert.h"
+
+#include "zbxalgo.h"
+
+#define TEST_MAX_OPERANDS	16
+
+static int	read_values(const char *path, const char **values)
+{
+	zbx_mock_error_t	error;
+	zbx_mock_handle_t	handle, element;
+	int			values_num = 0;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_parameter_exists(path))
+		return 0;
+
+	handle = zbx_mock_get_parameter_handle(path);
+
+	while (ZBX_MOCK_SUCCESS == (error = zbx_mock_vector_element(handle, &element)))
+	{
+		if (TEST_MAX_OPERANDS == values_num)
+			fail_msg("Too many values in \"%s\"", path);
+
+		if (ZBX_MOCK_SUCCESS != (error = zbx_mock_string(element, &values[values_num++])))
+			break;
+	}
+
+	if (ZBX_MOCK_END_OF_VECTOR != error)
+		fail_msg("Cannot read \"%s\": %s", path, zbx_mock_error_string(error));
+
+	return values_num;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char			*expression, *values[TEST_MAX_OPERANDS], *msgs[TEST_MAX_OPERANDS];
+	const zbx_expression_operand_t	*poperands[TEST_MAX_OPERANDS];
+	const zbx_uint64_t		*functionids;
+	zbx_expression_operand_t	operands[TEST_MAX_OPERANDS];
+	zbx_vector_ptr_t		unknown_msgs;
+	unsigned char			*program;
+	char				error[256];
+	double				value;
+	int				i, values_num, msgs_num, functionids_num, expected_ret, ret;
+
+	ZBX_UNUSED(state);
+
+	expression = zbx_mock_get_parameter_string("in.expression");
+	values_num = read_values("in.values", values);
+	msgs_num = read_values("in.unknown_msgs", msgs);
+
+	program = zbx_expression_compile(expression);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("out.compile") &&
+			SUCCEED != zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.compile")))
+	{
+		zbx_mock_assert_ptr_eq("compiled program", NULL, program);
+		return;
+	}
+
+	zbx_mock_assert_ptr_ne("compiled program", NULL, program);
+
+	functionids_num = zbx_expression_program_functionids(program, &functionids);
+
+	for (i = 0; i < functionids_num; i++)
+	{
+		/* functionid 0 stands for {TRIGGER.VALUE} macro */
+		if (0 == functionids[i])
+		{
+			operands[i].str = NULL;
+			operands[i].value = (double)zbx_mock_get_parameter_uint64("in.trigger_value");
+			operands[i].unknown_idx = -1;
+		}
+		else
+		{
+			if (values_num < (int)functionids[i])
+				fail_msg("No value for function {" ZBX_FS_UI64 "}", functionids[i]);
+
+			if (SUCCEED != zbx_expression_operand_parse(&operands[i], values[functionids[i] - 1]))
+			{
+				zbx_mock_assert_str_eq("operand parsing", zbx_mock_get_parameter_string("out.return"),
+						"FALLBACK");
+				goto out;
+			}
+		}
+
+		poperands[i] = &operands[i];
+	}
+
+	zbx_vector_ptr_create(&unknown_msgs);
+
+	for (i = 0; i < msgs_num; i++)
+		zbx_vector_ptr_append(&unknown_msgs, (void *)msgs[i]);
+
+	expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.return"));
+	ret = zbx_expression_execute(&value, program, poperands, expression, error, sizeof(error), &unknown_msgs);
+
+	zbx_mock_assert_result_eq("zbx_expression_execute() return value", expected_ret, ret);
+
+	if (SUCCEED == ret)
+		zbx_mock_assert_double_eq("result", zbx_mock_get_parameter_float("out.value"), value);
+	else
+		zbx_mock_assert_str_eq("error", zbx_mock_get_parameter_string("out.error"), error);
+
+	zbx_vector_ptr_destroy(&unknown_msgs);
+out:
+	while (0 != i--)
+	{
+		if (0 != functionids[i])
+			zbx_expression_operand_clear(&operands[i]);
+	}
+
+	zbx_free(program);
+}
@@ -0,0 +1,171 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "valuecache.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vcmock_check_value                                               *
+ *                                                                            *
+ * Purpose: checks numeric aggregate value against the expected value         *
+ *                                                                            *
+ ******************************************************************************/
+static void	vcmock_check_value(const char *prefix, unsigned char value_type, zbx_mock_handle_t hresult,
+		const char *key, const history_value_t *value)
+{
+	const char	*data;
+	zbx_uint64_t	value_ui64;
+
+	data = zbx_mock_get_object_member_string(hresult, key);
+
+	if (ITEM_VALUE_TYPE_UINT64 == value_type)
+	{
+		if (SUCCEED != is_uint64(data, &value_ui64))
+			fail_msg("Invalid %s value \"%s\"", key, data);
+
+		zbx_mock_assert_uint64_eq(prefix, value_ui64, value->ui64);
+	}
+	else
+		zbx_mock_assert_double_eq(prefix, atof(data), value->dbl);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mock_test_entry                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	char			*error = NULL, prefix[MAX_STRING_LEN];
+	const char		*data;
+	int			err, seconds, count, time_shift, index = 0;
+	zbx_timespec_t		ts;
+	zbx_uint64_t		itemid;
+	unsigned char		value_type;
+	zbx_mock_handle_t	handle, hitem, hrequests, hrequest, hvalues, hresult;
+	zbx_mock_error_t	mock_err;
+	zbx_vc_aggregate_t	aggregate;
+	zbx_vector_ptr_t	history;
+
+	ZBX_UNUSED(state);
+
+	/* set small cache size to force smaller cache free request size (5% of cache size) */
+	CONFIG_VALUE_CACHE_SIZE = ZBX_KIBIBYTE;
+
+	err = zbx_vc_init(&error);
+	zbx_mock_assert_result_eq("Value cache initialization failed", SUCCEED, err);
+
+	zbx_vc_enable();
+
+	zbx_vcmock_ds_init();
+	zbx_vector_ptr_create(&history);
+
+	/* precache values */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.precache", &handle))
+	{
+		while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(handle, &hitem))))
+		{
+			zbx_vcmock_set_time(hitem, "time");
+			zbx_vcmock_set_mode(hitem, "cache mode");
+			zbx_vcmock_set_cache_size(hitem, "cache size");
+
+			zbx_vcmock_get_request_params(hitem, &itemid, &value_type, &seconds, &count, &ts);
+			zbx_vc_precache_values(itemid, value_type, seconds, count, &ts);
+		}
+	}
+
+	/* perform requests, optionally adding new values before each request to move the windows */
+
+	hrequests = zbx_mock_get_parameter_handle("in.requests");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(hrequests, &hrequest))))
+	{
+		if (ZBX_MOCK_NOT_A_VECTOR == mock_err)
+			fail_msg("in.requests parameter is not a vector");
+
+		index++;
+		zbx_vcmock_set_time(hrequest, "time");
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hrequest, "values", &hvalues))
+		{
+			zbx_vcmock_get_dc_history(hvalues, &history);
+			err = zbx_vc_add_values(&history);
+			zbx_mock_assert_result_eq("zbx_vc_add_values() return value", SUCCEED, err);
+			zbx_vector_ptr_clear_ext(&history, zbx_vcmock_free_dc_history);
+		}
+
+		if (FAIL == is_uint64(zbx_mock_get_object_member_string(hrequest, "itemid"), &itemid))
+			fail_msg("Invalid itemid value");
+
+		value_type = zbx_mock_str_to_value_type(zbx_mock_get_object_member_string(hrequest, "value type"));
+		seconds = atoi(zbx_mock_get_object_member_string(hrequest, "seconds"));
+		time_shift = atoi(zbx_mock_get_object_member_string(hrequest, "time shift"));
+		zbx_strtime_to_timespec(zbx_mock_get_object_member_string(hrequest, "end"), &ts);
+
+		err = zbx_vc_get_aggregate(itemid, value_type, seconds, time_shift, &ts,
+				ZBX_VC_AGGREGATE_MIN | ZBX_VC_AGGREGATE_MAX, &aggregate);
+
+		data = zbx_mock_get_object_member_string(hrequest, "return");
+		zbx_snprintf(prefix, sizeof(prefix), "request #%d zbx_vc_get_aggregate() return value", index);
+		zbx_mock_assert_result_eq(prefix, zbx_mock_str_to_return_code(data), err);
+
+		if (SUCCEED != err)
+			continue;
+
+		hresult = zbx_mock_get_object_member_handle(hrequest, "result");
+
+		zbx_snprintf(prefix, sizeof(prefix), "request #%d count", index);
+		zbx_mock_assert_int_eq(prefix, atoi(zbx_mock_get_object_member_string(hresult, "count")),
+				aggregate.values_num);
+
+		if (0 == aggregate.values_num)
+			continue;
+
+		zbx_snprintf(prefix, sizeof(prefix), "request #%d sum", index);
+		vcmock_check_value(prefix, value_type, hresult, "sum", &aggregate.sum);
+
+		zbx_snprintf(prefix, sizeof(prefix), "request #%d avg", index);
+		zbx_mock_assert_double_eq(prefix, atof(zbx_mock_get_object_member_string(hresult, "avg")), aggregate.avg);
+
+		zbx_snprintf(prefix, sizeof(prefix), "request #%d min", index);
+		vcmock_check_value(prefix, value_type, hresult, "min", &aggregate.min);
+
+		zbx_snprintf(prefix, sizeof(prefix), "request #%d max", index);
+		vcmock_check_value(prefix, value_type, hresult, "max", &aggregate.max);
+	}
+
+	/* cleanup */
+
+	zbx_vector_ptr_destroy(&history);
+
+	zbx_vcmock_ds_destroy();
+
+	zbx_vc_reset();
+	zbx_vc_destroy();
+}
@@ -0,0 +1,294 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "comms.h"
+#include "dbcache.h"
+#include "../../../src/zabbix_server/poller/checks_agent.h"
+
+#define AGENT_HEADER_LEN	13
+#define AGENT_CONNECTIONS_MAX	1024
+
+typedef struct
+{
+	char	*data;
+	size_t	len;
+	size_t	offset;
+	int	persistent;
+}
+agent_connection_t;
+
+extern int	CONFIG_AGENT_PERSISTENT;
+
+static agent_connection_t	connections[AGENT_CONNECTIONS_MAX];
+static int			agent_persistent, requests_num, opening_num;
+
+ssize_t	__wrap_send(int sockfd, const void *buf, size_t len, int flags);
+ssize_t	__wrap_recv(int sockfd, void *buf, size_t len, int flags);
+int	__wrap_close(int fd);
+int	__real_close(int fd);
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_process_request                                            *
+ *                                                                            *
+ * Purpose: prepare the response of agent to passive check request            *
+ *                                                                            *
+ * Comments: Agent that does not support persistent connections treats the    *
+ *           connection opening request as unknown item key.                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_process_request(agent_connection_t *connection, const char *request, size_t request_len)
+{
+	zbx_mock_error_t	mock_err;
+	zbx_mock_handle_t	hitems, hitem, herror;
+	char			*key, *data = NULL;
+	size_t			data_alloc = 0, data_offset = 0;
+	zbx_uint32_t		len32_le;
+
+	key = (char *)zbx_malloc(NULL, request_len + 1);
+	memcpy(key, request, request_len);
+	key[request_len] = '\0';
+
+	if (0 == connection->persistent && 0 == strcmp(key, ZBX_PERSISTENT))
+	{
+		opening_num++;
+
+		if (0 != agent_persistent)
+		{
+			connection->persistent = 1;
+			zbx_strcpy_alloc(&data, &data_alloc, &data_offset, ZBX_PERSISTENT);
+		}
+		else
+		{
+			zbx_strcpy_alloc(&data, &data_alloc, &data_offset, ZBX_NOTSUPPORTED);
+			data_offset++;
+			zbx_strcpy_alloc(&data, &data_alloc, &data_offset, "Unsupported item key.");
+		}
+	}
+	else
+	{
+		requests_num++;
+		hitems = zbx_mock_get_parameter_handle("in.items");
+
+		while (ZBX_MOCK_END_OF_VECTOR != (mock_err = zbx_mock_vector_element(hitems, &hitem)))
+		{
+			if (ZBX_MOCK_SUCCESS != mock_err)
+				fail_msg("Cannot read 'items' element: %s", zbx_mock_error_string(mock_err));
+
+			if (0 != strcmp(key, zbx_mock_get_object_member_string(hitem, "key")))
+				continue;
+
+			if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hitem, "error", &herror))
+			{
+				zbx_strcpy_alloc(&data, &data_alloc, &data_offset, ZBX_NOTSUPPORTED);
+				data_offset++;
+				zbx_strcpy_alloc(&data, &data_alloc, &data_offset,
+						zbx_mock_get_object_member_string(hitem, "error"));
+			}
+			else
+			{
+				zbx_strcpy_alloc(&data, &data_alloc, &data_offset,
+						zbx_mock_get_object_member_string(hitem, "value"));
+			}
+
+			break;
+		}
+
+		if (NULL == data)
+			fail_msg("Unexpected item key \"%s\"", key);
+	}
+
+	zbx_free(connection->data);
+	connection->len = AGENT_HEADER_LEN + data_offset;
+	connection->data = (char *)zbx_malloc(NULL, connection->len);
+	connection->offset = 0;
+
+	memcpy(connection->data, "ZBXD", 4);
+	connection->data[4] = ZBX_TCP_PROTOCOL;
+	len32_le = zbx_htole_uint32((zbx_uint32_t)data_offset);
+	memcpy(connection->data + 5, &len32_le, sizeof(len32_le));
+	memset(connection->data + 9, 0, sizeof(len32_le));
+	memcpy(connection->data + AGENT_HEADER_LEN, data, data_offset);
+
+	zbx_free(data);
+	zbx_free(key);
+}
+
+ssize_t	__wrap_send(int sockfd, const void *buf, size_t len, int flags)
+{
+	zbx_uint32_t	len32_le;
+
+	ZBX_UNUSED(flags);
+
+	if (0 > sockfd || AGENT_CONNECTIONS_MAX <= sockfd)
+		fail_msg("Unexpected socket %d", sockfd);
+
+	if (AGENT_HEADER_LEN > len || 0 != memcmp(buf, "ZBXD", 4))
+		fail_msg("Request is missing header");
+
+	memcpy(&len32_le, (const char *)buf + 5, sizeof(len32_le));
+
+	if (AGENT_HEADER_LEN + zbx_letoh_uint32(len32_le) != len)
+		fail_msg("Request is not sent at once");
+
+	agent_process_request(&connections[sockfd], (const char *)buf + AGENT_HEADER_LEN, len - AGENT_HEADER_LEN);
+
+	return (ssize_t)len;
+}
+
+ssize_t	__wrap_recv(int sockfd, void *buf, size_t len, int flags)
+{
+	agent_connection_t	*connection;
+
+	ZBX_UNUSED(flags);
+
+	if (0 > sockfd || AGENT_CONNECTIONS_MAX <= sockfd)
+		fail_msg("Unexpected socket %d", sockfd);
+
+	connection = &connections[sockfd];
+
+	if (NULL == connection->data)
+	{
+		if (0 != connection->persistent)
+		{
+			errno = EAGAIN;
+			return -1;
+		}
+
+		return 0;	/* connection closed by agent */
+	}
+
+	if (len > connection->len - connection->offset)
+		len = connection->len - connection->offset;
+
+	memcpy(buf, connection->data + connection->offset, len);
+
+	if (connection->len == (connection->offset += len))
+		zbx_free(connection->data);
+
+	return (ssize_t)len;
+}
+
+int	__wrap_close(int fd)
+{
+	if (0 <= fd && AGENT_CONNECTIONS_MAX > fd)
+	{
+		zbx_free(connections[fd].data);
+		connections[fd].persistent = 0;
+	}
+
+	return __real_close(fd);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_error_t	mock_err;
+	zbx_mock_handle_t	hitems, hitem, herror;
+	DC_ITEM			*items = NULL;
+	AGENT_RESULT		*results;
+	int			*errcodes, i, num = 0;
+	char			msg[MAX_STRING_LEN];
+
+	ZBX_UNUSED(state);
+
+	CONFIG_AGENT_PERSISTENT = (int)zbx_mock_get_parameter_uint64("in.config");
+	agent_persistent = (int)zbx_mock_get_parameter_uint64("in.agent");
+	hitems = zbx_mock_get_parameter_handle("in.items");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (mock_err = zbx_mock_vector_element(hitems, &hitem)))
+	{
+		if (ZBX_MOCK_SUCCESS != mock_err)
+			fail_msg("Cannot read 'items' element #%d: %s", num, zbx_mock_error_string(mock_err));
+
+		items = (DC_ITEM *)zbx_realloc(items, sizeof(DC_ITEM) * (size_t)(num + 1));
+		memset(&items[num], 0, sizeof(DC_ITEM));
+
+		items[num].itemid = (zbx_uint64_t)num + 1;
+		items[num].key = (char *)zbx_mock_get_object_member_string(hitem, "key");
+		items[num].host.tls_connect = ZBX_TCP_SEC_UNENCRYPTED;
+		zbx_strlcpy(items[num].host.host, "Zabbix server", sizeof(items[num].host.host));
+		items[num].interface.interfaceid = 1;
+		items[num].interface.addr = (char *)"127.0.0.1";
+		items[num].interface.port = 10050;
+
+		num++;
+	}
+
+	results = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT) * (size_t)num);
+	errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
+
+	for (i = 0; i < num; i++)
+	{
+		init_result(&results[i]);
+		errcodes[i] = SUCCEED;
+	}
+
+	get_values_agent(items, results, errcodes, num);
+
+	hitems = zbx_mock_get_parameter_handle("in.items");
+
+	for (i = 0; i < num; i++)
+	{
+		if (ZBX_MOCK_SUCCESS != (mock_err = zbx_mock_vector_element(hitems, &hitem)))
+			fail_msg("Cannot read 'items' element #%d: %s", i, zbx_mock_error_string(mock_err));
+
+		zbx_snprintf(msg, sizeof(msg), "Value of item \"%s\"", items[i].key);
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hitem, "error", &herror))
+		{
+			zbx_mock_assert_result_eq(msg, NOTSUPPORTED, errcodes[i]);
+
+			if (NULL == GET_MSG_RESULT(&results[i]))
+				fail_msg("Item \"%s\" has no error message", items[i].key);
+
+			zbx_mock_assert_str_eq(msg, zbx_mock_get_object_member_string(hitem, "error"),
+					*GET_MSG_RESULT(&results[i]));
+		}
+		else
+		{
+			zbx_mock_assert_result_eq(msg, SUCCEED, errcodes[i]);
+
+			if (NULL == GET_TEXT_RESULT(&results[i]))
+				fail_msg("Item \"%s\" has no text value", items[i].key);
+
+			zbx_mock_assert_str_eq(msg, zbx_mock_get_object_member_string(hitem, "value"),
+					*GET_TEXT_RESULT(&results[i]));
+		}
+
+		free_result(&results[i]);
+	}
+
+	zbx_mock_assert_int_eq("Number of requests", (int)zbx_mock_get_parameter_uint64("out.requests"),
+			requests_num);
+	zbx_mock_assert_int_eq("Number of connection opening requests",
+			(int)zbx_mock_get_parameter_uint64("out.opening"), opening_num);
+
+	for (i = 0; i < AGENT_CONNECTIONS_MAX; i++)
+		zbx_free(connections[i].data);
+
+	zbx_free(errcodes);
+	zbx_free(results);
+	zbx_free(items);
+}
@@ -94,7 +94,7 @@ void	__zbx_mock_assert_int_ne(const char *file, int line, const char *prefix_msg
 void	__zbx_mock_assert_double_eq(const char *file, double line, const char *prefix_msg, double expected_value,
 		double returned_value)
 {
-	if (ZBX_DOUBLE_EPSILON >= fabs(returned_value - expected_value))
+	if (expected_value == returned_value || ZBX_DOUBLE_EPSILON >= fabs(returned_value - expected_value))
 		return;
 
 	_FAIL(file, line, prefix_msg, "Expected value \"%f\" while got \"%f\"", expected_value, returned_value);
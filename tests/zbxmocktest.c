@@ -64,6 +64,8 @@ int	CONFIG_HOUSEKEEPING_FREQUENCY	= 1;
 int	CONFIG_MAX_HOUSEKEEPER_DELETE	= 5000;		/* applies for every separate field value */
 int	CONFIG_HISTSYNCER_FORKS		= 4;
 int	CONFIG_HISTSYNCER_FREQUENCY	= 1;
+int	CONFIG_TRENDS_UPSERT		= 0;
+int	CONFIG_TRENDS_FLUSH_SPREAD	= 0;
 int	CONFIG_CONFSYNCER_FORKS		= 1;
 int	CONFIG_CONFSYNCER_FREQUENCY	= 60;
 
@@ -83,6 +85,7 @@ zbx_uint64_t	CONFIG_EXPORT_FILE_SIZE;
 int	CONFIG_UNREACHABLE_PERIOD	= 45;
 int	CONFIG_UNREACHABLE_DELAY	= 15;
 int	CONFIG_UNAVAILABLE_DELAY	= 60;
+int	CONFIG_AGENT_PERSISTENT		= 0;
 int	CONFIG_LOG_LEVEL		= 0;
 char	*CONFIG_ALERT_SCRIPTS_PATH	= NULL;
 char	*CONFIG_EXTERNALSCRIPTS		= NULL;